@@ -13,10 +13,12 @@
 #include <errno.h>
 #include <getopt.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "needconfig.h"
 #include "rc.h"
 #include "ProfileSearching.h"
+#include "BatchSearching.h"
 #include "FrequencyStore.h"
 #include "MOptions.h"
 #include "coma.h"
@@ -28,6 +30,7 @@
 bool GetScoringScheme( const mystring&, AbstractScoreMatrix::TType* );
 bool GetStatBehaviour( bool, AbstractScoreMatrix::TBehaviour* );
 bool GetMasking( bool, bool, TMask* );
+bool ReadQueryList( const mystring&, const mystring&, mystring**, mystring**, int* );
 
 // =========================================================================
 
@@ -37,10 +40,18 @@ int main( int argc, char *argv[] )
     char            strbuf[BUF_MAX];
     //names of input file and database
     mystring        input;
+    mystring        querylist;
     mystring        database;
     mystring        output;
     mystring        optfile;
+    mystring        nthreads;
+    mystring        shard;
+    mystring        cachedir;
     bool            suppress = true;    //suppress warnings
+    int             valTHREADS = 1;     //number of threads to search with
+    int             valSHARD = 0;       //number of the shard of the database to search
+    int             valNOSHARDS = 0;    //number of shards; 0, whole database is searched
+    char*           paux;
 
 
     SetGlobalProgName( argv[0], version );
@@ -50,19 +61,26 @@ int main( int argc, char *argv[] )
         int option_index = 0;
         static struct option long_options[] = {
             {"i",       required_argument, 0, 'i'},
+            {"l",       required_argument, 0, 'l'},
             {"d",       required_argument, 0, 'd'},
             {"o",       required_argument, 0, 'o'},
             {"p",       required_argument, 0, 'p'},
+            {"t",       required_argument, 0, 't'},
+            {"threads", required_argument, 0, 't'},
+            {"s",       required_argument, 0, 's'},
+            {"shard",   required_argument, 0, 's'},
+            {"c",       required_argument, 0, 'c'},
+            {"cache",   required_argument, 0, 'c'},
             { 0, 0, 0, 0 }
         };
         if(( c = getopt_long_only(
                     argc, argv,
-                    "hi:d:o:p:v",
+                    "hi:l:d:o:p:t:s:c:v",
                     long_options,
                     &option_index )) == -1 )
             break;
 #else
-        if(( c = getopt( argc, argv, "hi:d:o:p:v" )) == -1 )
+        if(( c = getopt( argc, argv, "hi:l:d:o:p:t:s:c:v" )) == -1 )
             break;
 #endif
         switch( c ) {
@@ -72,9 +90,13 @@ int main( int argc, char *argv[] )
             case 'h':   fprintf( stdout, "%s", usage( argv[0], instructions, version, verdate ).c_str());   return EXIT_SUCCESS;
 
             case 'i':   input       = optarg;       break;
+            case 'l':   querylist   = optarg;       break;
             case 'd':   database    = optarg;       break;
             case 'o':   output      = optarg;       break;
             case 'p':   optfile     = optarg;       break;
+            case 't':   nthreads    = optarg;       break;
+            case 's':   shard       = optarg;       break;
+            case 'c':   cachedir    = optarg;       break;
 
             case 'v':   suppress    = false;        break;
             default:    break;
@@ -83,16 +105,43 @@ int main( int argc, char *argv[] )
 
     SetQuiet( suppress );
 
+    if( !nthreads.empty()) {
+        errno = 0;
+        valTHREADS = strtol( nthreads.c_str(), &paux, 10 );
+        if( errno || *paux || valTHREADS <= 0 ) {
+            error( "Number of threads is invalid." );
+            return EXIT_FAILURE;
+        }
+    }
 
-    if( input.empty() && !database.empty()) {
+    if( !shard.empty()) {
+        errno = 0;
+        valSHARD = strtol( shard.c_str(), &paux, 10 );
+        if( errno || *paux != '/' || valSHARD <= 0 ) {
+            error( "Shard of the database is invalid: k/N with 1 <= k <= N expected." );
+            return EXIT_FAILURE;
+        }
+        valNOSHARDS = strtol( paux + 1, &paux, 10 );
+        if( errno || *paux || valNOSHARDS < valSHARD ) {
+            error( "Shard of the database is invalid: k/N with 1 <= k <= N expected." );
+            return EXIT_FAILURE;
+        }
+    }
+
+
+    if( !input.empty() && !querylist.empty()) {
+        error( "Input file and list of queries are mutually exclusive." );
+        return EXIT_FAILURE;
+    }
+    if( input.empty() && querylist.empty() && !database.empty()) {
         error( "Input multiple alignment file is not specified." );
         return EXIT_FAILURE;
     }
-    if( !input.empty() && database.empty()) {
+    if(( !input.empty() || !querylist.empty()) && database.empty()) {
         error( "Database is not specified." );
         return EXIT_FAILURE;
     }
-    if( input.empty() && database.empty()) {
+    if( input.empty() && querylist.empty() && database.empty()) {
         fprintf( stdout, "%s", usage( argv[0], instructions, version, verdate ).c_str());
         return EXIT_FAILURE;
     }
@@ -193,6 +242,9 @@ int main( int argc, char *argv[] )
     int             valHSPMAXDIST = options.GetHSPMAXDIST();
     int             valNOHSPS = options.GetNOHSPS();
 
+    double          valIDXWORDSCORE = options.GetIDXWORDSCORE();
+    int             valIDXNOSEEDS = options.GetIDXNOSEEDS();
+
     options.GetOPENCOST( &intOPENCOST, &boolAutoOpenCost );
     if( !boolAutoOpenCost )
         fixedOPENCOST = intOPENCOST;
@@ -218,6 +270,10 @@ int main( int argc, char *argv[] )
         error( "Global scoring scheme is not compatible with floating-point precision." );
         return EXIT_FAILURE;
     }
+    if( method == AbstractScoreMatrix::Universal && valNOSHARDS ) {
+        error( "Global scoring scheme is not compatible with searching a shard of the database." );
+        return EXIT_FAILURE;
+    }
 
     // -- statistical behaviour --
 
@@ -308,6 +364,9 @@ int main( int argc, char *argv[] )
 
     sprintf( strbuf, "HSPLEN = %d, HSPMINSCORE = %d, HSPMAXDIST = %d, NOHSPS = %d",
                     valHSPLEN, valHSPMINSCORE, valHSPMAXDIST, valNOHSPS );
+    message( strbuf, false );
+
+    sprintf( strbuf, "IDXWORDSCORE = %.1f, IDXNOSEEDS = %d", valIDXWORDSCORE, valIDXNOSEEDS );
     message( strbuf );
 
     // --
@@ -319,85 +378,128 @@ int main( int argc, char *argv[] )
 
     int                 ret = EXIT_SUCCESS;
     ProfileSearching*   searching = NULL;
-
-    try {
-        searching = new ProfileSearching(
-                    insparamfile.c_str(),
-                    input.c_str(),
-                    database.c_str(),
-                    output.c_str(),
-                    valEVAL,
-                    valNOHITS,
-                    valNOALNS,
-                    valIDENTITY,
-                    valINFCON,
-                    valSCALEDOWN,
-                    fixedOPENCOST,
-                    valEXTCOST,
-                    valSHOW,
-                    !valUSEGCPROBS,
-                    method,
-                    behaviour,
-                    precision,
-                    masking
-        );
-
-        if( !searching ) {
+    ProfileSearching**  searches = NULL;
+    mystring*           queries = NULL;
+    mystring*           outputs = NULL;
+    int                 noqueries = 0;
+    int                 n;
+
+    if( querylist.empty()) {
+        queries = new mystring[1];
+        outputs = new mystring[1];
+        if( !queries || !outputs ) {
             error( "Not enough memory." );
             return EXIT_FAILURE;
         }
+        queries[0] = input;
+        outputs[0] = output;
+        noqueries = 1;
+    }
+    else if( !ReadQueryList( querylist, output, &queries, &outputs, &noqueries ))
+        return EXIT_FAILURE;
 
-        searching->SetAutoGapCosts( boolAutoOpenCost, intOPENCOST );
-        searching->SetComputeDELETEstates( valDELSTATE );
-        searching->SetDeletionCoefficient( valDELPROBWEIGHT );
-
-        searching->SetExtentMinWindow( valMINALNPOS );
-        searching->SetExtentMinSeqPercentage( valMINALNFRN );
-        searching->SetPseudoCountWeight( valPCFWEIGHT );
-
-        searching->SetGapProbabFactorEvalue( valGPROBEVAL );
-        searching->SetGapProbabFactorWeight( valGPFARGWEIGHT );
-        searching->SetGapProbabFactorShift( valGPFARGSHIFT );
-
-        searching->SetAutocorrectionPositional( valANPOSCOR );
-        searching->SetAutoACcorrection( !valPROHIBITCOR );
-        searching->SetAutocorrectionNumerator1st( valAC1NUMER );
-        searching->SetAutocorrectionNumerator2nd( valAC2UBNUMER );
-        searching->SetAutocorrectionLogScale( valAC2LOGSCALE );
-        searching->SetAutocorrectionDenomScale( valAC2DENOMSCALE );
-
-        searching->SetInfoCorrectionUpperBound2nd( valINFCON2UB );
-        searching->SetInfoCorrectionNumerator2nd( valINFCON2NUMER );
-        searching->SetInfoCorrectionScale2nd( valINFCON2LOGSCALE );
-        searching->SetInfoCorrectionNumeratorAlt( valINFCONALTNUMER );
-        searching->SetInfoCorrectionScaleAlt( valINFCONALTLOGSCALE );
-
-        searching->SetHSPLength( valHSPLEN );
-        searching->SetHSPScore( valHSPMINSCORE );
-        searching->SetHSPDistance( valHSPMAXDIST );
-        searching->SetHSPNoHSPs( valNOHSPS );
-
-        if( valHCFILTER )
-            searching->SetHCParameters(
-                valHCWINDOW,
-                valHCLOWENT,
-                valHCHIGHENT
-            );
-        if( valINVLCFILTER )
-            searching->SetSegParameters(
-                valLCWINDOW,
-                valLCLOWENT,
-                valLCHIGHENT,
-                valDISTANCE
-            );
-        if( valLCFILTEREACH )
-            searching->SetSeqSegParameters(
-                valLCWINDOW,
-                valLCLOWENT,
-                valLCHIGHENT
+    searches = ( ProfileSearching** )malloc( sizeof( void* ) * noqueries );
+    if( !searches ) {
+        error( "Not enough memory." );
+        return EXIT_FAILURE;
+    }
+    memset( searches, 0, sizeof( void* ) * noqueries );
+
+    try {
+        for( n = 0; n < noqueries; n++ ) {
+            searching = searches[n] = new ProfileSearching(
+                        insparamfile.c_str(),
+                        queries[n].c_str(),
+                        database.c_str(),
+                        outputs[n].c_str(),
+                        valEVAL,
+                        valNOHITS,
+                        valNOALNS,
+                        valIDENTITY,
+                        valINFCON,
+                        valSCALEDOWN,
+                        fixedOPENCOST,
+                        valEXTCOST,
+                        valSHOW,
+                        !valUSEGCPROBS,
+                        method,
+                        behaviour,
+                        precision,
+                        masking
             );
 
-        searching->Run();
+            if( !searching )
+                throw myruntime_error( mystring( "Not enough memory." ));
+
+            searching->SetAutoGapCosts( boolAutoOpenCost, intOPENCOST );
+            searching->SetComputeDELETEstates( valDELSTATE );
+            searching->SetDeletionCoefficient( valDELPROBWEIGHT );
+
+            searching->SetExtentMinWindow( valMINALNPOS );
+            searching->SetExtentMinSeqPercentage( valMINALNFRN );
+            searching->SetPseudoCountWeight( valPCFWEIGHT );
+
+            searching->SetGapProbabFactorEvalue( valGPROBEVAL );
+            searching->SetGapProbabFactorWeight( valGPFARGWEIGHT );
+            searching->SetGapProbabFactorShift( valGPFARGSHIFT );
+
+            searching->SetAutocorrectionPositional( valANPOSCOR );
+            searching->SetAutoACcorrection( !valPROHIBITCOR );
+            searching->SetAutocorrectionNumerator1st( valAC1NUMER );
+            searching->SetAutocorrectionNumerator2nd( valAC2UBNUMER );
+            searching->SetAutocorrectionLogScale( valAC2LOGSCALE );
+            searching->SetAutocorrectionDenomScale( valAC2DENOMSCALE );
+
+            searching->SetInfoCorrectionUpperBound2nd( valINFCON2UB );
+            searching->SetInfoCorrectionNumerator2nd( valINFCON2NUMER );
+            searching->SetInfoCorrectionScale2nd( valINFCON2LOGSCALE );
+            searching->SetInfoCorrectionNumeratorAlt( valINFCONALTNUMER );
+            searching->SetInfoCorrectionScaleAlt( valINFCONALTLOGSCALE );
+
+            searching->SetHSPLength( valHSPLEN );
+            searching->SetHSPScore( valHSPMINSCORE );
+            searching->SetHSPDistance( valHSPMAXDIST );
+            searching->SetHSPNoHSPs( valNOHSPS );
+
+            searching->SetIndexWordScore( valIDXWORDSCORE );
+            searching->SetIndexNoSeeds( valIDXNOSEEDS );
+
+            searching->SetNoThreads( valTHREADS );
+
+            if( valNOSHARDS )
+                searching->SetShard( valSHARD - 1, valNOSHARDS );
+
+            if( !cachedir.empty())
+                searching->SetCacheDirectory( cachedir.c_str());
+
+            if( valHCFILTER )
+                searching->SetHCParameters(
+                    valHCWINDOW,
+                    valHCLOWENT,
+                    valHCHIGHENT
+                );
+            if( valINVLCFILTER )
+                searching->SetSegParameters(
+                    valLCWINDOW,
+                    valLCLOWENT,
+                    valLCHIGHENT,
+                    valDISTANCE
+                );
+            if( valLCFILTEREACH )
+                searching->SetSeqSegParameters(
+                    valLCWINDOW,
+                    valLCLOWENT,
+                    valLCHIGHENT
+                );
+        }
+
+        if( noqueries == 1 )
+            searching->Run();
+        else {
+            BatchSearching  batch( searches, noqueries );
+            batch.SetNoThreads( valTHREADS );
+            batch.Run();
+        }
 
     } catch( myexception const& ex )
     {
@@ -405,8 +507,13 @@ int main( int argc, char *argv[] )
         ret = EXIT_FAILURE;
     }
 
-    if( searching )
-        delete searching;
+    for( n = 0; n < noqueries; n++ )
+        if( searches[n] )
+            delete searches[n];
+
+    free( searches );
+    delete[] queries;
+    delete[] outputs;
 
     return ret;
 }
@@ -543,3 +650,91 @@ bool GetMasking(
     return true;
 }
 
+
+// -------------------------------------------------------------------------
+// ReadQueryList: reads filenames of queries, one per line, from the file
+//     given; output filenames are made of the output directory and the
+//     basename of each query; an ordinal is inserted in the filename of
+//     output if it is taken by a preceding query (same basename in
+//     another directory)
+// -------------------------------------------------------------------------
+
+bool ReadQueryList(
+    const mystring& listname,
+    const mystring& outdir,
+    mystring**      queries,
+    mystring**      outputs,
+    int*            noqueries )
+{
+    char        buffer[BUF_MAX];
+    FILE*       fp = NULL;
+    mystring    base;
+    size_t      len;
+    int         count = 0;
+    int         pass, n, p, k;
+
+    if( !queries || !outputs || !noqueries )
+        return false;
+
+    fp = fopen( listname.c_str(), "r" );
+    if( !fp ) {
+        error( "Failed to open file of queries." );
+        return false;
+    }
+
+    //count queries first, then read them
+    for( pass = 0; pass < 2; pass++ ) {
+        n = 0;
+        rewind( fp );
+        while( fgets( buffer, BUF_MAX, fp )) {
+            for( len = strlen( buffer ); len && ( buffer[len-1] == '\n' || buffer[len-1] == '\r' ||
+                    buffer[len-1] == ' ' || buffer[len-1] == '\t' ); len-- );
+            buffer[len] = 0;
+            if( !len || *buffer == '#' )
+                continue;
+            if( pass ) {
+                (*queries)[n] = buffer;
+                (*outputs)[n] = outdir.empty()? ".": outdir.c_str();
+                (*outputs)[n] += DIRSEPSTR;
+                (*outputs)[n] += my_basename( buffer );
+                (*outputs)[n] += ".out";
+            }
+            n++;
+        }
+        if( !pass ) {
+            count = n;
+            if( count <= 0 ) {
+                fclose( fp );
+                error( "No queries found in the file of queries." );
+                return false;
+            }
+            *queries = new mystring[count];
+            *outputs = new mystring[count];
+            if( !*queries || !*outputs ) {
+                fclose( fp );
+                error( "Not enough memory." );
+                return false;
+            }
+        }
+    }
+
+    fclose( fp );
+
+    //make output filenames unique
+    for( n = 1; n < count; n++ ) {
+        base = (*outputs)[n].substr( 0, (*outputs)[n].length() - strlen( ".out" ));
+        for( k = 2, p = 0; p < n; p++ ) {
+            if( (*outputs)[p] != (*outputs)[n] )
+                continue;
+            sprintf( buffer, ".%d.out", k++ );
+            (*outputs)[n] = base + buffer;
+            p = -1;//verify the new name against all preceding ones
+        }
+        if( 2 < k )
+            warning(( mystring( "Output of query " ) + (*queries)[n] +
+                    " written to " + (*outputs)[n] + " as the name is taken." ).c_str());
+    }
+
+    *noqueries = count;
+    return true;
+}
@@ -85,9 +85,15 @@
 // 1.02 . file of options added
 // 1.05 . format changed: new section of background probabilities
 // 1.10 . optimization of profile's target frequencies implemented
+// 1.11 . multithreaded searching of the database
+// 1.12 . batch searching of a number of queries in one pass over the database
+// 1.13 . profiles of the database prefiltered by the column-word index
+// 1.14 . searching of a shard of the database; partial hit lists merged by coma-merge
+// 1.15 . probabilities of scores of the global score system computed by multiple threads
+// 1.16 . global score systems cached on disk by fingerprints of query, database and options
 
 
-static const char*  version = "1.10";
+static const char*  version = "1.16";
 static const char*  verdate = "";
 
 
@@ -99,18 +105,41 @@ A protein sequence profile comparison and alignment searching tool.\n\
 (C)2010 Mindaugas Margelevicius,Institute of Biotechnology,Vilnius\n\
 \n\
 Usage:\n\
-<> -i <query> -d <database> [-o <output>] [-p <options>]\n\
+<> -i <query> -d <database> [-o <output>] [-p <options>] [-t <threads>] [-s <k/N>] [-c <directory>]\n\
+<> -l <list> -d <database> [-o <directory>] [-p <options>] [-t <threads>] [-s <k/N>] [-c <directory>]\n\
 \n\
 Parameters:\n\
 \n\
 -i <query>      [Filename]  Either multiple alignment file in fasta or\n\
                             profile made by makepro.\n\
+-l <list>       [Filename]  File of queries, one filename per line;\n\
+                            The database is read once for all of them.\n\
 -d <database>   [Filename]  Either name of database made by makedb or\n\
                             another multiple alignment file.\n\
--o <output>     [Filename]  Output file of alignments.\n\
+-o <output>     [Filename]  Output file of alignments;\n\
+                            With -l, directory to write outputs to,\n\
+                            named <query>.out (default = .); queries\n\
+                            of the same name get <query>.<k>.out,\n\
+                            k = 2, 3, ..., in order of the list.\n\
 -p <options>    [Filename]  Input file of options;\n\
                             By default, file in configuration\n\
                             directory of this package is searched.\n\
+-t <threads>    [Integer]   Number of threads to search the database with;\n\
+                            with the global score system, number of\n\
+                            threads to compute the score system with.\n\
+                            (default = 1)\n\
+-s <k/N>        [Int/Int]   Search k-th of N equal parts of the database\n\
+                            (--shard); parts are numbered from 1, e.g.\n\
+                            -s 1/3 searches the first third; e-values\n\
+                            are computed for the whole database, and the\n\
+                            output is a partial hit list to be merged by\n\
+                            coma-merge. Not available with the global\n\
+                            score system, whose state depends on all\n\
+                            the profiles searched before.\n\
+-c <directory>  [Dirname]   Directory of cached global score systems\n\
+                            (--cache); the score system scaled for the\n\
+                            same query, database, and options is read\n\
+                            from it instead of being computed again.\n\
 \n\
 -v                          Enable warnings.\n\
 -h                          This text.\n\
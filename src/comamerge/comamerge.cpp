@@ -0,0 +1,110 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Mindaugas Margelevicius                         *
+ *   Institute of Biotechnology, Vilnius                                   *
+ *   minmar@ibt.lt                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <getopt.h>
+#include <stdlib.h>
+
+#include "rc.h"
+#include "comamerge.h"
+#include "PartialHitList.h"
+
+
+
+int main( int argc, char *argv[] )
+{
+    //string values of the parameters
+    mystring        output;
+    bool            suppress = true;    //suppress output
+    int             c;
+
+    SetGlobalProgName( argv[0], version );
+
+    if( argc <= 1 ) {
+        fprintf( stdout, "%s", usage( argv[0], mergeinst, version, verdate ).c_str());
+        return EXIT_SUCCESS;
+    }
+
+    while( 1 ) {
+#ifdef USE_GETOPT_LONG
+        int option_index = 0;
+        static struct option long_options[] = {
+            {"o",       required_argument, 0, 'o'},
+            {"v",       no_argument,       0, 'v'},
+            { 0, 0, 0, 0 }
+        };
+        if(( c = getopt_long_only( argc, argv, "hvo:", long_options, &option_index )) == -1 )
+            break;
+#else
+        if(( c = getopt( argc, argv, "hvo:" )) == -1 )
+            break;
+#endif
+
+        switch( c ) {
+            case ':':   fprintf( stdout, "No parameter value.\n%s",
+                                                usage( argv[0], mergeinst, version, verdate ).c_str());  return EXIT_FAILURE;
+            case '?':   fprintf( stdout, "%s",  usage( argv[0], mergeinst, version, verdate ).c_str());  return EXIT_FAILURE;
+            case 'h':   fprintf( stdout, "%s",  usage( argv[0], mergeinst, version, verdate ).c_str());  return EXIT_SUCCESS;
+
+            case 'o':   output       = optarg;      break;
+
+            case 'v':   suppress     = false;       break;
+            default:    break;
+        }
+    }
+
+    SetQuiet( suppress );
+
+    if( argc <= optind ) {
+        error( "Partial hit lists are not specified." );
+        return EXIT_FAILURE;
+    }
+
+
+    try {
+        PartialHitList  merged;
+        PartialHitList  partial;
+        FILE*           fp = stdout;
+
+        merged.Read( argv[optind] );
+
+        for( int n = optind + 1; n < argc; n++ ) {
+            partial.Read( argv[n] );
+            merged.Merge( partial );
+        }
+
+        if( !merged.GetComplete()) {
+            error( "Partial hit lists of some shards are missing." );
+            return EXIT_FAILURE;
+        }
+
+        if( !output.empty())
+            fp = fopen( output.c_str(), "w" );
+
+        if( fp == NULL ) {
+            error( "Failed to open file for writing." );
+            return EXIT_FAILURE;
+        }
+
+        merged.Print( fp );
+
+        if( fp != stdout )
+            fclose( fp );
+
+    } catch( myexception const& ex )
+    {
+        error( ex.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
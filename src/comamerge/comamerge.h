@@ -0,0 +1,47 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Mindaugas Margelevicius                         *
+ *   Institute of Biotechnology, Vilnius                                   *
+ *   minmar@ibt.lt                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef __comamerge_h__
+#define __comamerge_h__
+
+// Version history:
+//
+// 1.00 . merging of partial hit lists of the shards of the database
+
+
+static const char*  version = "1.00";
+static const char*  verdate = "";
+
+static const char*  mergeinst = "\n\
+<>\n\
+\n\
+A program to merge partial hit lists of coma searches of the shards\n\
+of a database into the output of the search of the whole database.\n\
+(C)2008 Mindaugas Margelevicius,Institute of Biotechnology,Vilnius\n\
+\n\
+\n\
+Usage:\n\
+<> [-o <output>] <partial1> <partial2> ...\n\
+\n\
+Parameters:\n\
+\n\
+-o <output>     [Filename]  Output file of alignments.\n\
+                            (default = standard output)\n\
+<partial>       [Filename]  Partial hit list made by coma -s <k/N>;\n\
+                            lists of all N shards are to be given.\n\
+\n\
+Startup:\n\
+-v                          Enable warnings.\n\
+-h                          This text.\n\
+\n\
+Examples:\n\
+<> -o my_query.out my_query.1 my_query.2 my_query.3\n\
+\n\
+";
+
+#endif//__comamerge_h__
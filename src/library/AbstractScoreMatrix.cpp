@@ -17,10 +17,6 @@
 #include "AttributableScoresFPI.h"
 
 
-size_t AbstractScoreMatrix::deltaLength = 0;    //initialize length adjustment to zero at first
-Uint64 AbstractScoreMatrix::searchSpace = 0;    //equal search space to zero at initialization
-Uint64 AbstractScoreMatrix::raw_search_space = 0;//raw search space
-
 // -------------------------------------------------------------------------
 // constructor: initializing members to the default values
 // -------------------------------------------------------------------------
@@ -72,10 +68,12 @@ AbstractScoreMatrix::AbstractScoreMatrix(
 
     querySize( 0 ),
     subjectSize( 0 ),
+    sbjct_capacity( 0 ),
 
     supportoptfreq_( false ),
 
-    configuration( config )
+    configuration( config ),
+    context( NULL )
 {
     InitializeSSParameters();
 }
@@ -92,22 +90,25 @@ void AbstractScoreMatrix::Init( int sz_query, int sz_sbjct )
     bool    keep_in_memory = ( 0 < GetQuerySize() ) && ( 0 < GetSubjectSize());
 
     if( keep_in_memory ) {
-        image = ( double** )malloc( sizeof( double* ) * subjectSize );
-        mask = ( TMask** )malloc( sizeof( TMask* ) * subjectSize );
+        //rows of each matrix follow the table of row addresses in one block
+        image = ( double** )malloc( sizeof( double* ) * subjectSize + sizeof( double ) * subjectSize * querySize );
+        mask = ( TMask** )malloc( sizeof( TMask* ) * subjectSize + sizeof( TMask ) * subjectSize * querySize );
 
         if( !image || !mask )
             throw myruntime_error( mystring( "AbstractScoreMatrix: Not enough memory." ));
 
-        for( int m = 0; m < subjectSize; m++ ) {
-            image[m] = ( double* )malloc( sizeof( double ) * querySize );
-            mask[m] = ( TMask* )malloc( sizeof( TMask ) * querySize );
-
-            if( !image[m] || !mask[m] )
-                throw myruntime_error( mystring( "AbstractScoreMatrix: Not enough memory." ));
+        image[0] = ( double* )( image + subjectSize );
+        mask[0] = ( TMask* )( mask + subjectSize );
 
-            memset( image[m], 0, sizeof( double ) * querySize );
-            memset( mask[m], 0, sizeof( TMask ) * querySize );
+        for( int m = 1; m < subjectSize; m++ ) {
+            image[m] = image[m-1] + querySize;
+            mask[m] = mask[m-1] + querySize;
         }
+
+        memset( image[0], 0, sizeof( double ) * subjectSize * querySize );
+        memset( mask[0], 0, sizeof( TMask ) * subjectSize * querySize );
+
+        sbjct_capacity = subjectSize;
     }
 
     if( GetFPScaling())
@@ -161,6 +162,66 @@ void AbstractScoreMatrix::Init( int sz_query, int sz_sbjct )
     }
 }
 
+// -------------------------------------------------------------------------
+// Reinit: reinitializes the score system for another subject of the given
+//     size; the matrices are reallocated only if the subject is longer
+//     than any before; values computed for the previous subject are reset
+// -------------------------------------------------------------------------
+
+void AbstractScoreMatrix::Reinit( int sz_sbjct )
+{
+    if( !image || !mask || !corres_scores || sz_sbjct < 1 )
+        throw myruntime_error( mystring( "AbstractScoreMatrix: Unable to reinitialize score system." ));
+
+    if( sbjct_capacity < sz_sbjct ) {
+        free( image );
+        free( mask );
+        sbjct_capacity = 0;
+
+        image = ( double** )malloc( sizeof( double* ) * sz_sbjct + sizeof( double ) * sz_sbjct * querySize );
+        mask = ( TMask** )malloc( sizeof( TMask* ) * sz_sbjct + sizeof( TMask ) * sz_sbjct * querySize );
+
+        if( !image || !mask )
+            throw myruntime_error( mystring( "AbstractScoreMatrix: Not enough memory." ));
+
+        sbjct_capacity = sz_sbjct;
+    }
+
+    SetSubjectSize( sz_sbjct );
+
+    image[0] = ( double* )( image + sbjct_capacity );
+    mask[0] = ( TMask* )( mask + sbjct_capacity );
+
+    for( int m = 1; m < subjectSize; m++ ) {
+        image[m] = image[m-1] + querySize;
+        mask[m] = mask[m-1] + querySize;
+    }
+
+    //all scores are written when computed, whereas masks are set only
+    //at masked positions
+    memset( mask[0], 0, sizeof( TMask ) * subjectSize * querySize );
+
+    score_multiplier = 1.0;
+    prescore = 0.0;
+    prexpect = 10.0;
+    min_score = 0;
+    max_score = 0;
+    expscore = 0.0;
+    allnegatives = false;
+    derivedGappedLambda = -1.0;
+    derivedGappedK = -1.0;
+    lambda = -1.0;
+    entropy = 0.0;
+    parameterK = -1.0;
+
+    InitializeSSParameters();
+
+    corres_scores->Rebind( GetImage(), GetMask(), GetQuerySize(), GetSubjectSize());
+
+    if( scaled_scores )
+        scaled_scores->Rebind( GetImage(), GetMask(), GetQuerySize(), GetSubjectSize());
+}
+
 // -------------------------------------------------------------------------
 // default constructor is invalid for initialization
 // -------------------------------------------------------------------------
@@ -202,6 +263,7 @@ AbstractScoreMatrix::AbstractScoreMatrix()
 
     querySize( 0 ),
     subjectSize( 0 ),
+    sbjct_capacity( 0 ),
 
     supportoptfreq_( false ),
 
@@ -223,19 +285,11 @@ AbstractScoreMatrix::~AbstractScoreMatrix()
     if( scaled_scores )
         delete scaled_scores;
 
-    if( image ){
-        for( int m = 0; m < subjectSize; m++ )
-            if( image[m] )
-                free( image[m] );
+    if( image )
         free( image );
-    }
 
-    if( mask ){
-        for( int m = 0; m < subjectSize; m++ )
-            if( mask[m] )
-                free( mask[m] );
+    if( mask )
         free( mask );
-    }
 }
 
 // -------------------------------------------------------------------------
@@ -330,6 +384,31 @@ bool AbstractScoreMatrix::ScanForHSPs(
     return bret;
 }
 
+// -------------------------------------------------------------------------
+// PrescanForHSPs: performs verification of multiple high-scoring pairs
+//     in the same diagonal before the score matrix is computed; scores are
+//     computed row by row and are not saved; returns true if such hsps
+//     have been found or if the scores cannot be computed on the fly
+// -------------------------------------------------------------------------
+
+bool AbstractScoreMatrix::PrescanForHSPs(
+    double minhspscore, int hsplen, int nohsps, int maxdist,
+    int* possbjct, int* posquery )
+{
+    if( !IsValid())
+        throw myruntime_error( mystring( "Scan of HSPs failed: no score matrix." ));
+    if( !GetScaledScores() || !GetCorresScores())
+        throw myruntime_error( mystring( "PrescanForHSPs: Memory access error." ));
+
+    if( GetAutoScaling())
+        return GetScaledScores()->PrescanForHSPs(
+            minhspscore * GetScaledScores()->GetAutoScalingFactor(),
+            hsplen, nohsps, maxdist,
+            possbjct, posquery );
+
+    return GetCorresScores()->PrescanForHSPs( minhspscore, hsplen, nohsps, maxdist, possbjct, posquery );
+}
+
 // -------------------------------------------------------------------------
 // ComputeStatisticalParameters: implies computation of all the required
 //     statistical parameters
@@ -436,6 +515,47 @@ void AbstractScoreMatrix::MultiplierProgress( AttributableScores* PATTR_SCORES )
     SetMultiplier(  PATTR_SCORES->GetPrivateMultiplier());
 }
 
+// -------------------------------------------------------------------------
+// GetScaledParameters: get the parameters the scaling of the score
+//     system results in
+// -------------------------------------------------------------------------
+
+void AbstractScoreMatrix::GetScaledParameters( TScaledParameters* params ) const
+{
+    if( params == NULL )
+        throw myruntime_error( mystring( "AbstractScoreMatrix: Unable to get scaled parameters." ));
+
+    params->multiplier = GetMultiplier();
+    params->lambda = GetLambda();
+    params->entropy = GetEntropy();
+    params->parameterK = GetK();
+    params->expscore = GetExpectedScore();
+    params->gappedLambda = GetDerivedGappedLambda();
+    params->gappedK = GetDerivedGappedK();
+    params->minscore = ( Int64 )GetMinScore();
+    params->maxscore = ( Int64 )GetMaxScore();
+    params->allnegatives = ( Int64 )GetAllNegatives();
+}
+
+// -------------------------------------------------------------------------
+// SetScaledParameters: restore the parameters of the score system
+//     obtained by scaling before, so that the scaling can be omitted
+// -------------------------------------------------------------------------
+
+void AbstractScoreMatrix::SetScaledParameters( const TScaledParameters& params )
+{
+    SetMultiplier(          params.multiplier );
+    SetLambda(              params.lambda );
+    SetEntropy(             params.entropy );
+    SetK(                   params.parameterK );
+    SetExpectedScore(       params.expscore );
+    SetDerivedGappedLambda( params.gappedLambda );
+    SetDerivedGappedK(      params.gappedK );
+    SetMinScore(( TScore )params.minscore );
+    SetMaxScore(( TScore )params.maxscore );
+    SetAllNegatives( params.allnegatives != 0 );
+}
+
 // -------------------------------------------------------------------------
 // SetInfoThresholdByEval: sets information content threshold by e-value
 //     given
@@ -654,13 +774,16 @@ double AbstractScoreMatrix::GetMeanLengthGivenExpectation( double expect, double
 
 // -------------------------------------------------------------------------
 // ComputeLengthAdjustment: helper method for computation of length
-//     adjustment to edge-effect correction
+//     adjustment to edge-effect correction; results are saved in the
+//     search context
 // -------------------------------------------------------------------------
 
 bool AbstractScoreMatrix::ComputeLengthAdjustment(
+    SearchContext& ctx,
     const Configuration& config, size_t query_len, Uint64 db_len, size_t no_sequences )
 {
     return ComputeLengthAdjustment(
+        ctx,
         config.GetLambda(), config.GetK(), config.GetAlpha(), config.GetBeta(),
         query_len, db_len, no_sequences );
 }
@@ -689,12 +812,13 @@ bool AbstractScoreMatrix::ComputeLengthAdjustment(
 // -------------------------------------------------------------------------
 
 bool AbstractScoreMatrix::ComputeLengthAdjustment(
+        SearchContext& ctx,
         double lambda, double K,    double alpha,       double beta,
         size_t m/*query_len*/,      Uint64 n/*db_len*/, size_t N/*no_sequences*/ )
 {
-    SetRawSearchSpace( m * n );
-    SetSearchSpace( m * n );
-    SetDeltaLength( 0 );
+    ctx.SetRawSearchSpace( m * n );
+    ctx.SetSearchSpace( m * n );
+    ctx.SetDeltaLength( 0 );
 
     if( lambda <= 0.0 || K <= 0.0 || N == 0 ) {
         return false;
@@ -763,8 +887,8 @@ bool AbstractScoreMatrix::ComputeLengthAdjustment(
         }
     }
     //if not converged, save the closest value to the solution
-    SetSearchSpace(( Uint64 )sspace );
-    SetDeltaLength(( size_t )min_length );
+    ctx.SetSearchSpace(( Uint64 )sspace );
+    ctx.SetDeltaLength(( size_t )min_length );
 
     return converged;
 }
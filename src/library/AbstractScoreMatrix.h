@@ -24,6 +24,7 @@
 #include "Configuration.h"
 #include "GapScheme.h"
 #include "DistributionMatrix.h"
+#include "SearchContext.h"
 
 
 //Types for masking of scores
@@ -35,6 +36,20 @@ enum TMask {
 
 #include "AttributableScores.h"
 
+//parameters of a score system obtained by scaling
+struct TScaledParameters {
+    double  multiplier;     //multiplier of scores
+    double  lambda;         //computed ungapped lambda
+    double  entropy;        //computed relative entropy
+    double  parameterK;     //computed ungapped parameter K
+    double  expscore;       //expected score per column pair
+    double  gappedLambda;   //derived gapped lambda
+    double  gappedK;        //derived gapped K
+    Int64   minscore;       //minimum score
+    Int64   maxscore;       //maximum score
+    Int64   allnegatives;   //whether scores are all negative
+};
+
 
 // extern double rint( double x );
 
@@ -79,6 +94,7 @@ public:
     void                SetDeletionCoefficient( double value )  { deletioncoeff = value; }
 
     double              GetInformationThreshold() const { return information_content; }
+    void                SetInformationThreshold( double value )     { information_content = value; }
     void                SetInfoThresholdByEval( double eval );
 
     bool                GetAutocorrectionPositional() const             { return  positcorrects; }
@@ -122,6 +138,8 @@ public:
     virtual int         GetSubjectSize() const          { return GetPrivateSecndSize(); }
                                                                     //perform search of HSPs
     bool                ScanForHSPs( double minhspscore, int hsplen, int nohsps, int maxdist, int* = NULL, int* = NULL );
+                                                                    //search of HSPs before the score matrix is computed
+    bool                PrescanForHSPs( double minhspscore, int hsplen, int nohsps, int maxdist, int* = NULL, int* = NULL );
 
     double              GetRefLambda() const            { return referenceLambda; }
     double              GetRefH() const                 { return referenceH; }
@@ -169,11 +187,16 @@ public:
 
     //STATIC public methods...
     static  bool        ComputeLengthAdjustment(                    //compute length adjustment to correct edge-effects
-                const Configuration& , size_t query_len, Uint64 db_len, size_t no_sequences );
+                SearchContext&, const Configuration& , size_t query_len, Uint64 db_len, size_t no_sequences );
+
+    const SearchContext*GetSearchContext() const                    { return context; }
+    void                SetSearchContext( const SearchContext* ctx ){ context = ctx; }
+
+    void                SetGivenK( double );                        //set value of K known for the score system
 
-    static  size_t      GetDeltaLength() { return deltaLength; }    //get the length adjustment value
-    static  Uint64      GetSearchSpace() { return searchSpace; }    //get the search space computed
-    static  Uint64      GetRawSearchSpace() { return raw_search_space; }
+    size_t              GetDeltaLength() const;                     //get the length adjustment value
+    Uint64              GetSearchSpace() const;                     //get the search space computed
+    Uint64              GetRawSearchSpace() const;
 
                                                                     //print table of statistical parameter values...
     void                PrintReferenceParameterTable( char* ) const;
@@ -183,6 +206,10 @@ public:
 
                                                         //compute positional probabilities of scores
     virtual void        ComputePositionalScoreProbs( AttributableScores* ) = 0;
+                                                        //tabulate scores with their weights in probabilities
+    virtual bool        TabulateScores( AttributableScores* )       { return false; }
+                                                        //compute rows of scores on the fly for the search of HSPs
+    virtual bool        ScanScoresForHSPs( AttributableScores* )    { return false; }
 
     const double* const         GetQueryInfContent() const;         //information contents corresponding query positions
     const double* const         GetSbjctInfContent() const;         //information contents corresponding subject positions
@@ -191,6 +218,7 @@ protected:
     explicit AbstractScoreMatrix();
 
     void                Init( int sz_query, int sz_sbjct );
+    void                Reinit( int sz_sbjct );                     //reinitialize for another subject reusing memory
     void                InitializeSSParameters();
 
     virtual double      GetScoreBase( int m, int n ) const;         //returns score at specified profile positions
@@ -199,8 +227,7 @@ protected:
 
     int                 GetPrivateQuerySize() const                 { return querySize;   }
     int                 GetPrivateSecndSize() const                 { return subjectSize; }
-
-    void                SetInformationThreshold( double value )     { information_content = value; }
+    int                 GetSubjectCapacity() const                  { return sbjct_capacity; }
 
     bool                GetMaskedUnmasked( int m, int n  ) const    { return GetMasked( m, n  ) == Unmasked; }
     bool                GetMaskedToIgnore( int m, int n  ) const    { return GetMasked( m, n  ) == MaskToIgnore; }
@@ -223,6 +250,9 @@ protected:
 
     void                SetMultiplier( double value )               { score_multiplier = value; }
 
+    void                GetScaledParameters( TScaledParameters* ) const;    //get parameters obtained by scaling
+    void                SetScaledParameters( const TScaledParameters& );    //restore parameters obtained by scaling
+
                                                         //compute probabilities of scores at each position
     virtual void        ComputeScoreProbabilities( AttributableScores* ) = 0;
 
@@ -255,13 +285,10 @@ private:
             double* L = NULL, double* K = NULL, double* H = NULL, double* A = NULL, double* B = NULL );
 
     static  bool        ComputeLengthAdjustment(    //compute length adjustment to correct edge-effects
+                SearchContext&,
                 double lambda, double K, double alpha, double beta,
                 size_t query_len, Uint64 db_len, size_t no_sequences );
 
-    static  void        SetDeltaLength( size_t value ) { deltaLength = value; } //save the length adjustment value
-    static  void        SetSearchSpace( Uint64 value ) { searchSpace = value; } //set the search space value
-    static  void        SetRawSearchSpace( Uint64 value )   { raw_search_space = value; }
-
 protected:
     const AttributableScores*   GetCorresScores() const             { return corres_scores; }
     AttributableScores*         GetCorresScores()                   { return corres_scores; }
@@ -323,18 +350,49 @@ private:
 
     int                 querySize;                  //length of query sequence (profile)
     int                 subjectSize;                //length of subject sequence (profile)
+    int                 sbjct_capacity;             //number of subject positions the matrices have space for
 
     bool                supportoptfreq_;            //supports optimization of target frequencies
 
     const Configuration*    configuration;          //parameter configuration
-
-    static  size_t      deltaLength;                //length adjustment for edge-effect correction
-    static  Uint64      searchSpace;                //search space computed taking into account deltaLength
-    static  Uint64      raw_search_space;           //raw search space without any corrections
+    const SearchContext*    context;                //parameters of the search this score system is used in
 };
 
 // INLINES ...
 
+// -------------------------------------------------------------------------
+// GetDeltaLength: length adjustment of the search; zero when the score
+//     system is used outside of a database search
+// -------------------------------------------------------------------------
+
+inline
+size_t AbstractScoreMatrix::GetDeltaLength() const
+{
+    if( !context )
+        return 0;
+    return context->GetDeltaLength();
+}
+
+// GetSearchSpace: effective search space
+//
+inline
+Uint64 AbstractScoreMatrix::GetSearchSpace() const
+{
+    if( !context )
+        return 0;
+    return context->GetSearchSpace();
+}
+
+// GetRawSearchSpace: search space without any corrections
+//
+inline
+Uint64 AbstractScoreMatrix::GetRawSearchSpace() const
+{
+    if( !context )
+        return 0;
+    return context->GetRawSearchSpace();
+}
+
 // -------------------------------------------------------------------------
 // IsValid: whether the class object is valid
 // -------------------------------------------------------------------------
@@ -538,6 +596,18 @@ void AbstractScoreMatrix::SetAllNegatives( bool value )
     allnegatives = value;
 }
 
+// -------------------------------------------------------------------------
+// SetGivenK: set value of parameter K computed for the score system
+//     before; the representative scores, which K is computed for, take it
+//     instead of computing it again; negative value to compute K
+// -------------------------------------------------------------------------
+
+inline
+void AbstractScoreMatrix::SetGivenK( double value )
+{
+    if( GetCorresScores()) GetCorresScores()->SetGivenK( value );
+}
+
 // -------------------------------------------------------------------------
 // GetConfiguration: returns reference to parameter configuration object
 // -------------------------------------------------------------------------
@@ -12,6 +12,8 @@
 
 #include "rc.h"
 #include "data.h"
+#include "HashFunctions.h"
+#include "Serializer.h"
 #include "FrequencyStore.h"
 #include "AbstractUniversalScoreMatrix.h"
 
@@ -20,34 +22,289 @@
 //fake scale factor used to indicate the termination
 const double AbstractUniversalScoreMatrix::fake_scale_factor = -1.0;
 
+//signature of serialized score system
+const char* AbstractUniversalScoreMatrix::signature = "COMA universal score system v1.1\n";
+
+
+//maximum range of scores kept in a dense array
+const size_t ScoreHistogram::max_dense_range = 256 * KBYTE;
 
 // =========================================================================
-// CLASS ScoreProbability
+// CLASS ScoreHistogram
 //
-// constructor: initialization of values
+// constructor: initialization
 // -------------------------------------------------------------------------
 
-ScoreProbability::ScoreProbability( double sc, double p )
-:   probb( p  )
+ScoreHistogram::ScoreHistogram()
+:   probs( NULL ),
+    scores( NULL ),
+    base( 0 ),
+    capacity( 0 ),
+    noscores( 0 ),
+    minscore( 0 ),
+    maxscore( 0 )
 {
-    SetScores( sc );
 }
 
 // -------------------------------------------------------------------------
-// constructor: default
+// copy constructor is not allowed
 //
 
-ScoreProbability::ScoreProbability()
-:   score( 0    ),
-    double_score( 0.0 ),
-    probb( 0.0  )
+ScoreHistogram::ScoreHistogram( const ScoreHistogram& )
 {
+    throw myruntime_error( mystring( "ScoreHistogram: Copying is not allowed." ));
 }
 
 // destructor:
 //
-ScoreProbability::~ScoreProbability()
+ScoreHistogram::~ScoreHistogram()
+{
+    Destroy();
+}
+
+// -------------------------------------------------------------------------
+// Destroy: deallocates memory of the histogram
+// -------------------------------------------------------------------------
+
+void ScoreHistogram::Destroy()
+{
+    if( probs )
+        free( probs );
+    if( scores )
+        free( scores );
+
+    probs = NULL;
+    scores = NULL;
+    base = 0;
+    capacity = noscores = 0;
+    minscore = maxscore = 0;
+}
+
+// -------------------------------------------------------------------------
+// Clear: clears the histogram; the dense array is kept for reuse, while
+//     the sparse representation is released
+// -------------------------------------------------------------------------
+
+void ScoreHistogram::Clear()
+{
+    if( scores ) {
+        Destroy();
+        return;
+    }
+    if( noscores )
+        memset( probs + ( minscore - base ), 0, sizeof( double ) * ( maxscore - minscore + 1 ));
+
+    noscores = 0;
+    minscore = maxscore = 0;
+}
+
+// -------------------------------------------------------------------------
+// ReallocDense: reallocates the dense array so that it begins with score
+//     newbase and has newcap elements; the array is to cover all scores
+//     observed
+// -------------------------------------------------------------------------
+
+void ScoreHistogram::ReallocDense( int newbase, size_t newcap )
+{
+    double* tmpprobs;
+
+    tmpprobs = ( double* )malloc( sizeof( double ) * newcap );
+    if( !tmpprobs )
+        throw myruntime_error( mystring( "ScoreHistogram: Not enough memory." ));
+
+    memset( tmpprobs, 0, sizeof( double ) * newcap );
+    if( noscores )
+        memcpy( tmpprobs + ( minscore - newbase ), probs + ( minscore - base ),
+                sizeof( double ) * ( maxscore - minscore + 1 ));
+
+    if( probs )
+        free( probs );
+    probs = tmpprobs;
+    base = newbase;
+    capacity = newcap;
+}
+
+// -------------------------------------------------------------------------
+// ReallocSparse: reallocates memory of the sparse representation
+// -------------------------------------------------------------------------
+
+void ScoreHistogram::ReallocSparse( size_t newcap )
+{
+    double* tmpprobs;
+    int*    tmpscores;
+
+    if( newcap <= capacity )
+        return;
+
+    tmpprobs = ( double* )realloc( probs, sizeof( double ) * newcap );
+    if( !tmpprobs )
+        throw myruntime_error( mystring( "ScoreHistogram: Not enough memory." ));
+    probs = tmpprobs;
+
+    tmpscores = ( int* )realloc( scores, sizeof( int ) * newcap );
+    if( !tmpscores )
+        throw myruntime_error( mystring( "ScoreHistogram: Not enough memory." ));
+    scores = tmpscores;
+
+    capacity = newcap;
+}
+
+// -------------------------------------------------------------------------
+// AddDense: adds probability of the score which is not covered by the
+//     dense array; the array is extended with reserve at the side of the
+//     score, or the histogram turns sparse if the range becomes too wide
+// -------------------------------------------------------------------------
+
+void ScoreHistogram::AddDense( int score, double prob )
+{
+    int     lower = score;
+    int     upper = score;
+    size_t  range, reserve, newcap;
+
+    if( !noscores && capacity ) {
+        //the array is empty: center it at the score
+        base = score - ( int )( capacity / 2 );
+        Add( score, prob );
+        return;
+    }
+
+    if( noscores ) {
+        if( minscore < lower ) lower = minscore;
+        if( upper < maxscore ) upper = maxscore;
+    }
+
+    range = ( size_t )(( Int64 )upper - ( Int64 )lower ) + 1;
+
+    if( max_dense_range < range ) {
+        MakeSparse();
+        AddSparse( score, prob );
+        return;
+    }
+
+    reserve = ( range < MAX_RANGE_OF_SCORES )? MAX_RANGE_OF_SCORES: range;
+    if( max_dense_range < range + reserve )
+        reserve = max_dense_range - range;
+    newcap = range + reserve;
+    if( newcap < capacity )
+        newcap = capacity;
+
+    if( !noscores )
+        ReallocDense( score - ( int )( newcap / 2 ), newcap );
+    else if( score < minscore )
+        //extend the array downwards
+        ReallocDense( upper - ( int )( newcap - 1 ), newcap );
+    else
+        ReallocDense( lower, newcap );
+
+    Add( score, prob );
+}
+
+// -------------------------------------------------------------------------
+// MakeSparse: moves the scores observed from the dense array to the
+//     sparse representation
+// -------------------------------------------------------------------------
+
+void ScoreHistogram::MakeSparse()
+{
+    double* tmpprobs = NULL;
+    int*    tmpscores = NULL;
+    size_t  newcap = noscores? noscores * 2: KBYTE;
+    size_t  n = 0;
+    int     sc;
+
+    if( scores )
+        return;
+
+    tmpprobs = ( double* )malloc( sizeof( double ) * newcap );
+    tmpscores = ( int* )malloc( sizeof( int ) * newcap );
+    if( !tmpprobs || !tmpscores ) {
+        if( tmpprobs ) free( tmpprobs );
+        if( tmpscores ) free( tmpscores );
+        throw myruntime_error( mystring( "ScoreHistogram: Not enough memory." ));
+    }
+
+    if( noscores )
+        for( sc = minscore; sc <= maxscore; sc++ )
+            if( 0.0 < probs[sc - base] ) {
+                tmpscores[n] = sc;
+                tmpprobs[n] = probs[sc - base];
+                n++;
+            }
+
+    if( probs )
+        free( probs );
+    probs = tmpprobs;
+    scores = tmpscores;
+    base = 0;
+    capacity = newcap;
+    noscores = n;
+    if( n ) {
+        minscore = scores[0];
+        maxscore = scores[n-1];
+    }
+}
+
+// -------------------------------------------------------------------------
+// FindSparse: finds the location of the score in the sparse arrays; if
+//     the score is not there, returns the location it is to be inserted at
+// -------------------------------------------------------------------------
+
+size_t ScoreHistogram::FindSparse( int score ) const
+{
+    size_t  left = 0;
+    size_t  right = noscores;
+    size_t  middle;
+
+    while( left < right ) {
+        middle = ( left + right ) >> 1;
+        if( scores[middle] < score )
+            left = middle + 1;
+        else
+            right = middle;
+    }
+    return left;
+}
+
+// -------------------------------------------------------------------------
+// AddSparse: adds probability of the score to the sparse representation
+// -------------------------------------------------------------------------
+
+void ScoreHistogram::AddSparse( int score, double prob )
+{
+    size_t  loc = FindSparse( score );
+
+    if( loc < noscores && scores[loc] == score ) {
+        probs[loc] += prob;
+        return;
+    }
+
+    if( capacity <= noscores )
+        ReallocSparse( capacity * 2 );
+
+    memmove( scores + loc + 1, scores + loc, sizeof( int ) * ( noscores - loc ));
+    memmove( probs + loc + 1, probs + loc, sizeof( double ) * ( noscores - loc ));
+    scores[loc] = score;
+    probs[loc] = 0.0;
+    probs[loc] += prob;
+
+    if( !noscores || score < minscore ) minscore = score;
+    if( !noscores || maxscore < score ) maxscore = score;
+    noscores++;
+}
+
+// -------------------------------------------------------------------------
+// Add: adds probabilities of the other histogram in the order of scores
+// -------------------------------------------------------------------------
+
+void ScoreHistogram::Add( const ScoreHistogram& other )
 {
+    double  prob;
+
+    for( size_t n = 0; n < other.GetNoSlots(); n++ ) {
+        prob = other.GetProbabilityAt( n );
+        if( 0.0 < prob )
+            Add( other.GetScoreAt( n ), prob );
+    }
 }
 
 
@@ -73,10 +330,12 @@ AbstractUniversalScoreMatrix::AbstractUniversalScoreMatrix(
     distribution( distrib ),
     cpu_preference( cpu )
 {
-    if( !store || !freqstore->GetFrequencies())
+    if( !store || !freqstore->GetSize())
             throw myruntime_error( mystring ( "AbstractUniversalScoreMatrix: No frequency vectors provided." ));
 
-    prob_calculator = new BinarySearchStructure( ScoreProbability::ScoreComparer, GetMaxElemsOfProbCalculator());
+    memset( fingerprints, 0, sizeof( Uint64 ) * NoPrints );
+
+    prob_calculator = new ScoreHistogram;
 
     if( prob_calculator == NULL )
             throw myruntime_error( mystring ( "AbstractUniversalScoreMatrix: Not enough memory." ));
@@ -95,6 +354,7 @@ AbstractUniversalScoreMatrix::AbstractUniversalScoreMatrix()
     distribution( DISCRETE ),
     cpu_preference( true )
 {
+    memset( fingerprints, 0, sizeof( Uint64 ) * NoPrints );
 }
 
 // -------------------------------------------------------------------------
@@ -103,36 +363,8 @@ AbstractUniversalScoreMatrix::AbstractUniversalScoreMatrix()
 
 AbstractUniversalScoreMatrix::~AbstractUniversalScoreMatrix()
 {
-    DestroyProbCalculator( prob_calculator );
-}
-
-// -------------------------------------------------------------------------
-// ClearProbCalculator: destroys members of ProbCalculator and
-//     re-initializes it
-// -------------------------------------------------------------------------
-
-void AbstractUniversalScoreMatrix::ClearProbCalculator( BinarySearchStructure* pc )
-{
-    if( pc ) {
-        for( size_t n = 0; n < pc->GetSize(); n++ )
-        {
-            const ScoreProbability* scp = ( const ScoreProbability* )( pc->GetValueAt( n ));
-            ScoreProbability::Destroy( scp );
-        }
-        pc->Clear();
-    }
-}
-
-// -------------------------------------------------------------------------
-// DestroyProbCalculator: destroys totally ProbCalculator
-// -------------------------------------------------------------------------
-
-void AbstractUniversalScoreMatrix::DestroyProbCalculator( BinarySearchStructure* pc )
-{
-    if( pc ) {
-        ClearProbCalculator( pc );
-        delete pc;
-    }
+    if( prob_calculator )
+        delete prob_calculator;
 }
 
 // -------------------------------------------------------------------------
@@ -160,45 +392,6 @@ void AbstractUniversalScoreMatrix::ComputeScoreProbabilities( AttributableScores
     }
 }
 
-// -------------------------------------------------------------------------
-//  Push: pushes probability structure to the private store of
-//     probabilities; 
-//     returns true if structure has been inserted and false if a
-//     probability for the same score is observed in the private store;
-//     in the latter case a new structure is not inserted but probability
-//     value is adjusted instead
-// -------------------------------------------------------------------------
-
-bool AbstractUniversalScoreMatrix::Push( const ScoreProbability* scp )
-{
-    //get storage for scores and probabilities...
-    BinarySearchStructure*  loc_probabilities = GetProbCalculator();
-
-    if( !loc_probabilities || !scp )
-        USM_THROW( "AbstractUniversalScoreMatrix: Unable to save probabilities." );
-
-    int     location = -1;
-    //push score and probability to the ordered structure
-    bool    inserted = loc_probabilities->Push( scp, &location );
-
-    if( inserted ) {
-        //score with probability has been inserted
-    } else {
-        //the pair has not been inserted: score has already been observed,
-        //update probability
-        ScoreProbability*   found;
-
-        if( location < 0 ||
-            ( found = ( ScoreProbability* )loc_probabilities->GetValueAt( location ) ) == NULL )
-            USM_THROW( "AbstractUniversalScoreMatrix: Fatal: Unable to access probability structure." );
-
-        //increase probability for this particular score value
-        found->IncProbability( scp->GetProbability());
-    }
-
-    return inserted;
-}
-
 // -------------------------------------------------------------------------
 //  ProcessScoreProbabilities: copies probabilities stored in
 //     prob_calculator, performs final computations related to
@@ -221,7 +414,9 @@ void AbstractUniversalScoreMatrix::ProcessScoreProbabilities( AttributableScores
         normterm = norm;
 
     //get storage for scores and probabilities...
-    BinarySearchStructure*  loc_probabilities = GetProbCalculator();
+    ScoreHistogram* loc_probabilities = GetProbCalculator();
+    double          prob;
+    int             sc;
 
 #ifdef __DEBUG__
     if( !loc_probabilities || normterm <= 0.0 )
@@ -234,24 +429,19 @@ void AbstractUniversalScoreMatrix::ProcessScoreProbabilities( AttributableScores
         USM_THROW( "AbstractUniversalScoreMatrix: No scores to compute probabilities for." );
 
     PATTR_SCORES->SetMinMaxScores(
-        //minimum score is at the begining; maximum score is at the end
-        (( const ScoreProbability* )loc_probabilities->GetValueAt( 0 ))->GetScore(),
-        (( const ScoreProbability* )loc_probabilities->GetValueAt( no_scores - 1 ))->GetScore()
+        loc_probabilities->GetMinScore(),
+        loc_probabilities->GetMaxScore()
     );
 
     //re-write probabilities to the newly allocated vector
-    for( int sc = PATTR_SCORES->GetMinScore(), loc_sc = 0; sc <= PATTR_SCORES->GetMaxScore(); sc++ )
+    for( size_t n = 0; n < loc_probabilities->GetNoSlots(); n++ )
     {
-        const ScoreProbability* scp = ( const ScoreProbability* )( loc_probabilities->GetValueAt( loc_sc ));
-        //ensure the scores are equal
-        if( scp->GetScore() != sc )
+        prob = loc_probabilities->GetProbabilityAt( n );
+        //omit empty slots
+        if( prob <= 0.0 )
             continue;
-        else
-            loc_sc++;
 
-        double  prob = scp->GetProbability();
-        //destroy the ScoreProbability structure, we don't need it any more
-        ScoreProbability::Destroy( scp );
+        sc = loc_probabilities->GetScoreAt( n );
 
         //at first probability is zero; we increase it for score sc
         PATTR_SCORES->IncProbabilityOf( prob, sc );
@@ -384,7 +574,8 @@ void AbstractUniversalScoreMatrix::DeformatScaleFactor( const char* strstream )
 size_t AbstractUniversalScoreMatrix::FormatProbCalculator( char* strstream ) const
 {
     //get storage for scores and probabilities...
-    const BinarySearchStructure*    loc_probabilities = GetProbCalculator();
+    const ScoreHistogram*   loc_probabilities = GetProbCalculator();
+    double                  prob;
 
     if( !loc_probabilities || !strstream )
         USM_THROW( "AbstractUniversalScoreMatrix: Unable to format probabilities." );
@@ -401,15 +592,17 @@ size_t AbstractUniversalScoreMatrix::FormatProbCalculator( char* strstream ) con
     *( int* )p = ProbsHeader;   crc += *( int* )p;      p += sizeof( int );      written += sizeof( int );
     *( size_t* )p = no_scores;  crc += *( size_t* )p;   p += sizeof( size_t );   written += sizeof( size_t );
 
-    for( size_t n = 0; n < no_scores; n++ ) {
-        //write values: score of double and probability
-        const ScoreProbability* scp = ( const ScoreProbability* )loc_probabilities->GetValueAt( n );
+    for( size_t n = 0; n < loc_probabilities->GetNoSlots(); n++ ) {
+        prob = loc_probabilities->GetProbabilityAt( n );
+        if( prob <= 0.0 )
+            continue;
 
-        *( double* )p = scp->GetDoubleScore();
+        //write values: score of double and probability
+        *( double* )p = ( double )loc_probabilities->GetScoreAt( n );
         for( int i = 0; i < sizeof( double ); i++ ) crc += p[i];
         p += sizeof( double ); written += sizeof( double );
 
-        *( double* )p = scp->GetProbability();
+        *( double* )p = prob;
         for( int i = 0; i < sizeof( double ); i++ ) crc += p[i];
         p += sizeof( double ); written += sizeof( double );
     }
@@ -423,43 +616,41 @@ size_t AbstractUniversalScoreMatrix::FormatProbCalculator( char* strstream ) con
 
 // -------------------------------------------------------------------------
 //  DeformatProbCalculator: deformat score probabilities and create
-//     auxiliary binary search structure
+//     auxiliary histogram of them
 //
 //  NOTE: the method allocates new amount of memory and returns newly
 //     allocated resources
 // -------------------------------------------------------------------------
 
-BinarySearchStructure* AbstractUniversalScoreMatrix::DeformatProbCalculator( const char* strstream )
+ScoreHistogram* AbstractUniversalScoreMatrix::DeformatProbCalculator( const char* strstream )
 {
     if( !strstream )
         USM_THROW( "AbstractUniversalScoreMatrix: Unable to extract probabilities." );
 
-    //create local storage for scores and probabilities to be returned
-    BinarySearchStructure*  loc_probabilities =
-            new BinarySearchStructure( ScoreProbability::ScoreComparer, GetMaxElemsOfProbCalculator());
-
-    if( !loc_probabilities )
-        USM_THROW( "AbstractUniversalScoreMatrix: Not enough memory." );
-
     const char* p = strstream;
     size_t      bread = 0;
     int         crc = 0;    //value of simple crc computation
     double      sc = 0.0;   //score
     double      prob = 0.0; //probability
+    int         intsc;
+    mystring    error;
+    int         eclass = NOCLASS;
 
-    if( *( int* )p != ProbsHeader ) {
-        DestroyProbCalculator( loc_probabilities );
+    if( *( int* )p != ProbsHeader )
         USM_THROW( "AbstractUniversalScoreMatrix: Format of data received is invalid." );
-    }
 
     crc += *( int* )p; p += sizeof( int ); bread += sizeof( int );
 
     size_t  no_scores = *( size_t* )p; crc += *( size_t* )p; p += sizeof( size_t ); bread += sizeof( size_t );
 
-    if( GetMaxElemsOfProbCalculator() < no_scores ) {
-        DestroyProbCalculator( loc_probabilities );
+    if( GetMaxElemsOfProbCalculator() < no_scores )
         USM_THROW( "AbstractUniversalScoreMatrix: Range of scores received is invalid." );
-    }
+
+    //create local storage for scores and probabilities to be returned
+    ScoreHistogram* loc_probabilities = new ScoreHistogram;
+
+    if( !loc_probabilities )
+        USM_THROW( "AbstractUniversalScoreMatrix: Not enough memory." );
 
     for( size_t n = 0; n < no_scores; n++ ) {
         //write values: score of double and probability
@@ -470,27 +661,36 @@ BinarySearchStructure* AbstractUniversalScoreMatrix::DeformatProbCalculator( con
         for( int i = 0; i < sizeof( double ); i++ ) crc += p[i];
         prob = *( double* )p; p += sizeof( double ); bread += sizeof( double );
 
-        ScoreProbability* scp = new ScoreProbability( sc, prob );
-        if( !scp ) {
-            DestroyProbCalculator( loc_probabilities );
-            USM_THROW( "AbstractUniversalScoreMatrix: Not enough memory." );
-        }
+        intsc = ( int )rint( sc );
 
-        int     location = -1;
-        bool    inserted = loc_probabilities->Push( scp, &location );
+        if( prob <= 0.0 ) {
+            error = "AbstractUniversalScoreMatrix: Invalid probabilities received.";
+            break;
+        }
+        if( 0.0 < loc_probabilities->GetProbabilityOf( intsc )) {
+            error = "AbstractUniversalScoreMatrix: Duplicate scores received.";
+            break;
+        }
 
-        if( !inserted ) {
-            DestroyProbCalculator( loc_probabilities );
-            USM_THROW( "AbstractUniversalScoreMatrix: Duplicate scores received." );
+        try {
+            loc_probabilities->Add( intsc, prob );
+        } catch( myexception const& ex ) {
+            error = ex.what();
+            eclass = ex.eclass();
+            break;
         }
     }
 
     bread += sizeof( int );
 //     PrintStringinHex( strstream, bread );
 
-    if( *( int* )p != crc ) {
-        DestroyProbCalculator( loc_probabilities );
-        USM_THROW( "AbstractUniversalScoreMatrix: CRC of the received message is invalid." );
+    if( error.empty() && *( int* )p != crc )
+        error = "AbstractUniversalScoreMatrix: CRC of the received message is invalid.";
+
+    //the histogram is released once for all the errors
+    if( !error.empty()) {
+        delete loc_probabilities;
+        USM_THROW( error.c_str(), eclass );
     }
 
     return loc_probabilities;
@@ -504,34 +704,31 @@ BinarySearchStructure* AbstractUniversalScoreMatrix::DeformatProbCalculator( con
 // -------------------------------------------------------------------------
 
 bool AbstractUniversalScoreMatrix::InfuseProbCalculator(
-    const BinarySearchStructure* probs_obtained,
-    double* psum,
-    bool delete_duplicates )
+    const ScoreHistogram* probs_obtained,
+    double* psum )
 {
     bool    all_negat = true;   //all negative scores
+    double  prob;
 
-    if( !probs_obtained )
+    if( !probs_obtained || !GetProbCalculator())
         USM_THROW( "AbstractUniversalScoreMatrix: Unable to infuse with probabilities received." );
 
-    size_t  no_scores_probs_obtained = probs_obtained->GetSize();
-
     if( psum )
         *psum = 0.0;
 
-    for( size_t n = 0; n < no_scores_probs_obtained; n++ ) {
-        const ScoreProbability* scp = ( const ScoreProbability* )probs_obtained->GetValueAt( n );
+    for( size_t n = 0; n < probs_obtained->GetNoSlots(); n++ ) {
+        prob = probs_obtained->GetProbabilityAt( n );
+        if( prob <= 0.0 )
+            continue;
 
-        if( psum && scp )
-            *psum += scp->GetProbability();
+        if( psum )
+            *psum += prob;
+    }
 
-        if( ! Push( scp ))
-            //if hasn't  been pushed, destroy if needed
-            if( delete_duplicates )
-                delete scp;
+    GetProbCalculator()->Add( *probs_obtained );
 
-        if( all_negat && 0 < scp->GetScore())
-            all_negat = false;
-    }
+    if( probs_obtained->GetSize() && 0 < probs_obtained->GetMaxScore())
+        all_negat = false;
 
     return all_negat;
 }
@@ -571,20 +768,19 @@ void AbstractUniversalScoreMatrix::PrintProbCalculator( FILE* fp )
         return;
 
     //get storage for scores and probabilities...
-    const BinarySearchStructure*    loc_probabilities = GetProbCalculator();
+    const ScoreHistogram*   loc_probabilities = GetProbCalculator();
 
     if( !loc_probabilities )
         return;
 
-    size_t  no_scores = loc_probabilities->GetSize();
-
     fprintf( fp,"\n%5c Score probabilities\n", 32 );
 
     fprintf( fp, "%9c", 32 );
 
-    for( int n = 0; n < no_scores; n++ ) {
-        const ScoreProbability* scp = ( const ScoreProbability* )loc_probabilities->GetValueAt( n );
-        fprintf( fp, "\n%5d %6.4g", scp->GetScore(), scp->GetProbability());
+    for( size_t n = 0; n < loc_probabilities->GetNoSlots(); n++ ) {
+        if( loc_probabilities->GetProbabilityAt( n ) <= 0.0 )
+            continue;
+        fprintf( fp, "\n%5d %6.4g", loc_probabilities->GetScoreAt( n ), loc_probabilities->GetProbabilityAt( n ));
     }
     fprintf( fp, "\n" );
 }
@@ -592,23 +788,78 @@ void AbstractUniversalScoreMatrix::PrintProbCalculator( FILE* fp )
 // =========================================================================
 // SERIALIZATION ROUTINES
 //
-// Serialize: serialization of the statistical parameters computed
+// GetCacheKey: key of the score system obtained by hashing its
+//     fingerprints; the fingerprints are required to be computed
 //
-void AbstractUniversalScoreMatrix::Serialize( Serializer& ) const
+Uint64 AbstractUniversalScoreMatrix::GetCacheKey() const
 {
-/*    serializer.Write(( char* )&columns, sizeof( columns ), 1 );
+    for( int n = 0; n < NoPrints; n++ )
+        if( !fingerprints[n] )
+            USM_THROW( "AbstractUniversalScoreMatrix: Fingerprints of score system not computed." );
 
-    for( int n = 0; n < columns; n++ )
-        serializer.Write(( char* )values[n], sizeof( double ), NUMALPH );
+    return fnvhashing( fingerprints, sizeof( Uint64 ) * NoPrints );
+}
 
-    if( columns > 0 )
-        serializer.Write( aacids, sizeof( char ), columns );*/
+// Serialize: serialization of the statistical parameters computed by
+//     scaling together with the fingerprints identifying the score system
+//
+void AbstractUniversalScoreMatrix::Serialize( Serializer& serializer ) const
+{
+    TScaledParameters   params;
+
+    GetCacheKey();  //verify fingerprints
+    GetScaledParameters( &params );
+
+    serializer.Write(( char* )signature, 1, strlen( signature ));
+    for( int n = 0; n < NoPrints; n++ )
+        serializer.Write(( char* )&fingerprints[n], sizeof( Uint64 ), 1 );
+
+    serializer.Write(( char* )&params.multiplier, sizeof( double ), 1 );
+    serializer.Write(( char* )&params.lambda, sizeof( double ), 1 );
+    serializer.Write(( char* )&params.entropy, sizeof( double ), 1 );
+    serializer.Write(( char* )&params.parameterK, sizeof( double ), 1 );
+    serializer.Write(( char* )&params.expscore, sizeof( double ), 1 );
+    serializer.Write(( char* )&params.gappedLambda, sizeof( double ), 1 );
+    serializer.Write(( char* )&params.gappedK, sizeof( double ), 1 );
+    serializer.Write(( char* )&params.minscore, sizeof( Int64 ), 1 );
+    serializer.Write(( char* )&params.maxscore, sizeof( Int64 ), 1 );
+    serializer.Write(( char* )&params.allnegatives, sizeof( Int64 ), 1 );
 }
 
 // Deserialize: deserialization of the statistical parameters
-// NOTE: the method changes values of the class's own parameters
+// NOTE: the method changes values of the class's own parameters only
+//     when the fingerprints read match those of the score system
 //
-void AbstractUniversalScoreMatrix::Deserialize( Serializer& )
+void AbstractUniversalScoreMatrix::Deserialize( Serializer& serializer )
 {
-}
+    char                locsignature[BUF_MAX];
+    Uint64              locprints[NoPrints];
+    TScaledParameters   params;
+
+    GetCacheKey();  //verify fingerprints
 
+    serializer.Read( locsignature, 1, strlen( signature ));
+    if( strncmp( locsignature, signature, strlen( signature )))
+        USM_THROW( "AbstractUniversalScoreMatrix: Wrong format of serialized score system." );
+
+    for( int n = 0; n < NoPrints; n++ ) {
+        serializer.Read(( char* )&locprints[n], sizeof( Uint64 ), 1 );
+        if( locprints[n] != fingerprints[n] )
+            USM_THROW( "AbstractUniversalScoreMatrix: Serialized score system does not match." );
+    }
+
+    serializer.Read(( char* )&params.multiplier, sizeof( double ), 1 );
+    serializer.Read(( char* )&params.lambda, sizeof( double ), 1 );
+    serializer.Read(( char* )&params.entropy, sizeof( double ), 1 );
+    serializer.Read(( char* )&params.parameterK, sizeof( double ), 1 );
+    serializer.Read(( char* )&params.expscore, sizeof( double ), 1 );
+    serializer.Read(( char* )&params.gappedLambda, sizeof( double ), 1 );
+    serializer.Read(( char* )&params.gappedK, sizeof( double ), 1 );
+    serializer.Read(( char* )&params.minscore, sizeof( Int64 ), 1 );
+    serializer.Read(( char* )&params.maxscore, sizeof( Int64 ), 1 );
+    serializer.Read(( char* )&params.allnegatives, sizeof( Int64 ), 1 );
+    if( params.multiplier <= 0.0 || params.maxscore < params.minscore )
+        USM_THROW( "AbstractUniversalScoreMatrix: Serialized score system corrupted." );
+
+    SetScaledParameters( params );
+}
@@ -24,37 +24,58 @@ extern double rint( double x );
 class Serializer;
 
 class FrequencyStore;
-class BinarySearchStructure;
 
 // _________________________________________________________________________
-// Class ScoreProbability
+// Class ScoreHistogram
 //
-class ScoreProbability
+// Probabilities of integer scores accumulated in an array indexed by the
+// offset of a score from the base score of the array; the array grows to
+// cover new scores. When the range of scores becomes too wide to be kept
+// in an array, the histogram turns to sorted arrays of the scores
+// observed and their probabilities. Probabilities which are not positive
+// are ignored; a score is observed when its probability is positive
+//
+class ScoreHistogram
 {
 public:
-    ScoreProbability( double, double );
-    explicit ScoreProbability();
-    ~ScoreProbability();
-
-    int             GetScore() const                { return score; }
-    double          GetDoubleScore() const          { return double_score; }
-    double          GetProbability() const          { return probb; }
+    ScoreHistogram();
+    ~ScoreHistogram();
 
-    void            SetScores( double value )       { double_score = value; score = ( int )rint( double_score ); }
-    void            SetProbability( double value )  { probb = value; }
+    void            Add( int score, double prob );      //add probability of the score
+    void            Add( const ScoreHistogram& );       //add probabilities of the other histogram
+    void            Clear();                            //clear the histogram keeping the memory allocated
 
-    void            IncProbability( double );
+    size_t          GetSize() const                 { return noscores; }
+    int             GetMinScore() const             { return minscore; }
+    int             GetMaxScore() const             { return maxscore; }
+    bool            GetSparse() const               { return scores != NULL; }
+    double          GetProbabilityOf( int score ) const;
 
-    static  int                 ScoreComparer( const void* key1, const void* key2 );
-    static ScoreProbability*    NewScoreProbability();
-    static void                 Destroy( const ScoreProbability* );
+    size_t          GetNoSlots() const;                 //number of slots, some of which may be empty
+    int             GetScoreAt( size_t slot ) const;
+    double          GetProbabilityAt( size_t slot ) const;
 
 protected:
+    explicit ScoreHistogram( const ScoreHistogram& );
+
+    void            Destroy();
+    void            AddDense( int score, double prob );
+    void            AddSparse( int score, double prob );
+    void            ReallocDense( int newbase, size_t newcap );
+    void            ReallocSparse( size_t newcap );
+    void            MakeSparse();                       //move scores to the sparse representation
+    size_t          FindSparse( int score ) const;      //location of the score in the sparse arrays
 
 private:
-    int     score;          //score
-    double  double_score;   //same score of type double
-    double  probb;          //probability
+    double*         probs;          //probabilities of scores
+    int*            scores;         //scores of the sparse representation; NULL if dense
+    int             base;           //score of the first element of the dense array
+    size_t          capacity;       //number of elements allocated
+    size_t          noscores;       //number of distinct scores observed
+    int             minscore;       //minimum score observed
+    int             maxscore;       //maximum score observed
+
+    static const size_t max_dense_range;    //maximum range of scores kept in a dense array
 };
 
 
@@ -73,6 +94,12 @@ public:
         ProbsHeader = 0xffffffff,       //header of the formatted probabilities message
         ScaleHeader = 0xfffffff7        //header of the formatted scale factor message
     };
+    enum TFingerprint {                 //fingerprints identifying the score system
+        QueryPrint,                     //fingerprint of the query profile
+        StorePrint,                     //fingerprint of the frequency vectors of the database
+        OptionsPrint,                   //fingerprint of the options affecting scaling
+        NoPrints
+    };
 
 public:
     AbstractUniversalScoreMatrix(
@@ -102,6 +129,10 @@ public:
 
     const TFVectorProbabilities GetDistributionType() const { return distribution; }
 
+    Uint64              GetFingerprint( TFingerprint ) const;
+    void                SetFingerprint( TFingerprint, Uint64 value );
+    Uint64              GetCacheKey() const;                    //key of the score system made of its fingerprints
+
     virtual void        Serialize( Serializer& ) const;         //serialization of the parameters
     virtual void        Deserialize( Serializer& );             //deserialization of the parameters
 
@@ -119,13 +150,9 @@ protected:
                                                                                     //process scores and probabilities
     void                ProcessScoreProbabilities( AttributableScores*, double = 0.0 );
 
-    const FrequencyStore*           GetStore() const            { return freqstore;         }
-    BinarySearchStructure*          GetProbCalculator()         { return prob_calculator;   }
-    const BinarySearchStructure*    GetProbCalculator() const   { return prob_calculator;   }
-    static void                     ClearProbCalculator( BinarySearchStructure* );  //destroy members of probCalculator and clear it
-    static void                     DestroyProbCalculator( BinarySearchStructure* );//destroy totally probCalculator
-
-    bool                    Push( const ScoreProbability* );        //push score-probability strucutre into a private class member
+    const FrequencyStore*   GetStore() const            { return freqstore;         }
+    ScoreHistogram*         GetProbCalculator()         { return prob_calculator;   }
+    const ScoreHistogram*   GetProbCalculator() const   { return prob_calculator;   }
 
     size_t                  FormatTermMessage( char* ) const;       //commpose termination message using the scale factor format
     bool                    IsThatTermMessage( const char* ) const; //whether the message is termination message
@@ -135,9 +162,9 @@ protected:
     void                    DeformatScaleFactor( const char* );     //deformat message to extract scale factor written in it
 
     size_t                  FormatProbCalculator( char* ) const;    //format score probabilities and write them to the string stream
-    BinarySearchStructure*  DeformatProbCalculator( const char* );  //deformat score probabilities and re-create binary search structure
+    ScoreHistogram*         DeformatProbCalculator( const char* );  //deformat score probabilities and re-create the histogram
                                                                     //infuse probabilities with new ones given with the argument
-    bool                    InfuseProbCalculator( const BinarySearchStructure*, double*, bool delete_duplicates = true );
+    bool                    InfuseProbCalculator( const ScoreHistogram*, double* );
 
     void                    PrintProbCalculator( FILE* );                       //print information of scores and corresponding probabilities
     virtual void            USM_THROW( const char*, int = NOCLASS ) const = 0;  //throw method private for classes of this type
@@ -148,63 +175,99 @@ private:
 
 private:
     const FrequencyStore*   freqstore;          //big array of frequency vectors
-    BinarySearchStructure*  prob_calculator;    //vector used to calculate probabilities each time the scaling is performed
+    ScoreHistogram*         prob_calculator;    //histogram used to calculate probabilities each time the scaling is performed
     const TFVectorProbabilities distribution;   //frequency vector distribution type
     bool                    cpu_preference;     //applying universal score system requires a large amount of memory;
                                                 //  an alternative is to use more intense computations instead, i.e.
                                                 //  CPU preference
+    Uint64                  fingerprints[NoPrints]; //fingerprints of the score system; 0 if not computed
     static const double     fake_scale_factor;  //fake scale factor used to indicate the termination
+    static const char*      signature;          //signature of serialized score system
 };
 
 
 // INLINES ...
-// CLASS ScoreProbability
+// CLASS ScoreHistogram
 //
 // -------------------------------------------------------------------------
-// ScoreComparer: the method is for comparison of scores; returns 0 if the
-// keys are equal, value >0 if key1 > key2, and value <0 otherwise
+// Add: adds probability of the score; the dense array is accessed
+//     directly when it covers the score; probabilities not positive are
+//     ignored
 //
 inline
-int ScoreProbability::ScoreComparer( const void* key1, const void* key2 )
+void ScoreHistogram::Add( int score, double prob )
 {
-    const ScoreProbability* scp1 = ( const ScoreProbability* )key1;
-    const ScoreProbability* scp2 = ( const ScoreProbability* )key2;
-
-    if( !scp1 || !scp2 )
-        throw myruntime_error( mystring( "ScoreProbability: Unable to compare objects." ));
+    if( prob <= 0.0 )
+        return;
+    if( !scores && probs && base <= score && ( Int64 )score - base < ( Int64 )capacity ) {
+        double* slot = probs + ( score - base );
+        if( *slot <= 0.0 ) {
+            if( !noscores || score < minscore ) minscore = score;
+            if( !noscores || maxscore < score ) maxscore = score;
+            noscores++;
+        }
+        *slot += prob;
+        return;
+    }
+    if( scores )
+        AddSparse( score, prob );
+    else
+        AddDense( score, prob );
+}
 
-    return scp1->GetScore() - scp2->GetScore();
+// -------------------------------------------------------------------------
+// GetNoSlots: number of slots of the histogram; slots are ordered by
+//     score, and those of the dense array may be empty
+//
+inline
+size_t ScoreHistogram::GetNoSlots() const
+{
+    return scores? noscores: capacity;
 }
 
 // -------------------------------------------------------------------------
-// NewScoreProbability: creates new default object of class ScoreProbability
+// GetScoreAt: score of the slot
 //
 inline
-ScoreProbability* ScoreProbability::NewScoreProbability()
+int ScoreHistogram::GetScoreAt( size_t slot ) const
 {
-    ScoreProbability*   scp = new ScoreProbability;
-    if( scp == NULL )
-        throw myruntime_error( mystring( "ScoreProbability: Not enough memory." ));
-    return scp;
+#ifdef __DEBUG__
+    if( GetNoSlots() <= slot )
+        throw myruntime_error( mystring( "ScoreHistogram: Memory access error." ));
+#endif
+    return scores? scores[slot]: base + ( int )slot;
 }
 
 // -------------------------------------------------------------------------
-// Destroy: destroys the object of class ScoreProbability
+// GetProbabilityAt: probability of the slot
 //
 inline
-void ScoreProbability::Destroy( const ScoreProbability* scp )
+double ScoreHistogram::GetProbabilityAt( size_t slot ) const
 {
-    if( scp )
-        delete scp;
+#ifdef __DEBUG__
+    if( GetNoSlots() <= slot )
+        throw myruntime_error( mystring( "ScoreHistogram: Memory access error." ));
+#endif
+    return probs[slot];
 }
 
 // -------------------------------------------------------------------------
-// IncProbability: increases probability with the given value
+// GetProbabilityOf: probability of the score; 0 if the score has not
+//     been observed
 //
 inline
-void ScoreProbability::IncProbability( double value )
+double ScoreHistogram::GetProbabilityOf( int score ) const
 {
-    probb += value;
+    size_t  loc;
+
+    if( !noscores || score < minscore || maxscore < score )
+        return 0.0;
+    if( !scores )
+        return probs[score - base];
+    loc = FindSparse( score );
+    if( loc < noscores && scores[loc] == score )
+        return probs[loc];
+    return 0.0;
 }
 
 // =========================================================================
@@ -251,6 +314,31 @@ size_t AbstractUniversalScoreMatrix::GetSizeOfScaleMessage()
             ( sizeof( double ));    //size of scale factor itself
 }
 
+// -------------------------------------------------------------------------
+// GetFingerprint: fingerprint of the score system
+//
+inline
+Uint64 AbstractUniversalScoreMatrix::GetFingerprint( TFingerprint which ) const
+{
+#ifdef __DEBUG__
+    if( NoPrints <= which )
+        throw myruntime_error( mystring( "AbstractUniversalScoreMatrix: Memory access error." ));
+#endif
+    return fingerprints[which];
+}
+
+// SetFingerprint: set fingerprint of the score system
+//
+inline
+void AbstractUniversalScoreMatrix::SetFingerprint( TFingerprint which, Uint64 value )
+{
+#ifdef __DEBUG__
+    if( NoPrints <= which )
+        throw myruntime_error( mystring( "AbstractUniversalScoreMatrix: Memory access error." ));
+#endif
+    fingerprints[which] = value;
+}
+
 // -------------------------------------------------------------------------
 // IsFormattedDataValid: verifies wthether the message formatted is valid
 //
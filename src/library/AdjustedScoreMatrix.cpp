@@ -52,7 +52,7 @@ AdjustedScoreMatrix::AdjustedScoreMatrix(
     freqstore( store ),
     vector_probabilities( NULL )
 {
-    if( !store || !freqstore->GetFrequencies())
+    if( !store || !freqstore->GetSize())
             throw myruntime_error( mystring ( "AdjustedScoreMatrix: No frequency vectors provided." ));
 
     vector_probabilities = ( double* )malloc( sizeof( double ) * GetSubjectSize());
@@ -85,6 +85,31 @@ AdjustedScoreMatrix::~AdjustedScoreMatrix()
         free( vector_probabilities );
 }
 
+// -------------------------------------------------------------------------
+// Rebind: binds the score system to another subject profile; the vector
+//     of probabilities is reallocated only if the subject is longer than
+//     any before
+// -------------------------------------------------------------------------
+
+void AdjustedScoreMatrix::Rebind( const FrequencyMatrix& freq_sec, const LogOddsMatrix& logo_sec )
+{
+    int capacity = GetSubjectCapacity();
+
+    ScoringMatrix::Rebind( freq_sec, logo_sec );
+
+    if( capacity < GetSubjectCapacity()) {
+        if( vector_probabilities )
+            free( vector_probabilities );
+
+        vector_probabilities = ( double* )malloc( sizeof( double ) * GetSubjectCapacity());
+
+        if( !vector_probabilities )
+                throw myruntime_error( mystring ( "AdjustedScoreMatrix: Not enough memory." ));
+    }
+
+    memset( vector_probabilities, 0, sizeof( double ) * GetSubjectSize());
+}
+
 // -------------------------------------------------------------------------
 // ComputeScore: compute score given query position and charactersitic
 //     vector of frequencies
@@ -116,7 +141,7 @@ void AdjustedScoreMatrix::ComputeProfileScoringMatrix( bool final )
     if( GetQuerySize() <= 0 || GetSubjectSize() <= 0 )
         throw myruntime_error( mystring( "AdjustedScoreMatrix: No matrix." ));
 
-    if( !IsValid() || !GetStore() || !GetStore()->GetFrequencies())
+    if( !IsValid() || !GetStore() || !GetStore()->GetSize())
         throw myruntime_error( mystring( "AdjustedScoreMatrix: Unable to compute scores." ));
 
     int                 no_elems = 0;
@@ -125,7 +150,6 @@ void AdjustedScoreMatrix::ComputeProfileScoringMatrix( bool final )
     bool                all_negat = true;
     double              score = 0.0;
     const double        scoreX = -1.0;
-    const SimpleVector* frequencies = GetStore()->GetFrequencies();
     const char*         found = NULL;
 
     FrequencyVector     vector( NULL );
@@ -216,6 +240,97 @@ void AdjustedScoreMatrix::ComputeProfileScoringMatrix( bool final )
     SetAllNegatives( all_negat );
 }
 
+// -------------------------------------------------------------------------
+// ScanScoresForHSPs: computes scores row by row as
+//     ComputeProfileScoringMatrix does without saving them and passes each
+//     row to the search of HSPs until they are found
+// -------------------------------------------------------------------------
+
+bool AdjustedScoreMatrix::ScanScoresForHSPs( AttributableScores* PATTR_SCORES )
+{
+    if( PATTR_SCORES == NULL )
+        throw myruntime_error( mystring( "AdjustedScoreMatrix: Unable to scan scores: Wrong argument." ));
+
+    if( GetQuerySize() <= 0 || GetSubjectSize() <= 0 )
+        throw myruntime_error( mystring( "AdjustedScoreMatrix: No matrix." ));
+
+    if( !IsValid() || !GetStore() || !GetStore()->GetSize())
+        throw myruntime_error( mystring( "AdjustedScoreMatrix: Unable to compute scores." ));
+
+    TMask               currentmask = Unmasked;
+    const double        scoreX = -1.0;
+    const char*         found = NULL;
+    double*             row = NULL;
+    bool                done = false;
+    int                 m, n;
+
+    FrequencyVector     vector( NULL );
+
+    row = ( double* )malloc( sizeof( double ) * GetQuerySize());
+
+    if( !row )
+        throw myruntime_error( mystring( "AdjustedScoreMatrix: Not enough memory." ));
+
+    for( m = 0; m < GetSubjectSize() && !done; m++ )
+    {
+        try {
+            //omit positions of Xs
+            if( GetSbjctFreq().GetResidueAt( m ) == X ) {
+                for( n = 0; n < GetQuerySize(); n++ )
+                    row[n] = scoreX;
+                done = PATTR_SCORES->ScanHSPRow( m, row );
+                continue;
+            }
+
+            vector.SetVector(   *GetSbjctFreq().GetVectorAt( m ),
+                                 GetSbjctLogo().GetFrequencyWeightAt( m ),
+                                 GetSbjctLogo().GetThicknessAt( m ),
+                                *GetSbjctLogo().GetVectorAt( m ),
+                                 GetSbjctLogo().GetInformationAt( m )
+            );
+
+            found = ( const char* )GetStore()->Find( vector );
+
+            if( found == NULL )
+                throw myruntime_error( mystring( "AdjustedScoreMatrix: No frequency vector found in the database." ));
+
+            const FrequencyVector   quest_vector( found );
+
+            for( n = 0; n < GetQuerySize(); n++ )
+            {
+                currentmask = Unmasked;
+
+                //give constant penalties at the positions of X
+                if( GetQueryFreq().GetResidueAt( n ) == X ) {
+                    row[n] = scoreX;
+                    continue;
+                }
+
+                if( GetQueryLogo().GetInformationAt( n ) < GetInformationThreshold() ||
+                    GetSbjctLogo().GetInformationAt( m ) < GetInformationThreshold() ||
+                    ! ThicknessConstraintsMet( m, n ))
+                    currentmask = GetMaskingApproach();
+
+                if( currentmask != MaskToIgnore )
+                    row[n] = ComputeScore( n, quest_vector );
+                else
+                    row[n] = scoreX;
+            }
+
+            done = PATTR_SCORES->ScanHSPRow( m, row );
+
+        } catch( myexception const& ex ) {
+            vector.Destroy();
+            free( row );
+            throw myruntime_error( ex.what(), ex.eclass());
+        }
+    }
+
+    vector.Destroy();
+    free( row );
+    return true;
+}
+
 // -------------------------------------------------------------------------
 // ComputePositionalScoreProbs: computes probabilities of scores at each
 //     query and subject position
@@ -350,3 +465,24 @@ void AdjustedScoreMatrix::ComputeScoreProbabilities( AttributableScores* PATTR_S
     PATTR_SCORES->SetExpectedScore( avgscore );
 }
 
+// -------------------------------------------------------------------------
+// TabulateScores: makes the table of scores with their weights in the
+//     order the scores contribute to probabilities in
+//     ComputeScoreProbabilities
+// -------------------------------------------------------------------------
+
+bool AdjustedScoreMatrix::TabulateScores( AttributableScores* PATTR_SCORES )
+{
+    if( PATTR_SCORES == NULL )
+        throw myruntime_error( mystring( "AdjustedScoreMatrix: Unable to tabulate scores: Wrong argument." ));
+
+    for( int m = 0; m < GetSubjectSize(); m++ ) {
+        bool    sbjctX = GetSbjctFreq()[m] == X;
+        double  prob = sbjctX? -1.0: GetVectorProbabilityAt( m );
+
+        for( int n = 0; n < GetQuerySize(); n++ )
+            PATTR_SCORES->PushTableScore( m, n, ( sbjctX || GetQueryFreq()[n] == X )? -1.0: prob );
+    }
+    return true;
+}
+
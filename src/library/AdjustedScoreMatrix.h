@@ -52,10 +52,16 @@ public:
     virtual const char* GetMethodName() const { return "Adjusted vector-based"; }
 
     virtual void        ComputeProfileScoringMatrix( bool final = false );
+                                                                //bind the score system to another subject
+    virtual void        Rebind( const FrequencyMatrix& freq_sec, const LogOddsMatrix& logo_sec );
                                                                 //compute probabilities to observe scores at each position
     virtual void        ComputeScoreProbabilities( AttributableScores* );
                                                             //compute positional probabilities of scores
     virtual void        ComputePositionalScoreProbs( AttributableScores* );
+                                                            //tabulate scores with their weights in probabilities
+    virtual bool        TabulateScores( AttributableScores* );
+                                                            //compute rows of scores on the fly for the search of HSPs
+    virtual bool        ScanScoresForHSPs( AttributableScores* );
 
 protected:
                                                                 //compute score given query position and vector of frequencies
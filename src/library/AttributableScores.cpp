@@ -15,6 +15,7 @@
 #include "DistributionMatrix.h"
 #include "AbstractScoreMatrix.h"
 #include "AttributableScores.h"
+#include "HSPScanner.h"
 
 
 // -------------------------------------------------------------------------
@@ -51,12 +52,20 @@ AttributableScores::AttributableScores(
     sbjctminmaxscores( NULL ),
     probabilities( NULL ),
 
+    tablescores( NULL ),
+    tableweights( NULL ),
+    tablesize( 0 ),
+    tablecapacity( 0 ),
+
     min_score( 0 ),
     max_score( 0 ),
     score_gcd( 1 ),
 
     priv_prob_vector( NULL ),
     prob_vector_size( 0 ),
+    givenK( -1.0 ),
+    hspscanner( NULL ),
+    hsprow( NULL ),
 
     expscore( 0.0 ),
     allnegatives( false ),
@@ -74,7 +83,6 @@ AttributableScores::AttributableScores(
     SetRefLambda( reflambda );
     SetRefH( refH );
     SetRefK( refK );
-    NewPrivateProbVector( PARAMETER_K_MAXIT, MAX_RANGE_OF_SCORES );
 }
 
 // -------------------------------------------------------------------------
@@ -101,12 +109,20 @@ AttributableScores::AttributableScores()
     sbjctminmaxscores( NULL ),
     probabilities( NULL ),
 
+    tablescores( NULL ),
+    tableweights( NULL ),
+    tablesize( 0 ),
+    tablecapacity( 0 ),
+
     min_score( 0 ),
     max_score( 0 ),
     score_gcd( 1 ),
 
     priv_prob_vector( NULL ),
     prob_vector_size( 0 ),
+    givenK( -1.0 ),
+    hspscanner( NULL ),
+    hsprow( NULL ),
 
     expscore( 0.0 ),
     allnegatives( false ),
@@ -132,6 +148,7 @@ AttributableScores::AttributableScores()
 AttributableScores::~AttributableScores()
 {
     DestroyProbabilities();
+    DestroyScoreTable();
     DestroyPrivateProbVector();
     DestroyQueryInfContent();
     DestroySbjctInfContent();
@@ -294,6 +311,41 @@ void AttributableScores::Init()
     NewSbjctMinMaxScores();
 }
 
+// -------------------------------------------------------------------------
+// Rebind: binds the scores to the matrices of another pair of profiles;
+//     values computed for the previous pair are reset and memory of
+//     sizes depending on the profiles is reinitialized
+// -------------------------------------------------------------------------
+
+void AttributableScores::Rebind( const double** im, const TMask** msk, int sz_query, int sz_sbjct )
+{
+    //sizes are still those of the previous pair
+    DestroyProbabilities();
+    DestroyScoreTable();
+    DestroyQueryInfContent();
+    DestroySbjctInfContent();
+    DestroyQueryInfProbs();
+    DestroySbjctInfProbs();
+    DestroyQueryMinMaxScores();
+    DestroySbjctMinMaxScores();
+
+    image = im;
+    mask = msk;
+
+    private_multiplier = 1.0;
+    min_score = 0;
+    max_score = 0;
+    score_gcd = 1;
+    expscore = 0.0;
+    allnegatives = false;
+    lambda = -1.0;
+    entropy = 0.0;
+    parameterK = -1.0;
+    constant_c = -1.0;
+
+    Init( sz_query, sz_sbjct );
+}
+
 // -------------------------------------------------------------------------
 // SearchForHSPs: perform search of multiple high-scoring pairs (hsp)
 //     in the same diagonal of the score system
@@ -310,211 +362,112 @@ bool AttributableScores::SearchForHSPs(
     double minhspscore, int hsplen, int nohsps, int maxdist,
     int* possbjct, int* posquery )
 {
-    bool            bret = false;
     const TScore    hmin = ( TScore )minhspscore;
-    TScore          hmax = 0;
-    const int       diaglen = nohsps * 3; //nohsps*2 for indices
-    TScore**        diagonals = NULL;   //diagonals keeping best-scoring hsps
-    TScore**        hsps = NULL;
-    int**           lens = NULL;
-    TScore          loc_score, tvalue;
-    mystring        errstr;
-    int             m, n, ind, sum, k, l;
-    int             msb, nqu, mind;
-
-    if( hmin <= 0 ) {
-        warning( "Parameter: Non-positive HSP score threshold." );
-        return false;
-    }
-    if( hsplen <= 0 ) {
-        warning( "Parameter: Non-positive HSP length." );
-        return false;
-    }
-    if( nohsps <= 0 ) {
-        warning( "Parameter: Non-positive number of HSPs." );
-        return false;
-    }
-    if( maxdist <= 0 ) {
-        warning( "Parameter: Non-positive distance between HSPs." );
+    TScore*         row = NULL;
+    int             m, n;
+
+    if( !HSPScanner::VerifyParameters( hmin, hsplen, nohsps, maxdist ))
         return false;
-    }
     if( GetSubjectSize() <= 0 || GetQuerySize() <= 0 )
         return false;
 
+    HSPScanner  scanner( hmin, hsplen, nohsps, maxdist );
 
-    diagonals = ( TScore** )malloc( sizeof( TScore* ) * ( GetSubjectSize() + GetQuerySize() - 1 ));
-    hsps = ( TScore** )malloc( sizeof( TScore* ) * GetSubjectSize());
-    lens = ( int** )malloc( sizeof( int* ) * GetSubjectSize());
+    scanner.Reset( GetQuerySize(), GetSubjectSize());
 
-    if( !hsps || !lens )
-        throw myruntime_error( mystring( "AttributableScoresII: Not enough memory." ));
+    row = ( TScore* )malloc( sizeof( TScore ) * GetQuerySize());
 
-    for( m = GetSubjectSize(); m < GetSubjectSize() + GetQuerySize() - 1; m++ ) {
-        diagonals[m] = ( TScore* )malloc( sizeof( TScore ) * diaglen );
-        if( !diagonals[m])
-            throw myruntime_error( mystring( "AttributableScoresII: Not enough memory." ));
+    if( !row )
+        throw myruntime_error( mystring( "AttributableScores: Not enough memory." ));
 
-        memset( diagonals[m], 0, sizeof( TScore ) * diaglen );
-    }
+    //heuristics of several high-scoring pairs in the diagonal
     for( m = 0; m < GetSubjectSize(); m++ ) {
-        diagonals[m] = ( TScore* )malloc( sizeof( TScore ) * diaglen );
-        hsps[m] = ( TScore* )malloc( sizeof( TScore ) * GetQuerySize());
-        lens[m] = ( int* )malloc( sizeof( int ) * GetQuerySize());
+        for( n = 0; n < GetQuerySize(); n++ )
+            row[n] = ( TScore )GetScore( m, n );
+        if( scanner.ScanRow( m, row ))
+            break;
+    }
 
-        if( !hsps[m] || !lens[m] || !diagonals[m] )
-            throw myruntime_error( mystring( "AttributableScoresII: Not enough memory." ));
+    free( row );
 
-        memset( diagonals[m], 0, sizeof( TScore ) * diaglen );
-        memset( hsps[m], 0, sizeof( TScore ) * GetQuerySize());
-        memset( lens[m], 0, sizeof( int ) * GetQuerySize());
+    if( scanner.GetFound()) {
+        if( possbjct )  *possbjct = scanner.GetSbjctPos();
+        if( posquery )  *posquery = scanner.GetQueryPos();
     }
+    return scanner.GetFound();
+}
 
-    //heuristics of several high-scoring pairs in the diagonal
-    for( m = 0; m < GetSubjectSize() && !bret; m++ ) {
-        for( n = 0; n < GetQuerySize() && !bret; n++ )
-        {
-//             if( GetMaskedToIgnore( m, n ))
-//                 continue;
+// -------------------------------------------------------------------------
+// PrescanForHSPs: performs the same search of hsps as SearchForHSPs does
+//     before the score matrix is computed; the parent computes scores
+//     row by row and passes them to ScanHSPRow until hsps are found;
+//     returns true if hsps have been found or if the parent cannot compute
+//     scores on the fly
+// -------------------------------------------------------------------------
 
-            loc_score = ( TScore )GetScore( m, n );
+bool AttributableScores::PrescanForHSPs(
+    double minhspscore, int hsplen, int nohsps, int maxdist,
+    int* possbjct, int* posquery )
+{
+    const TScore    hmin = ( TScore )minhspscore;
+    bool            scanned = false;
 
-            if( loc_score <= SCORE_MIN ) {
-                hsps[m][n] = 0;
-                continue;
-            }
+    if( !HSPScanner::VerifyParameters( hmin, hsplen, nohsps, maxdist ))
+        return false;
+    if( GetSubjectSize() <= 0 || GetQuerySize() <= 0 )
+        return false;
+    if( GetParent() == NULL )
+        throw myruntime_error( mystring( "AttributableScores: No parent to compute scores." ));
 
-            hsps[m][n] = loc_score;
-            lens[m][n] = 0;
+    HSPScanner  scanner( hmin, hsplen, nohsps, maxdist );
 
-            if( 0 < loc_score ) {
-                //begin or continue hsp
-                hsps[m][n] = loc_score;
-                lens[m][n] = 1;
-            }
+    scanner.Reset( GetQuerySize(), GetSubjectSize());
 
-            if( 0 < m && 0 < n )
-                //boundary hsp positions should be positive
-//               (( ( lens[m-1][n-1] <= 1 || lens[m-1][n-1] == hsplen - 1 ) && 0 < hsps[m-1][n-1] ) ||
-//               ( 1 < lens[m-1][n-1] && lens[m-1][n-1] < hsplen - 1 ) ))
-            {
-                tvalue = hsps[m][n] + hsps[m-1][n-1];
-                if( hsps[m][n] < tvalue && 0 < hsps[m][n]) {
-                    if( lens[m-1][n-1] < hsplen ) {
-                        hsps[m][n] = tvalue;
-                        lens[m][n] = lens[m-1][n-1] + 1;
-                    }
-                }
-            }
+    hsprow = ( TScore* )malloc( sizeof( TScore ) * GetQuerySize());
 
-            //record hsp score in the diagonal
-            if( hsplen <= lens[m][n] && hmin <= hsps[m][n] )
-            {
-                ind = GetQuerySize() - 1 - n + m;
+    if( !hsprow )
+        throw myruntime_error( mystring( "AttributableScores: Not enough memory." ));
 
-                sum = 0;
-                for( k = 0; k < nohsps; k++ )
-                {
-                    if( diagonals[ind][k+nohsps] &&
-                        maxdist < m - diagonals[ind][k+nohsps] - hsplen ) {
-                        //distance between two hsps is too small- omit the hsp
-                        //all hsps are considered in turn
-                        sum = -1;//to break
-                        break;
-                    }
-                    if( diagonals[ind][k] < hsps[m][n] )
-                    {
-                        for( l = nohsps - 1; k < l && diagonals[ind][l-1] <= 0; l-- );
-                        for( ; k < l; l-- ) {
-                            if( maxdist < m - diagonals[ind][l-1+nohsps] - hsplen ) {
-                                //distance between two hsps is too small- omit the hsp
-                                sum = -1;//to break
-                                break;
-                            }
-                            diagonals[ind][l] = diagonals[ind][l-1];//save hsp score
-                            diagonals[ind][l+nohsps] = diagonals[ind][l-1+nohsps];//save coordinates..
-                            diagonals[ind][l+nohsps+nohsps] = diagonals[ind][l-1+nohsps+nohsps];
-                            sum += diagonals[ind][l];
-                        }
-                        if( sum < 0 )
-                            break;
-                        diagonals[ind][k] = hsps[m][n];
-                        diagonals[ind][k+nohsps] = m;
-                        diagonals[ind][k+nohsps+nohsps] = n;
-                        sum += diagonals[ind][k];
-                        break;
-                    }
-                    else
-                        sum += diagonals[ind][k];
-                }
-                if( diagonals[ind][nohsps-1] && hmax < sum ) {
-                    bret = true;    //at least one group of hsps is found
-                    hmax = sum;
-                    mind = ind;
-                    msb = diagonals[ind][nohsps];//positions of max of hsps
-                    nqu = diagonals[ind][nohsps+nohsps];
-                    if( possbjct )  *possbjct = msb;
-                    if( posquery )  *posquery = nqu;
-                }
-            }
-        }
+    hspscanner = &scanner;
+
+    try {
+        scanned = GetParent()->ScanScoresForHSPs( this );
+    } catch( myexception const& ex ) {
+        hspscanner = NULL;
+        free( hsprow );
+        hsprow = NULL;
+        throw myruntime_error( ex.what(), ex.eclass());
     }
 
-//{{TESTING BLOCK
-// GetParent()->PrintScoringMatrix( stderr );
-// fprintf( stderr, "\n\n");
-// for( n = 0; n < GetQuerySize(); n++ ) {
-//     if( !n ) {
-//         fprintf( stderr, "****");
-//         for( m = 0; m < GetSubjectSize(); m++ )
-//             fprintf( stderr, " %5d", m );
-//         fprintf( stderr, "\n");
-//         for( m = 0; m < GetSubjectSize(); m++ )
-//             fprintf( stderr, "------" );
-//         fprintf( stderr, "\n");
-//     }
-//     fprintf( stderr, "%3d:", n );
-//     for( m = 0; m < GetSubjectSize(); m++ ) {
-//         fprintf( stderr, " %5.1f", ( double )hsps[m][n] / GetAutoScalingFactor());
-//     }
-//     fprintf( stderr, "\n");
-// }
-// fprintf( stderr, "\n%d %5.1f: %d %d\n\n", bret, ( double )hmax/* / GetAutoScalingFactor()*/, nqu, msb );
-// if( bret ) {
-//     for( k = 0; k < nohsps; k++ ) {
-//         fprintf( stderr, "  score=%-.1f at (%d,%d)\n",
-//             ( double )diagonals[mind][k]/*/GetAutoScalingFactor()*/,
-//             diagonals[mind][k+nohsps+nohsps], diagonals[mind][k+nohsps]);
-//     }
-//     fprintf( stderr, "--------\n");
-//     for( ind = 0; ind < GetSubjectSize() + GetQuerySize() - 1; ind++ ) {
-//         if( diagonals[ind][nohsps-1] <= 0 )
-//             continue;
-//         for( k = 0; k < nohsps; k++ ) {
-//             fprintf( stderr, "  score=%-.1f at (%d,%d)\n",
-//                 ( double )diagonals[ind][k]/*/GetAutoScalingFactor()*/,
-//                 diagonals[ind][k+nohsps+nohsps], diagonals[ind][k+nohsps]);
-//         }
-//         fprintf( stderr, "\n");
-//     }
-// }
-//}}
+    hspscanner = NULL;
+    free( hsprow );
+    hsprow = NULL;
 
-    for( m = GetSubjectSize(); m < GetSubjectSize() + GetQuerySize() - 1; m++ ) {
-        if( diagonals[m]) { free( diagonals[m]); diagonals[m] = NULL; }
-    }
-    for( m = 0; m < GetSubjectSize(); m++ ) {
-        if( diagonals[m]) { free( diagonals[m]); diagonals[m] = NULL; }
-        if( hsps[m]) { free( hsps[m]); hsps[m] = NULL; }
-        if( lens[m]) { free( lens[m]); lens[m] = NULL; }
+    if( !scanned )
+        return true;
+
+    if( scanner.GetFound()) {
+        if( possbjct )  *possbjct = scanner.GetSbjctPos();
+        if( posquery )  *posquery = scanner.GetQueryPos();
     }
-    if( diagonals ) { free( diagonals ); diagonals = NULL; }
-    if( hsps ) { free( hsps ); hsps = NULL; }
-    if( lens ) { free( lens ); lens = NULL; }
+    return scanner.GetFound();
+}
+
+// -------------------------------------------------------------------------
+// ScanHSPRow: scans image scores of subject position m against all query
+//     positions for hsps; the scores are those the matrix would be set
+//     to; returns true when hsps are found and the scan is to stop
+// -------------------------------------------------------------------------
+
+bool AttributableScores::ScanHSPRow( int m, const double* values )
+{
+    if( !hspscanner || !hsprow || !values )
+        throw myruntime_error( mystring( "AttributableScores: No scan of HSPs in progress." ));
 
-    if( !errstr.empty())
-        throw myruntime_error( errstr );
+    for( int n = 0; n < GetQuerySize(); n++ )
+        hsprow[n] = ( TScore )GetScoreOf( values[n] );
 
-    return bret;
+    return hspscanner->ScanRow( m, hsprow );
 }
 
 // -------------------------------------------------------------------------
@@ -1149,6 +1102,69 @@ void AttributableScores::ComputePositionalScoreProbs()
     }
 }
 
+// -------------------------------------------------------------------------
+// TabulateScores: makes the table of image scores and their weights as
+//     they contribute to score probabilities; the parent fills the table
+//     in the order of its computation of probabilities, so that the
+//     probabilities computed from the table are the same; returns false
+//     if the table cannot be made
+// -------------------------------------------------------------------------
+
+bool AttributableScores::TabulateScores()
+{
+    DestroyScoreTable();
+
+    if( !GetKeepInMemory() || GetQuerySize() <= 0 || GetSubjectSize() <= 0 || !GetImage() || !GetMask())
+        return false;
+
+    tablecapacity = GetQuerySize() * GetSubjectSize();
+    tablescores = ( double* )malloc( sizeof( double ) * tablecapacity * 2 );
+
+    if( !tablescores )
+        throw myruntime_error( mystring( "AttributableScores: Not enough memory." ));
+
+    tableweights = tablescores + tablecapacity;
+
+    if( !GetParent()->TabulateScores( this )) {
+        DestroyScoreTable();
+        return false;
+    }
+    return true;
+}
+
+// -------------------------------------------------------------------------
+// DestroyScoreTable: deallocates the table of scores
+// -------------------------------------------------------------------------
+
+void AttributableScores::DestroyScoreTable()
+{
+    if( tablescores )
+        free( tablescores );
+    tablescores = tableweights = NULL;
+    tablesize = tablecapacity = 0;
+}
+
+// -------------------------------------------------------------------------
+// PushTableScore: appends the image score at the given positions and its
+//     weight to the table of scores; scores masked to be ignored and
+//     scores not greater than SCORE_MIN never contribute to probabilities
+//     and are omitted; negative weight indicates that the score is to be
+//     considered for the range of scores only
+// -------------------------------------------------------------------------
+
+void AttributableScores::PushTableScore( int m, int n, double weight )
+{
+    if( !tablescores || tablecapacity <= tablesize )
+        throw myruntime_error( mystring( "AttributableScores: Memory access error." ));
+
+    if( image[m][n] <= SCORE_MIN || GetMaskedToIgnore( m, n ))
+        return;
+
+    tablescores[tablesize] = image[m][n];
+    tableweights[tablesize] = weight;
+    tablesize++;
+}
+
 // -------------------------------------------------------------------------
 // ComputeScoreProbabilities: compute probabilities to observe scores at
 //     each position of the scoring system
@@ -1156,9 +1172,6 @@ void AttributableScores::ComputePositionalScoreProbs()
 
 void AttributableScores::ComputeScoreProbabilities()
 {
-    const double    accuracy = 1.e-6;
-    char            strbuf[KBYTE];
-    double          prob, consv;
 #ifdef __DEBUG__
     if( GetParent() == NULL || GetParentProbFunction() == NULL )
         throw myruntime_error( mystring( "AttributableScores: Unable to compute score probabilities." ));
@@ -1196,6 +1209,20 @@ void AttributableScores::ComputeScoreProbabilities()
 
     ( GetParent()->*GetParentProbFunction())( this );
 
+    VerifyProbabilityConservation();
+}
+
+// -------------------------------------------------------------------------
+// VerifyProbabilityConservation: verifies that score probabilities sum
+//     to 1
+// -------------------------------------------------------------------------
+
+void AttributableScores::VerifyProbabilityConservation() const
+{
+    const double    accuracy = 1.e-6;
+    char            strbuf[KBYTE];
+    double          prob, consv;
+
     consv = 0.0;
     for( int sc = GetMinScore(); sc <= GetMaxScore(); sc ++ ) {
         prob = GetProbabilityOf( sc );
@@ -1432,53 +1459,52 @@ void AttributableScores::ComputeKarlinsK()
         return;
     }
 
+    //value computed for the same scores before
+    if( 0.0 < GetGivenK()) {
+        SetK( GetGivenK());
+        return;
+    }
+
     double  sigma = 0.0;    //probability of alignment of any length
     double  Pj  = 1.0;      //probability to obtain arbitrary alignment of length j
-    double  Pji = 0.0;      //probability to obtain alignment of length j with score i
-    double* Pjivector =                 //vector of alignment score probabilities P[j](i),
-        GetPrivateProbVector();         // where j is an alignment length, and i is a score
+    double* Pjivector = NULL;   //vector of alignment score probabilities P[j](i),
+    double* Pprvector = NULL;   // where j is an alignment length, and i is a score; and P[j-1](i)
+    double* Ptmp = NULL;
     TScore  min_j_score = 0;    //minimum score of alignment of length j
     TScore  max_j_score = 0;    //minimum score of alignment of length j
-    TScore  lower = 0;          //lower bound of scores
-    TScore  upper = 0;          //upper bound of scores
+    TScore  top = 0;            //index of the maximum score of alignment of length j
+    TScore  i, k, x;
 
     size_t  maxPjisize = maxit * range + 1; //plus to include zero
 
-    if( !Pjivector ) {
-        error( "Probability vector is not allocated." );
-        return;
-    }
+    if( GetPrivateProbVectorSize() < maxPjisize )
+        NewPrivateProbVector( maxit, range );
+
+    Pprvector = GetPrivateProbVector();
+    Pjivector = Pprvector + GetPrivateProbVectorSize();
 
-    ResetPrivateProbVector( maxPjisize );
-    Pjivector[0] = 1.0;     //in order to compute the lowest score probability of alignment with length=1
+    Pprvector[0] = 1.0;     //in order to compute the lowest score probability of alignment with length=1
 
 
     //compute sigma, probability of alignment of any length
-    // Pjivector is reused in each iteration to restore probabilities of
-    // alignment of length one smaller
     for( int j = 1; j <= maxit && precision < Pj; j++ )
     {
-        TScore  i;
         min_j_score += GetMinScore();
         max_j_score += GetMaxScore();
-        lower = GetMaxScore();
-        upper = GetMaxScore();
+        top = max_j_score - min_j_score;
 
-        //compute Pj for all possible scores i
-        for( i = max_j_score; min_j_score <= i; i -= gcd )
-        {
-            Pji = 0.0;
-            //P[j](i) = SUM P[j-1](i-k) P[1](k)
-            for( int k = lower; k <= upper; k += gcd ) {
-                Pji += Pjivector[ ( i - min_j_score ) - ( k - GetMinScore()) ] * GetProbabilityOf( k );
-            }
+        //compute Pj for all possible scores i:
+        //P[j](i) = SUM P[j-1](i-k) P[1](k);
+        //the sum for each i is accumulated over k in increasing order, and
+        //the terms of zero probability do not contribute to it; vectors
+        //are indexed by score minus the minimum score
+        memset( Pjivector, 0, sizeof( double ) * ( top + 1 ));
 
-            if( GetMinScore() < lower )
-                lower -= gcd;
-            if( i - min_j_score <= range )
-                upper -= gcd;
-
-            Pjivector[ i - min_j_score ] = Pji;
+        for( k = range % gcd; k <= range; k += gcd ) {
+            if( !probabilities[k] )
+                continue;
+            for( x = k; x <= k + top - range; x += gcd )
+                Pjivector[x] += Pprvector[x-k] * probabilities[k];
         }
 
         Pj = 0.0;
@@ -1495,6 +1521,8 @@ void AttributableScores::ComputeKarlinsK()
             Pj += Pjivector[ i - min_j_score ];
 
         sigma += Pj / j;
+
+        Ptmp = Pprvector; Pprvector = Pjivector; Pjivector = Ptmp;
     }
 
     //we have all variables found to compute K
@@ -27,6 +27,7 @@
 // extern double rint( double x );
 
 class AbstractScoreMatrix;
+class HSPScanner;
 
 
 ////////////////////////////////////////////////////////////////////////////
@@ -58,6 +59,9 @@ public:
 
     bool                IsValid() const;                                //whether score matrix is valid
 
+    double              GetGivenK() const                       { return givenK; }
+    void                SetGivenK( double value )               { givenK = value; }
+
     double              GetImageScore( int m, int n ) const;            //returns image score at specified profile positions
 
     bool                GetMaskedUnmasked( int m, int n  ) const    { return GetMasked( m, n  ) == Unmasked; }
@@ -68,6 +72,7 @@ public:
 
     virtual double              GetScore( int m, int n ) const = 0;     //returns score at specified profile positions
     virtual void                SetScore( double, int m, int n ) = 0;   //set score at specified positions
+    virtual double              GetScoreOf( double ) const = 0;         //score the value is set as
 
     const double* const         GetQueryInfContent() const             { return queryinfcontent; }
     const double* const         GetSbjctInfContent() const             { return sbjctinfcontent; }
@@ -93,8 +98,11 @@ public:
     double              GetConstantForHAdjustment() const           { return constant_c; }
 
     virtual void                Init( int sz_query, int sz_sbjct ) = 0;
+    void                Rebind( const double** im, const TMask** msk, int sz_query, int sz_sbjct );
 
     bool                SearchForHSPs( double minhspscore, int hsplen, int nohsps, int maxdist, int* = NULL, int* = NULL );
+    bool                PrescanForHSPs( double minhspscore, int hsplen, int nohsps, int maxdist, int* = NULL, int* = NULL );
+    bool                ScanHSPRow( int m, const double* values );      //scan image scores of subject position m for hsps
 
     void                AdjustGaps(
                                 const LogOddsMatrix& qlogo, const LogOddsMatrix& slogo,
@@ -126,6 +134,8 @@ public:
     void                IncProbabilityOf( double value, TScore );       //increment probability value
     void                DivideProbabilityOf( double value, TScore );    //divide probability by value
 
+    void                PushTableScore( int m, int n, double weight );  //append score at the positions to the table of scores
+
 
     void                ComputePositionalInfContents();                 //compute entropies at each position of score system
 
@@ -221,6 +231,7 @@ protected:
     void                ComputePositionalScoreProbs();              //compute positional probabilities of scores
     void                ComputeScoreProbabilities();                //compute probabilities to observe scores at each position
     void                ComputeScalingLambda();                     //compute scaling parameter lambda
+    void                VerifyProbabilityConservation() const;      //verify that score probabilities sum to 1
     virtual void                ComputeEntropyGivenLambda() = 0;    //compute relative entropy given previously computed lambda
     virtual double              ComputePositionalEntropy(           //compute entropy at specified position of score system
                             double lambda, int minscore, int maxscore, int pos,
@@ -233,6 +244,12 @@ protected:
     void                NewProbabilities( size_t );                         //allocate memory for probabilities
     void                DestroyProbabilities();                             //deallocate memory for probabilities
 
+    bool                TabulateScores();                                   //make the table of image scores and their weights
+    void                DestroyScoreTable();                                //deallocate the table of scores
+    int                 GetTableSize() const        { return tablesize; }   //number of scores in the table
+    const double*       GetTableScores() const      { return tablescores; } //image scores of the table
+    const double*       GetTableWeights() const     { return tableweights; }//weights of the scores in the table
+
 
     TScore              GetGCD() const      { return score_gcd; }           //get the greatest common divisor
 
@@ -304,12 +321,20 @@ private:
     int*                    sbjctminmaxscores;  //min/max scores along the subject positions
 
     double*                 probabilities;      //score probabilities
+
+    double*                 tablescores;        //table of image scores contributing to score probabilities
+    double*                 tableweights;       //weights of the scores in the table
+    int                     tablesize;          //number of scores in the table
+    int                     tablecapacity;      //maximum number of scores the table can hold
     TScore                  min_score;          //minimum score value
     TScore                  max_score;          //maximum score value
     TScore                  score_gcd;          //the greatest common divisor of scores
 
-    double*                 priv_prob_vector;   //private probability vector
-    size_t                  prob_vector_size;   //size of private probability vector
+    double*                 priv_prob_vector;   //private probability vector of two halves
+    size_t                  prob_vector_size;   //size of one half of private probability vector
+    double                  givenK;             //value of K known beforehand; negative if K is to be computed
+    HSPScanner*             hspscanner;         //scan of hsps in progress
+    TScore*                 hsprow;             //row of scores being scanned for hsps
 
     double                  expscore;           //expected score per column pair
     bool                    allnegatives;       //whether scores are all negative
@@ -960,7 +985,8 @@ void AttributableScores::NewPrivateProbVector( size_t maxit, size_t range )
 
     size_t  size = maxit * range + 1;   //plus to include the zero value
 
-    priv_prob_vector = ( double* )malloc( sizeof( double ) * size );
+    //two halves to keep probabilities of alignments of two consecutive lengths
+    priv_prob_vector = ( double* )malloc( sizeof( double ) * size * 2 );
 
     if( !priv_prob_vector )
         throw myruntime_error( mystring( "AttributableScores: Not enough memory." ));
@@ -44,7 +44,8 @@ AttributableScoresFPI::AttributableScoresFPI(
         keep,
         as_factor
     ),
-    scores( NULL )
+    scores( NULL ),
+    sbjct_capacity( 0 )
 {
 }
 
@@ -55,7 +56,8 @@ AttributableScoresFPI::AttributableScoresFPI(
 AttributableScoresFPI::AttributableScoresFPI()
 :
     AttributableScores(),
-    scores( NULL )
+    scores( NULL ),
+    sbjct_capacity( 0 )
 {
 }
 
@@ -72,21 +74,28 @@ void AttributableScoresFPI::Init( int sz_query, int sz_sbjct )
 
         AttributableScores::Init(); //query and subject size have to be initialized before
 
-        scores = ( double** )malloc( sizeof( double* ) * GetSubjectSize());
+        //rows follow the table of row addresses in one block, which is
+        //reused by the following subjects not longer than this one
+        if( sbjct_capacity < GetSubjectSize()) {
+            if( scores )
+                free( scores );
+            sbjct_capacity = 0;
 
-        if( !scores ) 
-            throw myruntime_error( mystring( "AttributableScoresFPI: Not enough memory." ));
+            scores = ( double** )malloc( sizeof( double* ) * GetSubjectSize() +
+                                         sizeof( double ) * GetSubjectSize() * GetQuerySize());
 
-
-        for( int m = 0; m < GetSubjectSize(); m++ )
-        {
-            scores[m] = ( double* )malloc( sizeof( double ) * GetQuerySize());
-
-            if( !scores[m] )
+            if( !scores ) 
                 throw myruntime_error( mystring( "AttributableScoresFPI: Not enough memory." ));
 
-            memset( scores[m], 0, sizeof( double ) * GetQuerySize());
+            sbjct_capacity = GetSubjectSize();
         }
+
+        scores[0] = ( double* )( scores + sbjct_capacity );
+
+        for( int m = 1; m < GetSubjectSize(); m++ )
+            scores[m] = scores[m-1] + GetQuerySize();
+
+        memset( scores[0], 0, sizeof( double ) * GetSubjectSize() * GetQuerySize());
     }
 }
 
@@ -97,8 +106,6 @@ void AttributableScoresFPI::Init( int sz_query, int sz_sbjct )
 AttributableScoresFPI::~AttributableScoresFPI()
 {
     if( scores ){
-        for( int m = 0; m < GetSubjectSize(); m++ )
-            free( scores[m] );
         free( scores );
         scores = NULL;
     }
@@ -44,6 +44,7 @@ public:
 
     virtual double      GetScore( int m, int n ) const;             //returns score at specified profile positions
     virtual void        SetScore( double, int m, int n );           //set score at specified positions
+    virtual double      GetScoreOf( double ) const;                 //score the value is set as
 
     virtual void        Init( int sz_query, int sz_sbjct );
 
@@ -85,6 +86,7 @@ protected:
 
 private:
     double**                scores;             //matrix of floating-point scores
+    int                     sbjct_capacity;     //number of subject positions the matrix has space for
 };
 
 // INLINES ...
@@ -125,9 +127,19 @@ void AttributableScoresFPI::SetScore( double value, int m, int n )
         throw myruntime_error( mystring( "AttributableScoresFPI: Memory access error." ));
 #endif
 
+    scores[m][n] = GetScoreOf( value );
+}
+
+// -------------------------------------------------------------------------
+// GetScoreOf: returns the score the value is set as
+// -------------------------------------------------------------------------
+
+inline
+double AttributableScoresFPI::GetScoreOf( double value ) const
+{
     if( SCORE_MIN < value )
         value *= GetAutoScalingFactor();
-    scores[m][n] = value;
+    return value;
 }
 
 // -------------------------------------------------------------------------
@@ -44,7 +44,8 @@ AttributableScoresII::AttributableScoresII(
         keep,
         as_factor
     ),
-    scores( NULL )
+    scores( NULL ),
+    sbjct_capacity( 0 )
 {
 }
 
@@ -55,7 +56,8 @@ AttributableScoresII::AttributableScoresII(
 AttributableScoresII::AttributableScoresII()
 :
     AttributableScores(),
-    scores( NULL )
+    scores( NULL ),
+    sbjct_capacity( 0 )
 {
 }
 
@@ -72,21 +74,28 @@ void AttributableScoresII::Init( int sz_query, int sz_sbjct )
 
         AttributableScores::Init(); //query and subject size have to be initialized before
 
-        scores = ( TScore** )malloc( sizeof( TScore* ) * GetSubjectSize());
+        //rows follow the table of row addresses in one block, which is
+        //reused by the following subjects not longer than this one
+        if( sbjct_capacity < GetSubjectSize()) {
+            if( scores )
+                free( scores );
+            sbjct_capacity = 0;
 
-        if( !scores ) 
-            throw myruntime_error( mystring( "AttributableScoresII: Not enough memory." ));
+            scores = ( TScore** )malloc( sizeof( TScore* ) * GetSubjectSize() +
+                                         sizeof( TScore ) * GetSubjectSize() * GetQuerySize());
 
-
-        for( int m = 0; m < GetSubjectSize(); m++ )
-        {
-            scores[m] = ( TScore* )malloc( sizeof( TScore ) * GetQuerySize());
-
-            if( !scores[m] )
+            if( !scores ) 
                 throw myruntime_error( mystring( "AttributableScoresII: Not enough memory." ));
 
-            memset( scores[m], 0, sizeof( TScore ) * GetQuerySize());
+            sbjct_capacity = GetSubjectSize();
         }
+
+        scores[0] = ( TScore* )( scores + sbjct_capacity );
+
+        for( int m = 1; m < GetSubjectSize(); m++ )
+            scores[m] = scores[m-1] + GetQuerySize();
+
+        memset( scores[0], 0, sizeof( TScore ) * GetSubjectSize() * GetQuerySize());
     }
 }
 
@@ -97,8 +106,6 @@ void AttributableScoresII::Init( int sz_query, int sz_sbjct )
 AttributableScoresII::~AttributableScoresII()
 {
     if( scores ){
-        for( int m = 0; m < GetSubjectSize(); m++ )
-            free( scores[m] );
         free( scores );
         scores = NULL;
     }
@@ -114,7 +121,7 @@ AttributableScoresII::~AttributableScoresII()
 
 void AttributableScoresII::ScaleToAttainLambda()
 {
-    double          multiplier;
+    double          multiplier = 1.0;
 
 #ifdef SCALE_BINARY_SEARCH
 
@@ -124,8 +131,10 @@ void AttributableScoresII::ScaleToAttainLambda()
     double  diff_lambda;    //difference of the consecutive lamdas
     double  diff_target;    //difference of the target lambdas
     double  min_diff_target = 10.0;//minimum value of such difference
+    bool    pending = false;        //whether the scores lag behind the last multiplier
 
     ComputeProbabilitiesAndLambda();
+    TabulateScores();
 
     double          right = 1.0;    //right interval bound
     double          left  = 1.0;    //left interval bound
@@ -163,8 +172,7 @@ void AttributableScoresII::ScaleToAttainLambda()
             }
 // fprintf( stderr, "factor=%f, factor_low=%f, factor_high=%f\n", multiplier, left, right );
 
-            AdjustScoresInMatrix( multiplier, ImageTable );
-            ComputeProbabilitiesAndLambda();
+            pending = ScaleTableAndComputeLambda( multiplier );
 
             if( GetLambda() < 0.0 )
                 break;
@@ -184,8 +192,7 @@ void AttributableScoresII::ScaleToAttainLambda()
 
             prev_lambda = GetLambda();
 
-            AdjustScoresInMatrix( multiplier, ImageTable );
-            ComputeProbabilitiesAndLambda();
+            pending = ScaleTableAndComputeLambda( multiplier );
 
             if( GetLambda() < 0.0 )
                 break;
@@ -217,6 +224,7 @@ void AttributableScoresII::ScaleToAttainLambda()
 // fprintf( stderr, "IntegerScaleMatrix...\n" );
         AdjustScoresInMatrix( multiplier = 1.0, ImageTable );
         multiplier = IntegerScaleMatrix();
+        pending = false;
     }
 
     diff_target = fabs( GetRefLambda() - GetLambda());
@@ -224,8 +232,14 @@ void AttributableScoresII::ScaleToAttainLambda()
     if( GetLambda() < 0.0 || min_diff_target < diff_target ) {
         AdjustScoresInMatrix( multiplier = max_multiplier, ImageTable );
         ComputeProbabilitiesAndLambda();
+    } else if( pending ) {
+        //write the scores once the multiplier has been found
+        AdjustScoresInMatrix( multiplier, ImageTable );
+        ComputeProbabilitiesAndLambda();
     }
 
+    DestroyScoreTable();
+
 
 #else //if not defined SCALE_BINARY_SEARCH
 
@@ -240,6 +254,73 @@ void AttributableScoresII::ScaleToAttainLambda()
     SetPrivateMultiplier( multiplier );
 }
 
+// -------------------------------------------------------------------------
+// ScaleTableAndComputeLambda: computes score probabilities and lambda for
+//     the scores scaled by the multiplier; scores are scaled and rounded in
+//     the table of scores, which makes the same probabilities as the
+//     matrix of scaled scores does, while the matrix itself is left
+//     unchanged; returns true if so; otherwise, if there is no table, the
+//     scores in the matrix are scaled and false is returned
+// -------------------------------------------------------------------------
+
+bool AttributableScoresII::ScaleTableAndComputeLambda( double multiplier )
+{
+    const double*   tscores = GetTableScores();
+    const double*   tweights = GetTableWeights();
+    double  normterm = 0.0;
+    double  avgscore = 0.0;
+    TScore  l_minscore = 0,
+            l_maxscore = 0;
+    TScore  loc_score  = 0;
+    int     t;
+
+    if( tscores && tweights ) {
+        for( t = 0; t < GetTableSize(); t++ ) {
+            loc_score = GetRoundedScore( tscores[t] * multiplier );
+
+            if( loc_score <= SCORE_MIN )
+                continue;
+
+            if( loc_score < l_minscore ) l_minscore = loc_score;
+            if( l_maxscore < loc_score ) l_maxscore = loc_score;
+        }
+
+        SetMinMaxScores( l_minscore, l_maxscore );
+
+        for( t = 0; t < GetTableSize(); t++ ) {
+            if( tweights[t] < 0.0 )
+                continue;
+
+            loc_score = GetRoundedScore( tscores[t] * multiplier );
+
+            if( loc_score <= SCORE_MIN )
+                continue;
+
+            IncProbabilityOf( tweights[t], loc_score );
+            normterm += tweights[t];
+        }
+    }
+
+    if( !normterm ) {
+        //no table or no scores to normalize by; compute them from the matrix
+        AdjustScoresInMatrix( multiplier, ImageTable );
+        ComputeProbabilitiesAndLambda();
+        return false;
+    }
+
+    for( int sc = GetMinScore(); sc <= GetMaxScore(); sc++ ) {
+        DivideProbabilityOf( normterm, sc );
+        avgscore += sc * GetProbabilityOf( sc );
+    }
+
+    SetExpectedScore( avgscore );
+    VerifyProbabilityConservation();
+
+    if( GetExpectedScore() < 0.0 )
+        ComputeScalingLambda();
+    return true;
+}
+
 // -------------------------------------------------------------------------
 // IntegerScaleMatrix: perform iterative scaling until required lambda is
 //     attained; integer scaling is used 
@@ -44,6 +44,7 @@ public:
 
     virtual double      GetScore( int m, int n ) const;             //returns score at specified profile positions
     virtual void        SetScore( double, int m, int n );           //set score at specified positions
+    virtual double      GetScoreOf( double ) const;                 //score the value is set as
 
     virtual void        Init( int sz_query, int sz_sbjct );
 
@@ -73,6 +74,8 @@ protected:
 
     virtual void        ScaleToAttainLambda();                      //perform iterative scaling until required lambda is attained
     double              IntegerScaleMatrix();                       //same but integer scaling is used instead
+    bool                ScaleTableAndComputeLambda( double );      //compute lambda for the table of scores scaled by a factor
+    TScore              GetRoundedScore( double ) const;            //integer score corresponding to the value
 
     virtual void        ComputeEntropyGivenLambda();                //compute relative entropy given previously computed lambda
     virtual double      ComputePositionalEntropy(                   //compute entropy at specified position of score system
@@ -86,6 +89,7 @@ protected:
 
 private:
     TScore**                scores;             //matrix of integer scores computed by processing two profiles
+    int                     sbjct_capacity;     //number of subject positions the matrix has space for
 };
 
 // INLINES ...
@@ -126,9 +130,29 @@ void AttributableScoresII::SetScore( double value, int m, int n )
         throw myruntime_error( mystring( "AttributableScoresII: Memory access error." ));
 #endif
 
+    scores[m][n] = GetRoundedScore( value );
+}
+
+// -------------------------------------------------------------------------
+// GetScoreOf: returns the score the value is set as
+// -------------------------------------------------------------------------
+
+inline
+double AttributableScoresII::GetScoreOf( double value ) const
+{
+    return ( double )GetRoundedScore( value );
+}
+
+// -------------------------------------------------------------------------
+// GetRoundedScore: returns the integer score the value is rounded to
+// -------------------------------------------------------------------------
+
+inline
+TScore AttributableScoresII::GetRoundedScore( double value ) const
+{
     if( SCORE_MIN < value )
         value *= GetAutoScalingFactor();
-    scores[m][n] = ( TScore )rint( value );
+    return ( TScore )rint( value );
 }
 
 // -------------------------------------------------------------------------
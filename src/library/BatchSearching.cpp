@@ -0,0 +1,341 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Mindaugas Margelevicius                         *
+ *   Institute of Biotechnology, Vilnius                                   *
+ *   minmar@ibt.lt                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "BatchSearching.h"
+
+#include "mystring.h"
+#include "myexcept.h"
+
+
+
+////////////////////////////////////////////////////////////////////////////
+// CLASS BatchWorker
+//
+// Constructor
+//
+BatchWorker::BatchWorker( BatchSearching* batch, int nosearches )
+:
+    owner( batch ),
+    workers( NULL ),
+    noworkers( 0 ),
+    errclass( NOCLASS )
+{
+    if( !owner || nosearches <= 0 )
+        throw myruntime_error( mystring( "BatchWorker: Invalid arguments." ));
+
+    workers = ( SearchingWorker** )malloc( sizeof( void* ) * nosearches );
+    if( !workers )
+        throw myruntime_error( mystring( "BatchWorker: Not enough memory." ));
+
+    memset( workers, 0, sizeof( void* ) * nosearches );
+    noworkers = nosearches;
+}
+
+// Default constructor
+//
+BatchWorker::BatchWorker()
+:
+    owner( NULL ),
+    workers( NULL ),
+    noworkers( 0 ),
+    errclass( NOCLASS )
+{
+    throw( myruntime_error(
+            mystring( "Default initialization of the BatchWorker objects is prohibited." )));
+}
+
+// Destructor; workers of the searches are released by the batch
+//
+BatchWorker::~BatchWorker()
+{
+    if( workers )
+        free( workers );
+}
+
+////////////////////////////////////////////////////////////////////////////
+// CLASS BatchSearching
+//
+// Constructor
+//
+BatchSearching::BatchSearching( ProfileSearching** srchs, int nosrchs )
+:
+    searches( srchs ),
+    no_searches( nosrchs ),
+    no_threads( 1 ),
+    db_ordinal( 0 ),
+    scan_aborted( false )
+{
+    if( !searches || no_searches <= 0 )
+        throw myruntime_error( mystring( "BatchSearching: No searches given." ));
+
+    for( int n = 0; n < no_searches; n++ )
+        if( !searches[n] )
+            throw myruntime_error( mystring( "BatchSearching: Null search given." ));
+
+    pthread_mutex_init( &db_mutex, NULL );
+}
+
+// Default constructor
+//
+BatchSearching::BatchSearching()
+:
+    searches( NULL ),
+    no_searches( 0 ),
+    no_threads( 1 ),
+    db_ordinal( 0 ),
+    scan_aborted( false )
+{
+    throw( myruntime_error(
+            mystring( "Default initialization of the BatchSearching objects is prohibited." )));
+}
+
+// Destructor
+//
+BatchSearching::~BatchSearching()
+{
+    pthread_mutex_destroy( &db_mutex );
+}
+
+// -------------------------------------------------------------------------
+// Run: searches all queries of the batch against the database, which is
+//     opened and read once
+// -------------------------------------------------------------------------
+
+void BatchSearching::Run()
+{
+    ProfileSearching*   leader = GetLeader();
+    Database&           profile_db = leader->GetProfileDb();
+    int                 n;
+
+    for( n = 0; n < GetNoSearches(); n++ ) {
+        GetSearchAt( n )->Prepare();
+        if( n )
+            GetSearchAt( n )->SetSharedDb( &profile_db );
+    }
+
+    profile_db.Open();
+
+#ifdef  UNIVERSALSCORES
+    message( "Reading frequencies..." );
+    //read the distinct frequency vectors once for all queries
+    profile_db.ReadInFrequencies();
+#endif
+
+    for( n = 0; n < GetNoSearches(); n++ ) {
+        GetSearchAt( n )->PrepareScan();
+        GetSearchAt( n )->PrefilterProfiles();
+    }
+
+    message( "Searching..." );
+
+    if( 1 < GetNoThreads() &&
+        leader->GetScoreSystem() && leader->GetScoreSystem()->GetType() == AbstractScoreMatrix::Universal ) {
+        warning( "Score system shared by all profiles is in use: Searching with one thread." );
+        SetNoThreads( 1 );
+    }
+
+    //shards are given to all searches of the batch alike
+    for( n = 0; n < GetNoSearches(); n++ )
+        db_ordinal = GetSearchAt( n )->SelectShard();
+    scan_aborted = false;
+
+    if( GetNoThreads() <= 1 ) {
+        BatchWorker*    worker = NewWorker( true );
+        try {
+            ScanDatabase( *worker );
+        } catch( myexception const& ) {
+            ReleaseWorker( worker );
+            throw;
+        }
+        ReleaseWorker( worker );
+    }
+    else
+        RunWorkers();
+
+    for( n = 0; n < GetNoSearches(); n++ )
+        GetSearchAt( n )->PostComputationLogic();
+
+    profile_db.Close();
+    message( "Finished." );
+}
+
+// -------------------------------------------------------------------------
+// NewWorker: creates a worker holding a worker of each of the searches
+// -------------------------------------------------------------------------
+
+BatchWorker* BatchSearching::NewWorker( bool primary )
+{
+    BatchWorker*    worker = new BatchWorker( this, GetNoSearches());
+
+    if( !worker )
+        throw myruntime_error( mystring( "BatchSearching: Not enough memory." ));
+
+    try {
+        for( int n = 0; n < GetNoSearches(); n++ )
+            worker->workers[n] = GetSearchAt( n )->NewWorker( primary );
+    } catch( myexception const& ) {
+        ReleaseWorker( worker );
+        throw;
+    }
+
+    GetLeader()->SetupGapScheme( worker->dbgaps );
+    return worker;
+}
+
+// -------------------------------------------------------------------------
+// ReleaseWorker: releases workers of the searches and destroys the worker
+// -------------------------------------------------------------------------
+
+void BatchSearching::ReleaseWorker( BatchWorker* worker )
+{
+    if( !worker )
+        return;
+
+    for( int n = 0; n < worker->noworkers; n++ )
+        if( worker->workers[n] ) {
+            GetSearchAt( n )->ReleaseWorker( worker->workers[n] );
+            worker->workers[n] = NULL;
+        }
+
+    delete worker;
+}
+
+// -------------------------------------------------------------------------
+// NextProfile: reads the next profile from the database; returns false
+//     when the end of the database is reached or the scan has been aborted
+// -------------------------------------------------------------------------
+
+bool BatchSearching::NextProfile( BatchWorker& worker, size_t* ordinal, long* position )
+{
+    ProfileSearching*   leader = GetLeader();
+    bool                got = false;
+
+    pthread_mutex_lock( &db_mutex );
+    try {
+        if( !scan_aborted ) {
+            if( position )
+                *position = leader->GetProfileDb().GetPosition();
+            got = leader->GetProfileDb().Next( worker.dbfreq, worker.dbpssm, worker.dbgaps,
+                    leader->GetGapOpenCost(), leader->GetGapExtnCost(), leader->GetFixedCosts());
+            if( got && ordinal )
+                *ordinal = db_ordinal++;
+        }
+    } catch( myexception const& ex ) {
+        pthread_mutex_unlock( &db_mutex );
+        throw myruntime_error( ex.what(), ex.eclass());
+    }
+    pthread_mutex_unlock( &db_mutex );
+    return got;
+}
+
+// -------------------------------------------------------------------------
+// ScanDatabase: aligns each profile read from the database with all of
+//     the queries that selected it; each search gets its own copy of the
+//     subject's gap costs, since they are adjusted in alignment
+// -------------------------------------------------------------------------
+
+void BatchSearching::ScanDatabase( BatchWorker& worker )
+{
+    size_t  ordinal = 0;
+    long    position = -1;
+    int     n;
+
+    while( NextProfile( worker, &ordinal, &position ))
+        for( n = 0; n < GetNoSearches(); n++ ) {
+            SearchingWorker*    sworker = worker.workers[n];
+            //profiles not selected by the index for the query are skipped
+            if( !GetSearchAt( n )->IsCandidate( ordinal ))
+                continue;
+            sworker->dbgaps = worker.dbgaps;
+            GetSearchAt( n )->ComputationLogicWithProfiles(
+                    *sworker, worker.dbfreq, worker.dbpssm, sworker->dbgaps, ordinal, position );
+        }
+}
+
+// -------------------------------------------------------------------------
+// ScanThread: entry point of a worker thread
+// -------------------------------------------------------------------------
+
+void* BatchSearching::ScanThread( void* arg )
+{
+    BatchWorker*    worker = ( BatchWorker* )arg;
+
+    if( !worker || !worker->owner )
+        return NULL;
+
+    try {
+        worker->owner->ScanDatabase( *worker );
+
+    } catch( myexception const& ex ) {
+        worker->SetError( ex.what(), ex.eclass());
+        pthread_mutex_lock( &worker->owner->db_mutex );
+        worker->owner->scan_aborted = true;
+        pthread_mutex_unlock( &worker->owner->db_mutex );
+    }
+    return NULL;
+}
+
+// -------------------------------------------------------------------------
+// RunWorkers: scans the database with the pool of threads
+// -------------------------------------------------------------------------
+
+void BatchSearching::RunWorkers()
+{
+    int             nthreads = GetNoThreads();
+    BatchWorker**   workers = ( BatchWorker** )malloc( sizeof( void* ) * nthreads );
+    int             nstarted = 0;
+    int             n;
+
+    if( !workers )
+        throw myruntime_error( mystring( "BatchSearching: Not enough memory." ));
+
+    memset( workers, 0, sizeof( void* ) * nthreads );
+
+    try {
+        for( n = 0; n < nthreads; n++ )
+            workers[n] = NewWorker( n == 0 );
+
+        for( n = 0; n < nthreads; n++ ) {
+            if( pthread_create( &workers[n]->thread, NULL, &ScanThread, workers[n] ) != 0 ) {
+                pthread_mutex_lock( &db_mutex );
+                scan_aborted = true;
+                pthread_mutex_unlock( &db_mutex );
+                workers[n]->SetError( "BatchSearching: Failed to create thread.", NOCLASS );
+                break;
+            }
+            nstarted++;
+        }
+    } catch( myexception const& ) {
+        for( n = 0; n < nstarted; n++ )
+            pthread_join( workers[n]->thread, NULL );
+        for( n = 0; n < nthreads; n++ )
+            ReleaseWorker( workers[n] );
+        free( workers );
+        throw;
+    }
+
+    for( n = 0; n < nstarted; n++ )
+        pthread_join( workers[n]->thread, NULL );
+
+    mystring    errmsg;
+    int         errcls = NOCLASS;
+
+    for( n = 0; n < nthreads; n++ ) {
+        if( errmsg.empty() && workers[n]->GetError()) {
+            errmsg = workers[n]->GetError();
+            errcls = workers[n]->GetErrorClass();
+        }
+        ReleaseWorker( workers[n] );
+    }
+    free( workers );
+
+    if( !errmsg.empty())
+        throw myruntime_error( errmsg, errcls );
+}
@@ -0,0 +1,108 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Mindaugas Margelevicius                         *
+ *   Institute of Biotechnology, Vilnius                                   *
+ *   minmar@ibt.lt                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef __BatchSearching__
+#define __BatchSearching__
+
+#include <pthread.h>
+
+#include "debug.h"
+#include "types.h"
+#include "compdef.h"
+#include "rc.h"
+
+#include "GapScheme.h"
+#include "DistributionMatrix.h"
+#include "ProfileSearching.h"
+
+#include "mystring.h"
+#include "myexcept.h"
+
+
+class BatchSearching;
+
+// _________________________________________________________________________
+// Class BatchWorker
+//
+// Data of one thread scanning the database for a batch of queries: the
+// subject profile read and a worker of each of the searches
+//
+
+class BatchWorker {
+public:
+    BatchWorker( BatchSearching*, int nosearches );
+    ~BatchWorker();
+
+    const char*     GetError() const            { return error.empty()? NULL: error.c_str(); }
+    int             GetErrorClass() const       { return errclass; }
+
+protected:
+    explicit BatchWorker();
+
+    void            SetError( const char* msg, int ecl ) { error = msg; errclass = ecl; }
+
+private:
+    friend class BatchSearching;
+
+    BatchSearching*         owner;          //batch the worker belongs to
+    pthread_t               thread;         //thread identifier
+
+    FrequencyMatrix         dbfreq;         //subject profile read from the database
+    LogOddsMatrix           dbpssm;
+    GapScheme               dbgaps;
+
+    SearchingWorker**       workers;        //workers of each of the searches
+    int                     noworkers;      //number of workers
+
+    mystring                error;          //error message if the worker failed
+    int                     errclass;       //class of the error
+};
+
+// _________________________________________________________________________
+// Class BatchSearching
+//
+// Searching of a number of queries against the database in one pass;
+// each profile read from the database is aligned with all of the queries
+//
+
+class BatchSearching
+{
+public:
+    BatchSearching( ProfileSearching** searches, int nosearches );
+    ~BatchSearching();
+
+    void            Run();                  //searching of all queries
+
+    int             GetNoSearches() const                   { return no_searches; }
+
+    int             GetNoThreads() const                    { return no_threads; }
+    void            SetNoThreads( int value )               { no_threads = value; }
+
+protected:
+    explicit BatchSearching();
+
+    ProfileSearching*           GetSearchAt( int n )        { return searches[n]; }
+    ProfileSearching*           GetLeader()                 { return searches[0]; }
+
+    BatchWorker*                NewWorker( bool primary );  //create worker with workers of all searches
+    void                        ReleaseWorker( BatchWorker* );
+    bool                        NextProfile( BatchWorker&, size_t* ordinal, long* position );
+    void                        ScanDatabase( BatchWorker& );
+    void                        RunWorkers();
+    static void*                ScanThread( void* );
+
+private:
+    ProfileSearching**      searches;       //searches of the batch; the first one owns the database
+    int                     no_searches;    //number of searches
+
+    int                     no_threads;     //number of threads to scan the database with
+    size_t                  db_ordinal;     //ordinal number of the next profile read from the database
+    bool                    scan_aborted;   //whether one of the workers failed
+    pthread_mutex_t         db_mutex;       //serializes reading of the database
+};
+
+#endif//__BatchSearching__
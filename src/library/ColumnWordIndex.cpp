@@ -0,0 +1,512 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Mindaugas Margelevicius                         *
+ *   Institute of Biotechnology, Vilnius                                   *
+ *   minmar@ibt.lt                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "data.h"
+#include "Serializer.h"
+#include "ColumnWordIndex.h"
+
+
+const char* ColumnWordIndex::signature = "COMA column-word index v1.0\n";
+
+// -------------------------------------------------------------------------
+// SeedCompare: compares seeds for sorting by profile and diagonal
+// -------------------------------------------------------------------------
+
+static int SeedCompare( const void* key1, const void* key2 )
+{
+    Uint64  seed1 = *( const Uint64* )key1;
+    Uint64  seed2 = *( const Uint64* )key2;
+    return ( seed1 < seed2 )? -1: (( seed2 < seed1 )? 1: 0 );
+}
+
+// -------------------------------------------------------------------------
+// constructor: initialization
+// -------------------------------------------------------------------------
+
+ColumnWordIndex::ColumnWordIndex( int wordlen )
+:   wordlength( wordlen ),
+    nowords( 1 ),
+    postings( NULL ),
+    postwords( NULL ),
+    nopostings( 0 ),
+    postcapacity( 0 ),
+    offsets( NULL ),
+    positions( NULL ),
+    noprofiles( 0 ),
+    profcapacity( 0 )
+{
+    if( wordlength < 1 || CWI_MAX_WORD_LENGTH < wordlength )
+        throw myruntime_error( mystring( "ColumnWordIndex: Wrong word length." ));
+
+    for( int k = 0; k < wordlength; k++ )
+        nowords *= NUMAA;
+}
+
+// -------------------------------------------------------------------------
+// destructor: deallocation of resources
+// -------------------------------------------------------------------------
+
+ColumnWordIndex::~ColumnWordIndex()
+{
+    Destroy();
+}
+
+// -------------------------------------------------------------------------
+// Destroy: deallocates memory of the index
+// -------------------------------------------------------------------------
+
+void ColumnWordIndex::Destroy()
+{
+    if( postings )
+        free( postings );
+    if( postwords )
+        free( postwords );
+    if( offsets )
+        free( offsets );
+    if( positions )
+        free( positions );
+
+    postings = NULL;
+    postwords = NULL;
+    offsets = NULL;
+    positions = NULL;
+    nopostings = postcapacity = 0;
+    noprofiles = profcapacity = 0;
+}
+
+// -------------------------------------------------------------------------
+// ReallocPostings: reallocates memory for postings and their words
+// -------------------------------------------------------------------------
+
+void ColumnWordIndex::ReallocPostings( size_t newcap )
+{
+    TCWIPosting*    tmpposts;
+    Uint32*         tmpwords;
+
+    if( newcap <= postcapacity )
+        return;
+
+    tmpposts = ( TCWIPosting* )realloc( postings, sizeof( TCWIPosting ) * newcap );
+    if( !tmpposts )
+        throw myruntime_error( mystring( "ColumnWordIndex: Not enough memory." ));
+    postings = tmpposts;
+
+    tmpwords = ( Uint32* )realloc( postwords, sizeof( Uint32 ) * newcap );
+    if( !tmpwords )
+        throw myruntime_error( mystring( "ColumnWordIndex: Not enough memory." ));
+    postwords = tmpwords;
+
+    postcapacity = newcap;
+}
+
+// -------------------------------------------------------------------------
+// ReallocPositions: reallocates memory for positions of profiles
+// -------------------------------------------------------------------------
+
+void ColumnWordIndex::ReallocPositions( size_t newcap )
+{
+    Uint64* tmppos;
+
+    if( newcap <= profcapacity )
+        return;
+
+    tmppos = ( Uint64* )realloc( positions, sizeof( Uint64 ) * newcap );
+    if( !tmppos )
+        throw myruntime_error( mystring( "ColumnWordIndex: Not enough memory." ));
+    positions = tmppos;
+    profcapacity = newcap;
+}
+
+// -------------------------------------------------------------------------
+// GetColumnClass: returns the class of profile column, which is the
+//     residue of the greatest log-odds score; -1 if the column is of X
+// -------------------------------------------------------------------------
+
+int ColumnWordIndex::GetColumnClass( const LogOddsMatrix& pssm, int n )
+{
+    int     a, best = 0;
+
+    if( pssm.GetResidueAt( n ) == X )
+        return -1;
+
+    for( a = 1; a < NUMAA; a++ )
+        if( pssm.GetValueAt( n, best ) < pssm.GetValueAt( n, a ))
+            best = a;
+    return best;
+}
+
+// -------------------------------------------------------------------------
+// AddProfile: adds words of the profile at the given position of the
+//     database file; profiles are to be added in the order of the file
+// -------------------------------------------------------------------------
+
+void ColumnWordIndex::AddProfile( long position, const LogOddsMatrix& pssm )
+{
+    int*    classes = NULL;
+    size_t  code;
+    int     n, k, len;
+
+    if( offsets )
+        throw myruntime_error( mystring( "ColumnWordIndex: Unable to add profile to complete index." ));
+
+    if( position < 0 )
+        throw myruntime_error( mystring( "ColumnWordIndex: Invalid position of profile." ));
+
+    if( profcapacity <= noprofiles )
+        ReallocPositions( profcapacity? profcapacity * 2: ALLOCPOS );
+
+    len = pssm.GetColumns();
+
+    if( wordlength <= len ) {
+        classes = ( int* )malloc( sizeof( int ) * len );
+        if( !classes )
+            throw myruntime_error( mystring( "ColumnWordIndex: Not enough memory." ));
+
+        for( n = 0; n < len; n++ )
+            classes[n] = GetColumnClass( pssm, n );
+
+        try {
+            for( n = 0; n + wordlength <= len; n++ ) {
+                code = 0;
+                for( k = 0; k < wordlength; k++ ) {
+                    if( classes[n+k] < 0 )
+                        break;
+                    code = code * NUMAA + classes[n+k];
+                }
+                if( k < wordlength )
+                    //word includes column of X
+                    continue;
+
+                if( postcapacity <= nopostings )
+                    ReallocPostings( postcapacity? postcapacity * 2: ALLOCPOS );
+
+                postings[nopostings].profile = ( Uint32 )noprofiles;
+                postings[nopostings].position = ( Uint32 )n;
+                postwords[nopostings] = ( Uint32 )code;
+                nopostings++;
+            }
+        } catch( myexception const& ) {
+            free( classes );
+            throw;
+        }
+        free( classes );
+    }
+
+    positions[noprofiles++] = ( Uint64 )position;
+}
+
+// -------------------------------------------------------------------------
+// ShiftPositions: shifts the positions of all profiles by the given
+//     amount, e.g. when a header is put in front of the profiles
+// -------------------------------------------------------------------------
+
+void ColumnWordIndex::ShiftPositions( long amount )
+{
+    for( size_t n = 0; n < noprofiles; n++ ) {
+        if( amount < 0 && positions[n] < ( Uint64 )( -amount ))
+            throw myruntime_error( mystring( "ColumnWordIndex: Invalid shift of profiles." ));
+        positions[n] += amount;
+    }
+}
+
+// -------------------------------------------------------------------------
+// Reopen: makes the complete index, e.g. read from file, open for adding
+//     the words of further profiles; postings sorted by word are
+//     assigned their words back, so that the index written again is the
+//     same as that made of all the profiles at once
+// -------------------------------------------------------------------------
+
+void ColumnWordIndex::Reopen()
+{
+    size_t  w, n;
+
+    if( !offsets )
+        return;
+
+    if( postwords )
+        free( postwords );
+    postwords = ( Uint32* )malloc( sizeof( Uint32 ) * ( postcapacity + 1 ));
+    if( !postwords )
+        throw myruntime_error( mystring( "ColumnWordIndex: Not enough memory." ));
+
+    for( w = 0; w < nowords; w++ )
+        for( n = offsets[w]; n < offsets[w+1]; n++ )
+            postwords[n] = ( Uint32 )w;
+
+    free( offsets );
+    offsets = NULL;
+}
+
+// -------------------------------------------------------------------------
+// Write: sorts postings by word and writes the index to file
+// -------------------------------------------------------------------------
+
+void ColumnWordIndex::Write( const char* filename )
+{
+    TCWIPosting*    sorted = NULL;
+    Uint32          header[2];
+    Uint64          sizes[2];
+    mystring        errstr;
+    int             eclass = NOCLASS;
+    size_t          n;
+    FILE*           fp;
+
+    if( offsets )
+        throw myruntime_error( mystring( "ColumnWordIndex: Index has already been written." ));
+
+    offsets = ( Uint64* )malloc( sizeof( Uint64 ) * ( nowords + 1 ));
+    if( nopostings )
+        sorted = ( TCWIPosting* )malloc( sizeof( TCWIPosting ) * nopostings );
+
+    if( !offsets || ( nopostings && !sorted )) {
+        if( sorted )
+            free( sorted );
+        throw myruntime_error( mystring( "ColumnWordIndex: Not enough memory." ));
+    }
+
+    //counting sort of postings by word; postings of a word remain in
+    //the order of profiles and positions
+    memset( offsets, 0, sizeof( Uint64 ) * ( nowords + 1 ));
+    for( n = 0; n < nopostings; n++ )
+        offsets[postwords[n]+1]++;
+    for( n = 1; n <= nowords; n++ )
+        offsets[n] += offsets[n-1];
+    for( n = 0; n < nopostings; n++ )
+        sorted[offsets[postwords[n]]++] = postings[n];
+    for( n = nowords; 0 < n; n-- )
+        offsets[n] = offsets[n-1];
+    offsets[0] = 0;
+
+    if( postings )
+        free( postings );
+    if( postwords )
+        free( postwords );
+    postings = sorted;
+    postwords = NULL;
+    postcapacity = nopostings;
+
+    fp = fopen( filename, "w" );
+    if( fp == NULL )
+        throw myruntime_error( mystring( "Unable to write column-word index." ));
+
+    header[0] = ( Uint32 )wordlength;
+    header[1] = ( Uint32 )NUMAA;
+    sizes[0] = ( Uint64 )noprofiles;
+    sizes[1] = ( Uint64 )nopostings;
+
+    try {
+        Serializer::Write( fp, ( char* )signature, 1, strlen( signature ));
+        Serializer::Write( fp, ( char* )header, sizeof( Uint32 ), 2 );
+        Serializer::Write( fp, ( char* )sizes, sizeof( Uint64 ), 2 );
+        if( noprofiles )
+            Serializer::Write( fp, ( char* )positions, sizeof( Uint64 ), noprofiles );
+        Serializer::Write( fp, ( char* )offsets, sizeof( Uint64 ), nowords + 1 );
+        if( nopostings )
+            Serializer::Write( fp, ( char* )postings, sizeof( TCWIPosting ), nopostings );
+
+    } catch( myexception const& ex )
+    {
+        errstr = ex.what();
+        eclass = ex.eclass();
+    }
+
+    fclose( fp );
+
+    if( !errstr.empty())
+        throw myruntime_error( errstr.c_str(), eclass );
+}
+
+// -------------------------------------------------------------------------
+// Read: reads the index from file
+// -------------------------------------------------------------------------
+
+void ColumnWordIndex::Read( const char* filename )
+{
+    char        locsignature[BUF_MAX];
+    Uint32      header[2];
+    Uint64      sizes[2];
+    mystring    errstr;
+    int         eclass = NOCLASS;
+    size_t      n;
+    FILE*       fp;
+
+    Destroy();
+
+    fp = fopen( filename, "r" );
+    if( fp == NULL )
+        throw myruntime_error( mystring( "Failed to open column-word index." ));
+
+    try {
+        Serializer::Read( fp, locsignature, 1, strlen( signature ));
+        if( strncmp( locsignature, signature, strlen( signature )))
+            throw myruntime_error( mystring( "Wrong format of column-word index." ));
+
+        Serializer::Read( fp, ( char* )header, sizeof( Uint32 ), 2 );
+        Serializer::Read( fp, ( char* )sizes, sizeof( Uint64 ), 2 );
+
+        if( header[0] < 1 || CWI_MAX_WORD_LENGTH < header[0] || header[1] != NUMAA )
+            throw myruntime_error( mystring( "Wrong format of column-word index." ));
+
+        wordlength = header[0];
+        for( nowords = 1, n = 0; n < ( size_t )wordlength; n++ )
+            nowords *= NUMAA;
+
+        ReallocPositions(( size_t )sizes[0] + 1 );
+        noprofiles = ( size_t )sizes[0];
+
+        offsets = ( Uint64* )malloc( sizeof( Uint64 ) * ( nowords + 1 ));
+        if( !offsets )
+            throw myruntime_error( mystring( "ColumnWordIndex: Not enough memory." ));
+
+        postings = ( TCWIPosting* )malloc( sizeof( TCWIPosting ) * (( size_t )sizes[1] + 1 ));
+        if( !postings )
+            throw myruntime_error( mystring( "ColumnWordIndex: Not enough memory." ));
+        nopostings = postcapacity = ( size_t )sizes[1];
+
+        if( noprofiles )
+            Serializer::Read( fp, ( char* )positions, sizeof( Uint64 ), noprofiles );
+        Serializer::Read( fp, ( char* )offsets, sizeof( Uint64 ), nowords + 1 );
+        if( nopostings )
+            Serializer::Read( fp, ( char* )postings, sizeof( TCWIPosting ), nopostings );
+
+        if( offsets[0] != 0 || offsets[nowords] != nopostings )
+            throw myruntime_error( mystring( "Column-word index corrupted." ));
+        for( n = 0; n < nowords; n++ )
+            if( offsets[n+1] < offsets[n] )
+                throw myruntime_error( mystring( "Column-word index corrupted." ));
+        for( n = 0; n < nopostings; n++ )
+            if( noprofiles <= postings[n].profile )
+                throw myruntime_error( mystring( "Column-word index corrupted." ));
+
+    } catch( myexception const& ex )
+    {
+        errstr = ex.what();
+        eclass = ex.eclass();
+    }
+
+    fclose( fp );
+
+    if( !errstr.empty()) {
+        Destroy();
+        throw myruntime_error( errstr.c_str(), eclass );
+    }
+}
+
+// -------------------------------------------------------------------------
+// Prefilter: flags the profiles having at least the given number of
+//     seeds in the same diagonal with the query; a seed is a word of the
+//     profile scoring against the query at least wordscore; returns the
+//     number of profiles flagged
+// -------------------------------------------------------------------------
+
+size_t ColumnWordIndex::Prefilter(
+    const LogOddsMatrix& query, double wordscore, int noseeds, char* candidates ) const
+{
+    Uint64*     seeds = NULL;
+    size_t      noallseeds = 0;
+    size_t      capacity = 0;
+    size_t      nocands = 0;
+    double      maxrest[CWI_MAX_WORD_LENGTH+1];
+    double      maxscore;
+    int         qlen = query.GetColumns();
+    int         q, k, a;
+    size_t      n, run;
+
+    if( !offsets || !candidates )
+        throw myruntime_error( mystring( "ColumnWordIndex: Index is not read." ));
+
+    memset( candidates, 0, sizeof( char ) * noprofiles );
+
+    try {
+        for( q = 0; q + wordlength <= qlen; q++ ) {
+            //upper bounds of scores of the rest of words
+            maxrest[wordlength] = 0.0;
+            for( k = wordlength - 1; 0 <= k; k-- ) {
+                if( query.GetResidueAt( q + k ) == X )
+                    break;
+                maxscore = query.GetValueAt( q + k, 0 );
+                for( a = 1; a < NUMAA; a++ )
+                    if( maxscore < query.GetValueAt( q + k, a ))
+                        maxscore = query.GetValueAt( q + k, a );
+                maxrest[k] = maxrest[k+1] + maxscore;
+            }
+            if( 0 <= k || maxrest[0] < wordscore )
+                continue;
+
+            CollectSeeds( query, q, 0, 0, 0.0, wordscore, maxrest, &seeds, &noallseeds, &capacity );
+        }
+
+        if( noallseeds )
+            qsort( seeds, noallseeds, sizeof( Uint64 ), &SeedCompare );
+
+        //seeds of the same profile and diagonal follow each other
+        for( n = 0; n < noallseeds; n += run ) {
+            for( run = 1; n + run < noallseeds && seeds[n+run] == seeds[n]; run++ );
+            if(( size_t )noseeds <= run && !candidates[seeds[n] >> 32] ) {
+                candidates[seeds[n] >> 32] = 1;
+                nocands++;
+            }
+        }
+    } catch( myexception const& ) {
+        if( seeds )
+            free( seeds );
+        throw;
+    }
+
+    if( seeds )
+        free( seeds );
+    return nocands;
+}
+
+// -------------------------------------------------------------------------
+// CollectSeeds: enumerates words beginning at query position q whose
+//     scores can reach the threshold, and saves their occurrences as
+//     seeds made of profile and diagonal
+// -------------------------------------------------------------------------
+
+void ColumnWordIndex::CollectSeeds(
+    const LogOddsMatrix& query, int q, int k, size_t code, double score,
+    double wordscore, const double* maxrest, Uint64** seeds,
+    size_t* noseeds, size_t* capacity ) const
+{
+    Uint64*     tmpseeds;
+    Uint64      n, beg, end;
+    Uint32      diagonal;
+    int         a;
+
+    if( k == wordlength ) {
+        beg = offsets[code];
+        end = offsets[code+1];
+
+        if( *capacity < *noseeds + ( end - beg )) {
+            size_t newcap = *capacity? *capacity * 2: ALLOCPOS;
+            while( newcap < *noseeds + ( end - beg ))
+                newcap *= 2;
+            tmpseeds = ( Uint64* )realloc( *seeds, sizeof( Uint64 ) * newcap );
+            if( !tmpseeds )
+                throw myruntime_error( mystring( "ColumnWordIndex: Not enough memory." ));
+            *seeds = tmpseeds;
+            *capacity = newcap;
+        }
+
+        for( n = beg; n < end; n++ ) {
+            diagonal = postings[n].position + query.GetColumns() - q;
+            ( *seeds )[( *noseeds )++] = (( Uint64 )postings[n].profile << 32 ) | diagonal;
+        }
+        return;
+    }
+
+    for( a = 0; a < NUMAA; a++ )
+        if( wordscore <= score + query.GetValueAt( q + k, a ) + maxrest[k+1] )
+            CollectSeeds( query, q, k + 1, code * NUMAA + a, score + query.GetValueAt( q + k, a ),
+                          wordscore, maxrest, seeds, noseeds, capacity );
+}
@@ -0,0 +1,112 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Mindaugas Margelevicius                         *
+ *   Institute of Biotechnology, Vilnius                                   *
+ *   minmar@ibt.lt                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef __ColumnWordIndex__
+#define __ColumnWordIndex__
+
+#include "debug.h"
+#include "types.h"
+#include "compdef.h"
+#include "defines.h"
+
+#include "mystring.h"
+#include "myexcept.h"
+
+#include "DistributionMatrix.h"
+
+
+//posting of a word: profile and position in it the word begins at
+struct TCWIPosting {
+    Uint32  profile;
+    Uint32  position;
+};
+
+// _________________________________________________________________________
+// Class ColumnWordIndex
+//
+// Inverted index of the profile database: each profile column is
+// quantized to the class of the residue of its greatest log-odds score,
+// and windows of consecutive columns make words, which are mapped to the
+// profiles and positions they occur at. At search time, words scoring
+// against the query above a threshold are looked up, and profiles having
+// enough word hits (seeds) in the same diagonal are selected as
+// candidates for the full computation
+//
+
+class ColumnWordIndex
+{
+public:
+    ColumnWordIndex( int wordlen = CWI_WORD_LENGTH );
+    ~ColumnWordIndex();
+
+                                                //add words of the next profile of the database
+    void            AddProfile( long position, const LogOddsMatrix& pssm );
+    void            ShiftPositions( long amount );  //shift positions of all profiles
+    void            Reopen();                       //make complete index open for adding profiles
+    void            Write( const char* filename );  //write index to file
+    void            Read( const char* filename );   //read index from file
+
+                                                //flag profiles having enough seeds with the query
+    size_t          Prefilter( const LogOddsMatrix& query, double wordscore, int noseeds, char* candidates ) const;
+
+    int             GetWordLength() const           { return wordlength; }
+    size_t          GetNoWords() const              { return nowords; }
+    size_t          GetNoProfiles() const           { return noprofiles; }
+    size_t          GetNoPostings() const           { return nopostings; }
+    long            GetProfilePosition( size_t ordinal ) const;
+
+protected:
+    explicit ColumnWordIndex( const ColumnWordIndex& );
+
+    void            Destroy();
+    void            ReallocPostings( size_t newcap );
+    void            ReallocPositions( size_t newcap );
+
+    static int      GetColumnClass( const LogOddsMatrix& pssm, int n );
+
+                                                //collect seeds of the words scoring above the threshold
+    void            CollectSeeds( const LogOddsMatrix& query, int q, int k, size_t code, double score,
+                                  double wordscore, const double* maxrest, Uint64** seeds,
+                                  size_t* noseeds, size_t* capacity ) const;
+
+private:
+    int             wordlength;     //number of columns a word consists of
+    size_t          nowords;        //number of different words
+
+    TCWIPosting*    postings;       //postings of all words; sorted by word once the index is complete
+    Uint32*         postwords;      //words of the postings while the index is being made
+    size_t          nopostings;     //number of postings
+    size_t          postcapacity;   //capacity of postings
+
+    Uint64*         offsets;        //offsets of the postings of each word
+    Uint64*         positions;      //positions of profiles in the database file
+    size_t          noprofiles;     //number of profiles
+    size_t          profcapacity;   //capacity of positions
+
+    static const char*  signature;  //signature of the index file
+};
+
+
+// INLINES ...
+
+// -------------------------------------------------------------------------
+// GetProfilePosition: returns the position of the profile in the
+//     database file
+// -------------------------------------------------------------------------
+
+inline
+long ColumnWordIndex::GetProfilePosition( size_t ordinal ) const
+{
+#ifdef __DEBUG__
+    if( !positions || noprofiles <= ordinal )
+        throw myruntime_error( mystring( "ColumnWordIndex: Memory access error." ));
+#endif
+    return ( long )positions[ordinal];
+}
+
+#endif//__ColumnWordIndex__
@@ -7,6 +7,7 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <dirent.h>
 #include <stdlib.h>
 #include <string.h>
@@ -30,11 +31,111 @@ const char* Database::db_signature[] = {
 const char* Database::db_extensions[] = {//extensions of the database files
     ".prd",
     ".frq",
+    ".cwi",
+    ".poi",
+    ".fsi",
     NULL
 };
 
+//header of the main database file in the binary format
+struct TBinDbHeader {
+    char    signature[48];          //signature with version number
+    Uint64  noprofiles;             //number of profiles
+    Uint64  dbsize;                 //size of the database
+    Uint64  distribution;           //type of distribution of frequency vectors
+};
+
+////////////////////////////////////////////////////////////////////////////
+// CLASS MakingWorker
+//
+// Constructor
+//
+MakingWorker::MakingWorker( Database* db )
+:
+    owner( db ),
+    vectors( NULL ),
+    probs( NULL ),
+    novectors( 0 ),
+    veccapacity( 0 ),
+    record( NULL ),
+    szrecord( 0 ),
+    errclass( NOCLASS )
+{
+    if( !owner )
+        throw myruntime_error( mystring( "MakingWorker: Null arguments." ));
+}
+
+// Default constructor
+//
+MakingWorker::MakingWorker()
+:
+    owner( NULL ),
+    vectors( NULL ),
+    probs( NULL ),
+    novectors( 0 ),
+    veccapacity( 0 ),
+    record( NULL ),
+    szrecord( 0 ),
+    errclass( NOCLASS )
+{
+    throw( myruntime_error(
+            mystring( "Default initialization of the MakingWorker objects is prohibited." )));
+}
+
+// Destructor
+//
+MakingWorker::~MakingWorker()
+{
+    Reset();
+    if( vectors )
+        free( vectors );
+    if( probs )
+        free( probs );
+}
+
+// -------------------------------------------------------------------------
+// Reset: releases the record of the profile processed; the buffer of
+//     vectors is kept for the next profile, as the store copies vectors
+// -------------------------------------------------------------------------
+
+void MakingWorker::Reset()
+{
+    novectors = 0;
+
+    if( record )
+        free( record );
+    record = NULL;
+    szrecord = 0;
+    failure.erase();
+}
+
 // -------------------------------------------------------------------------
-// CLASS HitInformation
+// ReallocVectors: reallocates memory for the frequency vectors of profile
+// -------------------------------------------------------------------------
+
+void MakingWorker::ReallocVectors( size_t newcap )
+{
+    char*   tmpvectors;
+    double* tmpprobs;
+
+    if( newcap <= veccapacity )
+        return;
+
+    tmpvectors = ( char* )realloc( vectors, FrequencyVector::GetSizeOfVector() * newcap );
+    if( !tmpvectors )
+        throw myruntime_error( mystring( "MakingWorker: Not enough memory." ));
+    vectors = tmpvectors;
+
+    tmpprobs = ( double* )realloc( probs, sizeof( double ) * newcap );
+    if( !tmpprobs )
+        throw myruntime_error( mystring( "MakingWorker: Not enough memory." ));
+    probs = tmpprobs;
+
+    veccapacity = newcap;
+}
+
+// -------------------------------------------------------------------------
+// CLASS Database
 //
 // Constructor
 //
@@ -58,7 +159,24 @@ Database::Database( const char* name )
     seghighentropy( -1.0 ),
     segdistance( 0.0 ),
 
-    store( NULL )
+    store( NULL ),
+    storeprint( 0 ),
+    index( NULL ),
+    makeindex( false ),
+    offsets( NULL ),
+    endposition( -1 ),
+    binary( false ),
+    db_map( NULL ),
+    db_mapsize( 0 ),
+    db_mappos( 0 ),
+    no_threads( 1 ),
+    inputs( NULL ),
+    noinputs( 0 ),
+    inputcapacity( 0 ),
+    input_next( 0 ),
+    input_committed( 0 ),
+    record_base( 0 ),
+    make_aborted( false )
 {
     Init();
 }
@@ -85,7 +203,24 @@ Database::Database( const char* output, const char* directory )
     seghighentropy( -1.0 ),
     segdistance( 0.0 ),
 
-    store( NULL )
+    store( NULL ),
+    storeprint( 0 ),
+    index( NULL ),
+    makeindex( false ),
+    offsets( NULL ),
+    endposition( -1 ),
+    binary( false ),
+    db_map( NULL ),
+    db_mapsize( 0 ),
+    db_mappos( 0 ),
+    no_threads( 1 ),
+    inputs( NULL ),
+    noinputs( 0 ),
+    inputcapacity( 0 ),
+    input_next( 0 ),
+    input_committed( 0 ),
+    record_base( 0 ),
+    make_aborted( false )
 {
     Init();
 }
@@ -112,7 +247,24 @@ Database::Database( const char* output, char* arguments[], int no_args )
     seghighentropy( -1.0 ),
     segdistance( 0.0 ),
 
-    store( NULL )
+    store( NULL ),
+    storeprint( 0 ),
+    index( NULL ),
+    makeindex( false ),
+    offsets( NULL ),
+    endposition( -1 ),
+    binary( false ),
+    db_map( NULL ),
+    db_mapsize( 0 ),
+    db_mappos( 0 ),
+    no_threads( 1 ),
+    inputs( NULL ),
+    noinputs( 0 ),
+    inputcapacity( 0 ),
+    input_next( 0 ),
+    input_committed( 0 ),
+    record_base( 0 ),
+    make_aborted( false )
 {
     Init();
 }
@@ -138,7 +290,24 @@ Database::Database()
     seghighentropy( -1.0 ),
     segdistance( 0.0 ),
 
-    store( NULL )
+    store( NULL ),
+    storeprint( 0 ),
+    index( NULL ),
+    makeindex( false ),
+    offsets( NULL ),
+    endposition( -1 ),
+    binary( false ),
+    db_map( NULL ),
+    db_mapsize( 0 ),
+    db_mappos( 0 ),
+    no_threads( 1 ),
+    inputs( NULL ),
+    noinputs( 0 ),
+    inputcapacity( 0 ),
+    input_next( 0 ),
+    input_committed( 0 ),
+    record_base( 0 ),
+    make_aborted( false )
 {
     throw( myruntime_error( mystring( "Default object initialization is not allowed." )));
 }
@@ -152,6 +321,11 @@ Database::~Database()
         free( name_buffer );
     if( store )
         delete store;
+    if( index )
+        delete index;
+    if( offsets )
+        delete offsets;
+    DestroyInputs();
 }
 
 // -------------------------------------------------------------------------
@@ -199,6 +373,36 @@ const char* Database::GetFreqDbName()
     return  name_buffer;
 }
 
+// -------------------------------------------------------------------------
+// GetIndexDbName: obtains the name of column-word index file
+// -------------------------------------------------------------------------
+
+const char* Database::GetIndexDbName()
+{
+    strcpy( name_buffer + strlen( GetDbName()), db_extensions[IDX] );
+    return  name_buffer;
+}
+
+// -------------------------------------------------------------------------
+// GetOffsetsDbName: obtains the name of offset index file
+// -------------------------------------------------------------------------
+
+const char* Database::GetOffsetsDbName()
+{
+    strcpy( name_buffer + strlen( GetDbName()), db_extensions[OFFS] );
+    return  name_buffer;
+}
+
+// -------------------------------------------------------------------------
+// GetImageDbName: obtains the name of image file of frequency vectors
+// -------------------------------------------------------------------------
+
+const char* Database::GetImageDbName()
+{
+    strcpy( name_buffer + strlen( GetDbName()), db_extensions[IMG] );
+    return  name_buffer;
+}
+
 // -------------------------------------------------------------------------
 // Open: opens the database and initializes file descriptor related to it
 // -------------------------------------------------------------------------
@@ -219,8 +423,12 @@ void Database::Open()
 
     try {
         SetNextSym( 0 );
+        endposition = -1;
 //         GetHeader( db_fp[MAIN] );//obsolete
-        ReadTextHeader( db_fp[MAIN] );
+        if( IsBinaryFile( db_fp[MAIN] ))
+            MapMainFile();
+        else
+            ReadTextHeader( db_fp[MAIN] );
 
     } catch( myexception const& ex )
     {
@@ -235,6 +443,9 @@ void Database::Open()
 
 void Database::Close( TFile which )
 {
+    if( cntFiles <= which || which < 0 || which == MAIN )
+        UnmapMainFile();
+
     if( cntFiles <= which || which < 0 ) {
         for( int n = 0; n < cntFiles; n++ )
             if( db_fp[n] != NULL ) {
@@ -255,6 +466,20 @@ void Database::Close( TFile which )
 
 bool Database::Next( FrequencyMatrix& freq, LogOddsMatrix& pssm, GapScheme& gaps,
                     int gapopencost, int gapextncost, bool fixedcosts )
+{
+    if( 0 <= endposition && endposition <= GetPosition())
+        return false;
+
+    return ReadNext( freq, pssm, gaps, gapopencost, gapextncost, fixedcosts );
+}
+
+// -------------------------------------------------------------------------
+// ReadNext: reads profile matrices at the current position of the
+//     database; returns false if the end of the database is reached
+// -------------------------------------------------------------------------
+
+bool Database::ReadNext( FrequencyMatrix& freq, LogOddsMatrix& pssm, GapScheme& gaps,
+                    int gapopencost, int gapextncost, bool fixedcosts )
 {
     int nsym = 0;
 
@@ -267,7 +492,11 @@ bool Database::Next( FrequencyMatrix& freq, LogOddsMatrix& pssm, GapScheme& gaps
 
     try {
 //         serializer.DeserializeProfile( freq, pssm, gaps, GetDbDesc());//obsolete
-        serializer.ReadProfile( GetDbDesc(), freq, pssm, gaps );
+        if( db_map )
+            //matrices refer to the mapped file
+            db_mappos += BinaryReadProfile( db_map + db_mappos, db_mapsize - db_mappos, freq, pssm, gaps );
+        else
+            serializer.ReadProfile( GetDbDesc(), freq, pssm, gaps );
 
     } catch( myexception const& ex )
     {
@@ -281,7 +510,11 @@ bool Database::Next( FrequencyMatrix& freq, LogOddsMatrix& pssm, GapScheme& gaps
     gaps.Prepare( gapopencost, gapextncost, fixedcosts );
 
 
-    if( GetNextSym() != EOF ) {
+    if( db_map ) {
+        if( db_mapsize <= db_mappos )
+            SetNextSym( EOF );
+    }
+    else if( GetNextSym() != EOF ) {
         nsym = fgetc( GetDbDesc());
         ungetc( nsym, GetDbDesc());
         SetNextSym( nsym );
@@ -290,58 +523,474 @@ bool Database::Next( FrequencyMatrix& freq, LogOddsMatrix& pssm, GapScheme& gaps
 }
 
 // -------------------------------------------------------------------------
-// Make: creates the database by processing profiles
+// Read: reads profile information at the given position of the database;
+//     subsequent calls to Next continue with the profile that follows;
+//     the range of profiles does not apply
+// -------------------------------------------------------------------------
+
+bool Database::Read( long position, FrequencyMatrix& freq, LogOddsMatrix& pssm, GapScheme& gaps,
+                    int gapopencost, int gapextncost, bool fixedcosts )
+{
+    SetPosition( position );
+    return ReadNext( freq, pssm, gaps, gapopencost, gapextncost, fixedcosts );
+}
+
+// -------------------------------------------------------------------------
+// ReadAt: reads profile of the given ordinal number; the offset index is
+//     to be read in before
+// -------------------------------------------------------------------------
+
+bool Database::ReadAt( size_t ordinal, FrequencyMatrix& freq, LogOddsMatrix& pssm, GapScheme& gaps,
+                    int gapopencost, int gapextncost, bool fixedcosts )
+{
+    Seek( ordinal );
+    return ReadNext( freq, pssm, gaps, gapopencost, gapextncost, fixedcosts );
+}
+
+// -------------------------------------------------------------------------
+// Seek: positions the database at the profile of the given ordinal
+//     number; the offset index is to be read in before
+// -------------------------------------------------------------------------
+
+void Database::Seek( size_t ordinal )
+{
+    if( !offsets )
+        throw myruntime_error( mystring( "Unable to get information: No offset index of profiles." ));
+
+    if( offsets->GetNoProfiles() <= ordinal )
+        throw myruntime_error( mystring( "Unable to get information: Invalid profile number." ));
+
+    SetPosition( offsets->GetOffset( ordinal ));
+}
+
+// -------------------------------------------------------------------------
+// Range: restricts reading of the database by Next to the profiles of
+//     ordinal numbers from begin to end (excluded); the offset index is to
+//     be read in before
+// -------------------------------------------------------------------------
+
+void Database::Range( size_t begin, size_t end )
+{
+    if( !offsets )
+        throw myruntime_error( mystring( "Unable to get information: No offset index of profiles." ));
+
+    if( end < begin )
+        throw myruntime_error( mystring( "Unable to get information: Invalid range of profiles." ));
+
+    endposition = -1;
+    if( end < offsets->GetNoProfiles())
+        endposition = offsets->GetOffset( end );
+
+    if( begin < offsets->GetNoProfiles())
+        Seek( begin );
+    else if( GetDbDesc())
+        //nothing to read
+        SetNextSym( EOF );
+}
+
+// -------------------------------------------------------------------------
+// SetPosition: sets the position of the next profile to be read
+// -------------------------------------------------------------------------
+
+void Database::SetPosition( long position )
+{
+    if( GetDbDesc() == NULL )
+        throw myruntime_error( mystring( "Unable to get information: Database is not opened." ));
+
+    if( db_map ) {
+        if( position < ( long )sizeof( TBinDbHeader ) || db_mapsize <= ( size_t )position )
+            throw myruntime_error( mystring( "Unable to get information: Invalid position in the database." ));
+        db_mappos = position;
+    }
+    else
+    if( position < 0 || fseek( GetDbDesc(), position, SEEK_SET ) != 0 )
+        throw myruntime_error( mystring( "Unable to get information: Invalid position in the database." ));
+
+    SetNextSym( 0 );
+}
+
+// -------------------------------------------------------------------------
+// Make: creates the database by processing profiles; profiles are read
+//     and processed by the pool of workers and written in one pass in the
+//     order of the input to a temporary file, which becomes the main
+//     database file once the header is known
 // -------------------------------------------------------------------------
 
 void Database::Make()
 {
+    mystring    tmpname;
+    long        hdrsize = 0;
+    FILE*       fp = NULL;
+
     if( !GetMainDbName())
         throw myruntime_error( mystring( "Unable to make database." ));
 
     if( db_fp[MAIN] != NULL || db_fp[FREQ] != NULL )
         throw myruntime_error( mystring( "Unable to make database." ));
 
-    message( "Preprocessing..." );
+    if( offsets )
+        delete offsets;
+    offsets = new ProfileOffsetIndex;
+    if( !offsets )
+        throw myruntime_error( mystring( "Database: Not enough memory." ));
 
-    ResetProbNormTerm();
+    if( GetMakeIndex()) {
+        if( index )
+            delete index;
+        index = new ColumnWordIndex;
+        if( !index )
+            throw myruntime_error( mystring( "Database: Not enough memory." ));
+    }
+
+    DestroyInputs();
+    ProcessInput( &Database::CollectFile, NULL );
 
-    //1st pass: find out attributes of the database to be created
-    ProcessInput( &Database::ProcessFile, NULL );
+    if( GetUsingSeg())
+        //set once for all the workers
+        SEGProfile::SetDistance( GetSegDistance());
 
-//     db_fp[MAIN] = fopen( GetMainDbName(), "wb" );//obsolete
-    db_fp[MAIN] = fopen( GetMainDbName(), "w" );
+    tmpname = mystring( GetMainDbName()) + ".tmp";
+
+    db_fp[MAIN] = fopen( tmpname.c_str(), GetBinary()? "wb": "w+" );
 
     if( db_fp[MAIN] == NULL )
         throw myruntime_error( mystring( "Unable to make database." ));
 
-//     db_fp[FREQ] = fopen( GetFreqDbName(), "wb" );//obsolete
-    db_fp[FREQ] = fopen( GetFreqDbName(), "w" );
+    try {
+        message( "Processing..." );
+
+        ResetProbNormTerm();
+
+        if( GetBinary())
+            //reserve space for the header
+            WriteBinaryHeader( db_fp[MAIN] );
+
+        RunWorkers();
+
+        if( GetBinary()) {
+            if( fseek( db_fp[MAIN], 0, SEEK_SET ) != 0 )
+                throw myruntime_error( mystring( "Unable to make database." ));
+            WriteBinaryHeader( db_fp[MAIN] );
+            Close( MAIN );
+            if( rename( tmpname.c_str(), GetMainDbName()) != 0 )
+                throw myruntime_error( mystring( "Unable to make database." ));
+        }
+        else {
+            //header is of variable length; put it in front of the profiles
+            if( fseek( db_fp[MAIN], 0, SEEK_SET ) != 0 )
+                throw myruntime_error( mystring( "Unable to make database." ));
+            fp = fopen( GetMainDbName(), "w" );
+            if( fp == NULL )
+                throw myruntime_error( mystring( "Unable to make database." ));
+            WriteTextHeader( fp );
+            hdrsize = ftell( fp );
+            CopyContents( fp, db_fp[MAIN] );
+            if( fclose( fp ) != 0 ) {
+                fp = NULL;
+                throw myruntime_error( mystring( "Unable to make database." ));
+            }
+            fp = NULL;
+            Close( MAIN );
+            remove( tmpname.c_str());
+
+            offsets->ShiftPositions( hdrsize );
+            if( index )
+                index->ShiftPositions( hdrsize );
+        }
+
+//         db_fp[FREQ] = fopen( GetFreqDbName(), "wb" );//obsolete
+        db_fp[FREQ] = fopen( GetFreqDbName(), "w" );
+
+        if( db_fp[FREQ] == NULL )
+            throw myruntime_error( mystring( "Unable to make database." ));
+
+        message( "Writing frequencies..." );
+        WriteFrequencies( db_fp[FREQ] );
+        Close( FREQ );
+
+        message( "Writing image of frequencies..." );
+        WriteImage();
+
+        message( "Writing offsets..." );
+        offsets->Write( GetOffsetsDbName());
+
+        if( index ) {
+            message( "Writing index..." );
+            index->Write( GetIndexDbName());
+        }
 
-    if( db_fp[FREQ] == NULL ) {
+    } catch( myexception const& ex )
+    {
+        if( fp )
+            fclose( fp );
         Close();
-        throw myruntime_error( mystring( "Unable to make database." ));
+        remove( tmpname.c_str());
+        DestroyInputs();
+        throw myruntime_error( ex.what(), ex.eclass());
     }
 
+    DestroyInputs();
+    message( "Finished." );
+    Close();
+}
+
+// -------------------------------------------------------------------------
+// Append: appends profiles to the existing database; new records are
+//     written after the existing ones, and the store of frequency vectors
+//     and the indices of the database are extended, so that the database
+//     is the same as that made of all the profiles at once; the main file
+//     is rewritten only when the header of the text format changes in
+//     length; the distribution type and the format set are to be those of
+//     the database
+// -------------------------------------------------------------------------
+
+void Database::Append()
+{
+    TFVectorProbabilities   distrib = GetDistributionType();
+    mystring    tmpname;        //file of the records appended
+    mystring    newname;        //file of the main database rewritten
+    struct stat info;
+    long        dbsize;         //size of the main database file
+    long        hdrsize;        //size of the header of the main database file
+    char*       header = NULL;  //new header in the text format
+    size_t      szheader = 0;
+    FILE*       fp = NULL;
+    FILE*       in = NULL;
+    FILE*       out = NULL;     //file being closed; fp is cleared not to close it again on error
+    bool        binary = GetBinary();   //format of the profiles to be appended
+
+    if( !GetMainDbName())
+        throw myruntime_error( mystring( "Unable to append to database." ));
+
+    if( db_fp[MAIN] != NULL || db_fp[FREQ] != NULL )
+        throw myruntime_error( mystring( "Unable to append to database." ));
+
+    message( "Reading database..." );
+
+    Open();
     try {
-        message( "Writing..." );
-//         PutHeader( db_fp[MAIN] );//obsolete
-        WriteTextHeader( db_fp[MAIN] );
-        //2nd pass: write down the attributes and profiles themselves
-        ProcessInput( &Database::WriteFile, db_fp );
+        SetBinary( db_map != NULL );
+        if( fstat( fileno( GetDbDesc()), &info ) == -1 )
+            throw myruntime_error( mystring( "Unable to append to database." ));
+        dbsize = ( long )info.st_size;
+        if( stat( GetOffsetsDbName(), &info ) == 0 )
+            ReadInOffsets();
+        else {
+            //database made before the offset index was introduced
+            message( "Rebuilding offset index..." );
+            RebuildOffsets();
+        }
+    } catch( myexception const& ex )
+    {
+        Close();
+        throw myruntime_error( ex.what(), ex.eclass());
+    }
+    Close();
+
+    if( GetDistributionType() != distrib )
+        throw myruntime_error( mystring( "Distribution type differs from that of the database." ));
+
+    if( GetBinary() != binary )
+        throw myruntime_error( mystring( "Format of profiles differs from that of the database." ));
+
+    if( !offsets->GetNoProfiles())
+        throw myruntime_error( mystring( "Offset index of profiles does not correspond to the database." ));
+    hdrsize = offsets->GetOffset( 0 );
+
+    if( stat( GetIndexDbName(), &info ) == 0 ) {
+        ReadInIndex();
+        if( index->GetNoProfiles() != GetNoSequences())
+            throw myruntime_error( mystring( "Column-word index does not correspond to the database." ));
+        index->Reopen();
+    }
+    else if( GetMakeIndex())
+        throw myruntime_error( mystring( "Database has no column-word index to append to." ));
+
+    ReadFrequencies( false );
+
+    DestroyInputs();
+    ProcessInput( &Database::CollectFile, NULL );
+
+    if( GetUsingSeg())
+        //set once for all the workers
+        SEGProfile::SetDistance( GetSegDistance());
+
+    tmpname = mystring( GetMainDbName()) + ".tmp";
+    newname = mystring( GetMainDbName()) + ".new";
+
+    db_fp[MAIN] = fopen( tmpname.c_str(), "w+" );
+
+    if( db_fp[MAIN] == NULL )
+        throw myruntime_error( mystring( "Unable to append to database." ));
+
+    try {
+        message( "Processing..." );
+
+        record_base = dbsize;
+        RunWorkers();
+        record_base = 0;
+
+        if( fseek( db_fp[MAIN], 0, SEEK_SET ) != 0 )
+            throw myruntime_error( mystring( "Unable to append to database." ));
+
+        if( !GetBinary()) {
+            fp = open_memstream( &header, &szheader );
+            if( fp == NULL )
+                throw myruntime_error( mystring( "Database: Not enough memory." ));
+            WriteTextHeader( fp );
+            out = fp;
+            fp = NULL;
+            if( fclose( out ) != 0 )
+                throw myruntime_error( mystring( "Database: Not enough memory." ));
+        }
+
+        if( GetBinary() || ( long )szheader == hdrsize ) {
+            //append records and update header in place
+            fp = fopen( GetMainDbName(), "r+" );
+            if( fp == NULL )
+                throw myruntime_error( mystring( "Unable to append to database." ));
+            if( fseek( fp, 0, SEEK_END ) != 0 )
+                throw myruntime_error( mystring( "Unable to append to database." ));
+            CopyContents( fp, db_fp[MAIN] );
+            if( fseek( fp, 0, SEEK_SET ) != 0 )
+                throw myruntime_error( mystring( "Unable to append to database." ));
+            if( GetBinary())
+                WriteBinaryHeader( fp );
+            else
+                Serializer::Write( fp, header, 1, szheader );
+        }
+        else {
+            //header of different length; rewrite the main file
+            fp = fopen( newname.c_str(), "w" );
+            if( fp == NULL )
+                throw myruntime_error( mystring( "Unable to append to database." ));
+            Serializer::Write( fp, header, 1, szheader );
+            in = fopen( GetMainDbName(), "r" );
+            if( in == NULL || fseek( in, hdrsize, SEEK_SET ) != 0 )
+                throw myruntime_error( mystring( "Unable to append to database." ));
+            CopyContents( fp, in );
+            fclose( in );
+            in = NULL;
+            CopyContents( fp, db_fp[MAIN] );
+        }
+        out = fp;
+        fp = NULL;
+        if( fclose( out ) != 0 )
+            throw myruntime_error( mystring( "Unable to append to database." ));
+
+        if( !GetBinary() && ( long )szheader != hdrsize ) {
+            if( rename( newname.c_str(), GetMainDbName()) != 0 )
+                throw myruntime_error( mystring( "Unable to append to database." ));
+            offsets->ShiftPositions(( long )szheader - hdrsize );
+            if( index )
+                index->ShiftPositions(( long )szheader - hdrsize );
+        }
+        Close( MAIN );
+        remove( tmpname.c_str());
+
+        db_fp[FREQ] = fopen( GetFreqDbName(), "w" );
+
+        if( db_fp[FREQ] == NULL )
+            throw myruntime_error( mystring( "Unable to append to database." ));
 
         message( "Writing frequencies..." );
         WriteFrequencies( db_fp[FREQ] );
+        Close( FREQ );
+
+        message( "Writing image of frequencies..." );
+        WriteImage();
+
+        message( "Writing offsets..." );
+        offsets->Write( GetOffsetsDbName());
+
+        if( index ) {
+            message( "Writing index..." );
+            index->Write( GetIndexDbName());
+        }
 
     } catch( myexception const& ex )
     {
+        record_base = 0;
+        if( fp )
+            fclose( fp );
+        if( in )
+            fclose( in );
+        if( header )
+            free( header );
         Close();
+        remove( tmpname.c_str());
+        remove( newname.c_str());
+        DestroyInputs();
         throw myruntime_error( ex.what(), ex.eclass());
     }
 
+    if( header )
+        free( header );
+    DestroyInputs();
     message( "Finished." );
     Close();
 }
 
+// -------------------------------------------------------------------------
+// CopyContents: copies the rest of file from the current position to
+//     another file
+// -------------------------------------------------------------------------
+
+void Database::CopyContents( FILE* to, FILE* from )
+{
+    char    buffer[KBYTE];
+    size_t  rbts;
+
+    while(( rbts = fread( buffer, 1, KBYTE, from )) != 0 )
+        Serializer::Write( to, buffer, 1, rbts );
+
+    if( ferror( from ))
+        throw myruntime_error( mystring( "Database: Failed to copy file." ));
+}
+
+// -------------------------------------------------------------------------
+// CollectFile: adds the name of file to the list of inputs to make the
+//     database of
+// -------------------------------------------------------------------------
+
+void Database::CollectFile( const char* filename, void* )
+{
+    char**  tmpinputs;
+    char*   name;
+
+    if( !filename )
+        return;
+
+    if( inputcapacity <= noinputs ) {
+        tmpinputs = ( char** )realloc( inputs, sizeof( void* ) * ( inputcapacity? inputcapacity * 2: KBYTE ));
+        if( !tmpinputs )
+            throw myruntime_error( mystring( "Database: Not enough memory." ));
+        inputs = tmpinputs;
+        inputcapacity = inputcapacity? inputcapacity * 2: KBYTE;
+    }
+
+    name = ( char* )malloc( strlen( filename ) + 1 );
+    if( !name )
+        throw myruntime_error( mystring( "Database: Not enough memory." ));
+    strcpy( name, filename );
+    inputs[noinputs++] = name;
+}
+
+// -------------------------------------------------------------------------
+// DestroyInputs: deallocates the list of inputs
+// -------------------------------------------------------------------------
+
+void Database::DestroyInputs()
+{
+    for( size_t n = 0; n < noinputs; n++ )
+        if( inputs[n] )
+            free( inputs[n] );
+    if( inputs )
+        free( inputs );
+    inputs = NULL;
+    noinputs = inputcapacity = 0;
+}
+
 // -------------------------------------------------------------------------
 // ProcessInput: process profiles given explicitly or found in directory
 // -------------------------------------------------------------------------
@@ -383,9 +1032,13 @@ void Database::ProcessInput( PMETHOD processing_method, void* args )
                     option = false;
                     continue;
                 }
+                if( GetProfile( n )[0] == '-' && GetProfile( n )[1] && GetProfile( n )[2] )
+                    //long option or option with value attached
+                    continue;
                 if( GetProfile( n )[0] == '-' && GetProfile( n )[2] == 0 ) {
-                    if( GetProfile( n )[1] != 'v' )
-                        option = true;  //assume it is an option
+                    if( GetProfile( n )[1] != 'v' && GetProfile( n )[1] != 'I' && GetProfile( n )[1] != 'b' &&
+                        GetProfile( n )[1] != 'a' )
+                        option = true;  //assume it is an option with value
                     continue;
                 }
                 ( this->*processing_method )( GetProfile( n ), args );
@@ -409,94 +1062,267 @@ void Database::PreprocessProfile( FrequencyMatrix& freq, LogOddsMatrix& pssm, Ga
                 GetSegLowEntropy(),
                 GetSegHighEntropy()
         );
-        segpro.SetDistance( GetSegDistance());
         segpro.Run();
         segpro.MaskSeggedPositions( freq, pssm, gaps );
     }
 }
 
 // -------------------------------------------------------------------------
-// ProcessFile: read data from file and process it
+// ProcessFile: reads profile from file, preprocesses it, and prepares its
+//     record and frequency vectors for the commit; failure to process the
+//     profile is kept by the worker
 // -------------------------------------------------------------------------
 
-void Database::ProcessFile( const char* filename, void* )
+void Database::ProcessFile( MakingWorker& worker, const char* filename )
 {
-    FrequencyMatrix     freq;
-    LogOddsMatrix       pssm;
-    GapScheme           gaps;
-    double              prob = 0.0;
+    FrequencyMatrix&    freq = worker.freq;
+    LogOddsMatrix&      pssm = worker.pssm;
+    GapScheme&          gaps = worker.gaps;
+    FILE*               fp = NULL;
+
+    worker.Reset();
 
     try {
 //         serializer.DeserializeProfile( freq, pssm, gaps, filename );//obsolete
-        serializer.ReadProfile( filename, freq, pssm, gaps );
+        worker.serializer.ReadProfile( filename, freq, pssm, gaps );
         PreprocessProfile( freq, pssm, gaps );
-        IncNoSequences();
-        IncDbSize( pssm.GetColumns());
 
-        //store all different columns of frequency matrix in
-        //  order to write them later to a file
+        fp = open_memstream( &worker.record, &worker.szrecord );
+        if( fp == NULL )
+            throw myruntime_error( mystring( "Database: Not enough memory." ));
+
+//         serializer.SerializeProfile( freq, pssm, gaps, fp );//obsolete
+        if( GetBinary())
+            BinaryWriteProfile( fp, freq, pssm, gaps );
+        else
+            worker.serializer.WriteProfile( fp, freq, pssm, gaps );
+
+        if( fclose( fp ) != 0 ) {
+            fp = NULL;
+            throw myruntime_error( mystring( "Database: Not enough memory." ));
+        }
+        fp = NULL;
+
+        //make all different columns of frequency matrix in
+        //  order to store them in the commit
         freq.CheckForAllZeros();    //necessary to ensure valid scores
 
+        worker.ReallocVectors( freq.GetColumns());
+
         for( int n = 0; n < freq.GetColumns(); n++ )
         {
             //omit profile columns constructed for Xs
             if( freq.GetResidueAt( n ) == X )
                 continue;
 
-            FrequencyVector vect(   *freq.GetVectorAt( n ), pssm.GetFrequencyWeightAt( n ), pssm.GetThicknessAt( n ),
-                                    *pssm.GetVectorAt( n ), pssm.GetInformationAt( n ));
-            IncNoVectors();
-            FrequencyVector quest_vect = ( const char* )store->Store( vect );
-
-            if( quest_vect.GetVector() == vect.GetVector()) {
-                //vector has been stored
-                //compute probability of this frequency vector to occur
-                prob = vect.ComputeProbability();
-                //adjust probability-normalizing term
-                IncProbNormTerm( prob );
-            }
-            else {
-                //if the vector has not been stored, update probabilities of the original...
-                quest_vect.UpdateProbability();
-                //and destroy the duplicate
-                vect.Destroy();
-            }
+            FrequencyVector vect( worker.vectors + worker.novectors * FrequencyVector::GetSizeOfVector());
+            vect.SetVector( *freq.GetVectorAt( n ), pssm.GetFrequencyWeightAt( n ), pssm.GetThicknessAt( n ),
+                            *pssm.GetVectorAt( n ), pssm.GetInformationAt( n ));
+            //compute probability of this frequency vector to occur
+            worker.probs[worker.novectors++] = vect.ComputeProbability();
         }
 
     } catch( myexception const& ex )
     {
-        error( mystring( ex.what() + mystring( " Skipping '" ) + filename + mystring( "'." )).c_str());
+        if( fp )
+            fclose( fp );
+        worker.Reset();
+        worker.failure = ex.what();
     }
 }
 
 // -------------------------------------------------------------------------
-// WriteFile: write contents of file, i.e. profile matrices, to the
-//     database
+// CommitFile: stores the frequency vectors of the processed profile and
+//     appends its record to the database; called in the order of the
+//     input
 // -------------------------------------------------------------------------
 
-void Database::WriteFile( const char* filename, void* args )
+void Database::CommitFile( MakingWorker& worker, const char* filename )
 {
-    FILE**  FP = ( FILE** )args;
+    LogOddsMatrix&      pssm = worker.pssm;
+    long                position;
 
-    if( !FP || !FP[MAIN] || !FP[FREQ] )
+    if( !worker.failure.empty()) {
+        error( mystring( worker.failure + mystring( " Skipping '" ) + filename + mystring( "'." )).c_str());
         return;
+    }
+
+    IncNoSequences();
+    IncDbSize( pssm.GetColumns());
+
+    for( size_t n = 0; n < worker.novectors; n++ )
+    {
+        FrequencyVector vect( worker.vectors + n * FrequencyVector::GetSizeOfVector());
+        bool            inserted = false;
+        IncNoVectors();
+        FrequencyVector quest_vect = ( const char* )store->Store( vect, &inserted );
+
+        if( inserted )
+            //vector has been copied to the store;
+            //adjust probability-normalizing term
+            IncProbNormTerm( worker.probs[n] );
+        else
+            //if the vector has not been stored, update probabilities of the original
+            quest_vect.UpdateProbability();
+    }
+
+    position = record_base + ftell( db_fp[MAIN] );
+    Serializer::Write( db_fp[MAIN], worker.record, 1, worker.szrecord );
+
+    if( offsets )
+        offsets->AddProfile( position, ( long )worker.szrecord, pssm.GetColumns(), pssm.GetName());
+    if( index )
+        index->AddProfile( position, pssm );
+}
+
+// -------------------------------------------------------------------------
+// MakeProfiles: takes inputs one by one, processes them, and commits them
+//     in the order of the input until all of them are taken or making is
+//     aborted
+// -------------------------------------------------------------------------
+
+void Database::MakeProfiles( MakingWorker& worker )
+{
+    size_t  ordinal;
+
+    while( 1 ) {
+        pthread_mutex_lock( &make_mutex );
+        if( make_aborted || noinputs <= input_next ) {
+            pthread_mutex_unlock( &make_mutex );
+            break;
+        }
+        ordinal = input_next++;
+        pthread_mutex_unlock( &make_mutex );
+
+        ProcessFile( worker, inputs[ordinal] );
+
+        pthread_mutex_lock( &make_mutex );
+        while( !make_aborted && input_committed != ordinal )
+            pthread_cond_wait( &make_cond, &make_mutex );
+        if( make_aborted ) {
+            pthread_mutex_unlock( &make_mutex );
+            break;
+        }
+        try {
+            CommitFile( worker, inputs[ordinal] );
+        } catch( myexception const& ex ) {
+            pthread_mutex_unlock( &make_mutex );
+            throw myruntime_error( ex.what(), ex.eclass());
+        }
+        input_committed++;
+        pthread_cond_broadcast( &make_cond );
+        pthread_mutex_unlock( &make_mutex );
+    }
+    worker.Reset();
+}
+
+// -------------------------------------------------------------------------
+// MakeThread: entry point of a worker thread
+// -------------------------------------------------------------------------
 
-    FrequencyMatrix     freq;
-    LogOddsMatrix       pssm;
-    GapScheme           gaps;
+void* Database::MakeThread( void* arg )
+{
+    MakingWorker*   worker = ( MakingWorker* )arg;
+
+    if( !worker || !worker->owner )
+        return NULL;
 
     try {
-//         serializer.DeserializeProfile( freq, pssm, gaps, filename );//obsolete
-        serializer.ReadProfile( filename, freq, pssm, gaps );
-        PreprocessProfile( freq, pssm, gaps );
+        worker->owner->MakeProfiles( *worker );
+
+    } catch( myexception const& ex ) {
+        worker->SetError( ex.what(), ex.eclass());
+        pthread_mutex_lock( &worker->owner->make_mutex );
+        worker->owner->make_aborted = true;
+        pthread_cond_broadcast( &worker->owner->make_cond );
+        pthread_mutex_unlock( &worker->owner->make_mutex );
+    }
+    return NULL;
+}
 
-//         serializer.SerializeProfile( freq, pssm, gaps, FP[MAIN] );//obsolete
-        serializer.WriteProfile( FP[MAIN], freq, pssm, gaps );
+// -------------------------------------------------------------------------
+// RunWorkers: processes the inputs with the pool of threads; each worker
+//     reads and processes profiles on its own, while the vectors and
+//     records are committed to the database in the order of the input
+// -------------------------------------------------------------------------
 
-    } catch( myexception const& ex )
-    {
-        error( mystring( ex.what() + mystring( " Skipping '" ) + filename + mystring( "'." )).c_str());
+void Database::RunWorkers()
+{
+    int             nthreads = GetNoThreads();
+    MakingWorker**  workers = NULL;
+    int             nstarted = 0;
+    int             n;
+    mystring        errmsg;
+    int             errcls = NOCLASS;
+
+    if( nthreads < 1 )
+        nthreads = 1;
+    if( noinputs < ( size_t )nthreads )
+        nthreads = noinputs? ( int )noinputs: 1;
+
+    input_next = input_committed = 0;
+    make_aborted = false;
+
+    pthread_mutex_init( &make_mutex, NULL );
+    pthread_cond_init( &make_cond, NULL );
+
+    workers = ( MakingWorker** )malloc( sizeof( void* ) * nthreads );
+    if( !workers ) {
+        errmsg = "Database: Not enough memory.";
+        nthreads = 0;
     }
+    else
+        memset( workers, 0, sizeof( void* ) * nthreads );
+
+    try {
+        for( n = 0; n < nthreads; n++ ) {
+            workers[n] = new MakingWorker( this );
+            if( !workers[n] )
+                throw myruntime_error( mystring( "Database: Not enough memory." ));
+        }
+    } catch( myexception const& ex ) {
+        errmsg = ex.what();
+        errcls = ex.eclass();
+    }
+
+    if( errmsg.empty()) {
+        if( nthreads == 1 )
+            //no need for a thread
+            MakeThread( workers[0] );
+        else
+            for( n = 0; n < nthreads; n++ ) {
+                if( pthread_create( &workers[n]->thread, NULL, &MakeThread, workers[n] ) != 0 ) {
+                    pthread_mutex_lock( &make_mutex );
+                    make_aborted = true;
+                    pthread_cond_broadcast( &make_cond );
+                    pthread_mutex_unlock( &make_mutex );
+                    workers[n]->SetError( "Database: Failed to create thread.", NOCLASS );
+                    break;
+                }
+                nstarted++;
+            }
+    }
+
+    for( n = 0; n < nstarted; n++ )
+        pthread_join( workers[n]->thread, NULL );
+
+    for( n = 0; n < nthreads; n++ ) {
+        if( !workers[n] )
+            continue;
+        if( errmsg.empty() && workers[n]->GetError()) {
+            errmsg = workers[n]->GetError();
+            errcls = workers[n]->GetErrorClass();
+        }
+        delete workers[n];
+    }
+    if( workers )
+        free( workers );
+
+    pthread_cond_destroy( &make_cond );
+    pthread_mutex_destroy( &make_mutex );
+
+    if( !errmsg.empty())
+        throw myruntime_error( errmsg, errcls );
 }
 
 // -------------------------------------------------------------------------
@@ -508,13 +1334,9 @@ void Database::WriteFrequencies( FILE* fd )
     if( !fd || !store )
         return;
 
-    const SimpleVector* frequencies = store->GetFrequencies();
-    size_t              size = 0;
+    size_t              size = store->GetSize();
     size_t              n;
 
-    if( frequencies )
-        size = frequencies->GetSize();
-
     //write total number of frequency vectors and number of distinct
     //frequency vectors, respectively
 //     Serializer::Write( fd, ( char* )&no_vectors, sizeof( no_vectors ), 1 );//obsolete
@@ -523,7 +1345,7 @@ void Database::WriteFrequencies( FILE* fd )
     fprintf( fd, "%ld %ld\n", GetNoVectors(), size );
 
     for( n = 0; n < size; n++ ) {
-        FrequencyVector vector(( const char* )frequencies->GetValueAt( n ));
+        FrequencyVector vector( store->GetVectorAt( n ));
         //normalize probability before writing frequency vector
         vector.NormalizeProbability( GetProbNormTerm());
 //         serializer.SerializeFrequencies( vector, fd );//obsolete
@@ -532,9 +1354,10 @@ void Database::WriteFrequencies( FILE* fd )
 
     char    strbuf[UCHAR_MAX];
 
-    sprintf( strbuf, "distinct vectors,     %9d", size );                      message( strbuf, false );
-    sprintf( strbuf, "1st-level collisions, %9d", store->GetCollisions1());    message( strbuf, false );
-    sprintf( strbuf, "2nd-level collisions, %9d", store->GetCollisions2());    message( strbuf );
+    sprintf( strbuf, "distinct vectors,     %9zu", size );                         message( strbuf, false );
+    sprintf( strbuf, "index load factor,    %9.2f", store->GetLoadFactor());       message( strbuf, false );
+    sprintf( strbuf, "mean probe length,    %9.2f", store->GetMeanProbeLength());  message( strbuf, false );
+    sprintf( strbuf, "max probe length,     %9zu", store->GetMaxProbeLength());    message( strbuf );
 }
 
 // -------------------------------------------------------------------------
@@ -542,6 +1365,92 @@ void Database::WriteFrequencies( FILE* fd )
 // -------------------------------------------------------------------------
 
 void Database::ReadInFrequencies()
+{
+    storeprint = 0;
+    if( ReadInImage())
+        return;
+    ReadFrequencies( true );
+}
+
+// -------------------------------------------------------------------------
+// GetStoreFingerprint: returns the hash of the frequency vectors read in;
+//     it is computed once for all searches of the database
+// -------------------------------------------------------------------------
+
+Uint64 Database::GetStoreFingerprint()
+{
+    if( !store )
+        throw myruntime_error( mystring( "Database: No frequency vectors." ));
+
+    if( !storeprint )
+        storeprint = store->GetFingerprint();
+    return storeprint;
+}
+
+// -------------------------------------------------------------------------
+// ReadInImage: map the image of frequency vectors instead of reading the
+//     frequency file; returns false if there is no image up to date
+// -------------------------------------------------------------------------
+
+bool Database::ReadInImage()
+{
+    struct stat imginfo, frqinfo;
+    size_t      total;
+
+    if( !store || !GetImageDbName())
+        return false;
+
+    if( stat( GetImageDbName(), &imginfo ) != 0 )
+        return false;
+
+    if( stat( GetFreqDbName(), &frqinfo ) == 0 && imginfo.st_mtime < frqinfo.st_mtime ) {
+        warning( "Image of frequency vectors is older than frequency file; ignored." );
+        return false;
+    }
+
+    try {
+        total = store->MapImage( GetImageDbName());
+    } catch( myexception const& ex )
+    {
+        warning( mystring( mystring( ex.what()) + " Image ignored." ).c_str());
+        return false;
+    }
+
+    SetNoVectors( total );
+    ResetProbNormTerm();
+    return true;
+}
+
+// -------------------------------------------------------------------------
+// WriteImage: write the image of frequency vectors; the vectors are read
+//     back from the frequency file, so that the image holds exactly the
+//     values read by searches without the image
+// -------------------------------------------------------------------------
+
+void Database::WriteImage()
+{
+    if( !store )
+        return;
+
+    delete store;
+    store = new FrequencyStore;
+    storeprint = 0;
+
+    if( !store )
+        throw myruntime_error( mystring( "Database: Not enough memory." ));
+
+    ReadFrequencies( true );
+    store->WriteImage( GetImageDbName(), GetNoVectors());
+}
+
+// -------------------------------------------------------------------------
+// ReadFrequencies: read frequencies in the internal storage; final
+//     probabilities of vectors are computed if final is set; otherwise,
+//     vectors keep the values they are made with, so that further vectors
+//     can be stored and the frequencies written again
+// -------------------------------------------------------------------------
+
+void Database::ReadFrequencies( bool final )
 {
     if( !store )
         return;
@@ -556,6 +1465,7 @@ void Database::ReadInFrequencies()
     long long int   llintval;
     size_t      size = 0;       //number of distinct vectors
     double      reps = 0.0;     //number of occurences of vectors in the database
+    FrequencyVector readvector; //vector read before it is copied to the store
     mystring    errstr;
     int         eclass;
 
@@ -612,18 +1522,25 @@ void Database::ReadInFrequencies()
 
         //allocate needed memory at once to avoid excess and sequential reallocation
         store->SetNoFrequencyVectors( size );
+        ResetProbNormTerm();
 
         for( n = 0; n < size; n++ ) {
-            FrequencyVector vector;
-            //method's smart to allocate required memory
+            //method's smart to allocate required memory once
 //             serializer.DeserializeFrequencies( vector, db_fp[FREQ] );//obsolete
-            serializer.ReadVector( db_fp[FREQ], vector );
+            serializer.ReadVector( db_fp[FREQ], readvector );
 
-            if( store->Store( vector ) != vector.GetVector())
+            bool            inserted = false;
+            FrequencyVector vector = ( const char* )store->Store( readvector, &inserted );
+
+            if( !inserted )
                 throw myruntime_error( mystring( "Failed to store data vectors." ));
 
             reps += vector.GetProbability() + 1.0;
-            vector.FinalProbability( GetNoVectors());
+            if( final )
+                vector.FinalProbability( GetNoVectors());
+            else if( GetDistributionType() != DISCRETE )
+                //probability before normalization
+                IncProbNormTerm( vector.ComputeProbability());
         }
 
         if( ! AreVectorsConsistent( reps ))
@@ -635,6 +1552,7 @@ void Database::ReadInFrequencies()
         eclass = ex.eclass();
     }
 
+    readvector.Destroy();
     Close( FREQ );
 
     if( !errstr.empty())
@@ -643,6 +1561,88 @@ void Database::ReadInFrequencies()
 
 
 
+// -------------------------------------------------------------------------
+// ReadInIndex: read column-word index of profiles of the database
+// -------------------------------------------------------------------------
+
+void Database::ReadInIndex()
+{
+    if( !GetIndexDbName())
+        throw myruntime_error( mystring( "Unable to open one of database files." ));
+
+    if( !index )
+        index = new ColumnWordIndex;
+
+    if( !index )
+        throw myruntime_error( mystring( "Database: Not enough memory." ));
+
+    index->Read( GetIndexDbName());
+}
+
+// -------------------------------------------------------------------------
+// ReadInOffsets: read offset index of profiles of the database; the
+//     database is to be opened before
+// -------------------------------------------------------------------------
+
+void Database::ReadInOffsets()
+{
+    if( !GetOffsetsDbName())
+        throw myruntime_error( mystring( "Unable to open one of database files." ));
+
+    if( !offsets )
+        offsets = new ProfileOffsetIndex;
+
+    if( !offsets )
+        throw myruntime_error( mystring( "Database: Not enough memory." ));
+
+    offsets->Read( GetOffsetsDbName());
+
+    if( GetDbDesc() && offsets->GetNoProfiles() != GetNoSequences()) {
+        delete offsets;
+        offsets = NULL;
+        throw myruntime_error( mystring( "Offset index of profiles does not correspond to the database. "
+                                         "Remove it or make the database again with makedb." ));
+    }
+}
+
+// -------------------------------------------------------------------------
+// RebuildOffsets: makes the offset index of profiles in one pass over the
+//     opened database; records follow one another, so that a record ends
+//     where the next one begins
+// -------------------------------------------------------------------------
+
+void Database::RebuildOffsets()
+{
+    FrequencyMatrix freq;
+    LogOddsMatrix   pssm;
+    GapScheme       gaps;
+    long            position;
+    long            next;
+
+    if( !GetDbDesc())
+        throw myruntime_error( mystring( "Unable to get information: Database is not opened." ));
+
+    if( offsets )
+        delete offsets;
+    offsets = new ProfileOffsetIndex;
+
+    if( !offsets )
+        throw myruntime_error( mystring( "Database: Not enough memory." ));
+
+    position = GetPosition();
+
+    while( Next( freq, pssm, gaps, DEFAULTGAPOPENCOST, DEFAULTEXTENDCOST, false )) {
+        next = GetPosition();
+        offsets->AddProfile( position, next - position, pssm.GetColumns(), pssm.GetName());
+        position = next;
+    }
+
+    if( offsets->GetNoProfiles() != GetNoSequences())
+        throw myruntime_error( mystring( "Database is corrupted: Number of profiles differs from that in the header." ));
+}
+
+
+
 // -------------------------------------------------------------------------
 // PutHeader: puts header information of the database
 // -------------------------------------------------------------------------
@@ -825,6 +1825,128 @@ void Database::ReadTextHeader( FILE* fp )
 
 
 
+// =========================================================================
+
+const char* patstrBINDBVER = "COMA/CONDOR binary profile database v";
+const char* bindbversion = "1.0";
+
+// =========================================================================
+// WriteBinaryHeader: write header of database in the binary format to
+//     file descriptor; profile records follow it
+//
+void Database::WriteBinaryHeader( FILE* fp )
+{
+    if( !fp )
+        return;
+
+    TBinDbHeader    header;
+
+    memset( &header, 0, sizeof( header ));
+    sprintf( header.signature, "%s%s\n", patstrBINDBVER, bindbversion );
+
+    header.noprofiles = GetNoSequences();
+    header.dbsize = GetDbSize();
+    header.distribution = GetDistributionType();
+
+    Serializer::Write( fp, ( char* )&header, sizeof( header ), 1 );
+}
+
+// -------------------------------------------------------------------------
+// ReadBinaryHeader: read header of database in the binary format from
+//     memory
+//
+void Database::ReadBinaryHeader( const char* data, size_t size )
+{
+    const TBinDbHeader* header = ( const TBinDbHeader* )data;
+    size_t              lenstrBINDBVER = strlen( patstrBINDBVER );
+
+    if( !data || size < sizeof( TBinDbHeader ))
+        throw myruntime_error( "Wrong database format." );
+
+    if( strncmp( header->signature, patstrBINDBVER, lenstrBINDBVER ))
+        throw myruntime_error( "Wrong database format." );
+
+    if( strncmp( header->signature + lenstrBINDBVER, bindbversion, strlen( bindbversion )))
+        throw myruntime_error( "Wrong database version number." );
+
+    if( header->noprofiles < 1 )
+        throw myruntime_error( "Wrong database format: Invalid number of profiles." );
+
+    if( header->dbsize < 1 )
+        throw myruntime_error( "Wrong database format: Invalid size." );
+
+    if( DTypeUNKNOWN <= header->distribution )
+        throw myruntime_error( "Wrong database format: Unrecognized distribution." );
+
+    SetNoSequences( header->noprofiles );
+    SetDbSize( header->dbsize );
+    SetDistributionType(( TFVectorProbabilities )header->distribution );
+}
+
+// -------------------------------------------------------------------------
+// IsBinaryFile: verifies whether the database file is in the binary
+//     format; the file is positioned at the beginning afterwards
+//
+bool Database::IsBinaryFile( FILE* fp )
+{
+    char    locbuffer[KBYTE];
+    size_t  length = strlen( patstrBINDBVER );
+    bool    binary = false;
+
+    if( !fp )
+        return false;
+
+    if( fread( locbuffer, sizeof( char ), length, fp ) == length )
+        binary = strncmp( locbuffer, patstrBINDBVER, length ) == 0;
+
+    rewind( fp );
+    return binary;
+}
+
+// -------------------------------------------------------------------------
+// MapMainFile: maps the main database file in the binary format to
+//     memory; profiles read then refer to the mapped data
+//
+void Database::MapMainFile()
+{
+    struct stat info;
+    void*       addr;
+
+    if( GetDbDesc() == NULL || db_map )
+        throw myruntime_error( "Unable to map database." );
+
+    if( fstat( fileno( GetDbDesc()), &info ) == -1 || info.st_size < ( off_t )sizeof( TBinDbHeader ))
+        throw myruntime_error( "Wrong database format." );
+
+    addr = mmap( NULL, info.st_size, PROT_READ, MAP_SHARED, fileno( GetDbDesc()), 0 );
+    if( addr == MAP_FAILED )
+        throw myruntime_error( "Failed to map database." );
+
+    db_map = ( char* )addr;
+    db_mapsize = info.st_size;
+    db_mappos = sizeof( TBinDbHeader );
+    SetBinary( true );
+
+    ReadBinaryHeader( db_map, db_mapsize );
+
+    if( db_mapsize <= db_mappos )
+        SetNextSym( EOF );
+}
+
+// -------------------------------------------------------------------------
+// UnmapMainFile: unmaps the main database file
+//
+void Database::UnmapMainFile()
+{
+    if( db_map )
+        munmap( db_map, db_mapsize );
+    db_map = NULL;
+    db_mapsize = 0;
+    db_mappos = 0;
+}
+
+
+
 // -------------------------------------------------------------------------
 // PutSignature: puts signature of the database
 // -------------------------------------------------------------------------
@@ -8,6 +8,8 @@
 #ifndef __Database__
 #define __Database__
 
+#include <pthread.h>
+
 #include "debug.h"
 #include "types.h"
 #include "compdef.h"
@@ -16,10 +18,61 @@
 #include "SEGProfile.h"
 
 #include "FrequencyStore.h"
+#include "ColumnWordIndex.h"
+#include "ProfileOffsetIndex.h"
 
 #include "mystring.h"
 #include "myexcept.h"
 
+class Database;
+
+// _________________________________________________________________________
+// Class MakingWorker
+//
+// Private data of one thread making the database: profile read from file
+// and preprocessed, its frequency vectors, and the record of the profile
+// to be written to the database
+//
+
+class MakingWorker {
+public:
+    MakingWorker( Database* );
+    ~MakingWorker();
+
+    const char*     GetError() const            { return error.empty()? NULL: error.c_str(); }
+    int             GetErrorClass() const       { return errclass; }
+
+protected:
+    explicit MakingWorker();
+
+    void            SetError( const char* msg, int ecl ) { error = msg; errclass = ecl; }
+    void            Reset();                    //release the data of the profile processed
+    void            ReallocVectors( size_t newcap );
+
+private:
+    friend class Database;
+
+    Database*               owner;          //database the worker makes
+    pthread_t               thread;         //thread identifier
+    Serializer              serializer;     //object to read profile with
+
+    FrequencyMatrix         freq;           //profile being processed
+    LogOddsMatrix           pssm;
+    GapScheme               gaps;
+
+    char*                   vectors;        //records of the frequency vectors of the profile, packed
+    double*                 probs;          //probabilities of the vectors
+    size_t                  novectors;      //number of vectors
+    size_t                  veccapacity;    //capacity of vectors
+
+    char*                   record;         //record of the profile to be written to the database
+    size_t                  szrecord;       //size of the record
+    mystring                failure;        //message of the failure to process the profile
+
+    mystring                error;          //error message if the worker failed
+    int                     errclass;       //class of the error
+};
+
 // _________________________________________________________________________
 // Class Database
 //
@@ -35,6 +88,9 @@ class Database {
     enum TFile{
             MAIN,    //main profile database file
             FREQ,    //file of frequency vectors
+            IDX,     //column-word index of profiles
+            OFFS,    //offset index of profiles
+            IMG,     //image of frequency vectors
             cntFiles
     };
 public:
@@ -47,16 +103,34 @@ public:
     ~Database();
 
     void                    ReadInFrequencies();        //read frequencies in the internal storage
+    void                    ReadInIndex();              //read column-word index of profiles
+    void                    ReadInOffsets();            //read offset index of profiles
+    void                    RebuildOffsets();           //make offset index of profiles by reading the database
+    Uint64                  GetStoreFingerprint();      //hash of the frequency vectors read in
 
     void                    Open();                     //open database
     void                    Close( TFile = cntFiles );  //close database
                             //read one profile information...
     bool                    Next( FrequencyMatrix&, LogOddsMatrix&, GapScheme&, int goc, int gec, bool );
+                            //read profile information at the given position...
+    bool                    Read( long position, FrequencyMatrix&, LogOddsMatrix&, GapScheme&, int goc, int gec, bool );
+    long                    GetPosition() const;        //position of the next profile in the database
+                            //position the database at the profile of the given ordinal number...
+    void                    Seek( size_t ordinal );
+                            //read profile of the given ordinal number...
+    bool                    ReadAt( size_t ordinal, FrequencyMatrix&, LogOddsMatrix&, GapScheme&, int goc, int gec, bool );
+                            //restrict reading to profiles with ordinal numbers in [begin,end)...
+    void                    Range( size_t begin, size_t end );
                             //make the database by processing and gluing profiles
     void                    Make();
+                            //append profiles to the existing database
+    void                    Append();
 
     const char*             GetMainDbName();            //get main database name
     const char*             GetFreqDbName();            //get name of frequency file
+    const char*             GetIndexDbName();           //get name of column-word index file
+    const char*             GetOffsetsDbName();         //get name of offset index file
+    const char*             GetImageDbName();           //get name of image file of frequency vectors
     const char*             GetDbName() const           { return dbname; }
     size_t                  GetNoVectors() const        { return no_vectors; }
     size_t                  GetNoSequences() const      { return no_sequences; }
@@ -77,6 +151,17 @@ public:
                     }
 
     const FrequencyStore*   GetStore() const            { return store; }
+    const ColumnWordIndex*  GetIndex() const            { return index; }
+    const ProfileOffsetIndex*   GetOffsets() const      { return offsets; }
+
+    bool            GetMakeIndex() const        { return makeindex; }
+    void            SetMakeIndex( bool value )  { makeindex = value; }
+
+    bool            GetBinary() const           { return binary; }
+    void            SetBinary( bool value )     { binary = value; }
+
+    int             GetNoThreads() const        { return no_threads; }
+    void            SetNoThreads( int value )   { no_threads = value; }
 
     static mystring                 GetDistributionText( int type );
     static TFVectorProbabilities    GetDistributionType( const mystring& distrstr );
@@ -90,9 +175,21 @@ protected:
 
     void    ProcessInput( PMETHOD, void* );             //process profiles given explicitly or found in directory
     void    PreprocessProfile( FrequencyMatrix&, LogOddsMatrix&, GapScheme& );
-    void    ProcessFile( const char* filename, void* ); //process profile information
-    void    WriteFile( const char* filename, void* );   //append contents of file, i.e. profile,  to the database
+    void    CollectFile( const char* filename, void* ); //add file to the list of inputs
+    void    ProcessFile( MakingWorker&, const char* filename ); //read and process profile information
+    void    CommitFile( MakingWorker&, const char* filename );  //store vectors and append profile to the database
+    void    MakeProfiles( MakingWorker& );              //process inputs until all of them are taken
+    static void* MakeThread( void* );                   //entry point of a worker thread
+    void    RunWorkers();                               //process inputs with the pool of workers
+    void    DestroyInputs();
+    void    ReadFrequencies( bool final );              //read frequencies; raw values unless final
+    bool    ReadInImage();                              //map image of frequencies if it is up to date
+    void    WriteImage();                               //write image of frequencies read from file
+    static void CopyContents( FILE* to, FILE* from );   //copy the rest of file to another file
     void    WriteFrequencies( FILE* fd );               //write frequency vectors to file descriptor
+                                                        //read profile at the current position
+    bool    ReadNext( FrequencyMatrix&, LogOddsMatrix&, GapScheme&, int goc, int gec, bool );
+    void    SetPosition( long position );               //set position of the next profile to read
 
 
     void        SetUsingSeg( bool value )           { usingseg = value; }
@@ -125,6 +222,13 @@ protected:
     void        WriteTextHeader( FILE* );
     void        ReadTextHeader( FILE* );
 
+    void        WriteBinaryHeader( FILE* );
+    void        ReadBinaryHeader( const char*, size_t );
+    static bool IsBinaryFile( FILE* );                  //whether file is in binary format
+
+    void        MapMainFile();                          //map main database file in binary format to memory
+    void        UnmapMainFile();
+
     void        PutHeader( FILE* );                     //put header of the database
     void        GetHeader( FILE* );                     //get header from the database
 
@@ -161,6 +265,27 @@ private:
 
 
     FrequencyStore*     store;              //store of frequency vectors
+    Uint64              storeprint;         //hash of the vectors of the store; 0 if not computed yet
+    ColumnWordIndex*    index;              //column-word index of profiles
+    bool                makeindex;          //whether to make the index with the database
+    ProfileOffsetIndex* offsets;            //offset index of profiles
+    long                endposition;        //position reading of profiles ends at; -1 for the end of file
+    bool                binary;             //whether the main database file is in binary format
+
+    char*               db_map;             //main database file in binary format mapped to memory
+    size_t              db_mapsize;         //size of the mapped file
+    size_t              db_mappos;          //position of the next profile in the mapped file
+
+    int                 no_threads;         //number of threads to make the database with
+    char**              inputs;             //names of files of profiles to make the database of
+    size_t              noinputs;           //number of inputs
+    size_t              inputcapacity;      //capacity of inputs
+    size_t              input_next;         //next input to be taken by a worker
+    size_t              input_committed;    //number of inputs committed to the database so far
+    long                record_base;        //position in the main file the records committed start at
+    bool                make_aborted;       //whether making has been aborted on error
+    pthread_mutex_t     make_mutex;         //serializes taking and committing of inputs
+    pthread_cond_t      make_cond;          //signals the commit of an input
 
     static const char*  db_signature[];     // database signature
     static const char*  db_extensions[];    // extensions of the database files
@@ -180,6 +305,21 @@ const char* Database::GetProfile( int n ) const
     return profiles[ n ];
 }
 
+// -------------------------------------------------------------------------
+// GetPosition: returns position of the next profile to be read from the
+//     database; -1 if the database is not opened
+// -------------------------------------------------------------------------
+
+inline
+long Database::GetPosition() const
+{
+    if( GetDbDesc() == NULL )
+        return -1;
+    if( db_map )
+        return ( long )db_mappos;
+    return ftell( GetDbDesc());
+}
+
 // -------------------------------------------------------------------------
 // AreVectorsConsistent: verifies if the number of vectors is valid
 // -------------------------------------------------------------------------
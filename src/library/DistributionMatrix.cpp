@@ -32,7 +32,8 @@ DistributionMatrix::DistributionMatrix()
 :   values( 0 ),
     aacids( 0 ),
     columns( 0 ),
-    allocated( 0 )
+    allocated( 0 ),
+    external( false )
 {
     init();
 }
@@ -56,6 +57,7 @@ void DistributionMatrix::init()
     aacids = NULL;
     columns = 0;
     allocated = 0;
+    external = false;
 }
 
 // -------------------------------------------------------------------------
@@ -98,19 +100,73 @@ bool DistributionMatrix::IsCompatible( const GapScheme& goc ) const
 
 void DistributionMatrix::destroy()
 {
-    if( values ) { free( values ); values = NULL; }
-    if( aacids ) { free( aacids ); aacids = NULL; }
+    if( !external ) {
+        if( values ) free( values );
+        if( aacids ) free( aacids );
+    }
+    values = NULL;
+    aacids = NULL;
+    columns = 0;
+    allocated = 0;
+    external = false;
+}
+
+// -------------------------------------------------------------------------
+// SetView: makes the matrix refer to external data, which are to remain
+//     valid while in use; the data are copied only when the matrix is
+//     to be modified
+// -------------------------------------------------------------------------
+
+void DistributionMatrix::SetView( const double ( *vals )[NUMALPH], const char* res, int cols )
+{
+    if( !vals || !res || cols <= 0 )
+        throw myruntime_error( mystring( "DistributionMatrix: Invalid data of view." ));
+
+    DistributionMatrix::destroy();
+
+    values = ( double(*)[NUMALPH] )vals;
+    aacids = ( char* )res;
+    columns = cols;
+    allocated = cols;
+    external = true;
+}
+
+// -------------------------------------------------------------------------
+// detach: makes a copy of external data the matrix refers to
+// -------------------------------------------------------------------------
+
+void DistributionMatrix::detach()
+{
+    const double ( *ext_values )[NUMALPH] = values;
+    const char*     ext_aacids = aacids;
+    int             ext_columns = columns;
+
+    if( !external )
+        return;
+
+    values = NULL;
+    aacids = NULL;
     columns = 0;
     allocated = 0;
+    external = false;
+
+    DistributionMatrix::reallocate( ext_columns );
+
+    memcpy( values, ext_values, sizeof( double ) * NUMALPH * ext_columns );
+    memcpy( aacids, ext_aacids, sizeof( char ) * ext_columns );
+    columns = ext_columns;
 }
 
 // -------------------------------------------------------------------------
 // Clear: erases all information contained in this class but leaves the
-//     space allocated
+//     space allocated; external data are no longer referred to
 // -------------------------------------------------------------------------
 
 void DistributionMatrix::Clear()
 {
+    if( external )
+        DistributionMatrix::destroy();
+
     if( allocated ) {
         memset( values, 0, sizeof( double ) * NUMALPH * allocated );
         memset( aacids, 0, sizeof( char ) * allocated );
@@ -129,6 +185,9 @@ void DistributionMatrix::reallocate( int howmuch )
     double   ( *tmp_values )[NUMALPH];
     char*       tmp_aacids;
 
+    if( external )
+        detach();
+
     if( howmuch <= allocated )
         return;
 
@@ -173,6 +232,9 @@ void DistributionMatrix::Push( const double posvalues[NUMALPH], char aa )
 
 void DistributionMatrix::PushAt( const double posvalues[NUMALPH], char aa, int position )
 {
+    if( external )
+        detach();
+
     if( allocated < position + 1 )
         throw myruntime_error(
             mystring( "DistributionMatrix: Failed to insert vector." ));
@@ -265,7 +327,7 @@ void DistributionMatrix::CheckForAllZeros()
 
     for( int n = 0; n < GetColumns(); n++ ) {
         for( r = 0; r < NUMALPH; r++ )
-            if( zval < ( *this )( n, r ))
+            if( zval < GetValueAt( n, r ))
                 break;
         if( r == NUMALPH ) {
             // If all values are zero
@@ -398,9 +460,14 @@ void ExtendedDistributionMatrix::init()
 
 void ExtendedDistributionMatrix::destroy()
 {
-    if( freqweights )   { free( freqweights ); freqweights = NULL; }
-    if( information )   { free( information ); information = NULL; }
-    if( thickness   )   { free( thickness   ); thickness   = NULL; }
+    if( !external ) {
+        if( freqweights )   free( freqweights );
+        if( information )   free( information );
+        if( thickness   )   free( thickness   );
+    }
+    freqweights = NULL;
+    information = NULL;
+    thickness   = NULL;
     if( name )          { free( name ); name = NULL; szname = 0; }
     if( description )   { free( description ); description = NULL; szdescription = 0; }
     //
@@ -414,7 +481,13 @@ void ExtendedDistributionMatrix::destroy()
 
 void ExtendedDistributionMatrix::Clear()
 {
-    if( allocated ) {
+    if( external ) {
+        //the base class drops the view
+        freqweights = NULL;
+        information = NULL;
+        thickness   = NULL;
+    }
+    else if( allocated ) {
         memset( freqweights, 0, sizeof( double ) * allocated );
         memset( information, 0, sizeof( double ) * allocated );
         memset( thickness,   0, sizeof( size_t ) * allocated );
@@ -450,6 +523,9 @@ void ExtendedDistributionMatrix::reallocate( int howmuch )
     double*     tmp_information;
     size_t*     tmp_thickness;
 
+    if( external )
+        detach();
+
     if( howmuch <= allocated )
         return;
 
@@ -503,6 +579,9 @@ void ExtendedDistributionMatrix::Push( const double posvalues[NUMALPH], char aa,
 void ExtendedDistributionMatrix::PushAt( const double posvalues[NUMALPH], char aa, double weight, double info, size_t thick,
         int position )
 {
+    if( external )
+        detach();
+
     if( allocated < position + 1 )
         throw myruntime_error(
             mystring( "ExtendedDistributionMatrix: Failed to insert vector." ));
@@ -514,6 +593,56 @@ void ExtendedDistributionMatrix::PushAt( const double posvalues[NUMALPH], char a
     DistributionMatrix::PushAt( posvalues, aa, position );
 }
 
+// -------------------------------------------------------------------------
+// SetView: makes the matrix refer to external data, which are to remain
+//     valid while in use; name and description are not affected
+// -------------------------------------------------------------------------
+
+void ExtendedDistributionMatrix::SetView( const double ( *vals )[NUMALPH], const char* res,
+        const double* weights, const double* info, const size_t* thick, int cols )
+{
+    if( !weights || !info || !thick )
+        throw myruntime_error( mystring( "ExtendedDistributionMatrix: Invalid data of view." ));
+
+    if( !external ) {
+        if( freqweights )   free( freqweights );
+        if( information )   free( information );
+        if( thickness   )   free( thickness   );
+    }
+    freqweights = ( double* )weights;
+    information = ( double* )info;
+    thickness   = ( size_t* )thick;
+
+    DistributionMatrix::SetView( vals, res, cols );
+}
+
+// -------------------------------------------------------------------------
+// detach: makes a copy of external data the matrix refers to
+// -------------------------------------------------------------------------
+
+void ExtendedDistributionMatrix::detach()
+{
+    const double*   ext_freqweights = freqweights;
+    const double*   ext_information = information;
+    const size_t*   ext_thickness   = thickness;
+
+    if( !external )
+        return;
+
+    DistributionMatrix::detach();
+
+    freqweights = ( double* )malloc( sizeof( double ) * allocated );
+    information = ( double* )malloc( sizeof( double ) * allocated );
+    thickness   = ( size_t* )malloc( sizeof( size_t ) * allocated );
+
+    if( !freqweights || !information || !thickness )
+        throw myruntime_error( mystring( "ExtendedDistributionMatrix: Not enough memory." ));
+
+    memcpy( freqweights, ext_freqweights, sizeof( double ) * allocated );
+    memcpy( information, ext_information, sizeof( double ) * allocated );
+    memcpy( thickness,   ext_thickness,   sizeof( size_t ) * allocated );
+}
+
 // -------------------------------------------------------------------------
 // PushAt: pushes vector of values at the given position
 // -------------------------------------------------------------------------
@@ -1773,3 +1902,219 @@ void TextReadProfile( FILE* fp, FrequencyMatrix& frqs, LogOddsMatrix& pssm, GapS
             throw myruntime_error( mystring( "Wrong profile format: Ending." ));
 }
 
+
+// =========================================================================
+// BinaryRecordSize: size of the binary record of a profile given its
+//     length and sizes of name and description; arrays of the record are
+//     aligned to 8 bytes
+//
+static inline size_t BinaryAlign( size_t size )
+{
+    return ( size + 7 ) & ~( size_t )7;
+}
+
+static size_t BinaryRecordSize( size_t length, size_t szname, size_t szdescription )
+{
+    return  sizeof( TBinProfileHeader ) +
+            sizeof( double ) * NUMALPH * length * 2 +   //frequencies and scores
+            sizeof( double ) * length * 2 +             //frequency weights and information
+            sizeof( Uint64 ) * length +                 //thickness
+            sizeof( double ) * length * 3 +             //gap weights and deletion weights
+            BinaryAlign( sizeof( Int32 ) * length ) +   //deletion intervals
+            BinaryAlign( length ) +                     //residues
+            BinaryAlign( szname + 1 + szdescription + 1 );
+}
+
+// =========================================================================
+// BinaryWriteProfile: write profile data to file in the binary format
+//
+void BinaryWriteProfile( FILE* fp, const FrequencyMatrix& frqs, const LogOddsMatrix& pssm, const GapScheme& gaps )
+{
+    if( !fp )
+        return;
+
+    if( frqs.GetColumns() != pssm.GetColumns() ||
+        frqs.GetColumns() != gaps.GetColumns())
+        throw myruntime_error( "BinaryWriteProfile: Inconsistent Profile data." );
+
+    static const char   zeros[8] = {0};
+    TBinProfileHeader   header;
+    const int           prolen = pssm.GetColumns();
+    const char*         name = pssm.GetName()? pssm.GetName(): "";
+    const char*         desc = pssm.GetDescription()? pssm.GetDescription(): "";
+    size_t              written;
+    double              value;
+    Uint64              thick;
+    Int32               delint;
+    int                 m, r;
+
+    memset( &header, 0, sizeof( header ));
+
+    header.length = prolen;
+    header.szname = strlen( name );
+    header.szdescription = strlen( desc );
+    header.recsize = BinaryRecordSize( header.length, header.szname, header.szdescription );
+    header.thickness = pssm.GetMtxThickness();
+    header.effthickness = pssm.GetMtxEffectiveThickness();
+
+    for( r = 0; r < NUMALPH; r++ )
+        header.backprobs[r] = pssm.GetBackProbsAt( r );
+
+    header.opencost = gaps.GetOpenCost();
+    header.extendcost = gaps.GetExtendCost();
+    header.refLambda = pssm.GetRefLambda();
+    header.refK = pssm.GetRefK();
+    header.lambda = pssm.GetLambda();
+    header.entropy = pssm.GetEntropy();
+    header.parameterK = pssm.GetK();
+    header.expscore = pssm.GetExpectedScore();
+
+    for( m = 0; m < prolen; m++ )
+        if( pssm.GetResidueAt( m ) != frqs.GetResidueAt( m ) || pssm.GetResidueAt( m ) != gaps.AAcid( m ))
+            throw myruntime_error( "BinaryWriteProfile: Inconsistent Profile data." );
+
+    Serializer::Write( fp, ( char* )&header, sizeof( header ), 1 );
+
+    for( m = 0; m < prolen; m++ )
+        Serializer::Write( fp, ( char* )*frqs.GetVectorAt( m ), sizeof( double ), NUMALPH );
+    for( m = 0; m < prolen; m++ )
+        Serializer::Write( fp, ( char* )*pssm.GetVectorAt( m ), sizeof( double ), NUMALPH );
+
+    for( m = 0; m < prolen; m++ ) {
+        value = pssm.GetFrequencyWeightAt( m );
+        Serializer::Write( fp, ( char* )&value, sizeof( value ), 1 );
+    }
+    for( m = 0; m < prolen; m++ ) {
+        value = pssm.GetInformationAt( m );
+        Serializer::Write( fp, ( char* )&value, sizeof( value ), 1 );
+    }
+    for( m = 0; m < prolen; m++ ) {
+        thick = pssm.GetThicknessAt( m );
+        Serializer::Write( fp, ( char* )&thick, sizeof( thick ), 1 );
+    }
+    for( m = 0; m < prolen; m++ ) {
+        value = gaps.GetWeightsAt( m );
+        Serializer::Write( fp, ( char* )&value, sizeof( value ), 1 );
+    }
+    for( m = 0; m < prolen; m++ ) {
+        value = gaps.GetDeletesBegAt( m );
+        Serializer::Write( fp, ( char* )&value, sizeof( value ), 1 );
+    }
+    for( m = 0; m < prolen; m++ ) {
+        value = gaps.GetDeletesEndAt( m );
+        Serializer::Write( fp, ( char* )&value, sizeof( value ), 1 );
+    }
+    written = sizeof( header ) + sizeof( double ) * NUMALPH * prolen * 2 + sizeof( double ) * prolen * 6;
+
+    for( m = 0; m < prolen; m++ ) {
+        delint = gaps.GetDeletesIntervalAt( m );
+        Serializer::Write( fp, ( char* )&delint, sizeof( delint ), 1 );
+    }
+    written += sizeof( Int32 ) * prolen;
+    Serializer::Write( fp, ( char* )zeros, 1, BinaryAlign( written ) - written );
+    written = BinaryAlign( written );
+
+    Serializer::Write( fp, ( char* )frqs.GetResidues(), sizeof( char ), prolen );
+    written += prolen;
+    Serializer::Write( fp, ( char* )zeros, 1, BinaryAlign( written ) - written );
+    written = BinaryAlign( written );
+
+    Serializer::Write( fp, ( char* )name, sizeof( char ), header.szname + 1 );
+    Serializer::Write( fp, ( char* )desc, sizeof( char ), header.szdescription + 1 );
+    written += header.szname + 1 + header.szdescription + 1;
+    Serializer::Write( fp, ( char* )zeros, 1, BinaryAlign( written ) - written );
+}
+
+// -------------------------------------------------------------------------
+// BinaryReadProfile: read profile data from the binary record in memory;
+//     frequencies and scores refer to the record, which is to remain
+//     valid while they are in use; returns the size of the record
+//
+size_t BinaryReadProfile( const char* record, size_t size, FrequencyMatrix& frqs, LogOddsMatrix& pssm, GapScheme& gaps )
+{
+    if( !record || size < sizeof( TBinProfileHeader ))
+        throw myruntime_error( "Wrong profile format: Truncated record." );
+
+    const TBinProfileHeader*    header = ( const TBinProfileHeader* )record;
+    const char*     p = record + sizeof( TBinProfileHeader );
+    const double ( *freqns )[NUMALPH];
+    const double ( *scores )[NUMALPH];
+    const double*   weights, *inform;
+    const Uint64*   thickn;
+    const double*   gapwgt, *delbeg, *delend;
+    const Int32*    delint;
+    const char*     residues;
+    const char*     name, *desc;
+    int             prolen;
+    int             m, r;
+
+    if( header->length < 1 || MAXCOLUMNS < header->length )
+        throw myruntime_error( "Wrong profile format: Invalid profile length." );
+
+    prolen = ( int )header->length;
+
+    if( size < header->recsize ||
+        header->recsize != BinaryRecordSize( header->length, header->szname, header->szdescription ))
+        throw myruntime_error( "Wrong profile format: Truncated record." );
+
+    freqns = ( const double(*)[NUMALPH] )p;     p += sizeof( double ) * NUMALPH * prolen;
+    scores = ( const double(*)[NUMALPH] )p;     p += sizeof( double ) * NUMALPH * prolen;
+    weights = ( const double* )p;               p += sizeof( double ) * prolen;
+    inform = ( const double* )p;                p += sizeof( double ) * prolen;
+    thickn = ( const Uint64* )p;                p += sizeof( Uint64 ) * prolen;
+    gapwgt = ( const double* )p;                p += sizeof( double ) * prolen;
+    delbeg = ( const double* )p;                p += sizeof( double ) * prolen;
+    delend = ( const double* )p;                p += sizeof( double ) * prolen;
+    delint = ( const Int32* )p;                 p += BinaryAlign( sizeof( Int32 ) * prolen );
+    residues = p;                               p += BinaryAlign( prolen );
+    name = p;                                   p += header->szname + 1;
+    desc = p;
+
+    for( m = 0; m < prolen; m++ )
+        if( residues[m] < 0 || NUMALPH <= residues[m] )
+            throw myruntime_error( "Wrong profile format: Invalid residue." );
+
+    if( name[header->szname] || desc[header->szdescription] )
+        throw myruntime_error( "Wrong profile format: Invalid name or description." );
+
+    frqs.SetView( freqns, residues, prolen );
+
+    if( sizeof( size_t ) == sizeof( Uint64 ))
+        pssm.SetView( scores, residues, weights, inform, ( const size_t* )thickn, prolen );
+    else {
+        //thickness cannot be referred to
+        pssm.Clear();
+        pssm.Reserve( prolen );
+        for( m = 0; m < prolen; m++ )
+            pssm.PushAt( scores[m], residues[m], weights[m], inform[m], ( size_t )thickn[m], m );
+    }
+
+    pssm.SetName( header->szname? name: NULL );
+    pssm.SetDescription( header->szdescription? desc: NULL );
+
+    pssm.SetMtxThickness( header->thickness );
+    pssm.SetMtxEffectiveThickness( header->effthickness );
+
+    for( r = 0; r < NUMALPH; r++ )
+        pssm.SetBackProbsAt( r, header->backprobs[r] );
+
+    pssm.SetRefLambda( header->refLambda );
+    pssm.SetRefK( header->refK );
+    pssm.SetLambda( header->lambda );
+    pssm.SetEntropy( header->entropy );
+    pssm.SetK( header->parameterK );
+    pssm.SetExpectedScore( header->expscore );
+
+    //gap costs are prepared in place and thus copied
+    gaps.Clear();
+    gaps.Reserve( prolen );
+
+    for( m = 0; m < prolen; m++ )
+        gaps.PushAt( gapwgt[m], delbeg[m], delend[m], delint[m], residues[m], m );
+
+    gaps.SetOpenCost( header->opencost );
+    gaps.SetExtendCost( header->extendcost );
+    gaps.Initialize();
+
+    return ( size_t )header->recsize;
+}
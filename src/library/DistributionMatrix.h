@@ -11,6 +11,7 @@
 #define __DistributionMatrix__
 
 #include "compdef.h"
+#include "types.h"
 #include "debug.h"
 #include "rc.h"
 #include "data.h"
@@ -53,6 +54,9 @@ public:
     virtual void    OutputMatrix( const char* = NULL ) const;
 
     void            Reserve( int amount )   { reallocate( amount ); }
+                                                            //refer to external data instead of a copy of them
+    void            SetView( const double ( *vals )[NUMALPH], const char* res, int cols );
+    bool            IsView() const          { return external; }
 
     void            CheckForAllZeros();                     //verify wether extists positions with all values of zero
 
@@ -64,6 +68,7 @@ protected:
     virtual void    destroy();                              //deallocate memory and reset values
     virtual void    reallocate( int howmuch );              //memory allocation
     virtual void    init();                                 //initialization method
+    virtual void    detach();                               //make a copy of external data to modify them
 
     void            SetColumns( int col )   { columns = col; }
     void            CheckIntegrity() const;                 //check integrity of the structure
@@ -73,6 +78,7 @@ protected:
     char*       aacids;                 //sequence of amino acids for which profile was computed
     int         columns;   	            //number of columns of matrix
     int         allocated;              //how many positions allocated
+    bool        external;               //whether values refer to external memory not owned by the object
 
 };
 
@@ -88,6 +94,9 @@ public:
     virtual void    Push( const double posvalues[NUMALPH], char, double weight, double info, size_t thick );
     virtual void    PushAt( const double posvalues[NUMALPH], char, double weight, double info, size_t thick, int pos );
     virtual void    PushAt( const double posvalues[NUMALPH], char, int pos );
+                                    //refer to external data instead of a copy of them
+    void            SetView( const double ( *vals )[NUMALPH], const char* res,
+                             const double* weights, const double* info, const size_t* thick, int cols );
 
     virtual void    Serialize( Serializer& ) const;
     virtual void    Deserialize( Serializer& );
@@ -164,6 +173,7 @@ protected:
     virtual void    destroy();                              //deallocate memory and reset values
     virtual void    reallocate( int howmuch );              //memory allocation
     virtual void    init();                                 //initialization method
+    virtual void    detach();                               //make a copy of external data to modify them
 
     size_t          GetPrivateBufferSize() const    { return MAX_DESCRIPTION_LENGTH; }
     char*           GetPrivateBuffer() const        { return private_buffer; }
@@ -211,6 +221,36 @@ void OutputProfile( const char* filename, const FrequencyMatrix&, const LogOddsM
 void TextWriteProfile( FILE*, const FrequencyMatrix&, const LogOddsMatrix&, const GapScheme&, int = gcpDMscaling );
 void TextReadProfile( FILE*, FrequencyMatrix&, LogOddsMatrix&, GapScheme& );
 
+// -------------------------------------------------------------------------
+// Binary format of profile data: a record of a profile is the header
+// below followed by arrays aligned to 8 bytes, each of one value or
+// vector per column:
+//  frequencies [LEN][NUMALPH], scores [LEN][NUMALPH], frequency weights,
+//  information content, thickness (Uint64), gap weights, deletion weights
+//  at the beginning and end (doubles), deletion intervals (Int32),
+//  residues (chars); then name and description (null-terminated)
+//
+struct TBinProfileHeader {
+    Uint64  recsize;                //size of the whole record in bytes
+    Uint64  length;                 //number of columns
+    Uint64  szname;                 //length of name
+    Uint64  szdescription;          //length of description
+    Uint64  thickness;              //thickness of alignment
+    Uint64  effthickness;           //effective thickness
+    double  backprobs[NUMALPH];     //background probabilities
+    double  opencost;               //gap open cost
+    double  extendcost;             //gap extension cost
+    double  refLambda;              //reference statistical parameters
+    double  refK;
+    double  lambda;                 //computed statistical parameters
+    double  entropy;
+    double  parameterK;
+    double  expscore;
+};
+
+void BinaryWriteProfile( FILE*, const FrequencyMatrix&, const LogOddsMatrix&, const GapScheme& );
+size_t BinaryReadProfile( const char* record, size_t size, FrequencyMatrix&, LogOddsMatrix&, GapScheme& );
+
 // -------------------------------------------------------------------------
 // GetValue: used to access score value at the specified position and for
 //     the specified amino acid
@@ -268,6 +308,8 @@ const double ( *DistributionMatrix::GetVectorAt( int m ) const )[NUMALPH]
 inline
 double& DistributionMatrix::operator()( int m, int a )
 {
+    if( external )
+        detach();
 #ifdef __DEBUG__
     if( columns <= m || m < 0 )
         throw myruntime_error(
@@ -287,6 +329,8 @@ double& DistributionMatrix::operator()( int m, int a )
 inline
 char& DistributionMatrix::operator[]( int m )
 {
+    if( external )
+        detach();
 #ifdef __DEBUG__
     if( columns <= m || m < 0 )
         throw myruntime_error(
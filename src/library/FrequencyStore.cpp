@@ -6,8 +6,11 @@
  ***************************************************************************/
 
 #include <math.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 #include "mystring.h"
 #include "myexcept.h"
@@ -17,8 +20,8 @@
 
 
 TFVectorProbabilities   FrequencyStore::probtype = DISCRETE;
-THashFunction FrequencyStore::func1stlevel = FrequencyVector::RJHashing;
-THashFunction FrequencyStore::func2ndlevel = FrequencyVector::SBoxHashing;//;
+THashFunction FrequencyStore::hashfunc = FrequencyVector::RJHashing;
+const char* FrequencyStore::signature = "COMA frequency store image v1.0";
 
 THashFunction FrequencyVector::hash_FUNCTIONS[] = {
     RJHashing,
@@ -426,15 +429,13 @@ void FrequencyVector::TextWriteVector( FILE* fp ) const
 }
 
 // -------------------------------------------------------------------------
-// TextReadVector: read vector data from file
+// TextReadVector: read vector data from file; memory of the vector is
+//     reused if it has been allocated
 //
 void FrequencyVector::TextReadVector( FILE* fp )
 {
     if( !fp )
         return;
-    if( vector )
-        //vector supposed to be not initialized yet
-        throw myruntime_error( mystring( "FrequencyVector: TextReadVector: Vector is non-empty." ));
 
     size_t          length, rbts;
     const size_t    locsize = KBYTE;
@@ -666,18 +667,25 @@ size_t FrequencyVector::MixHashing( const void* vect )
 
 
 // /////////////////////////////////////////////////////////////////////////
-// CLASS FrequencyVector
+// CLASS FrequencyStore
 //
 // constructor: default
 // -------------------------------------------------------------------------
 
 FrequencyStore::FrequencyStore()
-:   primaryHash( NULL ),
-    frequencies( NULL ),
-    no_collisions1( 0 ),
-    no_collisions2( 0 )
+:   blocks( NULL ),
+    noblocks( 0 ),
+    blockcapacity( 0 ),
+    recordsize( 0 ),
+    novectors( 0 ),
+    slots( NULL ),
+    indexsize( 0 ),
+    image( NULL ),
+    imagesize( 0 )
 {
-    Init();
+    //records are aligned for access to the probability of vector
+    recordsize = ( FrequencyVector::GetSizeOfVector() + sizeof( double ) - 1 ) & ~( sizeof( double ) - 1 );
+    ReallocIndex( hashsize( IndexBits ));
 }
 
 // -------------------------------------------------------------------------
@@ -687,340 +695,391 @@ FrequencyStore::FrequencyStore()
 FrequencyStore::~FrequencyStore()
 {
     Destroy();
-    DestroyFrequencies();
 }
 
 // -------------------------------------------------------------------------
-// Init: initialization
+// Destroy: destroys the arena of vectors and the index, or unmaps the
+//     image they refer to
 // -------------------------------------------------------------------------
 
-void FrequencyStore::Init()
+void FrequencyStore::Destroy()
 {
-    //create primary hash strucutre using Jenkins' hash function;
-    //hash size is defined as 2 to FirstLevelHashBits
-    primaryHash = new HashTable( FirstLevelHashing, hashsize( FirstLevelHashBits ));
-
-    if( primaryHash == NULL )
-        throw myruntime_error(
-            mystring( "FrequencyStore: Not enough memory." ));
+    if( image )
+        munmap( image, imagesize );
+    else {
+        for( size_t n = 0; n < noblocks; n++ )
+            if( blocks[n] )
+                free( blocks[n] );
+        if( slots )
+            free( slots );
+    }
+    if( blocks )
+        free( blocks );
+
+    blocks = NULL;
+    slots = NULL;
+    image = NULL;
+    imagesize = 0;
+    noblocks = blockcapacity = 0;
+    novectors = 0;
+    indexsize = 0;
 }
 
 // -------------------------------------------------------------------------
-// SetNoFrequencyVectors: resets number that affects size of vector
-//     frequencies; all information in frequencies will be destroyed
+// NewBlock: allocates the next block of the arena
 // -------------------------------------------------------------------------
 
-void FrequencyStore::SetNoFrequencyVectors( size_t newsize )
+void FrequencyStore::NewBlock()
 {
-    DestroyFrequencies();
-    NewFrequencies( newsize );
+    char**  tmpblocks;
+    char*   block;
+
+    if( blockcapacity <= noblocks ) {
+        tmpblocks = ( char** )realloc( blocks, sizeof( void* ) * ( blockcapacity? blockcapacity * 2: 16 ));
+        if( !tmpblocks )
+            throw myruntime_error( mystring( "FrequencyStore: Not enough memory." ));
+        blocks = tmpblocks;
+        blockcapacity = blockcapacity? blockcapacity * 2: 16;
+    }
+
+    block = ( char* )malloc( recordsize * hashsize( ArenaBlockBits ));
+    if( !block )
+        throw myruntime_error( mystring( "FrequencyStore: Not enough memory." ));
+
+    blocks[noblocks++] = block;
 }
 
 // -------------------------------------------------------------------------
-// Destroy: destroys all elements contained in the two-level hash system
+// ReallocIndex: resizes the index to the given number of slots, which is
+//     a power of two, and puts all the records in it again
 // -------------------------------------------------------------------------
 
-void FrequencyStore::Destroy()
+void FrequencyStore::ReallocIndex( size_t newsize )
 {
-    if( !primaryHash )
-        return;
+    TFSSlot*    oldslots = slots;
+    size_t      oldsize = indexsize;
+    size_t      n;
 
-    for( size_t n = 0; n < primaryHash->GetHashSize(); n++ )
-    {   //iterate over all hash table...
-        const void* value = primaryHash->GetValueAt( n );
-        if( !value )
-            continue;
-        FrequencyVector frequencies(( const char* )value );
+    if( newsize < novectors || ( newsize & ( newsize - 1 )))
+        throw myruntime_error( mystring( "FrequencyStore: Invalid size of index." ));
 
-        if( frequencies.IsVector())
-            frequencies.Destroy();
-        else
-            DestroySecondaryHash( value );
+    slots = ( TFSSlot* )malloc( sizeof( TFSSlot ) * newsize );
+    if( !slots ) {
+        slots = oldslots;
+        throw myruntime_error( mystring( "FrequencyStore: Not enough memory." ));
     }
+    memset( slots, 0, sizeof( TFSSlot ) * newsize );
+    indexsize = newsize;
 
-    delete primaryHash;
+    for( n = 0; n < oldsize; n++ )
+        if( oldslots[n].record )
+            Insert( oldslots[n] );
+
+    if( oldslots )
+        free( oldslots );
 }
 
 // -------------------------------------------------------------------------
-// DestroySecondaryHash: destroys secondary hash table at the address
-//     specified
+// SetNoFrequencyVectors: reserves space in the index and arena for the
+//     given number of vectors; vectors already stored are kept
 // -------------------------------------------------------------------------
 
-void FrequencyStore::DestroySecondaryHash( const void* value )
+void FrequencyStore::SetNoFrequencyVectors( size_t size )
 {
-    const HashTable*    hash = ( const HashTable* )value;
+    size_t  newsize = indexsize;
 
-    if( !hash )
-        return;
+    if( image )
+        throw myruntime_error( mystring( "FrequencyStore: Mapped store is read-only." ));
 
-    for( size_t n = 0; n < hash->GetHashSize(); n++ )
-    {   //iterate over all hash table...
-        const void* value = hash->GetValueAt( n );
-        if( !value )
-            continue;
+    while( newsize * MaxLoadPercent < size * 100 )
+        newsize <<= 1;
+    if( indexsize < newsize )
+        ReallocIndex( newsize );
 
-        FrequencyVector frequencies(( const char* )value );
-
-        if( frequencies.IsVector())
-            frequencies.Destroy();
-        else
-            DestroyBSearchStructure( value );
-    }
-
-    delete hash;
+    while(( noblocks << ArenaBlockBits ) < size )
+        NewBlock();
 }
 
 // -------------------------------------------------------------------------
-// DestroyBSearchStructure: destroys binary search structure at the address
-//     specified
+// Insert: puts the record in the index; the vector of the record is not
+//     to be in the index; a record closer to its home slot gives its slot
+//     away and moves on
 // -------------------------------------------------------------------------
 
-void FrequencyStore::DestroyBSearchStructure( const void* value )
+void FrequencyStore::Insert( TFSSlot slot )
 {
-    const BinarySearchStructure*
-        bins = ( const BinarySearchStructure* )value;
-
-    if( !bins )
-        return;
-
-    for( size_t n = 0; n < bins->GetSize(); n++ )
-    {   //iterate over all hash table...
-        const void* value = bins->GetValueAt( n );
-        if( !value )
-            continue;
-
-        FrequencyVector frequencies(( const char* )value );
-
-        if( frequencies.IsVector())
-            frequencies.Destroy();
-#ifdef __DEBUG__
-        else
-            throw myruntime_error( mystring( "FrequencyStore: Internal error." ));
-#endif
+    size_t  mask = indexsize - 1;
+    size_t  pos = slot.hash & mask;
+    size_t  dist = 0;
+    size_t  existing;
+    TFSSlot tmp;
+
+    while( slots[pos].record ) {
+        existing = GetProbeLength( pos );
+        if( existing < dist ) {
+            tmp = slots[pos];
+            slots[pos] = slot;
+            slot = tmp;
+            dist = existing;
+        }
+        pos = ( pos + 1 ) & mask;
+        dist++;
     }
-
-    delete bins;
+    slots[pos] = slot;
 }
 
 // -------------------------------------------------------------------------
-// Store: stores frequency vector (key) into the hash system; at first the
-//     key is probed to put at the computed address in the primary hash
-//     table; if the position is occupied, secondary hash table is created
-//     if not exists and the occupation along with the key are put
-//     in the hash. If secondary hash table exists, then binary search
-//     structure is created and the occupation along with the key are put in
-//     there;
-//  returns address of the vector to be stored if frequencies have been
-//  stored in the system, otherwise returns address of the duplicate if
-//  there is one;
-//  returns NULL on error
+// Store: stores a copy of frequency vector (key) in the arena and puts it
+//     in the index unless there is a duplicate of the vector;
+//  returns address of the vector stored or address of the duplicate;
+//  inserted, if given, is set to indicate whether the vector has been
+//  stored
 // -------------------------------------------------------------------------
 
-const void* FrequencyStore::Store( const FrequencyVector& freq )
+const void* FrequencyStore::Store( const FrequencyVector& freq, bool* inserted )
 {
-    if( !primaryHash )
-        return NULL;
+    const void* found = Find( freq );
+    TFSSlot     slot;
+    char*       record;
 
-    size_t      address = primaryHash->GetAddress( freq.GetVector());
-    const void* value = primaryHash->GetValueAt( address );
+    if( inserted )
+        *inserted = false;
 
+    if( found )
+        return found;
 
-    if( value == NULL ) {
-        primaryHash->SetValueAt( address, freq.GetVector());
-        PushInFrequencies( freq.GetVector());
-        return freq.GetVector();
-    }
+    if( image )
+        throw myruntime_error( mystring( "FrequencyStore: Mapped store is read-only." ));
 
-    HashTable*              secondHash = ( HashTable* )value;
-    const FrequencyVector   freq_quest (( const char* )value );
+    if(( novectors + 1 ) * 100 > indexsize * MaxLoadPercent )
+        ReallocIndex( indexsize << 1 );
 
-    if( freq_quest.IsVector()) {
-        //check if it is not a duplicate first
-        if( VectorsAreEqual( freq, freq_quest ))
-            //it is a duplicate, omit further processing
-            return freq_quest.GetVector();
+    if(( noblocks << ArenaBlockBits ) <= novectors )
+        NewBlock();
 
-        //if there is only one frequency vector at the moment,
-        //  we need to create a secondary hash table next
-        secondHash = new HashTable( SecndLevelHashing, hashsize( SecndLevelHashBits ));
+    record = blocks[novectors >> ArenaBlockBits] + ( novectors & hashmask( ArenaBlockBits )) * recordsize;
+    memcpy( record, freq.GetVector(), FrequencyVector::GetSizeOfVector());
+    //clear alignment, so that images of the same vectors are equal
+    memset( record + FrequencyVector::GetSizeOfVector(), 0, recordsize - FrequencyVector::GetSizeOfVector());
 
-        if( secondHash == NULL )
-            throw myruntime_error( mystring( "FrequencyStore: Not enough memory." ));
+    slot.record = ++novectors;
+    slot.hash = Hashing( record );
+    Insert( slot );
 
-        //put the existing key in the secondary hash first
-        if( ! StoreInSecondaryHash( secondHash, freq_quest ))
-            throw myruntime_error( mystring( "FrequencyStore: Store failed." ));
-
-        //now this position of the primary hash will point to the secondary hash
-        primaryHash->SetValueAt( address, secondHash );
-    }
-
-    //put the original key in the secondary hash
-    const void* inserted = StoreInSecondaryHash( secondHash, freq );
-
-    //if the vector has been inserted
-    if( inserted == freq.GetVector()) {
-        no_collisions1++;
-        PushInFrequencies( freq.GetVector());
-    }
-
-    return  inserted;
+    if( inserted )
+        *inserted = true;
+    return record;
 }
 
 // -------------------------------------------------------------------------
-// StoreInSecondaryHashAt: stores frequency vector (key) into the secondary
-//     hash table
-//  returns address of the vector to be stored if frequencies have been
-//  stored in the hash, otherwise returns address of the duplicate if
-//  there is one;
-//  returns NULL on error
+// Find: finds frequency vector in the index; returns NULL if the vector
+//     is not found
 // -------------------------------------------------------------------------
 
-const void* FrequencyStore::StoreInSecondaryHash( HashTable* hash, const FrequencyVector& freq )
+const void* FrequencyStore::Find( const FrequencyVector& freq ) const
 {
-    if( !hash )
-        return NULL;
+    size_t  mask = indexsize - 1;
+    size_t  hash, pos;
+    size_t  dist = 0;
 
-    //compute address for the key
-    size_t  address = hash->GetAddress( freq.GetVector());
-    const void* value = hash->GetValueAt( address );
-
-    if( value == NULL ) {
-        hash->SetValueAt( address, freq.GetVector());
-        return freq.GetVector();
-    }
+    if( !slots || !freq.GetVector())
+        return NULL;
 
-    BinarySearchStructure*  bins = ( BinarySearchStructure* )value;
-    const FrequencyVector   freq_quest (( const char* )value );
+    hash = Hashing( freq.GetVector());
+    pos = hash & mask;
 
-    if( freq_quest.IsVector()) {
-        //check if it is not a duplicate first
-        if( VectorsAreEqual( freq, freq_quest ))
-            //it is a duplicate, omit further processing
-            return freq_quest.GetVector();
+    //a vector is not beyond the slot its record would take
+    for( ; slots[pos].record && dist <= GetProbeLength( pos ); pos = ( pos + 1 ) & mask, dist++ )
+        if( slots[pos].hash == hash &&
+            VectorsAreEqual( freq, FrequencyVector( GetVectorAt(( size_t )slots[pos].record - 1 ))))
+            return GetVectorAt(( size_t )slots[pos].record - 1 );
 
-        //if there is only one frequency vector at the moment,
-        //  we need to create a binary search structure next
-        bins = new BinarySearchStructure( FrequencyVector::FrequencyComparer, binSize );
+    return NULL;
+}
 
-        if( bins == NULL )
-            throw myruntime_error( mystring( "FrequencyStore: Not enough memory." ));
+// -------------------------------------------------------------------------
+// GetLoadFactor: returns the fraction of the slots of the index occupied
+// -------------------------------------------------------------------------
 
-        //put the existing key in the binary search structure first
-        if( ! StoreInBSearchStructure( bins, freq_quest ))
-            throw myruntime_error( mystring( "FrequencyStore: Store failed." ));
+double FrequencyStore::GetLoadFactor() const
+{
+    if( !indexsize )
+        return 0.0;
+    return ( double )novectors / ( double )indexsize;
+}
 
-        //now this position of the secondary hash will point to the binary search structure
-        hash->SetValueAt( address, bins );
-    }
+// -------------------------------------------------------------------------
+// GetMeanProbeLength: returns the average distance of the vectors from
+//     their home slots in the index
+// -------------------------------------------------------------------------
 
-    //put the original key in the secondary hash
-    const void* inserted = StoreInBSearchStructure( bins, freq );
+double FrequencyStore::GetMeanProbeLength() const
+{
+    size_t  sum = 0;
 
-    //if the vector has been inserted
-    if( inserted == freq.GetVector())
-        no_collisions2++;
+    if( !novectors )
+        return 0.0;
 
-    return  inserted;
+    for( size_t n = 0; n < indexsize; n++ )
+        if( slots[n].record )
+            sum += GetProbeLength( n );
+    return ( double )sum / ( double )novectors;
 }
 
 // -------------------------------------------------------------------------
-// BinarySearchStructure: stores frequency vector (key) into the binary
-//     search structure
-//  returns address of the vector to be stored if frequencies have been
-//  stored in the binary search structure, otherwise returns address of the
-//  duplicate if there is one;
-//  returns NULL on error
+// GetMaxProbeLength: returns the greatest distance of a vector from its
+//     home slot in the index
 // -------------------------------------------------------------------------
 
-const void* FrequencyStore::StoreInBSearchStructure( BinarySearchStructure* bins, const FrequencyVector& freq )
+size_t FrequencyStore::GetMaxProbeLength() const
 {
-    if( !bins )
-        return NULL;
+    size_t  max = 0;
 
-    int     location = -1;
-    //push the key into the appropriate place; the key
-    //  may not be inserted if it is a duplicate of
-    //  existing one
-    bool    inserted = bins->Push( freq.GetVector(), &location );
-    if( !inserted && 0 <= location ) {
-        //if not inserted, construct a vector object
-        const FrequencyVector   freq_quest(( const char* )bins->GetValueAt( location ));
-        //check whether it is a duplicate and the values (scores) are equal if so
-        /*inserted = */VectorsAreEqual( freq, freq_quest );
-        return freq_quest.GetVector();
-    }
-    return  inserted? freq.GetVector(): NULL;
+    for( size_t n = 0; n < indexsize; n++ )
+        if( slots[n].record && max < GetProbeLength( n ))
+            max = GetProbeLength( n );
+    return max;
 }
 
 // -------------------------------------------------------------------------
-// Find: finds frequency vector in the two-level hash system
+// GetFingerprint: returns the hash of the vectors of the store in the
+//     order of storing and of the distribution type
 // -------------------------------------------------------------------------
 
-const void* FrequencyStore::Find( const FrequencyVector& freq ) const
+Uint64 FrequencyStore::GetFingerprint() const
 {
-    if( !primaryHash )
-        return NULL;
-
-    size_t      address = primaryHash->GetAddress( freq.GetVector());
-    const void* value = primaryHash->GetValueAt( address );
-
-    if( value == NULL ) {
-        return NULL;
-    }
-
-    const HashTable*        secondHash = ( const HashTable* )value;
-    const FrequencyVector   freq_quest (( const char* )value );
-
-    if( freq_quest.IsVector())
-        return value;
+    Uint64  hash = FNVBASIS;
+    Uint64  distribution = ( Uint64 )GetDistributionType();
 
-    //must search in the secondary hash table
-    return FindInSecondaryHash( secondHash, freq );
+    hash = fnvhashing( &distribution, sizeof( distribution ), hash );
+    for( size_t n = 0; n < novectors; n++ )
+        hash = fnvhashing( GetVectorAt( n ), FrequencyVector::GetSizeOfVector(), hash );
+    return hash;
 }
 
 // -------------------------------------------------------------------------
-// FindInSecondaryHash: finds frequency vector in the secondary hash table
+// WriteImage: writes the records and index to file; total is the number
+//     of vectors, duplicates included, the store has been made of
 // -------------------------------------------------------------------------
 
-const void* FrequencyStore::FindInSecondaryHash( const HashTable* hash, const FrequencyVector& freq ) const
+void FrequencyStore::WriteImage( const char* filename, size_t total ) const
 {
-    if( !hash )
-        return NULL;
-
-    //compute address for the key
-    size_t  address = hash->GetAddress( freq.GetVector());
-    const void* value = hash->GetValueAt( address );
+    TFSImageHeader  header;
+    mystring        errstr;
+    int             eclass = NOCLASS;
+    size_t          n, count;
+    FILE*           fp;
+
+    memset( &header, 0, sizeof( header ));
+    strncpy( header.signature, signature, sizeof( header.signature ) - 1 );
+    header.total = ( Uint64 )total;
+    header.novectors = ( Uint64 )novectors;
+    header.szvector = ( Uint64 )FrequencyVector::GetSizeOfVector();
+    header.szrecord = ( Uint64 )recordsize;
+    header.indexsize = ( Uint64 )indexsize;
+    header.distribution = ( Uint64 )GetDistributionType();
+
+    fp = fopen( filename, "w" );
+    if( fp == NULL )
+        throw myruntime_error( mystring( "Unable to write image of frequency vectors." ));
+
+    try {
+        Serializer::Write( fp, ( char* )&header, sizeof( header ), 1 );
+        for( n = 0; n < noblocks && ( n << ArenaBlockBits ) < novectors; n++ ) {
+            count = novectors - ( n << ArenaBlockBits );
+            if( hashsize( ArenaBlockBits ) < count )
+                count = hashsize( ArenaBlockBits );
+            Serializer::Write( fp, blocks[n], recordsize, count );
+        }
+        if( indexsize )
+            Serializer::Write( fp, ( char* )slots, sizeof( TFSSlot ), indexsize );
 
-    if( value == NULL ) {
-        return NULL;
+    } catch( myexception const& ex )
+    {
+        errstr = ex.what();
+        eclass = ex.eclass();
     }
 
-    const BinarySearchStructure*    bins = ( const BinarySearchStructure* )value;
-    const FrequencyVector           freq_quest (( const char* )value );
-
-    if( freq_quest.IsVector())
-        return value;
+    if( fclose( fp ) != 0 && errstr.empty())
+        errstr = "Unable to write image of frequency vectors.";
 
-    //must search in the binary search structure
-    return FindInBSearchStructure( bins, freq );
+    if( !errstr.empty()) {
+        remove( filename );
+        throw myruntime_error( errstr.c_str(), eclass );
+    }
 }
 
 // -------------------------------------------------------------------------
-// FindInBSearchStructure: finds frequency vector (key) in the binary
-//     search structure
+// MapImage: maps the image file to memory read-only and makes the store
+//     refer to its records and index; the store is left intact if the
+//     image cannot be used; returns the total number of vectors the
+//     image has been written with
 // -------------------------------------------------------------------------
 
-const void* FrequencyStore::FindInBSearchStructure( const BinarySearchStructure* bins, const FrequencyVector& freq ) const
+size_t FrequencyStore::MapImage( const char* filename )
 {
-    if( !bins )
-        return NULL;
+    const TFSImageHeader*   header;
+    struct stat info;
+    void*       addr;
+    char**      mapblocks;
+    size_t      nomapblocks, n;
+    size_t      size, total, records;
+    FILE*       fp;
+
+    fp = fopen( filename, "r" );
+    if( fp == NULL )
+        throw myruntime_error( mystring( "Failed to open image of frequency vectors." ));
+
+    if( fstat( fileno( fp ), &info ) == -1 || info.st_size < ( off_t )sizeof( TFSImageHeader )) {
+        fclose( fp );
+        throw myruntime_error( mystring( "Wrong format of image of frequency vectors." ));
+    }
 
-    int location = -1;
+    size = ( size_t )info.st_size;
+    addr = mmap( NULL, size, PROT_READ, MAP_SHARED, fileno( fp ), 0 );
+    fclose( fp );
+    if( addr == MAP_FAILED )
+        throw myruntime_error( mystring( "Failed to map image of frequency vectors." ));
+
+    header = ( const TFSImageHeader* )addr;
+    records = ( size_t )header->novectors;
+
+    if( strncmp( header->signature, signature, sizeof( header->signature )) ||
+        header->szvector != ( Uint64 )FrequencyVector::GetSizeOfVector() ||
+        header->szrecord != ( Uint64 )recordsize ||
+        header->indexsize < header->novectors || !header->indexsize ||
+      ( header->indexsize & ( header->indexsize - 1 )) ||
+        size != sizeof( TFSImageHeader ) + records * recordsize + ( size_t )header->indexsize * sizeof( TFSSlot ))
+    {
+        munmap( addr, size );
+        throw myruntime_error( mystring( "Wrong format of image of frequency vectors." ));
+    }
 
-    if( bins->Find( freq.GetVector(), &location ))
-        return bins->GetValueAt( location );
+    if( header->distribution != ( Uint64 )GetDistributionType()) {
+        munmap( addr, size );
+        throw myruntime_error( mystring( "Image of frequency vectors is of different distribution type." ));
+    }
 
-    return NULL;
-}
+    nomapblocks = ( records + hashmask( ArenaBlockBits )) >> ArenaBlockBits;
+    mapblocks = ( char** )malloc( sizeof( void* ) * ( nomapblocks + 1 ));
+    if( !mapblocks ) {
+        munmap( addr, size );
+        throw myruntime_error( mystring( "FrequencyStore: Not enough memory." ));
+    }
+    for( n = 0; n < nomapblocks; n++ )
+        mapblocks[n] = ( char* )addr + sizeof( TFSImageHeader ) + ( n << ArenaBlockBits ) * recordsize;
 
+    total = ( size_t )header->total;
+
+    Destroy();
+
+    image = ( char* )addr;
+    imagesize = size;
+    blocks = mapblocks;
+    noblocks = blockcapacity = nomapblocks;
+    novectors = records;
+    slots = ( TFSSlot* )( image + sizeof( TFSImageHeader ) + records * recordsize );
+    indexsize = ( size_t )header->indexsize;
+
+    return total;
+}
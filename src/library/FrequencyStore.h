@@ -100,6 +100,7 @@ public:                                                 //for writing
     void        FinalProbability( size_t );             //set final probability value (non-multinomial case)
                                                         //number of logical components in the vector
     static int  GetNoElems()            { return no_Elems; }
+    static size_t   GetSizeOfVector()   { return Overall; }
     const char* GetVector() const       { return vector; }
 
     bool        IsVector() const;
@@ -149,40 +150,67 @@ private:
     static const size_t     no_hash_FUNCTIONS;          //number of hash functions
 };
 
+//slot of the index of frequency vectors; the slot refers to the record
+//  by number, so that the index can be written and mapped as it is
+struct TFSSlot {
+    Uint64  record;         //number of the record in the arena plus one; 0 if the slot is empty
+    Uint64  hash;           //hash value of the vector
+};
+
+//header of the image file of the store
+struct TFSImageHeader {
+    char    signature[32];  //signature with version number
+    Uint64  total;          //total number of vectors the store has been made of
+    Uint64  novectors;      //number of distinct vectors
+    Uint64  szvector;       //size of vector
+    Uint64  szrecord;       //size of record
+    Uint64  indexsize;      //number of slots of the index
+    Uint64  distribution;   //type of distribution of vectors
+};
+
 // _________________________________________________________________________
 // Class FrequencyStore
 //
-//  This class is for storage of frequency vectors. Frequency vectors are
-//  hashed in a two-level hashing structure with binary search structures
-//  in case of collisions. The top-level hash function gives address of the
-//  secondary hash structure designed for the case of collisions. If
-//  collisions appear in the secondary hash structures anyway, dynamic
-//  binary search structures are used.
+//  This class is for storage of frequency vectors. Vectors are copied to
+//  fixed-size records of an arena allocated in blocks, so that records
+//  are packed in the order of storing and never move. Records are looked
+//  up by a flat open-addressing index with Robin Hood probing: a vector
+//  being inserted takes the slot of the one lying closer to its home
+//  slot, which keeps probe sequences short and lets a search stop as soon
+//  as it passes the place the vector would occupy.
+//  The records and index can be written to an image file, which is then
+//  mapped to memory read-only in place of storing vectors one by one.
 //
 class FrequencyStore
 {
 public:
     enum {
-        FirstLevelHashBits = 22,    //number of significant bits used for the first-level hash size
-        SecndLevelHashBits = 7,     //number of significant bits used for the second-level hash size
-        binSize = 20,               //initial size of binary search structure
-        FrequenciesBits = 21        //number of significant bits used for the size of vector frequencies;
-                                    //  make size two times smaller than one of the primary hash
+        ArenaBlockBits = 16,        //number of significant bits used for the number of records in a block of the arena
+        IndexBits = 10,             //number of significant bits used for the initial size of the index
+        MaxLoadPercent = 80         //maximum load of the index in percent before it grows
     };
 
 public:
     FrequencyStore();
     ~FrequencyStore();
 
-    const void* Store( const FrequencyVector& freq );       //store frequency vector in the two-level hash system
+                                                            //store copy of frequency vector unless there is a duplicate
+    const void* Store( const FrequencyVector& freq, bool* inserted = NULL );
     const void* Find( const FrequencyVector& freq ) const;  //find frequency vector
 
-    size_t  GetCollisions1() const          { return no_collisions1; }
-    size_t  GetCollisions2() const          { return no_collisions2; }
+    size_t      GetSize() const             { return novectors; }
+    const char* GetVectorAt( size_t n ) const;              //vector in the order of storing
+
+    double      GetLoadFactor() const;                      //fraction of the slots of the index occupied
+    double      GetMeanProbeLength() const;                 //average distance of the vectors from their home slots
+    size_t      GetMaxProbeLength() const;                  //greatest distance of a vector from its home slot
+    Uint64      GetFingerprint() const;                     //hash of the vectors stored
 
+    void        SetNoFrequencyVectors( size_t );            //reserve space for the given number of vectors
 
-    const SimpleVector* GetFrequencies() const { return frequencies; }
-    void                SetNoFrequencyVectors( size_t );    //this number affects size of vector frequencies
+    void        WriteImage( const char* filename, size_t total ) const;    //write records and index to file
+    size_t      MapImage( const char* filename );           //map image file read-only; returns total written with it
+    bool        GetMapped() const           { return image != NULL; }
 
     bool    IsConsistent( double count ) const;             //verify consistency of frequency vectors
     bool    IsConsistent( double count, size_t ) const;     //verify consistency of frequency vectors
@@ -193,35 +221,36 @@ public:
     static  void SetDistributionType( TFVectorProbabilities type )  { probtype = type; }
 
 protected:
-    void    Init();
-    void    Destroy();                                      //destroy whole two-level hash system
-    void    DestroySecondaryHash( const void* );            //destroy secondary hash structure at the address
-    void    DestroyBSearchStructure( const void* );         //destroy binary search structure at the address
+    explicit FrequencyStore( const FrequencyStore& );
 
-    const void* StoreInSecondaryHash( HashTable*, const FrequencyVector& );
-    const void* StoreInBSearchStructure( BinarySearchStructure*, const FrequencyVector& );
-
-    const void* FindInSecondaryHash( const HashTable*, const FrequencyVector& ) const;
-    const void* FindInBSearchStructure( const BinarySearchStructure*, const FrequencyVector& ) const;
-
-    void    DestroyFrequencies();                           //destroy vector frequencies
-    void    NewFrequencies( size_t );                       //allocate space for frequencies
-    void    PushInFrequencies( const void* );               //store address of frequency vector
+    void    Destroy();                                      //destroy arena and index
+    void    NewBlock();                                     //allocate next block of the arena
+    void    ReallocIndex( size_t newsize );                 //resize index and put records in it again
+    void    Insert( TFSSlot );                              //put record in the index; it is not there
+    size_t  GetProbeLength( size_t slot ) const;            //distance of the record at slot from its home slot
 
                                                             //whether two vectors are equal
-    bool    VectorsAreEqual( const FrequencyVector&, const FrequencyVector& );
+    static bool VectorsAreEqual( const FrequencyVector&, const FrequencyVector& );
 
-    static size_t   FirstLevelHashing( const void* key );
-    static size_t   SecndLevelHashing( const void* key );
+    static size_t   Hashing( const void* key );
 
 private:
     static TFVectorProbabilities    probtype;       //probability distribution type
-    static THashFunction    func1stlevel;   //first-level hash function
-    static THashFunction    func2ndlevel;   //second level hash function
-    HashTable*      primaryHash;            //hash to store frequency vectors for instant access
-    SimpleVector*   frequencies;            //contains pointers to frequency vectors to be able to iterate over all of them
-    size_t      no_collisions1;             //1st-level collisions
-    size_t      no_collisions2;             //2nd-level collisions
+    static THashFunction    hashfunc;               //hash function of vectors
+
+    char**          blocks;                 //blocks of the arena of vector records
+    size_t          noblocks;               //number of blocks
+    size_t          blockcapacity;          //capacity of blocks
+    size_t          recordsize;             //size of a record aligned to the size of double
+    size_t          novectors;              //number of vectors stored
+
+    TFSSlot*        slots;                  //index of records
+    size_t          indexsize;              //number of slots; power of two
+
+    char*           image;                  //image file mapped to memory; blocks and slots then refer to it
+    size_t          imagesize;              //size of the mapped image
+
+    static const char*  signature;          //signature of the image file
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -423,7 +452,7 @@ void FrequencyVector::SetProbability( double value )
 inline
 bool FrequencyStore::IsConsistent( double count ) const
 {
-    return IsConsistent( count, GetFrequencies()->GetSize());
+    return IsConsistent( count, GetSize());
 }
 
 inline
@@ -433,81 +462,48 @@ bool FrequencyStore::IsConsistent( double count, size_t no_vectors ) const
     if( FrequencyStore::GetDistributionType() != DISCRETE )
         return true;
 
-    if( !GetFrequencies())
-        return false;
-
     return ( size_t )count == no_vectors;
 }
 
 // -------------------------------------------------------------------------
-// DestroyFrequencies: destroy vector frequencies
-// -------------------------------------------------------------------------
-
-inline
-void FrequencyStore::DestroyFrequencies()
-{
-    if( frequencies )
-        delete frequencies;
-}
-
-// -------------------------------------------------------------------------
-// NewFrequencies: allocates space for vector frequencies
+// GetVectorAt: returns the record of the vector stored n-th
 // -------------------------------------------------------------------------
 
 inline
-void FrequencyStore::NewFrequencies( size_t size )
+const char* FrequencyStore::GetVectorAt( size_t n ) const
 {
-    frequencies = new SimpleVector( size );
-
-    if( frequencies == NULL )
-        throw( myruntime_error(
-            mystring( "FrequencyStore: Not enough memory." )));
-}
-
-// -------------------------------------------------------------------------
-// PushInFrequencies: push one frequency vector (distribution) into their
-//     vector
-// -------------------------------------------------------------------------
-
-inline
-void FrequencyStore::PushInFrequencies( const void* vect )
-{
-    if( !frequencies )
-        NewFrequencies( hashsize( FrequenciesBits ));
-    frequencies->Push( vect );
+#ifdef __DEBUG__
+    if( novectors <= n )
+        throw myruntime_error(
+            mystring( "FrequencyStore: Memory access error." ));
+#endif
+    return blocks[n >> ArenaBlockBits] + ( n & hashmask( ArenaBlockBits )) * recordsize;
 }
 
 // -------------------------------------------------------------------------
-// FirstLevelHashing: perform hash computing for the first level hash table
+// GetProbeLength: returns the distance of the record at the slot from
+//     its home slot
 // -------------------------------------------------------------------------
 
 inline
-size_t FrequencyStore::FirstLevelHashing( const void* key )
+size_t FrequencyStore::GetProbeLength( size_t slot ) const
 {
-#ifdef __DEBUG__
-    if( !func1stlevel )
-        throw myruntime_error(
-            mystring( "FrequencyStore: Unable to perform hash computations." ));
-#endif
-    size_t  address = ( *func1stlevel )( key );
-//     return  ( address >> (( sizeof( address ) << 3 ) - FirstLevelHashBits ))& hashmask( FirstLevelHashBits );
-    return  address & hashmask( FirstLevelHashBits );
+    return ( slot - slots[slot].hash ) & ( indexsize - 1 );
 }
 
 // -------------------------------------------------------------------------
-// PushInFrequencies: perform hash computing for the second level hash table
+// Hashing: perform hash computing for the index
 // -------------------------------------------------------------------------
 
 inline
-size_t FrequencyStore::SecndLevelHashing( const void* key )
+size_t FrequencyStore::Hashing( const void* key )
 {
 #ifdef __DEBUG__
-    if( !func2ndlevel )
+    if( !hashfunc )
         throw myruntime_error(
             mystring( "FrequencyStore: Unable to perform hash computations." ));
 #endif
-    size_t  address = ( *func2ndlevel )( key );
-    return  address & hashmask( SecndLevelHashBits );
+    return ( *hashfunc )( key );
 }
 
 // -------------------------------------------------------------------------
@@ -71,6 +71,63 @@ GapScheme::~GapScheme()
     destroy();
 }
 
+// -------------------------------------------------------------------------
+// operator=: makes a deep copy of the given object; memory is reallocated
+//     only when the object cannot contain the copy
+// -------------------------------------------------------------------------
+
+GapScheme& GapScheme::operator=( const GapScheme& one )
+{
+    if( this == &one )
+        return *this;
+
+    Clear();
+    reallocate( one.GetColumns());
+
+    if( 0 < one.GetColumns()) {
+        const size_t    dsize = sizeof( double ) * one.GetColumns();
+
+        memcpy( posvec,  one.posvec,  dsize );
+        memcpy( posext,  one.posext,  dsize );
+        memcpy( vector,  one.vector,  dsize );
+        memcpy( extvec,  one.extvec,  dsize );
+        memcpy( weights, one.weights, dsize );
+        for( size_t n = 0; n < DCnt; n++ )
+            memcpy( deletes[n], one.deletes[n], dsize );
+        memcpy( deleteInt, one.deleteInt, sizeof( int ) * one.GetColumns());
+        memcpy( aacids,  one.aacids,  sizeof( char ) * one.GetColumns());
+        memcpy( positionalaccorr, one.positionalaccorr, dsize );
+    }
+
+    fixed = one.fixed;
+    length = one.length;
+    openCost = one.openCost;
+    extendCost = one.extendCost;
+    scaledopenCost = one.scaledopenCost;
+    scaledextendCost = one.scaledextendCost;
+    scalefactor = one.scalefactor;
+    configuration = one.configuration;
+
+    autcorrection = one.autcorrection;
+    ac_correction = one.ac_correction;
+
+    gapprobfactevalue = one.gapprobfactevalue;
+    gapprobfactweight = one.gapprobfactweight;
+    gapprobfactshift = one.gapprobfactshift;
+
+    acorrnumerator1st = one.acorrnumerator1st;
+    acorrnumerator2nd = one.acorrnumerator2nd;
+    acorrlogscale = one.acorrlogscale;
+    acorrdenomscale = one.acorrdenomscale;
+
+    thickness = one.thickness;
+    contextevalue = one.contextevalue;
+    contextadjusted = one.contextadjusted;
+    useposaccorrect = one.useposaccorrect;
+
+    return *this;
+}
+
 // -------------------------------------------------------------------------
 // IsCompatible: verifies whether the vector containing gap opening costs is 
 //     compositionally identical to another one
@@ -43,6 +43,8 @@ public:
     GapScheme( double gap_open = DEFAULTGAPOPENCOST, double gap_extend = DEFAULTEXTENDCOST );
     ~GapScheme();
 
+    GapScheme&  operator=( const GapScheme& );  //deep copy of gap costs and their context
+
     const Configuration*    GetConfiguration() const { return configuration; }
     void        SetConfiguration( const Configuration* config );
 
@@ -87,6 +89,8 @@ public:
     double      GetDeleteOpenProbAt( int pos ) const;
     double      GetDeleteExtendWeightAt( int pos, int time ) const;
     double      GetDeleteExtensionProbAt( int pos, int time ) const;
+    double      GetDeleteExtensionProbAt( int pos, int time, double factor01 ) const;
+    double      GetProbabilityFactor() const;       //factor of probabilities; constant while aligning
 
     void        SetOpenCost( double value )                     { openCost = value; }
     void        SetExtendCost( double value )                   { extendCost = value; }
@@ -201,7 +205,6 @@ protected:
     void        SetContextEvalue( double evalue )   { contextevalue = evalue; }
     void        ResetContextEvalue()                { contextevalue = -1.0; }
 
-    double      GetProbabilityFactor() const;
     static double   SigmoidResponse( double );
 
 private:
@@ -539,7 +542,14 @@ double GapScheme::GetDeleteOpenProbAt( int pos ) const
 inline
 double GapScheme::GetDeleteExtensionProbAt( int pos, int time ) const
 {
-    double  factor01 = GetProbabilityFactor();
+    return GetDeleteExtensionProbAt( pos, time, GetProbabilityFactor());
+}
+
+// GetDeleteExtensionProbAt: overloaded; factor of probabilities is given
+//
+inline
+double GapScheme::GetDeleteExtensionProbAt( int pos, int time, double factor01 ) const
+{
     double  extweight = GetDeleteExtendWeightAt( pos, time ) * factor01;
     double  delprob = 2.0 * (( extweight <= 0.5 )? extweight: 1.0 - extweight );
 #ifdef __DEBUG__
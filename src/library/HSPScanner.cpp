@@ -0,0 +1,266 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Mindaugas Margelevicius                         *
+ *   Institute of Biotechnology, Vilnius                                   *
+ *   minmar@ibt.lt                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rc.h"
+#include "pcmath.h"
+#include "HSPScanner.h"
+
+
+// -------------------------------------------------------------------------
+// constructor: initialization
+// -------------------------------------------------------------------------
+
+HSPScanner::HSPScanner( TScore minhspscore, int hsplen, int no_hsps, int maxdist )
+:   hmin( minhspscore ),
+    hsplength( hsplen ),
+    nohsps( no_hsps ),
+    maxdistance( maxdist ),
+    diagonals( NULL ),
+    rowblock( NULL ),
+    prevhsps( NULL ),
+    currhsps( NULL ),
+    prevlens( NULL ),
+    currlens( NULL ),
+    querySize( 0 ),
+    nodiags( 0 ),
+    diaglen( no_hsps * 3 ), //nohsps*2 for indices
+    found( false ),
+    hmax( 0 ),
+    sbjctpos( -1 ),
+    querypos( -1 )
+{
+}
+
+// -------------------------------------------------------------------------
+// default constructor is invalid for initialization
+// -------------------------------------------------------------------------
+
+HSPScanner::HSPScanner()
+:   hmin( 0 ),
+    hsplength( 0 ),
+    nohsps( 0 ),
+    maxdistance( 0 ),
+    diagonals( NULL ),
+    rowblock( NULL ),
+    prevhsps( NULL ),
+    currhsps( NULL ),
+    prevlens( NULL ),
+    currlens( NULL ),
+    querySize( 0 ),
+    nodiags( 0 ),
+    diaglen( 0 ),
+    found( false ),
+    hmax( 0 ),
+    sbjctpos( -1 ),
+    querypos( -1 )
+{
+    throw myruntime_error(
+            mystring( "HSPScanner: Default initialization is not allowed." ));
+}
+
+// -------------------------------------------------------------------------
+// destructor: deallocation of resources
+// -------------------------------------------------------------------------
+
+HSPScanner::~HSPScanner()
+{
+    Destroy();
+}
+
+// -------------------------------------------------------------------------
+// Destroy: deallocates the memory of the scan
+// -------------------------------------------------------------------------
+
+void HSPScanner::Destroy()
+{
+    if( diagonals )
+        free( diagonals );
+    if( rowblock )
+        free( rowblock );
+
+    diagonals = rowblock = prevhsps = currhsps = NULL;
+    prevlens = currlens = NULL;
+}
+
+// -------------------------------------------------------------------------
+// VerifyParameters: verifies parameters of the heuristics; returns false
+//     with a warning if any of them is invalid
+// -------------------------------------------------------------------------
+
+bool HSPScanner::VerifyParameters( TScore minhspscore, int hsplen, int nohsps, int maxdist )
+{
+    if( minhspscore <= 0 ) {
+        warning( "Parameter: Non-positive HSP score threshold." );
+        return false;
+    }
+    if( hsplen <= 0 ) {
+        warning( "Parameter: Non-positive HSP length." );
+        return false;
+    }
+    if( nohsps <= 0 ) {
+        warning( "Parameter: Non-positive number of HSPs." );
+        return false;
+    }
+    if( maxdist <= 0 ) {
+        warning( "Parameter: Non-positive distance between HSPs." );
+        return false;
+    }
+    return true;
+}
+
+// -------------------------------------------------------------------------
+// Reset: allocates and clears memory to scan a score system of the given
+//     sizes
+// -------------------------------------------------------------------------
+
+void HSPScanner::Reset( int sz_query, int sz_sbjct )
+{
+    Destroy();
+
+    found = false;
+    hmax = 0;
+    sbjctpos = querypos = -1;
+
+    if( sz_query <= 0 || sz_sbjct <= 0 || diaglen <= 0 )
+        throw myruntime_error( mystring( "HSPScanner: Wrong sizes." ));
+
+    querySize = sz_query;
+    nodiags = sz_sbjct + sz_query - 1;
+
+    //HSPs and lengths of both rows follow each other in one block
+    diagonals = ( TScore* )malloc( sizeof( TScore ) * nodiags * diaglen );
+    rowblock = ( TScore* )malloc(( sizeof( TScore ) + sizeof( int )) * querySize * 2 );
+
+    if( !diagonals || !rowblock ) {
+        Destroy();
+        throw myruntime_error( mystring( "HSPScanner: Not enough memory." ));
+    }
+
+    prevhsps = rowblock;
+    currhsps = prevhsps + querySize;
+    prevlens = ( int* )( currhsps + querySize );
+    currlens = prevlens + querySize;
+
+    memset( diagonals, 0, sizeof( TScore ) * nodiags * diaglen );
+    memset( rowblock, 0, ( sizeof( TScore ) + sizeof( int )) * querySize * 2 );
+}
+
+// -------------------------------------------------------------------------
+// ScanRow: scans scores of subject position m against all query
+//     positions; rows are to be given in order; returns true when a group
+//     of HSPs in the same diagonal is found
+// -------------------------------------------------------------------------
+
+bool HSPScanner::ScanRow( int m, const TScore* scores )
+{
+    TScore  loc_score, tvalue;
+    TScore* tmphsps;
+    int*    tmplens;
+    int     n;
+
+    if( !diagonals || !scores )
+        throw myruntime_error( mystring( "HSPScanner: Memory access error." ));
+
+    if( found )
+        return true;
+
+    for( n = 0; n < querySize; n++ )
+    {
+        loc_score = scores[n];
+
+        if( loc_score <= SCORE_MIN ) {
+            currhsps[n] = 0;
+            currlens[n] = 0;
+            continue;
+        }
+
+        currhsps[n] = loc_score;
+        currlens[n] = 0;
+
+        if( 0 < loc_score )
+            //begin or continue hsp
+            currlens[n] = 1;
+
+        if( 0 < m && 0 < n ) {
+            tvalue = currhsps[n] + prevhsps[n-1];
+            if( currhsps[n] < tvalue && 0 < currhsps[n]) {
+                if( prevlens[n-1] < hsplength ) {
+                    currhsps[n] = tvalue;
+                    currlens[n] = prevlens[n-1] + 1;
+                }
+            }
+        }
+
+        //record hsp score in the diagonal
+        if( hsplength <= currlens[n] && hmin <= currhsps[n] )
+            if( RecordHSP( m, n, currhsps[n] ))
+                return true;
+    }
+
+    tmphsps = prevhsps; prevhsps = currhsps; currhsps = tmphsps;
+    tmplens = prevlens; prevlens = currlens; currlens = tmplens;
+    return false;
+}
+
+// -------------------------------------------------------------------------
+// RecordHSP: records the score of HSP ending at positions m and n among
+//     the best HSPs of its diagonal; returns true if the diagonal then
+//     makes a group of HSPs
+// -------------------------------------------------------------------------
+
+bool HSPScanner::RecordHSP( int m, int n, TScore hspscore )
+{
+    TScore* diagonal = diagonals + ( querySize - 1 - n + m ) * diaglen;
+    int     sum = 0;
+    int     k, l;
+
+    for( k = 0; k < nohsps; k++ )
+    {
+        if( diagonal[k+nohsps] &&
+            maxdistance < m - diagonal[k+nohsps] - hsplength ) {
+            //distance between two hsps is too small- omit the hsp
+            //all hsps are considered in turn
+            sum = -1;//to break
+            break;
+        }
+        if( diagonal[k] < hspscore )
+        {
+            for( l = nohsps - 1; k < l && diagonal[l-1] <= 0; l-- );
+            for( ; k < l; l-- ) {
+                if( maxdistance < m - diagonal[l-1+nohsps] - hsplength ) {
+                    //distance between two hsps is too small- omit the hsp
+                    sum = -1;//to break
+                    break;
+                }
+                diagonal[l] = diagonal[l-1];//save hsp score
+                diagonal[l+nohsps] = diagonal[l-1+nohsps];//save coordinates..
+                diagonal[l+nohsps+nohsps] = diagonal[l-1+nohsps+nohsps];
+                sum += diagonal[l];
+            }
+            if( sum < 0 )
+                break;
+            diagonal[k] = hspscore;
+            diagonal[k+nohsps] = m;
+            diagonal[k+nohsps+nohsps] = n;
+            sum += diagonal[k];
+            break;
+        }
+        else
+            sum += diagonal[k];
+    }
+    if( diagonal[nohsps-1] && hmax < sum ) {
+        found = true;   //at least one group of hsps is found
+        hmax = sum;
+        sbjctpos = diagonal[nohsps];//positions of max of hsps
+        querypos = diagonal[nohsps+nohsps];
+    }
+    return found;
+}
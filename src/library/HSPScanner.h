@@ -0,0 +1,74 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Mindaugas Margelevicius                         *
+ *   Institute of Biotechnology, Vilnius                                   *
+ *   minmar@ibt.lt                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef __HSPScanner__
+#define __HSPScanner__
+
+#include "debug.h"
+#include "types.h"
+#include "compdef.h"
+
+#include "mystring.h"
+#include "myexcept.h"
+
+
+// _________________________________________________________________________
+// Class HSPScanner
+//
+// Heuristics of multiple high-scoring pairs (HSPs) in the same diagonal of
+// a score system. Scores are given row by row, one row for a subject
+// position, and the scan stops as soon as a group of HSPs is found. Only
+// the HSPs of the previous row and the best HSPs of each diagonal are
+// kept, so that the score matrix itself need not exist
+//
+
+class HSPScanner
+{
+public:
+    HSPScanner( TScore minhspscore, int hsplen, int no_hsps, int maxdist );
+    ~HSPScanner();
+
+    static bool     VerifyParameters( TScore minhspscore, int hsplen, int nohsps, int maxdist );
+
+    void            Reset( int sz_query, int sz_sbjct );    //prepare to scan a score system of the given sizes
+    bool            ScanRow( int m, const TScore* scores ); //scan scores of subject position m; true if HSPs found
+
+    bool            GetFound() const            { return found; }
+    int             GetSbjctPos() const         { return sbjctpos; }    //subject position of the HSPs found
+    int             GetQueryPos() const         { return querypos; }    //query position of the HSPs found
+
+protected:
+    explicit HSPScanner();
+
+    void            Destroy();
+    bool            RecordHSP( int m, int n, TScore hspscore );
+
+private:
+    const TScore    hmin;           //minimum score of HSP
+    const int       hsplength;      //length of HSP
+    const int       nohsps;         //number of HSPs required in the same diagonal
+    const int       maxdistance;    //max distance between HSPs
+
+    TScore*         diagonals;      //best-scoring HSPs of each diagonal with their positions
+    TScore*         rowblock;       //block of HSPs and lengths of both rows
+    TScore*         prevhsps;       //scores of HSPs ending at the positions of the previous row
+    TScore*         currhsps;       //scores of HSPs ending at the positions of the current row
+    int*            prevlens;       //lengths of HSPs of the previous row
+    int*            currlens;       //lengths of HSPs of the current row
+
+    int             querySize;      //length of query
+    int             nodiags;        //number of diagonals
+    int             diaglen;        //number of values kept for a diagonal
+
+    bool            found;          //whether a group of HSPs has been found
+    TScore          hmax;           //score of the group found
+    int             sbjctpos;       //positions of the group found
+    int             querypos;
+};
+
+#endif//__HSPScanner__
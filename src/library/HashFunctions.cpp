@@ -34,3 +34,21 @@ Uint32 oneatatime( const void *key, size_t length )
     return hash;
 }
 
+
+// -------------------------------------------------------------------------
+// fnvhashing: 64-bit FNV-1a hashing; the hash of the preceding data can be
+//     given to continue hashing over a number of pieces of data
+// -------------------------------------------------------------------------
+
+Uint64 fnvhashing( const void *key, size_t length, Uint64 hash )
+{
+    const unsigned char*    k = ( const unsigned char* )key;
+
+    for( size_t n = 0; n < length; n++ )
+    {
+        hash ^= k[n];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
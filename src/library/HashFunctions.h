@@ -11,7 +11,11 @@
 #include "types.h"
 
 
+//offset basis of FNV hashing
+#define FNVBASIS    0xcbf29ce484222325ULL
+
 Uint32 oneatatime( const void *key, size_t length );
+Uint64 fnvhashing( const void *key, size_t length, Uint64 hash = FNVBASIS );
 
 
 
@@ -102,6 +102,9 @@ void MOptions::Init()
     valHSPMINSCORE_ = defHSPMINSCORE;
     valHSPMAXDIST_ = defHSPMAXDIST;
     valNOHSPS_ = defNOHSPS;
+
+    valIDXWORDSCORE_ = defIDXWORDSCORE;
+    valIDXNOSEEDS_ = defIDXNOSEEDS;
 }
 
 // -------------------------------------------------------------------------
@@ -165,6 +168,9 @@ void MOptions::Read()
     ReadHSPMINSCORE();
     ReadHSPMAXDIST();
     ReadNOHSPS();
+
+    ReadIDXWORDSCORE();
+    ReadIDXNOSEEDS();
 }
 
 // -------------------------------------------------------------------------
@@ -570,6 +576,24 @@ void MOptions::ReadNOHSPS()
     valNOHSPS_ = value;
 }
 
+// Column-word index of the database
+//
+void MOptions::ReadIDXWORDSCORE()
+{
+    MOPTPRIV_DOUBLE_KEY( IDXWORDSCORE );
+    if( value <= 0.0 )
+        throw myruntime_error( "Score of index words is non-positive." );
+    valIDXWORDSCORE_ = value;
+}
+
+void MOptions::ReadIDXNOSEEDS()
+{
+    MOPTPRIV_INT_KEY( IDXNOSEEDS );
+    if( value < 0 || 10 < value )
+        throw myruntime_error( "Number of index seeds is not valid." );
+    valIDXNOSEEDS_ = value;
+}
+
 // -------------------------------------------------------------------------
 
 // Translate open cost to integer values
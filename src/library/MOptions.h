@@ -87,6 +87,9 @@ public:
     int             GetHSPMAXDIST() const { return valHSPMAXDIST_; }
     int             GetNOHSPS() const { return valNOHSPS_; }
 
+    double          GetIDXWORDSCORE() const { return valIDXWORDSCORE_; }
+    int             GetIDXNOSEEDS() const { return valIDXNOSEEDS_; }
+
     const char*     GetFilename() const                 { return filename_; }
     void            SetFilename( const char* name )     { filename_ = name; }
 
@@ -151,6 +154,9 @@ protected:
     void            ReadHSPMAXDIST();
     void            ReadNOHSPS();
 
+    void            ReadIDXWORDSCORE();
+    void            ReadIDXNOSEEDS();
+
 private:
     const char* filename_;
 
@@ -213,6 +219,9 @@ private:
     int         valHSPMAXDIST_;
     int         valNOHSPS_;
 
+    double      valIDXWORDSCORE_;
+    int         valIDXNOSEEDS_;
+
 };
 
 // INLINES
@@ -280,6 +289,9 @@ private:
 #define defHSPMAXDIST ( 60 )
 #define defNOHSPS ( 3 )
 
+#define defIDXWORDSCORE ( 11.0 )
+#define defIDXNOSEEDS ( 0 )
+
 #define MIN_AUTOCORR_WINDOW_SIZE (  1 )
 #define MAX_AUTOCORR_WINDOW_SIZE ( 50 )
 
@@ -346,5 +358,8 @@ static const char*  HSPMINSCORE = "HSPMINSCORE";
 static const char*  HSPMAXDIST = "HSPMAXDIST";
 static const char*  NOHSPS = "NOHSPS";
 
+static const char*  IDXWORDSCORE = "IDXWORDSCORE";
+static const char*  IDXNOSEEDS = "IDXNOSEEDS";
+
 
 #endif//__MOptions__
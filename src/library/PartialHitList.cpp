@@ -0,0 +1,454 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Mindaugas Margelevicius                         *
+ *   Institute of Biotechnology, Vilnius                                   *
+ *   minmar@ibt.lt                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "defines.h"
+#include "Serializer.h"
+#include "ProfileSearching.h"
+#include "PartialHitList.h"
+
+
+const char* PartialHitList::signature = "COMA partial hit list v1.0\n";
+
+// -------------------------------------------------------------------------
+// constructor: initialization of the list of the given shard
+// -------------------------------------------------------------------------
+
+PartialHitList::PartialHitList( size_t shard, size_t noshards )
+:   headertext( NULL ),
+    footertext( NULL ),
+    hits( NULL ),
+    nohits( 0 ),
+    capacity( 0 ),
+    shards( NULL )
+{
+    if( noshards <= shard )
+        throw myruntime_error( mystring( "PartialHitList: Invalid shard number." ));
+
+    memset( &header, 0, sizeof( header ));
+    header.shard = ( Uint64 )shard;
+    header.noshards = ( Uint64 )noshards;
+
+    ReallocShards( noshards );
+    shards[shard] = 1;
+}
+
+// constructor: initialization of the list to be read
+//
+PartialHitList::PartialHitList()
+:   headertext( NULL ),
+    footertext( NULL ),
+    hits( NULL ),
+    nohits( 0 ),
+    capacity( 0 ),
+    shards( NULL )
+{
+    memset( &header, 0, sizeof( header ));
+}
+
+// -------------------------------------------------------------------------
+// destructor: deallocation of resources
+// -------------------------------------------------------------------------
+
+PartialHitList::~PartialHitList()
+{
+    Destroy();
+}
+
+// -------------------------------------------------------------------------
+// Destroy: deallocates memory of the list
+// -------------------------------------------------------------------------
+
+void PartialHitList::Destroy()
+{
+    for( size_t n = 0; n < nohits; n++ )
+        if( hits[n] )
+            delete hits[n];
+    if( hits )
+        free( hits );
+    if( headertext )
+        free( headertext );
+    if( footertext )
+        free( footertext );
+    if( shards )
+        free( shards );
+
+    hits = NULL;
+    headertext = NULL;
+    footertext = NULL;
+    shards = NULL;
+    nohits = capacity = 0;
+    memset( &header, 0, sizeof( header ));
+}
+
+// -------------------------------------------------------------------------
+// ReallocHits: reallocates memory for hits
+// -------------------------------------------------------------------------
+
+void PartialHitList::ReallocHits( size_t newcap )
+{
+    HitInformation**    tmphits;
+
+    if( newcap <= capacity )
+        return;
+
+    tmphits = ( HitInformation** )realloc( hits, sizeof( void* ) * newcap );
+    if( !tmphits )
+        throw myruntime_error( mystring( "PartialHitList: Not enough memory." ));
+    hits = tmphits;
+    capacity = newcap;
+}
+
+// -------------------------------------------------------------------------
+// ReallocShards: allocates flags of the shards
+// -------------------------------------------------------------------------
+
+void PartialHitList::ReallocShards( size_t noshards )
+{
+    if( shards )
+        free( shards );
+
+    shards = ( char* )malloc( sizeof( char ) * ( noshards + 1 ));
+    if( !shards )
+        throw myruntime_error( mystring( "PartialHitList: Not enough memory." ));
+    memset( shards, 0, sizeof( char ) * ( noshards + 1 ));
+}
+
+// -------------------------------------------------------------------------
+// GetComplete: whether the list contains hits of all shards
+// -------------------------------------------------------------------------
+
+bool PartialHitList::GetComplete() const
+{
+    if( !shards || !header.noshards )
+        return false;
+
+    for( size_t n = 0; n < ( size_t )header.noshards; n++ )
+        if( !shards[n] )
+            return false;
+    return true;
+}
+
+// -------------------------------------------------------------------------
+// SetLimits: sets the numbers of hits to output and the e-value threshold
+//     of the search
+// -------------------------------------------------------------------------
+
+void PartialHitList::SetLimits( size_t hitlimit, int nohitsthr, int noalnsthr, double evalthr )
+{
+    header.hitlimit = ( Uint64 )hitlimit;
+    header.nohitsthr = ( Int64 )nohitsthr;
+    header.noalnsthr = ( Int64 )noalnsthr;
+    header.evalthr = evalthr;
+}
+
+// -------------------------------------------------------------------------
+// SetHeaderText: sets the text of the output header; memory is to be
+//     allocated by malloc
+// -------------------------------------------------------------------------
+
+void PartialHitList::SetHeaderText( char* text )
+{
+    if( headertext )
+        free( headertext );
+    headertext = text;
+    header.szheader = text? ( Uint64 )strlen( text ): 0;
+}
+
+// -------------------------------------------------------------------------
+// SetFooterText: sets the text of the output footer; memory is to be
+//     allocated by malloc; the footer lacks description of the score
+//     system if no profile of the shard has been scored
+// -------------------------------------------------------------------------
+
+void PartialHitList::SetFooterText( char* text, bool scoring )
+{
+    if( footertext )
+        free( footertext );
+    footertext = text;
+    header.szfooter = text? ( Uint64 )strlen( text ): 0;
+    header.scoring = scoring? 1: 0;
+}
+
+// -------------------------------------------------------------------------
+// AddHit: adds the copy of the given hit to the list
+// -------------------------------------------------------------------------
+
+void PartialHitList::AddHit( const HitInformation& hit )
+{
+    HitInformation* newhit;
+    char*           annotation;
+    char*           alignment;
+
+    if( !hit.GetAnnotation() || !hit.GetFullAlignment())
+        throw myruntime_error( mystring( "PartialHitList: Hit without alignment." ));
+
+    if( capacity <= nohits )
+        ReallocHits( capacity? capacity * 2: KBYTE );
+
+    newhit = new HitInformation( hit.GetScore(), hit.GetEvalue(), hit.GetRefEvalue(), hit.GetOrdinal(), -1 );
+    annotation = strdup( hit.GetAnnotation());
+    alignment = strdup( hit.GetFullAlignment());
+
+    if( !newhit || !annotation || !alignment ) {
+        if( newhit ) delete newhit;
+        if( annotation ) free( annotation );
+        if( alignment ) free( alignment );
+        throw myruntime_error( mystring( "PartialHitList: Not enough memory." ));
+    }
+
+    newhit->SetAnnotation( annotation );
+    newhit->SetFullAlignment( alignment );
+    hits[nohits++] = newhit;
+    header.nohits = ( Uint64 )nohits;
+}
+
+// -------------------------------------------------------------------------
+// Write: writes the list to file; standard output is used if no filename
+//     is given
+// -------------------------------------------------------------------------
+
+void PartialHitList::Write( const char* filename ) const
+{
+    TPHLHit     rec;
+    mystring    errstr;
+    int         eclass = NOCLASS;
+    FILE*       fp = stdout;
+
+    if( filename && strlen( filename ))
+        fp = fopen( filename, "w" );
+    if( fp == NULL )
+        throw myruntime_error( mystring( "Failed to open file for writing." ));
+
+    try {
+        Serializer::Write( fp, ( char* )signature, 1, strlen( signature ));
+        Serializer::Write( fp, ( char* )&header, sizeof( header ), 1 );
+        if( header.szheader )
+            Serializer::Write( fp, headertext, 1, ( size_t )header.szheader );
+        if( header.szfooter )
+            Serializer::Write( fp, footertext, 1, ( size_t )header.szfooter );
+
+        for( size_t n = 0; n < nohits; n++ ) {
+            memset( &rec, 0, sizeof( rec ));
+            rec.score = hits[n]->GetScore();
+            rec.evalue = hits[n]->GetEvalue();
+            rec.refevalue = hits[n]->GetRefEvalue();
+            rec.ordinal = ( Uint64 )hits[n]->GetOrdinal();
+            rec.szannotation = ( Uint64 )strlen( hits[n]->GetAnnotation());
+            rec.szalignment = ( Uint64 )strlen( hits[n]->GetFullAlignment());
+            Serializer::Write( fp, ( char* )&rec, sizeof( rec ), 1 );
+            if( rec.szannotation )
+                Serializer::Write( fp, ( char* )hits[n]->GetAnnotation(), 1, ( size_t )rec.szannotation );
+            if( rec.szalignment )
+                Serializer::Write( fp, ( char* )hits[n]->GetFullAlignment(), 1, ( size_t )rec.szalignment );
+        }
+    } catch( myexception const& ex )
+    {
+        errstr = ex.what();
+        eclass = ex.eclass();
+    }
+
+    if( fp != stdout )
+        fclose( fp );
+
+    if( !errstr.empty())
+        throw myruntime_error( errstr.c_str(), eclass );
+}
+
+// -------------------------------------------------------------------------
+// Read: reads the list from file
+// -------------------------------------------------------------------------
+
+void PartialHitList::Read( const char* filename )
+{
+    char            locsignature[BUF_MAX];
+    TPHLHit         rec;
+    HitInformation* hit;
+    char*           annotation;
+    char*           alignment;
+    char*           text;
+    mystring        errstr;
+    int             eclass = NOCLASS;
+    size_t          n, count;
+    FILE*           fp;
+
+    Destroy();
+
+    fp = fopen( filename, "r" );
+    if( fp == NULL )
+        throw myruntime_error( mystring( "Failed to open partial hit list: " ) + filename );
+
+    try {
+        Serializer::Read( fp, locsignature, 1, strlen( signature ));
+        if( strncmp( locsignature, signature, strlen( signature )))
+            throw myruntime_error( mystring( "Wrong format of partial hit list: " ) + filename );
+
+        Serializer::Read( fp, ( char* )&header, sizeof( header ), 1 );
+        if( !header.noshards || header.noshards <= header.shard )
+            throw myruntime_error( mystring( "Partial hit list corrupted: " ) + filename );
+
+        ReallocShards(( size_t )header.noshards );
+        shards[header.shard] = 1;
+
+        count = ( size_t )header.nohits;
+        header.nohits = 0;
+
+        text = ( char* )malloc(( size_t )header.szheader + 1 );
+        if( !text )
+            throw myruntime_error( mystring( "PartialHitList: Not enough memory." ));
+        text[header.szheader] = 0;
+        headertext = text;
+        if( header.szheader )
+            Serializer::Read( fp, headertext, 1, ( size_t )header.szheader );
+
+        text = ( char* )malloc(( size_t )header.szfooter + 1 );
+        if( !text )
+            throw myruntime_error( mystring( "PartialHitList: Not enough memory." ));
+        text[header.szfooter] = 0;
+        footertext = text;
+        if( header.szfooter )
+            Serializer::Read( fp, footertext, 1, ( size_t )header.szfooter );
+
+        ReallocHits( count + 1 );
+
+        for( n = 0; n < count; n++ ) {
+            Serializer::Read( fp, ( char* )&rec, sizeof( rec ), 1 );
+
+            hit = new HitInformation( rec.score, rec.evalue, rec.refevalue, ( size_t )rec.ordinal, -1 );
+            if( !hit )
+                throw myruntime_error( mystring( "PartialHitList: Not enough memory." ));
+            hits[nohits++] = hit;
+            header.nohits = ( Uint64 )nohits;
+
+            annotation = ( char* )malloc(( size_t )rec.szannotation + 1 );
+            if( !annotation )
+                throw myruntime_error( mystring( "PartialHitList: Not enough memory." ));
+            annotation[rec.szannotation] = 0;
+            hit->SetAnnotation( annotation );
+
+            alignment = ( char* )malloc(( size_t )rec.szalignment + 1 );
+            if( !alignment )
+                throw myruntime_error( mystring( "PartialHitList: Not enough memory." ));
+            alignment[rec.szalignment] = 0;
+            hit->SetFullAlignment( alignment );
+
+            if( rec.szannotation )
+                Serializer::Read( fp, annotation, 1, ( size_t )rec.szannotation );
+            if( rec.szalignment )
+                Serializer::Read( fp, alignment, 1, ( size_t )rec.szalignment );
+        }
+
+    } catch( myexception const& ex )
+    {
+        errstr = ex.what();
+        eclass = ex.eclass();
+    }
+
+    fclose( fp );
+
+    if( !errstr.empty()) {
+        Destroy();
+        throw myruntime_error( errstr.c_str(), eclass );
+    }
+}
+
+// -------------------------------------------------------------------------
+// Merge: moves hits of the given list of another shard of the same search
+//     to this list
+// -------------------------------------------------------------------------
+
+void PartialHitList::Merge( PartialHitList& other )
+{
+    size_t  n;
+
+    if( !shards || !other.shards || header.noshards != other.header.noshards )
+        throw myruntime_error( mystring( "Partial hit lists of different partitions of the database." ));
+
+    if( header.hitlimit != other.header.hitlimit ||
+        header.nohitsthr != other.header.nohitsthr ||
+        header.noalnsthr != other.header.noalnsthr ||
+        header.evalthr != other.header.evalthr ||
+        header.szheader != other.header.szheader ||
+      ( header.szheader && strcmp( headertext, other.headertext )))
+        throw myruntime_error( mystring( "Partial hit lists of different searches." ));
+
+    if( header.scoring == other.header.scoring &&
+      ( header.szfooter != other.header.szfooter ||
+      ( header.szfooter && strcmp( footertext, other.footertext ))))
+        throw myruntime_error( mystring( "Partial hit lists of different searches." ));
+
+    for( n = 0; n < ( size_t )header.noshards; n++ )
+        if( shards[n] && other.shards[n] )
+            throw myruntime_error( mystring( "Partial hit lists of the same shard." ));
+
+    ReallocHits( nohits + other.nohits + 1 );
+
+    for( n = 0; n < ( size_t )header.noshards; n++ )
+        if( other.shards[n] )
+            shards[n] = 1;
+
+    for( n = 0; n < other.nohits; n++ ) {
+        hits[nohits++] = other.hits[n];
+        other.hits[n] = NULL;
+    }
+
+    if( !header.scoring && other.header.scoring ) {
+        //footer of the search of the whole database describes the score system
+        SetFooterText( other.footertext, true );
+        other.footertext = NULL;
+        other.header.szfooter = 0;
+        other.header.scoring = 0;
+    }
+    other.nohits = 0;
+    other.header.nohits = 0;
+    header.nohits = ( Uint64 )nohits;
+}
+
+// -------------------------------------------------------------------------
+// SortHits: sorts hits in the order of output; only the hits to be output
+//     are kept, as in the search of the whole database
+// -------------------------------------------------------------------------
+
+void PartialHitList::SortHits()
+{
+    if( 1 < nohits )
+        qsort( hits, nohits, sizeof( HitInformation* ), &HitInformation::Compare );
+
+    while( header.hitlimit < ( Uint64 )nohits ) {
+        nohits--;
+        delete hits[nohits];
+        hits[nohits] = NULL;
+    }
+    header.nohits = ( Uint64 )nohits;
+}
+
+// -------------------------------------------------------------------------
+// Print: prints output of the search; the list is to include hits of all
+//     shards
+// -------------------------------------------------------------------------
+
+void PartialHitList::Print( FILE* fp )
+{
+    if( fp == NULL )
+        return;
+
+    if( !GetComplete())
+        throw myruntime_error( mystring( "Partial hit lists of some shards are missing." ));
+
+    SortHits();
+
+    if( headertext )
+        fprintf( fp, "%s", headertext );
+    ProfileSearching::PrintHits( fp, hits, nohits,
+                ( int )header.nohitsthr, ( int )header.noalnsthr, header.evalthr );
+    if( footertext )
+        fprintf( fp, "%s", footertext );
+}
@@ -0,0 +1,99 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Mindaugas Margelevicius                         *
+ *   Institute of Biotechnology, Vilnius                                   *
+ *   minmar@ibt.lt                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef __PartialHitList__
+#define __PartialHitList__
+
+#include <stdio.h>
+
+#include "debug.h"
+#include "types.h"
+#include "compdef.h"
+
+#include "mystring.h"
+#include "myexcept.h"
+
+class HitInformation;
+
+//header of a partial hit list file
+struct TPHLHeader {
+    Uint64  shard;          //number of the shard searched, starting at 0
+    Uint64  noshards;       //number of shards the database is split into
+    Uint64  nohits;         //number of hits in the list
+    Uint64  hitlimit;       //maximum number of hits to be output
+    Int64   nohitsthr;      //number of hits to print annotations for
+    Int64   noalnsthr;      //number of hits to print alignments for
+    double  evalthr;        //e-value threshold
+    Uint64  szheader;       //length of the text of the output header
+    Uint64  szfooter;       //length of the text of the output footer
+    Uint64  scoring;        //whether the footer describes the score system used
+};
+
+//hit in a partial hit list file
+struct TPHLHit {
+    double  score;          //raw alignment score
+    double  evalue;         //e-value of the score
+    double  refevalue;      //reference e-value
+    Uint64  ordinal;        //ordinal number of the subject profile in the whole database
+    Uint64  szannotation;   //length of the annotation
+    Uint64  szalignment;    //length of the alignment text
+};
+
+// _________________________________________________________________________
+// Class PartialHitList
+//
+// Hits found by searching one shard of the database, together with the
+// text of the header and footer of the output. Shards are searched with
+// the statistics of the whole database, so the lists of all shards are
+// merged into the output of the whole database by ranking the hits only
+//
+
+class PartialHitList
+{
+public:
+    PartialHitList( size_t shard, size_t noshards );
+    PartialHitList();
+    ~PartialHitList();
+
+    void            Write( const char* filename ) const;    //write list to file
+    void            Read( const char* filename );           //read list from file
+    void            Merge( PartialHitList& );               //move hits of the other list to this one
+    void            Print( FILE* );                         //sort hits and print output of the merged lists
+
+    void            AddHit( const HitInformation& );        //add copy of the hit
+
+    size_t          GetShard() const                { return ( size_t )header.shard; }
+    size_t          GetNoShards() const             { return ( size_t )header.noshards; }
+    size_t          GetNoHits() const               { return nohits; }
+    bool            GetComplete() const;                    //whether lists of all shards are merged
+
+    void            SetLimits( size_t hitlimit, int nohitsthr, int noalnsthr, double evalthr );
+    void            SetHeaderText( char* );
+    void            SetFooterText( char*, bool scoring );
+
+protected:
+    explicit PartialHitList( const PartialHitList& );
+
+    void            Destroy();
+    void            ReallocHits( size_t newcap );
+    void            ReallocShards( size_t noshards );
+    void            SortHits();
+
+private:
+    TPHLHeader      header;         //header of the list
+    char*           headertext;     //text of the output header
+    char*           footertext;     //text of the output footer
+    HitInformation** hits;          //hits of the list
+    size_t          nohits;         //number of hits
+    size_t          capacity;       //capacity of hits
+    char*           shards;         //flags of the shards whose hits the list contains
+
+    static const char*  signature;  //signature of the list file
+};
+
+#endif//__PartialHitList__
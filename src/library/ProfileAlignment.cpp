@@ -19,8 +19,6 @@
 #include "ProfileAlignment.h"
 
 
-double  ProfileAlignment::s_information_thrsh = 0.0;    //information content threshold
-double  ProfileAlignment::s_segdistance_thrsh = 0.0;    //SEG distance threshold
 
 FrequencyMatrix dummyfreq;
 LogOddsMatrix   dummylogo;
@@ -145,6 +143,11 @@ ProfileAlignment::ProfileAlignment(
 
     F( NULL ),
     pointer( NULL ),
+    pointercols( 0 ),
+    maxscore( 0 ),
+    maxrow( 0 ),
+    maxcolumn( 0 ),
+    gapcoefs( NULL ),
     querySize( 0 ),
     subjectSize( 0 ),
 
@@ -185,24 +188,18 @@ ProfileAlignment::ProfileAlignment(
 	querySize = freq_fst_.GetColumns();
 	subjectSize = freq_sec_.GetColumns();
 
-	//one extra is reserved for dynamic programming matrix...
-	F 	    = (TPAScore(**)[countState] )malloc( sizeof( TPAScore* )*( subjectSize + 1 ));
-	pointer = (     int(**)[countState] )malloc( sizeof( int*      )*( subjectSize + 1 ));
+	//one extra is reserved for dynamic programming matrix; only two columns
+	//of it, the previous and the current one, are kept;
+	//back-tracing pointers are allocated when the path is to be traced
+	F 	    = (TPAScore(*)[countState] )malloc( sizeof( TPAScore )*( subjectSize + 1 ) * countState * 2 );
 
     path    = (    int (*)[nPro] )malloc( sizeof( int )*( subjectSize + querySize ) * nPro );
 
+    gapcoefs = ( double* )malloc( sizeof( double )*( subjectSize + querySize ) * gcCount );
 
-    if( !F || !pointer || !path )
-        throw myruntime_error( mystring( "ProfileAlignment: Not enough memory." ));
-
-    for( int m = 0; m < GetSubjectSize() + 1; m++ )
-    {
-        F[m]        = (TPAScore(*)[countState] )malloc( sizeof( TPAScore )*( GetQuerySize() + 1 ) * countState );
-        pointer[m]  = ( int    (*)[countState] )malloc( sizeof( int      )*( GetQuerySize() + 1 ) * countState );
 
-        if( !F[m] || !pointer[m] )
-            throw myruntime_error( mystring( "ProfileAlignment: Not enough memory." ));
-    }
+    if( !F || !path || !gapcoefs )
+        throw myruntime_error( mystring( "ProfileAlignment: Not enough memory." ));
 }
 
 // -------------------------------------------------------------------------
@@ -214,6 +211,11 @@ ProfileAlignment::ProfileAlignment()
 
     F( 0 ),
 	pointer( 0 ),
+	pointercols( 0 ),
+	maxscore( 0 ),
+	maxrow( 0 ),
+	maxcolumn( 0 ),
+	gapcoefs( NULL ),
 	querySize( 0 ),
 	subjectSize( 0 ),
 
@@ -250,13 +252,21 @@ ProfileAlignment::ProfileAlignment()
 void ProfileAlignment::Init()
 {
     memset( path, 0, sizeof( int )*( GetSubjectSize() + GetQuerySize()) * nPro );
+    memset( F, 0, sizeof( TPAScore )*( GetSubjectSize() + 1 ) * countState * 2 );
 
-    for( int m = 0; m < GetSubjectSize() + 1; m++ )
-    {
-        memset( F[m], 0,  sizeof( TPAScore )*( GetQuerySize() + 1 ) * countState );
-        memset( pointer[m], 0, sizeof( int )*( GetQuerySize() + 1 ) * countState );
-    }
+    maxscore = 0;
+    maxrow = 0;
+    maxcolumn = 0;
 
+    ResetStatistics();
+}
+
+// -------------------------------------------------------------------------
+// ResetStatistics: resets score and its statistical significance
+// -------------------------------------------------------------------------
+
+void ProfileAlignment::ResetStatistics()
+{
     SetBitScore( -1.0 );
     SetReferenceExpectation( -1.0 );
     SetExpectPerAlignment( -1.0 );
@@ -277,17 +287,35 @@ ProfileAlignment::~ProfileAlignment()
 {
     if( path )
         free( path );
+	if( F )
+		free( F );
+	if( pointer )
+		free( pointer );
+	if( gapcoefs )
+		free( gapcoefs );
+}
+
+// -------------------------------------------------------------------------
+// ReservePointers: allocates back-tracing pointers for the given number of
+//     query positions
+// -------------------------------------------------------------------------
+
+void ProfileAlignment::ReservePointers( int columns )
+{
+    if( columns <= pointercols )
+        return;
 
-	if( !F && !pointer )
-		return;
+    if( pointer )
+        free( pointer );
 
-	for( int m = 0; m < subjectSize + 1; m++ ) {
-		if( F ) free( F[m] );
-		if( pointer ) free( pointer[m] );
-	}
+    pointercols = 0;
+    pointer = ( unsigned char(*)[countState] )malloc( sizeof( unsigned char ) * countState *
+                                                      ( subjectSize + 1 ) * columns );
+    if( !pointer )
+        throw myruntime_error( mystring( "ProfileAlignment: Not enough memory." ));
 
-	if( F ) free( F );
-	if( pointer ) free( pointer );
+    memset( pointer, 0, sizeof( unsigned char ) * countState * ( subjectSize + 1 ) * columns );
+    pointercols = columns;
 }
 
 // -------------------------------------------------------------------------
@@ -359,7 +387,7 @@ void ProfileAlignment::Run()
 {
     Init();
 
-    AlignProfiles();                //1.
+    AlignProfiles( GetQuerySize(), true );  //1.
     MakeAlignmentPath();            //2.
     PostProcess();
     SetFinalScore( GetAlnScore());
@@ -367,6 +395,37 @@ void ProfileAlignment::Run()
 // fprintf( stderr, "%12.4g\n", GetRawExpectation());
 }
 
+// -------------------------------------------------------------------------
+// RunWithThreshold: computes the maximum score first keeping two columns
+//     of the dynamic programming matrix only; since the score can only
+//     decrease after the path is made, the path is traced only if the
+//     e-value of the maximum score is within the given threshold;
+//     returns false if the alignment cannot reach the threshold; the score
+//     and its statistics then refer to the maximum score
+// -------------------------------------------------------------------------
+
+bool ProfileAlignment::RunWithThreshold( double evalue )
+{
+    Init();
+
+    AlignProfiles( GetQuerySize(), false );
+    SetFinalScore( maxscore );
+    ComputeStatistics();
+
+    if( maxscore <= 0 || evalue < GetExpectation() || evalue < GetReferenceExpectation())
+        return false;
+
+    ResetStatistics();
+
+    //compute again up to the position of the maximum score saving pointers
+    AlignProfiles( maxcolumn, true );
+    MakeAlignmentPath();
+    PostProcess();
+    SetFinalScore( GetAlnScore());
+    ComputeStatistics();
+    return true;
+}
+
 // -------------------------------------------------------------------------
 // AdjustScore: adjusts score and recomputes its statistical significance
 // -------------------------------------------------------------------------
@@ -467,12 +526,47 @@ double ProfileAlignment::AutocorrScore(
     return ro;
 }
 
+// -------------------------------------------------------------------------
+// ComputeGapCoefficients: computes gap coefficients which depend on
+//     position only, so that they are not recomputed for each cell of the
+//     dynamic programming matrix; probabilities are computed only if gap
+//     costs are not fixed
+// -------------------------------------------------------------------------
+
+void ProfileAlignment::ComputeGapCoefficients( bool probabilities )
+{
+    const AbstractScoreMatrix*  scmatrix = GetScoreMatrix();
+    double  gapadj = scmatrix? scmatrix->GetDeletionCoefficient(): 1.0;
+    double* fst = gapcoefs;
+    double* sec = gapcoefs + gcCount * querySize;
+    int     n, m;
+
+    for( n = 0; n < querySize; n++ ) {
+        fst[gcOpen * querySize + n] = gaps_fst_.GetOpenAt( n );
+        fst[gcExtend * querySize + n] = gaps_fst_.GetExtendAt( n );
+        if( !probabilities )
+            continue;
+        fst[gcProb * querySize + n] = gaps_fst_.GetProbabilityAt( n );
+        fst[gcDelOpen * querySize + n] = gaps_fst_.GetDeleteOpenProbAt( n ) * gapadj;
+    }
+    for( m = 0; m < subjectSize; m++ ) {
+        sec[gcOpen * subjectSize + m] = gaps_sec_.GetOpenAt( m );
+        sec[gcExtend * subjectSize + m] = gaps_sec_.GetExtendAt( m );
+        if( !probabilities )
+            continue;
+        sec[gcProb * subjectSize + m] = gaps_sec_.GetProbabilityAt( m );
+        sec[gcDelOpen * subjectSize + m] = gaps_sec_.GetDeleteOpenProbAt( m ) * gapadj;
+    }
+}
+
 // -------------------------------------------------------------------------
 // AlignProfiles: computes dynamic programming matrix for a pair of profiles
-//     using position-specific gap costs
+//     using position-specific gap costs; only two columns of the matrix
+//     are kept; the maximum score and its most distant position are
+//     recorded; back-tracing pointers are saved when tracing
 // -------------------------------------------------------------------------
 
-void ProfileAlignment::AlignProfiles()
+void ProfileAlignment::AlignProfiles( int lastcolumn, bool tracing )
 {
     TPAScore    bestA, currentA, A;     //the best, current, and operating scores for state inAlign
     TPAScore    bestU, currentU, U;     //the best, current, and operating scores for state inGapUp
@@ -500,18 +594,57 @@ void ProfileAlignment::AlignProfiles()
 
     bool        fixedcosts = gaps_fst_.GetFixed() || gaps_sec_.GetFixed();
 
+    TPAScore    ( *Fprev )[countState];     //column of the previous query position
+    TPAScore    ( *Fcurr )[countState];     //column of the current query position
+    unsigned char   ( *ptrs )[countState] = NULL;   //back-tracing pointers of the current column
+
+    if( querySize < lastcolumn )
+        lastcolumn = querySize;
+
+    memset( F, 0, sizeof( TPAScore )*( subjectSize + 1 ) * countState * 2 );
+
+    maxscore = 0;
+    maxrow = 0;
+    maxcolumn = 0;
+
+    if( tracing )
+        ReservePointers( lastcolumn + 1 );
+
+    //position-specific gap coefficients
+    if( !IsUngapped())
+        ComputeGapCoefficients( !fixedcosts );
+
+    const double*   fstopen = GetFstCoefficients( gcOpen );
+    const double*   fstextend = GetFstCoefficients( gcExtend );
+    const double*   fstprob = GetFstCoefficients( gcProb );
+    const double*   fstdelopen = GetFstCoefficients( gcDelOpen );
+
+    const double*   secopen = GetSecCoefficients( gcOpen );
+    const double*   secextend = GetSecCoefficients( gcExtend );
+    const double*   secprob = GetSecCoefficients( gcProb );
+    const double*   secdelopen = GetSecCoefficients( gcDelOpen );
+
+    //factors of deletion extension probabilities
+    double          fstfactor = fixedcosts? 1.0: gaps_fst_.GetProbabilityFactor();
+    double          secfactor = fixedcosts? 1.0: gaps_sec_.GetProbabilityFactor();
+
 ///     if( 60.0 <= scmatrix->GetPrelimScore())
 ///         gapadj = 0.8 - 0.8 * exp( -0.01 * ( scmatrix->GetPrelimScore() - 60.0 ));
 
     //iterate over the query positions
-    for( int n = 1; n < querySize + 1; n++ )
+    for( int n = 1; n < lastcolumn + 1; n++ )
     {
-        bestA 	  = F[0][n][inAlign];
-        currentA  = F[0][n-1][inAlign];
+        Fprev = F + (( n - 1 ) & 1 ) * ( subjectSize + 1 );
+        Fcurr = F + ( n & 1 ) * ( subjectSize + 1 );
+        if( tracing )
+            ptrs = GetPointersAt( n );
 
-        bestU     = F[0][n][inGapUp];
+        bestA 	  = Fcurr[0][inAlign];
+        currentA  = Fprev[0][inAlign];
 
-        currentL  = F[0][n-1][inGapLeft];
+        bestU     = Fcurr[0][inGapUp];
+
+        currentL  = Fprev[0][inGapLeft];
 
         //iterate over the subject positions
         for( int m = 1; m < subjectSize + 1; m++ )
@@ -525,54 +658,54 @@ void ProfileAlignment::AlignProfiles()
                 upOpen += SCORE_MIN;
             else {
                 if( fixedcosts )
-                    upOpen += gaps_fst_.GetOpenAt( n-1 );
+                    upOpen += fstopen[n-1];
                 else {
 //                     insadj = gaps_fst_.GetProbabilityAt( n-1 );
-                    insadj = gaps_sec_.GetProbabilityAt( m-1 );//original
-                    deladj = gaps_fst_.GetDeleteOpenProbAt( n-1 ) * gapadj;
+                    insadj = secprob[m-1];//original
+                    deladj = fstdelopen[n-1];
 //                     deladj = gaps_fst_.GetDeleteOpenWeightAt( n-1 ) * gapadj;
                     double  sumu = deladj + insadj;
                     if( 1.0 < sumu ) sumu = 1.0;
-                    upOpen += gaps_fst_.GetOpenAt( n-1 ) * ( 1.0 - sumu );
+                    upOpen += fstopen[n-1] * ( 1.0 - sumu );
                 }
             }
 
             A        = currentA;
-            currentA = F[m][n-1][inAlign];
+            currentA = Fprev[m][inAlign];
                         //gap opening cost for subject position
             leftOpen = currentA;
             if( IsUngapped())
                 leftOpen += SCORE_MIN;
             else {
                 if( fixedcosts )
-                    leftOpen += gaps_sec_.GetOpenAt( m-1 );
+                    leftOpen += secopen[m-1];
                 else {
 //                     insadj = gaps_sec_.GetProbabilityAt( m-1 );
-                    insadj = gaps_fst_.GetProbabilityAt( n-1 );//original
-                    deladj = gaps_sec_.GetDeleteOpenProbAt( m-1 ) * gapadj;
+                    insadj = fstprob[n-1];//original
+                    deladj = secdelopen[m-1];
 //                     deladj = gaps_sec_.GetDeleteOpenWeightAt( m-1 ) * gapadj;
                     double  suml = deladj + insadj;
                     if( 1.0 < suml ) suml = 1.0;
-                    leftOpen += gaps_sec_.GetOpenAt( m-1 ) * ( 1.0 - suml );
+                    leftOpen += secopen[m-1] * ( 1.0 - suml );
                 }
             }
 
 
             L        = currentL;
-            currentL = F[m][n-1][inGapLeft];
+            currentL = Fprev[m][inGapLeft];
             leftExtend = currentL;              //gap extend cost for subject position
             if( IsUngapped())
                 leftExtend += SCORE_MIN;
             else {
                 if( fixedcosts )
-                    leftExtend += gaps_sec_.GetExtendAt( m-1 );
+                    leftExtend += secextend[m-1];
                 else {
-                    insadj = gaps_fst_.GetProbabilityAt( n-1 );
-                    deladj = gaps_sec_.GetDeleteExtensionProbAt( m-1, extimeleft ) * gapadj;
+                    insadj = fstprob[n-1];
+                    deladj = gaps_sec_.GetDeleteExtensionProbAt( m-1, extimeleft, secfactor ) * gapadj;
 //                     deladj = gaps_sec_.GetDeleteExtendWeightAt( m-1, extimeleft ) * gapadj;
                     double  suml = deladj + insadj;
                     if( 1.0 < suml ) suml = 1.0;
-                    leftExtend += gaps_sec_.GetExtendAt( m-1 ) * ( 1.0 - suml );
+                    leftExtend += secextend[m-1] * ( 1.0 - suml );
                 }
             }
 
@@ -581,18 +714,18 @@ void ProfileAlignment::AlignProfiles()
                 upExtend += SCORE_MIN;
             else {
                 if( fixedcosts )
-                    upExtend += gaps_fst_.GetExtendAt( n-1 );
+                    upExtend += fstextend[n-1];
                 else {
-                    insadj = gaps_sec_.GetProbabilityAt( m-1 );
-                    deladj = gaps_fst_.GetDeleteExtensionProbAt( n-1, extimeup ) * gapadj;
+                    insadj = secprob[m-1];
+                    deladj = gaps_fst_.GetDeleteExtensionProbAt( n-1, extimeup, fstfactor ) * gapadj;
 //                     deladj = gaps_fst_.GetDeleteExtendWeightAt( n-1, extimeup ) * gapadj;
                     double  sumu = deladj + insadj;
                     if( 1.0 < sumu ) sumu = 1.0;
-                    upExtend += gaps_fst_.GetExtendAt( n-1 ) * ( 1.0 - sumu );
+                    upExtend += fstextend[n-1] * ( 1.0 - sumu );
                 }
             }
 
-            U = F[m-1][n-1][inGapUp];
+            U = Fprev[m-1][inGapUp];
 
 // fprintf( stderr, "%4d %4d : %7.3f %7.3f ; %7.3f %7.3f : %7.3f %7.3f\n", m, n, upOpen, upExtend,
 // gaps_sec_.GetDeleteExtendWeightAt( m-1, extimeleft ), gaps_sec_.GetWeightsAt( m-1 ),
@@ -614,12 +747,14 @@ void ProfileAlignment::AlignProfiles()
                         ptr = Diag_Up;  //diagonal or up
                     }
             if( bestU > 0 ) {
-                F[m][n][inGapUp] = bestU;
-                pointer[m][n][inGapUp] = ptr;
+                Fcurr[m][inGapUp] = bestU;
             } else {
                 bestU = 0;
-                pointer[m][n][inGapUp] = No;
+                Fcurr[m][inGapUp] = 0;
+                ptr = No;
             }
+            if( tracing )
+                ptrs[m][inGapUp] = ( unsigned char )ptr;
 
             //process state inGapLeft
             //.......................
@@ -637,12 +772,14 @@ void ProfileAlignment::AlignProfiles()
                         ptr = Diag_Left;  //diagonal or left
                     }
             if( bestL > 0 ) {
-                F[m][n][inGapLeft] = bestL;
-                pointer[m][n][inGapLeft] = ptr;
+                Fcurr[m][inGapLeft] = bestL;
             } else {
                 bestL = 0;
-                pointer[m][n][inGapLeft] = No;
+                Fcurr[m][inGapLeft] = 0;
+                ptr = No;
             }
+            if( tracing )
+                ptrs[m][inGapLeft] = ( unsigned char )ptr;
 
             //process state inAlign
             //.....................
@@ -683,12 +820,21 @@ void ProfileAlignment::AlignProfiles()
                     }
             bestA += scoring;
             if( bestA > 0 ) {
-                F[m][n][inAlign] = bestA;
-                pointer[m][n][inAlign] = ptr;
+                Fcurr[m][inAlign] = bestA;
+                //the most distant maximum: of the greatest subject position
+                //and then of the greatest query position
+                if( maxscore < bestA || ( maxscore == bestA && maxrow <= m )) {
+                    maxscore = bestA;
+                    maxrow = m;
+                    maxcolumn = n;
+                }
             } else {
                 bestA = 0;
-                pointer[m][n][inAlign] = No;
+                Fcurr[m][inAlign] = 0;
+                ptr = No;
             }
+            if( tracing )
+                ptrs[m][inAlign] = ( unsigned char )ptr;
         }
     }
 }
@@ -700,9 +846,9 @@ void ProfileAlignment::AlignProfiles()
 
 void ProfileAlignment::MakeAlignmentPath()
 {
-    TPAScore    score = 0;              //maximum score of the dynamic programming matrix
-    int         row = 0;                //row index of the maximum score
-    int         column = 0;             //column index of the maximum score
+    TPAScore    score = maxscore;       //maximum score of the dynamic programming matrix
+    int         row = maxrow;           //row index of the maximum score
+    int         column = maxcolumn;     //column index of the maximum score
     State       laststate = inAlign;    //last state we started back-tracing with
     State       state = laststate;      //state of back-tracing
     int         step = 0;               //index for variable path
@@ -712,20 +858,14 @@ void ProfileAlignment::MakeAlignmentPath()
     if( !scmatrix )
         throw myruntime_error( "ProfileAlignment: No scoring system." );
 
-    if( !F )
+    if( !pointer || pointercols <= column )
         throw myruntime_error( mystring( "ProfileAlignment: Failed to generate path: No dynamic programming matrix computed." ));
 
     if( !path )
         throw myruntime_error( mystring( "ProfileAlignment: Failed to generate path: No tracing path." ));
 
-    //find the most distant maximum value 
-    for( int m = subjectSize; m; m-- )
-        for( int n = querySize; n; n-- )
-            if( score < F[m][n][inAlign] ) {    //check only inAlign state since the ending of alignment in gap is impossible
-                score = F[m][n][inAlign];
-                row = m;
-                column = n;
-            }
+    //the most distant maximum value has been found while computing the matrix;
+    //only inAlign state is checked since the ending of alignment in gap is impossible
     if( score <= 0 )
         return;
 
@@ -735,7 +875,7 @@ void ProfileAlignment::MakeAlignmentPath()
 
     while( row > 0 && column > 0 ) {
         state = laststate;
-        laststate = getState( pointer[row][column][state] );
+        laststate = getState( GetPointersAt( column )[row][state] );
         if( laststate == countState )
             break;  //end of path
         switch( state ) {
@@ -95,6 +95,7 @@ public:
 
     void                        Init();
     void                        Run();
+    bool                        RunWithThreshold( double evalue );          //path is traced only if e-value may be reached
     void                        AdjustScore( double value );
     void                        PostProcess();
 
@@ -134,18 +135,20 @@ public:
 
     size_t                      GetMinimumRequiredSizeForAlignment() const; //get minimum required size to contain alignment information
 
-    static void                 SetInformationThreshold( double value )     { s_information_thrsh = value; }
-    static void                 SetSEGdistanceThreshold( double value )     { s_segdistance_thrsh = value; }
-
-    static double               GetInformationThreshold()                   { return s_information_thrsh; }
-    static double               GetSEGdistanceThreshold()                   { return s_segdistance_thrsh; }
+    double                      GetInformationThreshold() const;            //thresholds of the search context
+    double                      GetSEGdistanceThreshold() const;
 
 protected:
     explicit ProfileAlignment();
 
-    void                        AlignProfiles();
+    void                        AlignProfiles( int lastcolumn, bool tracing );
+    void                        ComputeGapCoefficients( bool probabilities );
     void                        MakeAlignmentPath();
     void                        ComputeStatistics();
+    void                        ResetStatistics();
+
+    void                        ReservePointers( int columns );             //allocate back-tracing pointers
+    unsigned char             ( *GetPointersAt( int column ))[countState];  //back-tracing pointers of a column
 
     double                      AutocorrScore( const AbstractScoreMatrix*, int sbjctpos, int querypos );
     double                      AutocorrScore( const AbstractScoreMatrix*, int sbjctpos, int querypos, int, int, int, int );
@@ -173,11 +176,30 @@ protected:
 
     static  double              ComputePvalue( double expect );
 
+    //sections of the vector of gap coefficients
+    enum TGapCoefficient {
+        gcOpen,         //gap opening cost
+        gcExtend,       //gap extension cost
+        gcProb,         //gap probability
+        gcDelOpen,      //deletion opening probability weighted by deletion coefficient
+        gcCount
+    };
+
+    const double*               GetFstCoefficients( TGapCoefficient c ) const   { return gapcoefs + c * querySize; }
+    const double*               GetSecCoefficients( TGapCoefficient c ) const   { return gapcoefs + gcCount * querySize + c * subjectSize; }
+
 private:
     StatModel                   model;          //statistical model object
 
-    TPAScore    ( **F )[countState];            //dynamic programming matrix
-    int	        ( **pointer )[countState];      //backtracing pointer
+    TPAScore    ( *F )[countState];             //two columns of dynamic programming matrix
+    unsigned char   ( *pointer )[countState];   //backtracing pointers kept by columns of query positions
+    int                         pointercols;    //number of columns pointers are allocated for
+
+    TPAScore                    maxscore;       //maximum score of the dynamic programming matrix
+    int                         maxrow;         //subject position of the maximum score
+    int                         maxcolumn;      //query position of the maximum score
+
+    double*                     gapcoefs;       //position-specific gap coefficients computed before alignment
 
     int                         querySize;      //length of query sequence (profile)
     int                         subjectSize;    //length of subject sequence (profile)
@@ -207,9 +229,6 @@ private:
 
     bool        ungapped;                   //align profiles without using gaps
 
-    static double   s_information_thrsh;    //information content threshold
-    static double   s_segdistance_thrsh;    //SEG distance threshold
-
 };
 
 
@@ -234,6 +253,21 @@ inline ProfileAlignment::State ProfileAlignment::getState( int direct ) const
     return state;
 }
 
+// -------------------------------------------------------------------------
+// GetPointersAt: back-tracing pointers for all subject positions at the
+//     given query position
+// -------------------------------------------------------------------------
+
+inline
+unsigned char ( *ProfileAlignment::GetPointersAt( int column ))[countState]
+{
+#ifdef __DEBUG__
+    if( !pointer || column < 0 || pointercols <= column )
+        throw myruntime_error( mystring( "ProfileAlignment: Memory access error." ));
+#endif
+    return pointer + column * ( subjectSize + 1 );
+}
+
 // -------------------------------------------------------------------------
 // GetScoreMatrix: obtains one of the two possible scoring matrices
 // -------------------------------------------------------------------------
@@ -249,6 +283,27 @@ const AbstractScoreMatrix* ProfileAlignment::GetScoreMatrix() const
     return scoreSystem;
 }
 
+// -------------------------------------------------------------------------
+// GetInformationThreshold: information content threshold of the search
+//     the score system belongs to
+// -------------------------------------------------------------------------
+
+inline
+double ProfileAlignment::GetInformationThreshold() const
+{
+    const SearchContext*    ctx = GetScoreMatrix()? GetScoreMatrix()->GetSearchContext(): NULL;
+    return ctx? ctx->GetInformationThreshold(): 0.0;
+}
+
+// GetSEGdistanceThreshold: SEG distance threshold of the search
+//
+inline
+double ProfileAlignment::GetSEGdistanceThreshold() const
+{
+    const SearchContext*    ctx = GetScoreMatrix()? GetScoreMatrix()->GetSearchContext(): NULL;
+    return ctx? ctx->GetSEGdistanceThreshold(): 0.0;
+}
+
 // -------------------------------------------------------------------------
 // SetFinalScore: adjusts if needed the final alignment score and saves it
 // -------------------------------------------------------------------------
@@ -0,0 +1,233 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Mindaugas Margelevicius                         *
+ *   Institute of Biotechnology, Vilnius                                   *
+ *   minmar@ibt.lt                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "defines.h"
+#include "Serializer.h"
+#include "ProfileOffsetIndex.h"
+
+
+const char* ProfileOffsetIndex::signature = "COMA profile offset index v1.0\n";
+
+// -------------------------------------------------------------------------
+// constructor: initialization
+// -------------------------------------------------------------------------
+
+ProfileOffsetIndex::ProfileOffsetIndex()
+:   entries( NULL ),
+    noprofiles( 0 ),
+    capacity( 0 ),
+    names( NULL ),
+    sznames( 0 ),
+    namecapacity( 0 )
+{
+}
+
+// -------------------------------------------------------------------------
+// destructor: deallocation of resources
+// -------------------------------------------------------------------------
+
+ProfileOffsetIndex::~ProfileOffsetIndex()
+{
+    Destroy();
+}
+
+// -------------------------------------------------------------------------
+// Destroy: deallocates memory of the index
+// -------------------------------------------------------------------------
+
+void ProfileOffsetIndex::Destroy()
+{
+    if( entries )
+        free( entries );
+    if( names )
+        free( names );
+
+    entries = NULL;
+    names = NULL;
+    noprofiles = capacity = 0;
+    sznames = namecapacity = 0;
+}
+
+// -------------------------------------------------------------------------
+// ReallocEntries: reallocates memory for entries of profiles
+// -------------------------------------------------------------------------
+
+void ProfileOffsetIndex::ReallocEntries( size_t newcap )
+{
+    TPOIEntry*  tmpentries;
+
+    if( newcap <= capacity )
+        return;
+
+    tmpentries = ( TPOIEntry* )realloc( entries, sizeof( TPOIEntry ) * newcap );
+    if( !tmpentries )
+        throw myruntime_error( mystring( "ProfileOffsetIndex: Not enough memory." ));
+    entries = tmpentries;
+    capacity = newcap;
+}
+
+// -------------------------------------------------------------------------
+// ReallocNames: reallocates memory for names of profiles
+// -------------------------------------------------------------------------
+
+void ProfileOffsetIndex::ReallocNames( size_t newcap )
+{
+    char*   tmpnames;
+
+    if( newcap <= namecapacity )
+        return;
+
+    tmpnames = ( char* )realloc( names, newcap );
+    if( !tmpnames )
+        throw myruntime_error( mystring( "ProfileOffsetIndex: Not enough memory." ));
+    names = tmpnames;
+    namecapacity = newcap;
+}
+
+// -------------------------------------------------------------------------
+// AddProfile: adds the entry of the next profile of the database
+// -------------------------------------------------------------------------
+
+void ProfileOffsetIndex::AddProfile( long offset, long length, int columns, const char* name )
+{
+    size_t  len;
+
+    if( offset < 0 || length <= 0 || columns <= 0 )
+        throw myruntime_error( mystring( "ProfileOffsetIndex: Invalid entry of profile." ));
+
+    if( !name )
+        name = "";
+    len = strlen( name ) + 1;
+
+    if( capacity <= noprofiles )
+        ReallocEntries( capacity? capacity * 2: KBYTE );
+    if( namecapacity < sznames + len )
+        ReallocNames(( namecapacity < len )? namecapacity * 2 + len: namecapacity * 2 );
+
+    entries[noprofiles].offset = ( Uint64 )offset;
+    entries[noprofiles].length = ( Uint64 )length;
+    entries[noprofiles].columns = ( Uint64 )columns;
+    entries[noprofiles].name = ( Uint64 )sznames;
+    noprofiles++;
+
+    memcpy( names + sznames, name, len );
+    sznames += len;
+}
+
+// -------------------------------------------------------------------------
+// ShiftPositions: shifts the offsets of all profiles by the given amount,
+//     e.g. when a header is put in front of the profiles
+// -------------------------------------------------------------------------
+
+void ProfileOffsetIndex::ShiftPositions( long amount )
+{
+    for( size_t n = 0; n < noprofiles; n++ ) {
+        if( amount < 0 && entries[n].offset < ( Uint64 )( -amount ))
+            throw myruntime_error( mystring( "ProfileOffsetIndex: Invalid shift of profiles." ));
+        entries[n].offset += amount;
+    }
+}
+
+// -------------------------------------------------------------------------
+// Write: writes the index to file
+// -------------------------------------------------------------------------
+
+void ProfileOffsetIndex::Write( const char* filename ) const
+{
+    Uint64      sizes[2];
+    mystring    errstr;
+    int         eclass = NOCLASS;
+    FILE*       fp;
+
+    fp = fopen( filename, "w" );
+    if( fp == NULL )
+        throw myruntime_error( mystring( "Unable to write offset index of profiles." ));
+
+    sizes[0] = ( Uint64 )noprofiles;
+    sizes[1] = ( Uint64 )sznames;
+
+    try {
+        Serializer::Write( fp, ( char* )signature, 1, strlen( signature ));
+        Serializer::Write( fp, ( char* )sizes, sizeof( Uint64 ), 2 );
+        if( noprofiles )
+            Serializer::Write( fp, ( char* )entries, sizeof( TPOIEntry ), noprofiles );
+        if( sznames )
+            Serializer::Write( fp, names, 1, sznames );
+
+    } catch( myexception const& ex )
+    {
+        errstr = ex.what();
+        eclass = ex.eclass();
+    }
+
+    fclose( fp );
+
+    if( !errstr.empty())
+        throw myruntime_error( errstr.c_str(), eclass );
+}
+
+// -------------------------------------------------------------------------
+// Read: reads the index from file
+// -------------------------------------------------------------------------
+
+void ProfileOffsetIndex::Read( const char* filename )
+{
+    char        locsignature[BUF_MAX];
+    Uint64      sizes[2];
+    mystring    errstr;
+    int         eclass = NOCLASS;
+    size_t      n;
+    FILE*       fp;
+
+    Destroy();
+
+    fp = fopen( filename, "r" );
+    if( fp == NULL )
+        throw myruntime_error( mystring( "Failed to open offset index of profiles." ));
+
+    try {
+        Serializer::Read( fp, locsignature, 1, strlen( signature ));
+        if( strncmp( locsignature, signature, strlen( signature )))
+            throw myruntime_error( mystring( "Wrong format of offset index of profiles." ));
+
+        Serializer::Read( fp, ( char* )sizes, sizeof( Uint64 ), 2 );
+
+        ReallocEntries(( size_t )sizes[0] + 1 );
+        ReallocNames(( size_t )sizes[1] + 1 );
+        noprofiles = ( size_t )sizes[0];
+        sznames = ( size_t )sizes[1];
+
+        if( noprofiles )
+            Serializer::Read( fp, ( char* )entries, sizeof( TPOIEntry ), noprofiles );
+        if( sznames )
+            Serializer::Read( fp, names, 1, sznames );
+
+        if( noprofiles && ( !sznames || names[sznames-1] ))
+            throw myruntime_error( mystring( "Offset index of profiles corrupted." ));
+        for( n = 0; n < noprofiles; n++ )
+            if( sznames <= entries[n].name ||
+              ( n && entries[n].offset < entries[n-1].offset + entries[n-1].length ))
+                throw myruntime_error( mystring( "Offset index of profiles corrupted." ));
+
+    } catch( myexception const& ex )
+    {
+        errstr = ex.what();
+        eclass = ex.eclass();
+    }
+
+    fclose( fp );
+
+    if( !errstr.empty()) {
+        Destroy();
+        throw myruntime_error( errstr.c_str(), eclass );
+    }
+}
@@ -0,0 +1,134 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Mindaugas Margelevicius                         *
+ *   Institute of Biotechnology, Vilnius                                   *
+ *   minmar@ibt.lt                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef __ProfileOffsetIndex__
+#define __ProfileOffsetIndex__
+
+#include "debug.h"
+#include "types.h"
+#include "compdef.h"
+
+#include "mystring.h"
+#include "myexcept.h"
+
+
+//entry of a profile in the offset index
+struct TPOIEntry {
+    Uint64  offset;     //byte offset of the profile in the database file
+    Uint64  length;     //length of the profile in bytes
+    Uint64  columns;    //number of columns of the profile
+    Uint64  name;       //offset of the name of the profile in the block of names
+};
+
+// _________________________________________________________________________
+// Class ProfileOffsetIndex
+//
+// Offset index of the profile database: for each profile in the order of
+// the database, it keeps the byte offset and length of the profile in the
+// database file, number of columns, and name, so that any profile or
+// range of profiles can be read without reading the ones before it
+//
+
+class ProfileOffsetIndex
+{
+public:
+    ProfileOffsetIndex();
+    ~ProfileOffsetIndex();
+
+                                                //add entry of the next profile of the database
+    void            AddProfile( long offset, long length, int columns, const char* name );
+    void            ShiftPositions( long amount );          //shift offsets of all profiles
+    void            Write( const char* filename ) const;    //write index to file
+    void            Read( const char* filename );           //read index from file
+
+    size_t          GetNoProfiles() const           { return noprofiles; }
+
+    long            GetOffset( size_t ordinal ) const;
+    long            GetLength( size_t ordinal ) const;
+    int             GetColumns( size_t ordinal ) const;
+    const char*     GetName( size_t ordinal ) const;
+
+protected:
+    explicit ProfileOffsetIndex( const ProfileOffsetIndex& );
+
+    void            Destroy();
+    void            ReallocEntries( size_t newcap );
+    void            ReallocNames( size_t newcap );
+
+private:
+    TPOIEntry*      entries;        //entries of profiles
+    size_t          noprofiles;     //number of profiles
+    size_t          capacity;       //capacity of entries
+
+    char*           names;          //null-terminated names of profiles one after another
+    size_t          sznames;        //size of the names
+    size_t          namecapacity;   //capacity of names
+
+    static const char*  signature;  //signature of the index file
+};
+
+
+// INLINES ...
+
+// -------------------------------------------------------------------------
+// GetOffset: returns the byte offset of the profile in the database file
+// -------------------------------------------------------------------------
+
+inline
+long ProfileOffsetIndex::GetOffset( size_t ordinal ) const
+{
+#ifdef __DEBUG__
+    if( !entries || noprofiles <= ordinal )
+        throw myruntime_error( mystring( "ProfileOffsetIndex: Memory access error." ));
+#endif
+    return ( long )entries[ordinal].offset;
+}
+
+// -------------------------------------------------------------------------
+// GetLength: returns the length of the profile in bytes
+// -------------------------------------------------------------------------
+
+inline
+long ProfileOffsetIndex::GetLength( size_t ordinal ) const
+{
+#ifdef __DEBUG__
+    if( !entries || noprofiles <= ordinal )
+        throw myruntime_error( mystring( "ProfileOffsetIndex: Memory access error." ));
+#endif
+    return ( long )entries[ordinal].length;
+}
+
+// -------------------------------------------------------------------------
+// GetColumns: returns the number of columns of the profile
+// -------------------------------------------------------------------------
+
+inline
+int ProfileOffsetIndex::GetColumns( size_t ordinal ) const
+{
+#ifdef __DEBUG__
+    if( !entries || noprofiles <= ordinal )
+        throw myruntime_error( mystring( "ProfileOffsetIndex: Memory access error." ));
+#endif
+    return ( int )entries[ordinal].columns;
+}
+
+// -------------------------------------------------------------------------
+// GetName: returns the name of the profile
+// -------------------------------------------------------------------------
+
+inline
+const char* ProfileOffsetIndex::GetName( size_t ordinal ) const
+{
+#ifdef __DEBUG__
+    if( !entries || noprofiles <= ordinal )
+        throw myruntime_error( mystring( "ProfileOffsetIndex: Memory access error." ));
+#endif
+    return names + entries[ordinal].name;
+}
+
+#endif//__ProfileOffsetIndex__
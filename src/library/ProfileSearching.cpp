@@ -7,11 +7,14 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "ProfileSearching.h"
 #include "InputMultipleAlignment.h"
 #include "SEGSequence.h"
 #include "Serializer.h"
+#include "HashFunctions.h"
+#include "PartialHitList.h"
 
 #include "mystring.h"
 #include "myexcept.h"
@@ -28,16 +31,20 @@ HitInformation::HitInformation(
         double sc,
         double eval,
         double refeval,
-        char* annot,
-        char* fullinfo,
+        size_t ordnum,
+        long pos,
         bool destroy )
 :
     score( sc ),
     evalue( eval ),
     ref_evalue( refeval ),
-    annotation( annot ),
-    fullalignment( fullinfo ),
-    autodestroy( destroy )
+    annotation( NULL ),
+    fullalignment( NULL ),
+    autodestroy( destroy ),
+    ordinal( ordnum ),
+    position( pos ),
+    infothreshold( 0.0 ),
+    parameterK( -1.0 )
 {
 }
 
@@ -49,7 +56,11 @@ HitInformation::HitInformation()
     evalue( -1.0 ),
     ref_evalue( -1.0 ),
     annotation( NULL ),
-    fullalignment( NULL )
+    fullalignment( NULL ),
+    ordinal( 0 ),
+    position( -1 ),
+    infothreshold( 0.0 ),
+    parameterK( -1.0 )
 {
     throw( myruntime_error(
             mystring( "Default initialization of the HitInformation objects is prohibited." )));
@@ -68,6 +79,75 @@ HitInformation::~HitInformation()
         free( fullalignment );
 }
 
+// Compare: compares hits given by pointers to them in the order of output
+//
+int HitInformation::Compare( const void* a, const void* b )
+{
+    const HitInformation*   left = *( const HitInformation** )a;
+    const HitInformation*   rght = *( const HitInformation** )b;
+
+    if( left->Precedes( *rght ))
+        return -1;
+    if( rght->Precedes( *left ))
+        return 1;
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// CLASS SearchingWorker
+//
+// Constructor
+//
+SearchingWorker::SearchingWorker(
+        ProfileSearching* search,
+        FrequencyMatrix* qfreq,
+        LogOddsMatrix* qpssm,
+        GapScheme* qgaps,
+        bool ownq )
+:
+    owner( search ),
+    query_freq( qfreq ),
+    query_pssm( qpssm ),
+    query_gaps( qgaps ),
+    ownquery( ownq ),
+    scoreSystem( NULL ),
+    ownscores( false ),
+    errclass( NOCLASS )
+{
+    if( !owner || !query_freq || !query_pssm || !query_gaps )
+        throw myruntime_error( mystring( "SearchingWorker: Null arguments." ));
+}
+
+// Default constructor
+//
+SearchingWorker::SearchingWorker()
+:
+    owner( NULL ),
+    query_freq( NULL ),
+    query_pssm( NULL ),
+    query_gaps( NULL ),
+    ownquery( false ),
+    scoreSystem( NULL ),
+    ownscores( false ),
+    errclass( NOCLASS )
+{
+    throw( myruntime_error(
+            mystring( "Default initialization of the SearchingWorker objects is prohibited." )));
+}
+
+// Destructor
+//
+SearchingWorker::~SearchingWorker()
+{
+    if( scoreSystem && ownscores )
+        delete scoreSystem;
+    if( ownquery ) {
+        delete query_freq;
+        delete query_pssm;
+        delete query_gaps;
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////
 // CLASS ProfileSearching
 //
@@ -98,6 +178,7 @@ ProfileSearching::ProfileSearching(
     input_name( input ),
     database_name( database ),
     output_name( output ),
+    cache_dir( NULL ),
     scoreSystem( NULL ),
 
     max_evalue( eval_threshold ),
@@ -121,6 +202,7 @@ ProfileSearching::ProfileSearching(
     size( 0 ),
 
     profile_db( database ),
+    sharedb( NULL ),
 
     no_sequences( 0 ),
     db_size( 0 ),
@@ -166,9 +248,19 @@ ProfileSearching::ProfileSearching(
     hspdistance_( 0 ),
     hspnohsps_( 0 ),
 
+    idxwordscore_( 0.0 ),
+    idxnoseeds_( 0 ),
+    candidates( NULL ),
+
     evalue_alnlength( -1.0 ),
     positcorrects( false ),
-    autoaccorrection( true )
+    autoaccorrection( true ),
+
+    no_threads( 1 ),
+    db_ordinal( 0 ),
+    shard_no( 0 ),
+    no_shards( 0 ),
+    scan_aborted( false )
 {
     Realloc( ALLOCHITS );
 
@@ -177,13 +269,17 @@ ProfileSearching::ProfileSearching(
         SetGapExtnCost( Configuration::NOGAPVAL );
     }
 
-    ProfileAlignment::SetInformationThreshold( infrm_threshold );
+    context.SetInformationThreshold( infrm_threshold );
+
+    pthread_mutex_init( &db_mutex, NULL );
+    pthread_mutex_init( &hit_mutex, NULL );
 }
 
 // Default constructor
 //
 ProfileSearching::ProfileSearching()
 :
+    cache_dir( NULL ),
     scoreSystem( NULL ),
     information_content( 0.0 ),
     deletestates_( true ),
@@ -191,6 +287,7 @@ ProfileSearching::ProfileSearching()
     thickness_percnt( 0.0 ),
     maskscale_percnt( 0.0 ),
     profile_db( NULL ),
+    sharedb( NULL ),
 
     autogapcosts( false ),
     autocorrwinsize( -1 ),
@@ -206,9 +303,19 @@ ProfileSearching::ProfileSearching()
     seqseglowent( DEFAULT_SEGSEQ_LOW_ENTROPY ),
     seqseghighent( DEFAULT_SEGSEQ_HIGH_ENTROPY ),
 
+    idxwordscore_( 0.0 ),
+    idxnoseeds_( 0 ),
+    candidates( NULL ),
+
     evalue_alnlength( -1.0 ),
     positcorrects( false ),
-    autoaccorrection( true )
+    autoaccorrection( true ),
+
+    no_threads( 1 ),
+    db_ordinal( 0 ),
+    shard_no( 0 ),
+    no_shards( 0 ),
+    scan_aborted( false )
 {
     throw( myruntime_error(
             mystring( "Default initialization of the ProfileSearching objects is prohibited." )));
@@ -228,6 +335,12 @@ ProfileSearching::~ProfileSearching()
         size = 0;
     }
     DestroyScoreSystem();
+
+    if( candidates )
+        free( candidates );
+
+    pthread_mutex_destroy( &db_mutex );
+    pthread_mutex_destroy( &hit_mutex );
 }
 
 // -------------------------------------------------------------------------
@@ -257,79 +370,82 @@ void ProfileSearching::Realloc( size_t newcap )
 }
 
 // -------------------------------------------------------------------------
-// Push: pushes hit information into the hit listing
+// Push: pushes hit information into the hit listing; the listing is kept
+//     as a heap of the best hits found so far with the worst of them on
+//     top; hit is deleted if it is not better than any of them
 // -------------------------------------------------------------------------
 
 void ProfileSearching::Push( HitInformation* hit )
 {
-    if( capacity  <  size + 1 ) {
-        Realloc( capacity * 2 );
+    if( !hit )
+        return;
+
+    if( size < GetHitlistLimit()) {
+        if( capacity  <  size + 1 ) {
+            Realloc( capacity * 2 );
+        }
+        hitListing[size] = hit;
+        size++;
+        SiftUp( size - 1 );
+        return;
     }
 
-    hitListing[size] = hit;
+    if( !hit->Precedes( *hitListing[0] )) {
+        delete hit;
+        return;
+    }
 
-    size++;
+    delete hitListing[0];
+    hitListing[0] = hit;
+    SiftDown( 0 );
 }
 
 // -------------------------------------------------------------------------
-// Run: Begins searching of the query profile against the database
+// SiftUp: moves hit up the heap until its parent is worse
 // -------------------------------------------------------------------------
 
-void ProfileSearching::Run()
+void ProfileSearching::SiftUp( size_t n )
 {
-    FrequencyMatrix dbfreq;
-    LogOddsMatrix   dbpssm;
-    GapScheme       dbgaps;
-
-    GetConfiguration( ProcomUngapped ).SetFilename( GetParamConfigFile());
-    GetConfiguration( ProcomGapped ).SetFilename( GetParamConfigFile());
-
-    //read parameters
-    GetConfiguration( ProcomUngapped ).ReadUngapped();  //read ungapped configuration
-    GetConfiguration( ProcomGapped ).SetAutoGapOpenCost( GetAutoGapCosts());
-    GetConfiguration( ProcomGapped ).SetGapOpenCost( GetGapOpenCost());
-    GetConfiguration( ProcomGapped ).SetGapExtendCost( GetGapExtnCost());
-    GetConfiguration( ProcomGapped ).Read();            //read reference parameters
-
-    char    strbuf[BUF_MAX];
-
-    sprintf( strbuf, "Lambda (u/g), %8.4f/%8.4f",   GetConfiguration( ProcomUngapped ).GetLambda(),
-                                                    GetConfiguration( ProcomGapped ).GetLambda());   message( strbuf, false );
-    sprintf( strbuf, "K      (u/g), %8.4f/%8.4f",   GetConfiguration( ProcomUngapped ).GetK(),
-                                                    GetConfiguration( ProcomGapped ).GetK());        message( strbuf, false );
-    sprintf( strbuf, "H      (u/g), %8.4f/%8.4f",   GetConfiguration( ProcomUngapped ).GetH(),
-                                                    GetConfiguration( ProcomGapped ).GetH());        message( strbuf, false );
-    sprintf( strbuf, "Alpha  (u/g), %8.4f/%8.4f",   GetConfiguration( ProcomUngapped ).GetAlpha(),
-                                                    GetConfiguration( ProcomGapped ).GetAlpha());    message( strbuf, false );
-    sprintf( strbuf, "Beta   (u/g), %8.4f/%8.4f",   GetConfiguration( ProcomUngapped ).GetBeta(),
-                                                    GetConfiguration( ProcomGapped ).GetBeta());     message( strbuf );
-
-
-    if( scoreSystem )
-        throw myruntime_error( mystring( "ProfileSearching: Score system has been unexpectedly initialized." ));
-
-    query_gaps.SetGapProbabFactorEvalue( GetGapProbabFactorEvalue());
-    query_gaps.SetGapProbabFactorWeight( GetGapProbabFactorWeight());
-    query_gaps.SetGapProbabFactorShift( GetGapProbabFactorShift());
-
-    query_gaps.SetAutocorrectionNumerator1st( GetAutocorrectionNumerator1st());
-    query_gaps.SetAutocorrectionNumerator2nd( GetAutocorrectionNumerator2nd());
-    query_gaps.SetAutocorrectionLogScale( GetAutocorrectionLogScale());
-    query_gaps.SetAutocorrectionDenomScale( GetAutocorrectionDenomScale());
-    query_gaps.SetConfiguration( GetConfiguration());
+    HitInformation* hit = hitListing[n];
+    size_t          parent;
+
+    while( n ) {
+        parent = ( n - 1 ) >> 1;
+        if( !hitListing[parent]->Precedes( *hit ))
+            break;
+        hitListing[n] = hitListing[parent];
+        n = parent;
+    }
+    hitListing[n] = hit;
+}
 
+// -------------------------------------------------------------------------
+// SiftDown: moves hit down the heap until its children are better
+// -------------------------------------------------------------------------
 
-    dbgaps.SetGapProbabFactorEvalue( GetGapProbabFactorEvalue());
-    dbgaps.SetGapProbabFactorWeight( GetGapProbabFactorWeight());
-    dbgaps.SetGapProbabFactorShift( GetGapProbabFactorShift());
+void ProfileSearching::SiftDown( size_t n )
+{
+    HitInformation* hit = hitListing[n];
+    size_t          child;
+
+    while(( child = ( n << 1 ) + 1 ) < size ) {
+        if( child + 1 < size && hitListing[child]->Precedes( *hitListing[child+1] ))
+            child++;
+        if( !hit->Precedes( *hitListing[child] ))
+            break;
+        hitListing[n] = hitListing[child];
+        n = child;
+    }
+    hitListing[n] = hit;
+}
 
-    dbgaps.SetAutocorrectionNumerator1st( GetAutocorrectionNumerator1st());
-    dbgaps.SetAutocorrectionNumerator2nd( GetAutocorrectionNumerator2nd());
-    dbgaps.SetAutocorrectionLogScale( GetAutocorrectionLogScale());
-    dbgaps.SetAutocorrectionDenomScale( GetAutocorrectionDenomScale());
-    dbgaps.SetConfiguration( GetConfiguration());
+// -------------------------------------------------------------------------
+// Run: Begins searching of the query profile against the database
+// -------------------------------------------------------------------------
 
-    ProcessQuery();
+void ProfileSearching::Run()
+{
+    Prepare();
 
     try{
         //try read database header next
@@ -337,9 +453,15 @@ void ProfileSearching::Run()
 
     } catch( myexception const& ex )
     {
+        if( GetNoShards())
+            throw myruntime_error(( mystring( ex.what()) + "\n" )+ "Only a database of profiles can be sharded.", ex.eclass());
+
+        SearchingWorker worker( this, &query_freq, &query_pssm, &query_gaps, false );
+        SetupGapScheme( worker.dbgaps );
+
         try{
             //maybe multiple alignment in fasta is given
-            FillMatrices( dbfreq, dbpssm, dbgaps, GetDatabase());
+            FillMatrices( worker.dbfreq, worker.dbpssm, worker.dbgaps, GetDatabase());
         } catch( myexception const& ex1 ) {
             throw myruntime_error(( mystring( ex.what()) + "\n" )+ ex1.what(), ex.eclass());
         }
@@ -348,16 +470,20 @@ void ProfileSearching::Run()
         message( "Searching..." );
 
         SetNoSequences( 1 );
-        SetDbSize( dbpssm.GetColumns());
+        SetDbSize( worker.dbpssm.GetColumns());
 
         AbstractScoreMatrix::ComputeLengthAdjustment(
+                        context,
                         GetConfiguration( ProcomGapped ),
                         query_pssm.GetColumns(),
                         GetDbSize(),
                         GetNoSequences()
         );
 
-        ComputationLogicWithProfiles( dbfreq, dbpssm, dbgaps );
+        ComputationLogicWithProfiles( worker, worker.dbfreq, worker.dbpssm, worker.dbgaps, 0, -1 );
+
+        scoreSystem = worker.scoreSystem;
+        worker.scoreSystem = NULL;
 
         PostComputationLogic();
         message( "Finished." );
@@ -368,50 +494,593 @@ void ProfileSearching::Run()
     message( "Reading frequencies..." );
     //read the distinct frequency vectors first
     profile_db.ReadInFrequencies();
+#endif
+
+    PrepareScan();
+    PrefilterProfiles();
+    SelectShard();
+
+    message( "Searching..." );
+
+    if( 1 < GetNoThreads() && scoreSystem && scoreSystem->GetType() == AbstractScoreMatrix::Universal ) {
+        warning( "Score system shared by all profiles is in use: Searching with one thread." );
+        SetNoThreads( 1 );
+    }
+
+    if( GetNoThreads() <= 1 ) {
+        SearchingWorker*    worker = NewWorker( true );
+        try {
+            ScanDatabase( *worker );
+        } catch( myexception const& ) {
+            ReleaseWorker( worker );
+            throw;
+        }
+        ReleaseWorker( worker );
+    }
+    else
+        RunWorkers();
+
+    PostComputationLogic();
+
+    profile_db.Close();
+    message( "Finished." );
+}
+
+// -------------------------------------------------------------------------
+// Prepare: reads parameter configuration and the query; the first step
+//     of the search
+// -------------------------------------------------------------------------
 
+void ProfileSearching::Prepare()
+{
+    GetConfiguration( ProcomUngapped ).SetFilename( GetParamConfigFile());
+    GetConfiguration( ProcomGapped ).SetFilename( GetParamConfigFile());
+
+    //read parameters
+    GetConfiguration( ProcomUngapped ).ReadUngapped();  //read ungapped configuration
+    GetConfiguration( ProcomGapped ).SetAutoGapOpenCost( GetAutoGapCosts());
+    GetConfiguration( ProcomGapped ).SetGapOpenCost( GetGapOpenCost());
+    GetConfiguration( ProcomGapped ).SetGapExtendCost( GetGapExtnCost());
+    GetConfiguration( ProcomGapped ).Read();            //read reference parameters
+
+    char    strbuf[BUF_MAX];
+
+    sprintf( strbuf, "Lambda (u/g), %8.4f/%8.4f",   GetConfiguration( ProcomUngapped ).GetLambda(),
+                                                    GetConfiguration( ProcomGapped ).GetLambda());   message( strbuf, false );
+    sprintf( strbuf, "K      (u/g), %8.4f/%8.4f",   GetConfiguration( ProcomUngapped ).GetK(),
+                                                    GetConfiguration( ProcomGapped ).GetK());        message( strbuf, false );
+    sprintf( strbuf, "H      (u/g), %8.4f/%8.4f",   GetConfiguration( ProcomUngapped ).GetH(),
+                                                    GetConfiguration( ProcomGapped ).GetH());        message( strbuf, false );
+    sprintf( strbuf, "Alpha  (u/g), %8.4f/%8.4f",   GetConfiguration( ProcomUngapped ).GetAlpha(),
+                                                    GetConfiguration( ProcomGapped ).GetAlpha());    message( strbuf, false );
+    sprintf( strbuf, "Beta   (u/g), %8.4f/%8.4f",   GetConfiguration( ProcomUngapped ).GetBeta(),
+                                                    GetConfiguration( ProcomGapped ).GetBeta());     message( strbuf );
+
+
+    if( scoreSystem )
+        throw myruntime_error( mystring( "ProfileSearching: Score system has been unexpectedly initialized." ));
+
+    SetupGapScheme( query_gaps );
+
+    ProcessQuery();
+
+    db_ordinal = 0;
+    scan_aborted = false;
+}
+
+// -------------------------------------------------------------------------
+// PrepareScan: prepares for scanning of the opened database; frequencies
+//     are supposed to be read from it already
+// -------------------------------------------------------------------------
+
+void ProfileSearching::PrepareScan()
+{
+#ifdef  UNIVERSALSCORES
     message( "Computing scores..." );
     CreateScoreSystem();
 #endif
 
-    message( "Searching..." );
-
-    SetNoSequences( profile_db.GetNoSequences());
-    SetDbSize( profile_db.GetDbSize());
+    SetNoSequences( GetProfileDb().GetNoSequences());
+    SetDbSize( GetProfileDb().GetDbSize());
 
     AbstractScoreMatrix::ComputeLengthAdjustment(
+                    context,
                     GetConfiguration( ProcomGapped ),
                     query_pssm.GetColumns(),
                     GetDbSize(),
                     GetNoSequences()
     );
+}
+
+// -------------------------------------------------------------------------
+// PrefilterProfiles: selects the profiles to search by looking up words
+//     of the query in the column-word index of the database; all profiles
+//     are searched if the index is not in use or not found
+// -------------------------------------------------------------------------
+
+void ProfileSearching::PrefilterProfiles()
+{
+    const ColumnWordIndex*  index;
+    size_t                  nocands;
+    char                    strbuf[BUF_MAX];
+
+    if( candidates ) {
+        free( candidates );
+        candidates = NULL;
+    }
+
+    if( GetIndexNoSeeds() <= 0 )
+        return;
+
+    if( !file_exists( GetProfileDb().GetIndexDbName()))
+        return;
+
+    if( !GetProfileDb().GetIndex()) {
+        //the index of the database shared by a batch of searches is read once
+        message( "Reading index..." );
+        GetProfileDb().ReadInIndex();
+    }
+    index = GetProfileDb().GetIndex();
+
+    if( !index || index->GetNoProfiles() != GetProfileDb().GetNoSequences()) {
+        warning( "Column-word index does not match the database: Searching all profiles." );
+        return;
+    }
+
+    candidates = ( char* )malloc( sizeof( char ) * ( index->GetNoProfiles() + 1 ));
+    if( !candidates )
+        throw myruntime_error( mystring( "ProfileSearching: Not enough memory." ));
+
+    nocands = index->Prefilter( query_pssm, GetIndexWordScore(), GetIndexNoSeeds(), candidates );
+
+    sprintf( strbuf, "Profiles selected by index, %9zu of %zu", nocands, index->GetNoProfiles());
+    message( strbuf );
+}
+
+// -------------------------------------------------------------------------
+// GetCacheName: makes the name of the file of the cached score system;
+//     the name is the key made of the fingerprints of the score system
+// -------------------------------------------------------------------------
+
+void ProfileSearching::GetCacheName( const UniversalScoreMatrix* universal, mystring& name ) const
+{
+    char    strbuf[BUF_MAX];
+
+    if( !universal || !GetCacheDirectory())
+        throw myruntime_error( mystring( "ProfileSearching: Unable to make name of cached score system." ));
+
+    sprintf( strbuf, "%016llx.uss", ( unsigned long long )universal->GetCacheKey());
+    name = GetCacheDirectory();
+    if( name.empty() || name[name.length()-1] != DIRSEP )
+        name += DIRSEPSTR;
+    name += strbuf;
+}
+
+// -------------------------------------------------------------------------
+// GetOptionsFingerprint: hash of the options of the search that affect
+//     the query profile and the scaling of the score system, including
+//     those not passed to the score system, e.g., the scaling of masked
+//     positions (SCALEDOWN)
+// -------------------------------------------------------------------------
+
+Uint64 ProfileSearching::GetOptionsFingerprint() const
+{
+    Uint64  hash = FNVBASIS;
+    double  values[9];
+
+    values[0] = GetMaskscalePercents();
+    values[1] = GetInformationThreshold();
+    values[2] = GetGapOpenCost();
+    values[3] = GetGapExtnCost();
+    values[4] = GetFixedCosts();
+    values[5] = autogapcosts;
+    values[6] = autocorrwinsize;
+    values[7] = GetComputeDELETEstates();
+    values[8] = GetPseudoCountWeight();
+    hash = fnvhashing( values, sizeof( double ) * 9, hash );
+
+    values[0] = GetHCSeg();
+    values[1] = GetHCWinLength();
+    values[2] = GetHCLowEntropy();
+    values[3] = GetHCHighEntropy();
+    values[4] = GetUsingSeg();
+    values[5] = GetSegWinLength();
+    values[6] = GetSegLowEntropy();
+    values[7] = GetSegHighEntropy();
+    values[8] = GetSegDistance();
+    hash = fnvhashing( values, sizeof( double ) * 9, hash );
+
+    values[0] = GetUsingSeqSeg();
+    values[1] = GetSeqSegWinLength();
+    values[2] = GetSeqSegLowEntropy();
+    values[3] = GetSeqSegHighEntropy();
+    values[4] = GetExtentMinSeqPercentage();
+    values[5] = GetExtentMinWindow();
+    values[6] = GetThicknessNumber();
+    values[7] = GetThicknessPercents();
+    values[8] = GetAutoACcorrection();
+    hash = fnvhashing( values, sizeof( double ) * 9, hash );
+
+    values[0] = GetAutocorrectionNumerator1st();
+    values[1] = GetAutocorrectionNumerator2nd();
+    values[2] = GetAutocorrectionLogScale();
+    values[3] = GetAutocorrectionDenomScale();
+    values[4] = GetGapProbabFactorEvalue();
+    values[5] = GetGapProbabFactorWeight();
+    values[6] = GetGapProbabFactorShift();
+    values[7] = GetMethod();
+    values[8] = GetScaling();
+    hash = fnvhashing( values, sizeof( double ) * 9, hash );
+
+    return hash;
+}
+
+// -------------------------------------------------------------------------
+// ReadScoreSystem: reads the parameters of the scaled score system from
+//     cache; returns false if the score system has not been cached or the
+//     cache file does not match
+// -------------------------------------------------------------------------
+
+bool ProfileSearching::ReadScoreSystem( UniversalScoreMatrix* universal )
+{
+    Serializer  serializer;
+    mystring    name;
+
+    GetCacheName( universal, name );
+
+    if( !file_exists( name.c_str()))
+        return false;
+
+    try {
+        serializer.DeserializeScoreSystem( *universal, name.c_str());
+    } catch( myexception const& ex ) {
+        warning(( mystring( "Cached score system ignored: " ) + ex.what()).c_str());
+        return false;
+    }
+
+    message( "Score system read from cache." );
+    return true;
+}
+
+// -------------------------------------------------------------------------
+// WriteScoreSystem: writes the parameters of the scaled score system to
+//     cache; the file is written under a temporary name first so that
+//     searches running at the same time never read it incomplete
+// -------------------------------------------------------------------------
+
+void ProfileSearching::WriteScoreSystem( const UniversalScoreMatrix* universal )
+{
+    Serializer  serializer;
+    mystring    name, tmpname;
+    char        strbuf[BUF_MAX];
+
+    GetCacheName( universal, name );
+
+    sprintf( strbuf, ".%d.%p.tmp", ( int )getpid(), ( const void* )this );
+    tmpname = name + strbuf;
+
+    try {
+        serializer.SerializeScoreSystem( *universal, tmpname.c_str());
+        if( rename( tmpname.c_str(), name.c_str()) != 0 )
+            throw myruntime_error( mystring( "Unable to rename file." ));
+    } catch( myexception const& ex ) {
+        remove( tmpname.c_str());
+        warning(( mystring( "Score system not cached: " ) + ex.what()).c_str());
+    }
+}
+
+// -------------------------------------------------------------------------
+// SetShard: sets the search to scan the given one of the shards the
+//     database is split into, in order of profiles; statistics are
+//     computed for the whole database all the same
+// -------------------------------------------------------------------------
+
+void ProfileSearching::SetShard( size_t shard, size_t noshards )
+{
+    if( noshards && noshards <= shard )
+        throw myruntime_error( mystring( "ProfileSearching: Invalid shard number." ));
+
+    shard_no = shard;
+    no_shards = noshards;
+}
+
+// -------------------------------------------------------------------------
+// SelectShard: restricts the scan of the opened database to the profiles
+//     of the shard; returns the ordinal number of the profile to begin the
+//     scan with, which numbers hits as in the search of the whole database;
+//     the score system shared by all profiles keeps information of the
+//     previous profile, and it cannot be used to search a shard
+// -------------------------------------------------------------------------
+
+size_t ProfileSearching::SelectShard()
+{
+    size_t  noprofiles, begin, end;
+    char    strbuf[BUF_MAX];
+
+    if( !GetNoShards())
+        return 0;
+
+    if( scoreSystem && scoreSystem->GetType() == AbstractScoreMatrix::Universal )
+        throw myruntime_error( mystring( "Global score system in use: Unable to search a shard of the database." ));
+
+    if( !file_exists( GetProfileDb().GetOffsetsDbName()))
+        throw myruntime_error( mystring( "Offset index of profiles not found: Unable to shard the database." ));
+
+    GetProfileDb().ReadInOffsets();
+
+    noprofiles = GetProfileDb().GetOffsets()->GetNoProfiles();
+    begin = ( size_t )(( Uint64 )noprofiles * GetShardNo() / GetNoShards());
+    end = ( size_t )(( Uint64 )noprofiles * ( GetShardNo() + 1 ) / GetNoShards());
+
+    GetProfileDb().Range( begin, end );
+
+    if( candidates ) {
+        //profiles of other shards are not searched
+        memset( candidates, 0, sizeof( char ) * begin );
+        memset( candidates + end, 0, sizeof( char ) * ( noprofiles - end ));
+    }
+
+    sprintf( strbuf, "Shard %zu of %zu, profiles %zu to %zu",
+            GetShardNo() + 1, GetNoShards(), begin + 1, end );
+    message( strbuf );
+
+    db_ordinal = begin;
+    return db_ordinal;
+}
+
+// -------------------------------------------------------------------------
+// NewWorker: creates a worker to scan the database with; the primary
+//     worker uses the query of this object, the others read their own
+//     copy of it
+// -------------------------------------------------------------------------
+
+SearchingWorker* ProfileSearching::NewWorker( bool primary )
+{
+    SearchingWorker*    worker = NULL;
+
+    if( primary )
+        worker = new SearchingWorker( this, &query_freq, &query_pssm, &query_gaps, false );
+    else {
+        FrequencyMatrix*    qfreq = new FrequencyMatrix;
+        LogOddsMatrix*      qpssm = new LogOddsMatrix;
+        GapScheme*          qgaps = new GapScheme;
+        if( !qfreq || !qpssm || !qgaps )
+            throw myruntime_error( mystring( "ProfileSearching: Not enough memory." ));
+        worker = new SearchingWorker( this, qfreq, qpssm, qgaps, true );
+        if( worker ) {
+            SetupGapScheme( *qgaps );
+            ProcessQuery( *qfreq, *qpssm, *qgaps );
+        }
+    }
+
+    if( !worker )
+        throw myruntime_error( mystring( "ProfileSearching: Not enough memory." ));
+
+    SetupGapScheme( worker->dbgaps );
+    //score system shared by all subject profiles
+    worker->scoreSystem = scoreSystem;
+    worker->ownscores = false;
+    return worker;
+}
+
+// -------------------------------------------------------------------------
+// ReleaseWorker: destroys the worker; the score system it made is kept
+//     for the footer if there is none yet
+// -------------------------------------------------------------------------
+
+void ProfileSearching::ReleaseWorker( SearchingWorker* worker )
+{
+    if( !worker )
+        return;
+
+    if( worker->ownscores ) {
+        if( !scoreSystem ) {
+            scoreSystem = worker->scoreSystem;
+            worker->scoreSystem = NULL;
+        }
+    }
+    else
+        worker->scoreSystem = NULL;
+
+    delete worker;
+}
+
+// -------------------------------------------------------------------------
+// SetupGapScheme: sets parameters of the gap scheme given by options
+// -------------------------------------------------------------------------
+
+void ProfileSearching::SetupGapScheme( GapScheme& gaps )
+{
+    gaps.SetGapProbabFactorEvalue( GetGapProbabFactorEvalue());
+    gaps.SetGapProbabFactorWeight( GetGapProbabFactorWeight());
+    gaps.SetGapProbabFactorShift( GetGapProbabFactorShift());
+
+    gaps.SetAutocorrectionNumerator1st( GetAutocorrectionNumerator1st());
+    gaps.SetAutocorrectionNumerator2nd( GetAutocorrectionNumerator2nd());
+    gaps.SetAutocorrectionLogScale( GetAutocorrectionLogScale());
+    gaps.SetAutocorrectionDenomScale( GetAutocorrectionDenomScale());
+    gaps.SetConfiguration( GetConfiguration());
+}
+
+// -------------------------------------------------------------------------
+// NextProfile: reads the next profile from the database into the worker's
+//     matrices; returns false when the end of the database is reached or
+//     the scan has been aborted; profiles not selected by the index are
+//     skipped
+// -------------------------------------------------------------------------
+
+bool ProfileSearching::NextProfile( SearchingWorker& worker, size_t* ordinal, long* position )
+{
+    const ColumnWordIndex*  index = GetProfileDb().GetIndex();
+    bool                    got = false;
+    long                    pos;
+
+    pthread_mutex_lock( &db_mutex );
+    try {
+        if( !scan_aborted && candidates && index ) {
+            while( db_ordinal < index->GetNoProfiles() && !candidates[db_ordinal] )
+                db_ordinal++;
+            if( db_ordinal < index->GetNoProfiles()) {
+                pos = index->GetProfilePosition( db_ordinal );
+                if( position )
+                    *position = pos;
+                got = GetProfileDb().Read( pos, worker.dbfreq, worker.dbpssm, worker.dbgaps,
+                                       GetGapOpenCost(), GetGapExtnCost(), GetFixedCosts());
+                if( got && ordinal )
+                    *ordinal = db_ordinal;
+                db_ordinal++;
+            }
+        }
+        else if( !scan_aborted ) {
+            if( position )
+                *position = GetProfileDb().GetPosition();
+            got = GetProfileDb().Next( worker.dbfreq, worker.dbpssm, worker.dbgaps,
+                                   GetGapOpenCost(), GetGapExtnCost(), GetFixedCosts());
+            if( got && ordinal )
+                *ordinal = db_ordinal++;
+        }
+    } catch( myexception const& ex ) {
+        pthread_mutex_unlock( &db_mutex );
+        throw myruntime_error( ex.what(), ex.eclass());
+    }
+    pthread_mutex_unlock( &db_mutex );
+    return got;
+}
+
+// -------------------------------------------------------------------------
+// ScanDatabase: processes profiles read from the database until the end
+//     of it
+// -------------------------------------------------------------------------
+
+void ProfileSearching::ScanDatabase( SearchingWorker& worker )
+{
+    size_t  ordinal = 0;
+    long    position = -1;
 
     //while not having reached the end of database
-    while( profile_db.Next( dbfreq, dbpssm, dbgaps, GetGapOpenCost(), GetGapExtnCost(), GetFixedCosts())) {
-        ComputationLogicWithProfiles( dbfreq, dbpssm, dbgaps );
+    while( NextProfile( worker, &ordinal, &position ))
+        ComputationLogicWithProfiles( worker, worker.dbfreq, worker.dbpssm, worker.dbgaps, ordinal, position );
+}
+
+// -------------------------------------------------------------------------
+// ScanThread: entry point of a worker thread
+// -------------------------------------------------------------------------
+
+void* ProfileSearching::ScanThread( void* arg )
+{
+    SearchingWorker*    worker = ( SearchingWorker* )arg;
+
+    if( !worker || !worker->owner )
+        return NULL;
+
+    try {
+        worker->owner->ScanDatabase( *worker );
+
+    } catch( myexception const& ex ) {
+        worker->SetError( ex.what(), ex.eclass());
+        pthread_mutex_lock( &worker->owner->db_mutex );
+        worker->owner->scan_aborted = true;
+        pthread_mutex_unlock( &worker->owner->db_mutex );
     }
+    return NULL;
+}
 
-    PostComputationLogic();
+// -------------------------------------------------------------------------
+// RunWorkers: scans the database with the pool of threads; each worker
+//     has its own copy of the query, subject profile, and score system
+// -------------------------------------------------------------------------
 
-    profile_db.Close();
-    message( "Finished." );
+void ProfileSearching::RunWorkers()
+{
+    int                 nthreads = GetNoThreads();
+    SearchingWorker**   workers = ( SearchingWorker** )malloc( sizeof( void* ) * nthreads );
+    int                 nstarted = 0;
+    int                 n;
+
+    if( !workers )
+        throw myruntime_error( mystring( "ProfileSearching: Not enough memory." ));
+
+    memset( workers, 0, sizeof( void* ) * nthreads );
+
+    try {
+        for( n = 0; n < nthreads; n++ )
+            workers[n] = NewWorker( n == 0 );
+
+        for( n = 0; n < nthreads; n++ ) {
+            if( pthread_create( &workers[n]->thread, NULL, &ScanThread, workers[n] ) != 0 ) {
+                pthread_mutex_lock( &db_mutex );
+                scan_aborted = true;
+                pthread_mutex_unlock( &db_mutex );
+                workers[n]->SetError( "ProfileSearching: Failed to create thread.", NOCLASS );
+                break;
+            }
+            nstarted++;
+        }
+    } catch( myexception const& ) {
+        for( n = 0; n < nstarted; n++ )
+            pthread_join( workers[n]->thread, NULL );
+        for( n = 0; n < nthreads; n++ )
+            ReleaseWorker( workers[n] );
+        free( workers );
+        throw;
+    }
+
+    for( n = 0; n < nstarted; n++ )
+        pthread_join( workers[n]->thread, NULL );
+
+    mystring    errmsg;
+    int         errcls = NOCLASS;
+
+    for( n = 0; n < nthreads; n++ ) {
+        if( errmsg.empty() && workers[n]->GetError()) {
+            errmsg = workers[n]->GetError();
+            errcls = workers[n]->GetErrorClass();
+        }
+        ReleaseWorker( workers[n] );
+    }
+    free( workers );
+
+    if( !errmsg.empty())
+        throw myruntime_error( errmsg, errcls );
 }
 
 // -------------------------------------------------------------------------
 // ComputationLogicWithProfiles: performs computations with profiles; this
 //     includes profile alignment, statistical significance calculations and
-//     gathering of information for output
+//     gathering of information for output; when the hit to render is
+//     given, the alignment is made again to produce its text
 // -------------------------------------------------------------------------
 
-void ProfileSearching::ComputationLogicWithProfiles( FrequencyMatrix& freq, LogOddsMatrix& pssm, GapScheme& gaps )
+void ProfileSearching::ComputationLogicWithProfiles(
+    SearchingWorker& worker,
+    FrequencyMatrix& freq, LogOddsMatrix& pssm, GapScheme& gaps,
+    size_t ordinal, long position, HitInformation* render )
 {
 //  gaps.OutputGapScheme();
 //  freq.OutputMatrix();
 //  pssm.OutputMatrix();
 
     double  expscore = 0.0;
+    double  infothresh = 0.0;
+
+    //score system shared by all profiles keeps the information threshold
+    //set for the previous profile; the same is to be used to make the
+    //alignment again
+    if( worker.scoreSystem ) {
+        if( render )
+            worker.scoreSystem->SetInformationThreshold( render->GetInfoThreshold());
+        infothresh = worker.scoreSystem->GetInformationThreshold();
+    }
+
+    //gap costs adjusted by the e-value of the previous pair are not to be
+    //carried over; with automatically computed costs, they are reset
+    //when adjusted, but fixed costs are prepared only
+    gaps.ResetContext();
+    worker.query_gaps->ResetContext();
 
     try{
-        if( !PreprocessSubject( freq, pssm, gaps, true/*first call*/ ))
+        if( !PreprocessSubject( worker, freq, pssm, gaps, true/*first call*/,
+                                render? render->GetParameterK(): -1.0 ))
             return;
     } catch( myexception const& ex )
     {
@@ -422,73 +1091,111 @@ void ProfileSearching::ComputationLogicWithProfiles( FrequencyMatrix& freq, LogO
         throw myruntime_error( ex.what(), ex.eclass());
     }
 
+    AbstractScoreMatrix*    scsystem = worker.scoreSystem;
+
     ProfileAlignment    proaln(
-            query_freq, query_pssm, query_gaps,
+            *worker.query_freq, *worker.query_pssm, *worker.query_gaps,
             freq,       pssm,       gaps,
-            GetScoreSystem(),
+            scsystem,
             UngappedAlignments()
     );
 
+    bool    secondpass = GetAutoACcorrection() && scsystem;
+
     //run alignment algorithm...
-    proaln.Run();
+    //the path of the final alignment is made only if its score may pass
+    //the e-value threshold
+    if( secondpass || render )
+        proaln.Run();
+    else if( !proaln.RunWithThreshold( GetEvalueThreshold()))
+        return;
 
     //{{2nd pass if needed
-    if( GetAutoACcorrection() && GetScoreSystem()) {
+    if( secondpass ) {
         gaps.AdjustContextByEval(
 //                 proaln.GetRawExpectation(),
                 proaln.GetExpectPerAlignment(),
-                GetScoreSystem()->GetEntropy(),
-                GetScoreSystem()->GetSbjctInfContent());
-        query_gaps.AdjustContextByEval(
+                scsystem->GetEntropy(),
+                scsystem->GetSbjctInfContent());
+        worker.query_gaps->AdjustContextByEval(
 //                 proaln.GetRawExpectation(),
                 proaln.GetExpectPerAlignment(),
-                GetScoreSystem()->GetEntropy(),
-                GetScoreSystem()->GetQueryInfContent());
-//         GetScoreSystem()->SetInfoThresholdByEval( proaln.GetRawExpectation());
-        GetScoreSystem()->SetInfoThresholdByEval( proaln.GetExpectPerAlignment());
-        PreprocessSubject( freq, pssm, gaps, false );
-        proaln.Run();
+                scsystem->GetEntropy(),
+                scsystem->GetQueryInfContent());
+//         scsystem->SetInfoThresholdByEval( proaln.GetRawExpectation());
+        scsystem->SetInfoThresholdByEval( proaln.GetExpectPerAlignment());
+        PreprocessSubject( worker, freq, pssm, gaps, false );
+        if( render )
+            proaln.Run();
+        else if( !proaln.RunWithThreshold( GetEvalueThreshold()))
+            return;
     }
     //}}
 
     //if alignment length is shorter than the expected mean length given
     //computed statistical parameters
     if( 0.0 < GetExpectForAlnLength() &&
-        proaln.GetExpectation() < GetExpectForAlnLength())
+        proaln.GetExpectation() < GetExpectForAlnLength()) {
         if( proaln.GetAlnLength() <
-            GetScoreSystem()->GetMeanLengthGivenExpectation( GetExpectForAlnLength(), &expscore ))
-                if( expscore < proaln.GetScore())
+            scsystem->GetMeanLengthGivenExpectation( GetExpectForAlnLength(), &expscore )) {
+                if( expscore < proaln.GetScore()) {
                     if( expscore < proaln.GetScore() - expscore )
                         proaln.AdjustScore( proaln.GetScore() - expscore );
                     else
                         proaln.AdjustScore( expscore );
+                }
+        }
+    }
 
 
+    if( render ) {
+        size_t  title_size  = pssm.GetMinimumRequiredSizeForDescription();
+        size_t  aln_size = proaln.GetMinimumRequiredSizeForAlignment();
+        size_t  total_size = title_size + aln_size; //total size required to contain full alignment information + desc.
+
+        char*   annotatn = ( char* )malloc( pssm.GetMaxAnnotationWidth());
+        char*   fullinfo = ( char* )malloc( total_size );
+
+        if( !annotatn || !fullinfo ) {
+            if( annotatn ) free( annotatn );
+            if( fullinfo ) free( fullinfo );
+            throw myruntime_error( mystring( "Not enough memory." ));
+        }
+
+        //printing routines use static buffers; hits are rendered by one thread
+        pssm.PrintAnnotation( annotatn );
+        proaln.Print( fullinfo, ToShowPars());
+
+        render->SetAnnotation( annotatn );
+        render->SetFullAlignment( fullinfo );
+        return;
+    }
+
     //if expectation is above threshold used
     if( GetEvalueThreshold() < proaln.GetExpectation() ||
         GetEvalueThreshold() < proaln.GetReferenceExpectation() ||
         proaln.GetScore() <= 0 )
         return;
 
-    size_t  title_size  = pssm.GetMinimumRequiredSizeForDescription();
-    size_t  aln_size = proaln.GetMinimumRequiredSizeForAlignment();
-    size_t  total_size = title_size + aln_size; //total size required to contain full alignment information + desc.
-
-
-    char*   annotatn = ( char* )malloc( pssm.GetMaxAnnotationWidth());
-    char*   fullinfo = ( char* )malloc( total_size );
+    HitInformation* hit =
+        new HitInformation( proaln.GetScore(), proaln.GetExpectation(),
+                    proaln.GetReferenceExpectation(), ordinal, position );
 
-    if( !annotatn || !fullinfo )
+    if( !hit )
         throw myruntime_error( mystring( "Not enough memory." ));
 
-    pssm.PrintAnnotation( annotatn );
-    proaln.Print( fullinfo, ToShowPars());
+    hit->SetInfoThreshold( infothresh );
+    hit->SetParameterK( scsystem? scsystem->GetK(): -1.0 );
 
-    HitInformation* hit =
-        new HitInformation( proaln.GetScore(), proaln.GetExpectation(),
-                    proaln.GetReferenceExpectation(), annotatn, fullinfo );
+    pthread_mutex_lock( &hit_mutex );
+    try {
+        Push( hit );
 
-    Push( hit );
+    } catch( myexception const& ex ) {
+        pthread_mutex_unlock( &hit_mutex );
+        throw myruntime_error( ex.what(), ex.eclass());
+    }
+    pthread_mutex_unlock( &hit_mutex );
 
 //  proaln.OutputScoringMatrix(); //
 }
@@ -501,14 +1208,20 @@ void ProfileSearching::PostComputationLogic()
 {
     FILE*   fp = stdout;
 
+    QSortHits();
+    RenderHits();
+
+    if( GetNoShards()) {
+        WritePartialHits();
+        return;
+    }
+
     if( GetOutput() && strlen( GetOutput()))
         fp = fopen( GetOutput(), "w" );
 
     if( fp == NULL )
         throw myruntime_error( mystring( "Failed to open file for writing." ));
 
-    QSortHits();
-
     PrintSearchingHeader( fp );
     PrintHits( fp );
     PrintSearchingFooter( fp );
@@ -517,6 +1230,113 @@ void ProfileSearching::PostComputationLogic()
         fclose( fp );
 }
 
+// -------------------------------------------------------------------------
+// WritePartialHits: writes the hits of the shard searched together with
+//     the text of the header and footer to the output, so that the lists
+//     of all shards can be merged into the output of the whole database
+// -------------------------------------------------------------------------
+
+void ProfileSearching::WritePartialHits()
+{
+    PartialHitList  partial( GetShardNo(), GetNoShards());
+
+    partial.SetLimits( GetHitlistLimit(), GetNoHitsThreshold(), GetNoAlnsThreshold(), GetEvalueThreshold());
+    partial.SetHeaderText( PrintToText( &ProfileSearching::PrintSearchingHeader ));
+    partial.SetFooterText( PrintToText( &ProfileSearching::PrintSearchingFooter ), scoreSystem != NULL );
+
+    for( size_t h = 0; h < GetHitlistSize(); h++ )
+        partial.AddHit( *GetHitAt( h ));
+
+    partial.Write( GetOutput());
+}
+
+// -------------------------------------------------------------------------
+// PrintToText: returns the text printed by the given method; memory is
+//     allocated by malloc
+// -------------------------------------------------------------------------
+
+char* ProfileSearching::PrintToText( void ( ProfileSearching::*print )( FILE* ))
+{
+    FILE*   fp = tmpfile();
+    char*   text = NULL;
+    long    size;
+
+    if( fp == NULL )
+        throw myruntime_error( mystring( "ProfileSearching: Failed to create temporary file." ));
+
+    ( this->*print )( fp );
+
+    size = ftell( fp );
+    if( 0 <= size )
+        text = ( char* )malloc( sizeof( char ) * ( size + 1 ));
+
+    if( text ) {
+        rewind( fp );
+        if( fread( text, sizeof( char ), size, fp ) != ( size_t )size ) {
+            free( text );
+            text = NULL;
+        }
+        else
+            text[size] = 0;
+    }
+
+    fclose( fp );
+
+    if( !text )
+        throw myruntime_error( mystring( "ProfileSearching: Failed to print text." ));
+    return text;
+}
+
+// -------------------------------------------------------------------------
+// RenderHits: reads the subject profiles of the hits to be output again
+//     and aligns them with the query to produce the text of the hits
+// -------------------------------------------------------------------------
+
+void ProfileSearching::RenderHits()
+{
+    size_t  nohits = GetHitlistSize();
+
+    if( !nohits )
+        return;
+
+    if( GetHitlistLimit() < nohits )
+        nohits = GetHitlistLimit();
+
+    SearchingWorker*    worker = NewWorker( true );
+    HitInformation*     hit = NULL;
+    bool                got = false;
+    double              infothresh = scoreSystem? scoreSystem->GetInformationThreshold(): 0.0;
+
+    try {
+        for( size_t h = 0; h < nohits; h++ ) {
+            hit = GetHitAt( h );
+            if( hit->GetPosition() < 0 ) {
+                //subject was given as multiple alignment
+                FillMatrices( worker->dbfreq, worker->dbpssm, worker->dbgaps, GetDatabase());
+                got = true;
+            }
+            else
+                got = GetProfileDb().Read( hit->GetPosition(), worker->dbfreq, worker->dbpssm, worker->dbgaps,
+                                           GetGapOpenCost(), GetGapExtnCost(), GetFixedCosts());
+            if( !got )
+                throw myruntime_error( mystring( "ProfileSearching: Failed to read profile of the hit." ));
+
+            ComputationLogicWithProfiles( *worker, worker->dbfreq, worker->dbpssm, worker->dbgaps,
+                                          hit->GetOrdinal(), hit->GetPosition(), hit );
+
+            if( !hit->GetAnnotation() || !hit->GetFullAlignment())
+                throw myruntime_error( mystring( "ProfileSearching: Failed to reproduce alignment of the hit." ));
+        }
+    } catch( myexception const& ) {
+        ReleaseWorker( worker );
+        throw;
+    }
+    ReleaseWorker( worker );
+
+    if( scoreSystem )
+        scoreSystem->SetInformationThreshold( infothresh );
+}
+
 // -------------------------------------------------------------------------
 // PrintSearchingHeader: Prints general information related to the query and
 //     database
@@ -550,7 +1370,7 @@ void ProfileSearching::PrintSearchingHeader( FILE* fp )
 
     fprintf( fp, "\n\n" );
     fprintf( fp, " Database:\n" );
-    fprintf( fp, "%s\n", my_basename( profile_db.GetDbName()));
+    fprintf( fp, "%s\n", my_basename( GetProfileDb().GetDbName()));
 
     
     fprintf( fp, "%s%d profiles\n%s%llu total positions\n\n\n",
@@ -564,6 +1384,17 @@ void ProfileSearching::PrintSearchingHeader( FILE* fp )
 // -------------------------------------------------------------------------
 
 void ProfileSearching::PrintHits( FILE* fp )
+{
+    PrintHits( fp, hitListing, GetHitlistSize(),
+               GetNoHitsThreshold(), GetNoAlnsThreshold(), GetEvalueThreshold());
+}
+
+// PrintHits: prints the given hits in the order they are given; the
+//     numbers of hits to print annotations and alignments for and the
+//     e-value threshold of the search are given
+//
+void ProfileSearching::PrintHits(
+    FILE* fp, HitInformation** hits, size_t nohits, int nohitsthr, int noalnsthr, double evalthr )
 {
     if( fp == NULL )
         return;
@@ -573,8 +1404,8 @@ void ProfileSearching::PrintHits( FILE* fp )
     const char* nohitstitle = " No profiles found below the e-value threshold";
     size_t      padding = width - strlen( title );
 
-    if( !GetHitlistSize()) {
-        fprintf( fp, "%s of %g.\n\n\n", nohitstitle, GetEvalueThreshold());
+    if( !nohits ) {
+        fprintf( fp, "%s of %g.\n\n\n", nohitstitle, evalthr );
         return;
     }
 
@@ -582,9 +1413,9 @@ void ProfileSearching::PrintHits( FILE* fp )
     for( size_t n = 0; n < padding; n++ ) fprintf( fp, " " );
     fprintf( fp, " %7s %7s\n\n", "Score", "E-value" );
 
-    for( size_t h = 0; h < GetHitlistSize() && ( int )h < GetNoHitsThreshold(); h++ )
+    for( size_t h = 0; h < nohits && ( int )h < nohitsthr; h++ )
     {
-        const HitInformation*   hit = GetHitAt( h );
+        const HitInformation*   hit = hits[h];
         //annotation will never be null
         size_t                  alength = strlen( hit->GetAnnotation());
 
@@ -600,9 +1431,9 @@ void ProfileSearching::PrintHits( FILE* fp )
     fprintf( fp, "\n\n" );
 
 
-    for( size_t h = 0; h < GetHitlistSize() && ( int )h < GetNoAlnsThreshold(); h++ )
+    for( size_t h = 0; h < nohits && ( int )h < noalnsthr; h++ )
     {
-        const HitInformation*   hit = GetHitAt( h );
+        const HitInformation*   hit = hits[h];
         fprintf( fp, "%s\n", hit->GetFullAlignment());
     }
 }
@@ -617,8 +1448,8 @@ void ProfileSearching::PrintSearchingFooter( FILE* fp )
     if( fp == NULL )
         return;
 
-    size_t  length = ScoringMatrix::GetDeltaLength();       //length adjustment
-    Uint64  sspace = ScoringMatrix::GetSearchSpace();       //effective search space
+    size_t  length = context.GetDeltaLength();              //length adjustment
+    Uint64  sspace = context.GetSearchSpace();              //effective search space
 
     int     eff_query_length = query_pssm.GetColumns() - length;
     Int64   eff_db_length = GetDbSize() - GetNoSequences() * length;
@@ -649,25 +1480,34 @@ void ProfileSearching::PrintSearchingFooter( FILE* fp )
 }
 
 // -------------------------------------------------------------------------
-// ProcessQuery: Reads query profile from file and processes it
+// ProcessQuery: Reads query profile from file and processes it; the data
+//     of the query used for each subject profile are computed once here
 // -------------------------------------------------------------------------
 
 void ProfileSearching::ProcessQuery()
 {
-    FillMatrices( query_freq, query_pssm, query_gaps, GetInput());
+    ProcessQuery( query_freq, query_pssm, query_gaps );
+    querycontext.Build( query_freq, query_pssm, GetThicknessNumber(), GetThicknessPercents());
+}
+
+// ProcessQuery: reads query profile into the given matrices
+//
+void ProfileSearching::ProcessQuery( FrequencyMatrix& qfreq, LogOddsMatrix& qpssm, GapScheme& qgaps )
+{
+    FillMatrices( qfreq, qpssm, qgaps, GetInput());
 
     if( GetUsingSeg()) {
         //SEG logic
         SEGProfile  segpro(
-                query_freq,
-                query_pssm,
+                qfreq,
+                qpssm,
                 GetSegWinLength(),
                 GetSegLowEntropy(),
                 GetSegHighEntropy()
         );
         segpro.SetDistance( GetSegDistance());
         segpro.Run();
-        segpro.MaskSeggedPositions( query_freq, query_pssm, query_gaps );
+        segpro.MaskSeggedPositions( qfreq, qpssm, qgaps );
     }
 }
 
@@ -753,90 +1593,14 @@ void ProfileSearching::FillMatrices(
 }
 
 // -------------------------------------------------------------------------
-// qsort: this quick sort implementation is from 'Numerical recipes in C'
-// Avoiding recursion makes the implementation much faster.
-// QS_MIN is the size of subarrays sorted by straight insertion.
-// QNSTACK is the required auxiliary storage whose size should be at least
-// 2 log2 N
+// QSortHits: sorts hits by e-value; hits of equal e-values are ordered as
+//     the subject profiles in the database, so that the result does not
+//     depend on the number of threads used
 // -------------------------------------------------------------------------
 
-#define SWAP( a, b ) temp = ( a ); ( a ) = ( b ); ( b ) = temp;
-#define QS_MIN 7
-#define QNSTACK 100
-
 void ProfileSearching::QSortHits()
 {
-    size_t  n = GetHitlistSize();
-
-    if( !n )
+    if( GetHitlistSize() < 2 )
         return;
-
-    int     lpos = 0;                           //left position
-    int     rpos = ( int )n - 1;                //right position
-    int     i, j, k;
-    int     s = 0;                              //stack iterator
-    int     stack[QNSTACK+1];                   //position stack
-    HitInformation* hit, *temp;
-
-    for(;;) {
-        if( 1|| rpos - lpos < QS_MIN ) {                    //insertion sort when subarray small enough.
-            for( j = lpos + 1; j <= rpos; j++ ) {
-                hit = GetHitAt( j );
-                for( i = j - 1; i >= lpos; i-- ) {
-                    if( !( *hit < *GetHitAt( i )))
-                        break;
-                    GetHitAt( i+1 ) = GetHitAt( i );
-                }
-                GetHitAt( i+1 ) = hit;
-            }
-            if( s == 0 ) break;
-            rpos = stack[s--];                          //pop stack and begin a new round of partitioning
-            lpos = stack[s--];
-
-        } else {
-            k = ( lpos + rpos ) >> 1;       //choose median of left, center, and right elements as partitioning element hit
-            SWAP( GetHitAt( k ), GetHitAt( lpos+1 ));   //also rearrange so that hit[lpos] <= hit[lpos+1] <= hit[rpos]
-
-            if( *GetHitAt( rpos ) < *GetHitAt( lpos )) {
-                SWAP( GetHitAt( lpos ), GetHitAt( rpos ));
-            }
-            if( *GetHitAt( rpos ) < *GetHitAt( lpos+1 )) {
-                SWAP( GetHitAt( lpos+1 ), GetHitAt( rpos ));
-            }
-            if( *GetHitAt( lpos+1 ) < *GetHitAt( lpos )) {
-                SWAP( GetHitAt( lpos ), GetHitAt( lpos+1 ));
-            }
-
-            i = lpos + 1;                           //initialize pointers for partitioning
-            j = rpos;
-            hit = GetHitAt( lpos+1 );               //partitioning element
-
-            for(;;) {
-                do { i++; } while ( *GetHitAt( i ) < *hit );//scan up to find element > hit
-                do { j--; } while ( *hit < *GetHitAt( j )); //scan down to find element < hit
-                if( j < i ) break;                          //pointers crossed; partitioning complete
-                SWAP( GetHitAt( i ), GetHitAt( j ));
-            }
-
-            GetHitAt( lpos+1 ) = GetHitAt( j );             //insert partitioning element
-            GetHitAt( j ) = hit;
-            s += 2;
-
-            if( s > QNSTACK ) {
-                error( "Sort of e-values failed: Pre-allocated stack size is too small." );
-                break;
-            }
-
-            //push pointers to larger subarray on stack, process smaller subarray immediately
-            if( rpos - i + 1 >= j - lpos ) {
-                stack[s] = rpos;
-                stack[s-1] = i;
-                rpos = j - 1;
-            } else {
-                stack[s] = j - 1;
-                stack[s-1] = lpos;
-                lpos = i;
-            }
-        }
-    }
+    qsort( hitListing, GetHitlistSize(), sizeof( HitInformation* ), &HitInformation::Compare );
 }
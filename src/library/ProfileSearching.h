@@ -8,6 +8,8 @@
 #ifndef __ProfileSearching__
 #define __ProfileSearching__
 
+#include <pthread.h>
+
 #include "debug.h"
 #include "types.h"
 #include "compdef.h"
@@ -22,6 +24,8 @@
 #include "AdjustedScoreMatrix.h"
 #include "UniversalScoreMatrix.h"
 #include "Configuration.h"
+#include "SearchContext.h"
+#include "QueryContext.h"
 
 #include "ProfileAlignment.h"
 
@@ -31,13 +35,18 @@
 // _________________________________________________________________________
 // Class HitInformation
 //
+// Hit found while searching; the text of annotation and alignment is
+// produced only for the hits to be output, after the search has finished
+//
 
 class HitInformation {
 public:
-    HitInformation( double sc, double eval, double refeval, char* annot, char* fullinfo, bool destroy = true );
+    HitInformation( double sc, double eval, double refeval, size_t ordinal, long position, bool destroy = true );
     ~HitInformation();
 
     bool        operator<( const HitInformation& ) const;
+    bool        Precedes( const HitInformation& ) const;
+    static int  Compare( const void*, const void* );    //comparison of pointers to hits for qsort
 
     double      GetScore() const        { return score; }
     double      GetEvalue() const       { return evalue; }
@@ -46,6 +55,18 @@ public:
     const char* GetAnnotation() const   { return annotation; }
     const char* GetFullAlignment() const{ return fullalignment; }
 
+    void        SetAnnotation( char* );
+    void        SetFullAlignment( char* );
+
+    size_t      GetOrdinal() const      { return ordinal; }
+    long        GetPosition() const     { return position; }
+
+    double      GetInfoThreshold() const        { return infothreshold; }
+    void        SetInfoThreshold( double value ){ infothreshold = value; }
+
+    double      GetParameterK() const           { return parameterK; }
+    void        SetParameterK( double value )   { parameterK = value; }
+
 //     void    SetScore( double value )    { score = value; }
 //     void    SetEvalue( double value )   { evalue = value; }
 
@@ -59,6 +80,57 @@ private:
     char*   annotation;     //short (up to 80 ch.) annotation of the hit
     char*   fullalignment;  //alignment and additional information
     bool    autodestroy;    //whether to deallocate memory used by the class members
+    size_t  ordinal;        //ordinal number of the subject profile in the database
+    long    position;       //position of the subject profile in the database file; -1 if not in the database
+    double  infothreshold;  //information threshold of the score system the subject was processed with
+    double  parameterK;     //ungapped parameter K computed for the pair of profiles; negative if unknown
+};
+
+
+class ProfileSearching;
+class BatchSearching;
+
+// _________________________________________________________________________
+// Class SearchingWorker
+//
+// Private data of one thread scanning the database: query and subject
+// profiles, and the score system made for the current pair of profiles
+//
+
+class SearchingWorker {
+public:
+    SearchingWorker( ProfileSearching*, FrequencyMatrix*, LogOddsMatrix*, GapScheme*, bool ownquery );
+    ~SearchingWorker();
+
+    const char*     GetError() const            { return error.empty()? NULL: error.c_str(); }
+    int             GetErrorClass() const       { return errclass; }
+
+protected:
+    explicit SearchingWorker();
+
+    void            SetError( const char* msg, int ecl ) { error = msg; errclass = ecl; }
+
+private:
+    friend class ProfileSearching;
+    friend class BatchSearching;
+
+    ProfileSearching*       owner;          //search the worker belongs to
+    pthread_t               thread;         //thread identifier
+
+    FrequencyMatrix*        query_freq;     //frequency matrix for the query
+    LogOddsMatrix*          query_pssm;     //PSSM matrix for the query
+    GapScheme*              query_gaps;     //position-specific gap costs for the query
+    bool                    ownquery;       //whether the query matrices are to be deallocated
+
+    FrequencyMatrix         dbfreq;         //subject profile being processed
+    LogOddsMatrix           dbpssm;
+    GapScheme               dbgaps;
+
+    AbstractScoreMatrix*    scoreSystem;    //score system for the query and subject profiles
+    bool                    ownscores;      //whether the score system belongs to the worker
+
+    mystring                error;          //error message if the worker failed
+    int                     errclass;       //class of the error
 };
 
 
@@ -98,6 +170,9 @@ public:
     const char*     GetDatabase() const         { return database_name; }
     const char*     GetOutput() const           { return output_name; }
 
+    const char*     GetCacheDirectory() const               { return cache_dir; }
+    void            SetCacheDirectory( const char* value )  { cache_dir = value; }
+
     double          GetEvalueThreshold() const  { return max_evalue; }
     int             GetNoHitsThreshold() const  { return max_no_hits; }
     int             GetNoAlnsThreshold() const  { return max_no_alns; }
@@ -148,7 +223,7 @@ public:
                         SetSegLowEntropy( lowent );
                         SetSegHighEntropy( highent );
                         SetSegDistance( distance );
-                        ProfileAlignment::SetSEGdistanceThreshold( distance );
+                        context.SetSEGdistanceThreshold( distance );
                     }
     void            SetSeqSegParameters( size_t winlen, double lowent, double highent )  {
                         SetUsingSeqSeg( true );
@@ -239,33 +314,80 @@ public:
     void            SetHSPNoHSPs( int value )                   { hspnohsps_ = value; }
 
 
+    double          GetIndexWordScore() const                   { return idxwordscore_; }
+    void            SetIndexWordScore( double value )           { idxwordscore_ = value; }
+
+    int             GetIndexNoSeeds() const                     { return idxnoseeds_; }
+    void            SetIndexNoSeeds( int value )                { idxnoseeds_ = value; }
+
+
     double          GetExpectForAlnLength() const           { return evalue_alnlength; }
     void            SetExpectForAlnLength( double value )   { evalue_alnlength = value; }
 
+    int             GetNoThreads() const                    { return no_threads; }
+    void            SetNoThreads( int value )               { no_threads = value; }
+
+    size_t          GetShardNo() const                      { return shard_no; }
+    size_t          GetNoShards() const                     { return no_shards; }
+    void            SetShard( size_t shard, size_t noshards );  //search one of the shards of the database
+
     void            PrintMethodName( FILE* fp ) const;          //printing of the method name used in scoring alignments
     void            PrintParameterTable( FILE* ) const;         //printing of parameter table
+                                                                //print hits in the order given
+    static void     PrintHits( FILE*, HitInformation** hits, size_t nohits, int nohitsthr, int noalnsthr, double evalthr );
 
 protected:
+    friend class BatchSearching;
+
     explicit ProfileSearching();
+
+    void                        Prepare();                      //read configuration and query
+    void                        PrepareScan();                  //prepare for scanning of the opened database
+    void                        PrefilterProfiles();            //select profiles to search by the index of the database
+    bool                        IsCandidate( size_t ordinal ) const { return !candidates || candidates[ordinal]; }
+    size_t                      SelectShard();                  //restrict the scan to the shard of the database
                                                                 //create alternative score system given subject profile
-    void                        CreateScoreSystem( const FrequencyMatrix&, const LogOddsMatrix& );
+    void                        CreateScoreSystem( SearchingWorker&, const FrequencyMatrix&, const LogOddsMatrix& );
     void                        CreateScoreSystem();            //create member score system
+    bool                        ReadScoreSystem( UniversalScoreMatrix* );           //read scaled score system from cache
+    void                        WriteScoreSystem( const UniversalScoreMatrix* );    //write scaled score system to cache
+    void                        GetCacheName( const UniversalScoreMatrix*, mystring& ) const;
+    Uint64                      GetOptionsFingerprint() const;  //hash of the search options affecting scaling
     void                        DestroyScoreSystem();           //destroy score system
-    void                        ComputeScoreSystem();           //compute score system if needed
-    void                        ScaleScoreSystem();             //scale score system
-    bool    ScanForHSPs( double minhspscore, int hsplen, int nohsps, int mindist, int* possbjct = NULL, int* posquery = NULL );
+    void                        DestroyScoreSystem( SearchingWorker& );
+    void                        ComputeScoreSystem( AbstractScoreMatrix* );//compute score system if needed
+    void                        ScaleScoreSystem( AbstractScoreMatrix* );  //scale score system
+    bool    ScanForHSPs( AbstractScoreMatrix*,
+                         double minhspscore, int hsplen, int nohsps, int mindist, int* possbjct = NULL, int* posquery = NULL );
     bool                        PreprocessSubject(              //preprocessing of subject profile
-        const FrequencyMatrix&, const LogOddsMatrix&, GapScheme&, bool firstpass );
+        SearchingWorker&, const FrequencyMatrix&, const LogOddsMatrix&, GapScheme&, bool firstpass,
+        double givenK = -1.0 );
 
     const AbstractScoreMatrix*  GetScoreSystem() const  { return scoreSystem; }
     AbstractScoreMatrix*        GetScoreSystem()        { return scoreSystem; }
 
     void                        Realloc( size_t newcap );       //memory reallocation
-    void                        Push( HitInformation* hit );    //push hit into the list
+    void                        Push( HitInformation* hit );    //push hit into the bounded heap of hits
+    void                        SiftUp( size_t );               //heap operations
+    void                        SiftDown( size_t );
+    size_t                      GetHitlistLimit() const;        //number of hits kept
 
     bool                        IsCompatible( GapScheme&, GapScheme& ) const;
-    void                        ComputationLogicWithProfiles( FrequencyMatrix&, LogOddsMatrix&, GapScheme& );
+    void                        ComputationLogicWithProfiles(
+                                    SearchingWorker&, FrequencyMatrix&, LogOddsMatrix&, GapScheme&,
+                                    size_t ordinal, long position, HitInformation* render = NULL );
     void                        PostComputationLogic();
+    void                        WritePartialHits();             //write hits of the shard to be merged
+    char*                       PrintToText( void ( ProfileSearching::*print )( FILE* ));
+    void                        RenderHits();                   //make text of the hits to be output
+
+    void                        SetupGapScheme( GapScheme& );   //set parameters of gap scheme given by options
+    void                        ScanDatabase( SearchingWorker& );   //scan database with one worker
+    SearchingWorker*            NewWorker( bool primary );      //create worker with its own copy of the query
+    void                        ReleaseWorker( SearchingWorker* );
+    void                        RunWorkers();                   //scan database with the pool of workers
+    bool                        NextProfile( SearchingWorker&, size_t* ordinal, long* position );
+    static void*                ScanThread( void* );            //thread entry point
 
 
     void            SetHCSeg( bool value )              { hcseg = value; }
@@ -302,11 +424,15 @@ protected:
     void            SetGapExtnCost( int value )         { gapextncost = value; }
 
     void                        ProcessQuery(); //read query information from the file
+    void                        ProcessQuery( FrequencyMatrix&, LogOddsMatrix&, GapScheme& );
     void                        FillMatrices(   //fill profile matrices by reading and processing information from file
                                     FrequencyMatrix&, LogOddsMatrix&, GapScheme&,
                                     const char* filename );
 
 
+    Database&       GetProfileDb()              { return sharedb? *sharedb: profile_db; }
+    void            SetSharedDb( Database* db ) { sharedb = db; }
+
     size_t          GetNoSequences() const      { return no_sequences; }            //number of sequences in database
     Uint64          GetDbSize() const           { return db_size; }                 //size of database
 
@@ -319,15 +445,18 @@ protected:
     size_t                      GetHitlistCapacity() const  { return capacity; }    //capacity of hitListing
     size_t                      GetHitlistSize() const      { return size; }        //size of hitListing
 
-    void                        QSortHits();                                        //quick sort of hits
+    void                        QSortHits();                                        //sort of hits by e-value
 
 private:
     const char*             paramConfigFile;//full pathname to parameter configuration file
     const char*             input_name;     //input profile's name
     const char*             database_name;  //profile database name
     const char*             output_name;    //output file name, null if standard output
+    const char*             cache_dir;      //directory of cached score systems, null if not in use
     AbstractScoreMatrix*    scoreSystem;    //score system used to align profiles
     Configuration           configuration[NoSchemes];   //parameter configuration
+    SearchContext           context;        //parameters shared by all score systems of the search
+    QueryContext            querycontext;   //data of the query shared by all score systems of the search
 
     double                  max_evalue;     //e-value threshold used for outputing of the alignments
     int                     max_no_hits;    //maximum number of hits to show in the result list
@@ -349,7 +478,7 @@ private:
     bool                    show_pars;      //show statistical significance parameters below the alignments
     bool                    fixed_costs;    //use fixed (not position-specific) gap cost scheme
 
-    HitInformation**        hitListing;     //the resulting hit listing
+    HitInformation**        hitListing;     //the resulting hit listing; heap with the worst hit on top until sorted
     size_t                  capacity;       //capacity of hitListing
     size_t                  size;           //current size of hitListing
 
@@ -358,6 +487,7 @@ private:
     GapScheme               query_gaps;     //position-specific gap costs for the query
 
     Database                profile_db;     //profile database
+    Database*               sharedb;        //database shared with other searches of a batch; NULL otherwise
     size_t                  no_sequences;   //number of sequences within the database
     Uint64                  db_size;        //size of the database
 
@@ -407,9 +537,21 @@ private:
     int                     hspdistance_;           //distance between the HSPs
     int                     hspnohsps_;             //number of HSPs in the diagonal
 
+    double                  idxwordscore_;          //minimum score of query words looked up in the index
+    int                     idxnoseeds_;            //number of word hits in a diagonal required to search a profile
+    char*                   candidates;             //flags of profiles selected to search; NULL if all are searched
+
     double                  evalue_alnlength;       //evalue to compute expected mean alignment length
     bool                    positcorrects;          //whether corrections computed positionally by entropies are to be used
     bool                    autoaccorrection;       //if auto correction for autocorrelation gap cost function is in effect
+
+    int                     no_threads;             //number of threads to scan the database with
+    size_t                  db_ordinal;             //ordinal number of the next profile read from the database
+    size_t                  shard_no;               //number of the shard of the database to search
+    size_t                  no_shards;              //number of shards the database is split into; 0, no sharding
+    bool                    scan_aborted;           //whether one of the workers failed
+    pthread_mutex_t         db_mutex;               //serializes reading of the database
+    pthread_mutex_t         hit_mutex;              //serializes formatting and saving of hits
 };
 
 
@@ -425,6 +567,40 @@ bool HitInformation::operator<( const HitInformation& right ) const
     return GetRefEvalue() < right.GetRefEvalue();
 }
 
+// Precedes: whether the hit is to be output before the given one; hits
+//     of equal e-values are ordered as the profiles in the database
+//
+inline
+bool HitInformation::Precedes( const HitInformation& right ) const
+{
+    if( *this < right )
+        return true;
+    if( right < *this )
+        return false;
+    return GetOrdinal() < right.GetOrdinal();
+}
+
+// SetAnnotation: sets annotation of the hit; memory is to be allocated
+//     by malloc
+//
+inline
+void HitInformation::SetAnnotation( char* annot )
+{
+    if( annotation && autodestroy )
+        free( annotation );
+    annotation = annot;
+}
+
+// SetFullAlignment: sets text of the alignment
+//
+inline
+void HitInformation::SetFullAlignment( char* fullinfo )
+{
+    if( fullalignment && autodestroy )
+        free( fullalignment );
+    fullalignment = fullinfo;
+}
+
 // -------------------------------------------------------------------------
 // CLASS ProfileSearching
 //
@@ -462,6 +638,22 @@ Configuration& ProfileSearching::GetConfiguration( TProcomSchemes ps )
     return configuration[ps];
 }
 
+// -------------------------------------------------------------------------
+// GetHitlistLimit: maximum number of hits kept while searching; other
+//     hits are never output
+//
+inline
+size_t ProfileSearching::GetHitlistLimit() const
+{
+    int limit = GetNoHitsThreshold();
+
+    if( limit < GetNoAlnsThreshold())
+        limit = GetNoAlnsThreshold();
+    if( limit < 1 )
+        limit = 1;
+    return ( size_t )limit;
+}
+
 // -------------------------------------------------------------------------
 // obtain hit at the specified location
 
@@ -496,13 +688,15 @@ HitInformation*& ProfileSearching::GetHitAt( size_t n )
 inline
 void ProfileSearching::CreateScoreSystem()
 {
+    UniversalScoreMatrix*   universal;
+
     if( GetMethod() != AbstractScoreMatrix::Universal )
         return;
 
-    scoreSystem = new UniversalScoreMatrix(
+    scoreSystem = universal = new UniversalScoreMatrix(
                 query_freq,
                 query_pssm,
-                profile_db.GetStore(),
+                GetProfileDb().GetStore(),
                 GetInformationThreshold(),
                 GetThicknessNumber(),
                 GetThicknessPercents(),
@@ -516,6 +710,7 @@ void ProfileSearching::CreateScoreSystem()
     if( scoreSystem == NULL )
         throw myruntime_error( mystring( "ProfileSearching: Not enough memory." ));
 
+    scoreSystem->SetSearchContext( &context );
     scoreSystem->SetDeletionCoefficient( GetDeletionCoefficient());
     scoreSystem->SetInfoCorrectionUpperBound2nd( GetInfoCorrectionUpperBound2nd());
     scoreSystem->SetInfoCorrectionNumerator2nd( GetInfoCorrectionNumerator2nd());
@@ -523,22 +718,39 @@ void ProfileSearching::CreateScoreSystem()
     scoreSystem->SetInfoCorrectionNumeratorAlt( GetInfoCorrectionNumeratorAlt());
     scoreSystem->SetInfoCorrectionScaleAlt( GetInfoCorrectionScaleAlt());
     scoreSystem->SetAutocorrectionPositional( GetAutocorrectionPositional());
+    //the threads of the search compute probabilities of scores while scaling
+    universal->SetNoThreads( GetNoThreads());
+
+    if( GetCacheDirectory() && GetBehaviour() != AbstractScoreMatrix::StatisticsGiven ) {
+        //score system scaled before for the same query, database, and options
+        universal->ComputeFingerprints( GetProfileDb().GetStoreFingerprint(), GetOptionsFingerprint());
+        if( ReadScoreSystem( universal ))
+            return;
+        ScaleScoreSystem( scoreSystem );
+        WriteScoreSystem( universal );
+        return;
+    }
 
-    ScaleScoreSystem();
+    ScaleScoreSystem( scoreSystem );
 }
 
-// CreateScoreSystem: creates score system of alternative type
+// CreateScoreSystem: creates score system of alternative type for the
+//     worker
 //
 inline
 void ProfileSearching::CreateScoreSystem(
+        SearchingWorker& worker,
         const FrequencyMatrix& sbjctfreq,
         const LogOddsMatrix& sbjctpssm )
 {
+    AbstractScoreMatrix*    scoreSystem = NULL;
+    ScoringMatrix*          profileScores = NULL;
+
     switch( GetMethod()) {
         case AbstractScoreMatrix::ProfileSpecific:
-                scoreSystem = new ScoringMatrix(
-                    query_freq,
-                    query_pssm,
+                scoreSystem = profileScores = new ScoringMatrix(
+                    *worker.query_freq,
+                    *worker.query_pssm,
                     sbjctfreq,
                     sbjctpssm,
                     GetInformationThreshold(),
@@ -550,14 +762,16 @@ void ProfileSearching::CreateScoreSystem(
                     GetScaling(),   //FPScaling, AutoScalling, or NoScaling
                     GetMasking()
                 );
+                if( profileScores )
+                    profileScores->SetQueryContext( &querycontext );
         break;
         case AbstractScoreMatrix::AdjustedProfileSpecific:
                 scoreSystem = new AdjustedScoreMatrix(
-                    query_freq,
-                    query_pssm,
+                    *worker.query_freq,
+                    *worker.query_pssm,
                     sbjctfreq,
                     sbjctpssm,
-                    profile_db.GetStore(),
+                    GetProfileDb().GetStore(),
                     GetInformationThreshold(),
                     GetThicknessNumber(),
                     GetThicknessPercents(),
@@ -574,6 +788,10 @@ void ProfileSearching::CreateScoreSystem(
     if( scoreSystem == NULL )
         throw myruntime_error( mystring( "ProfileSearching: Not enough memory." ));
 
+    worker.scoreSystem = scoreSystem;
+    worker.ownscores = true;
+
+    scoreSystem->SetSearchContext( &context );
     scoreSystem->SetDeletionCoefficient( GetDeletionCoefficient());
     scoreSystem->SetInfoCorrectionNumerator2nd( GetInfoCorrectionNumerator2nd());
     scoreSystem->SetInfoCorrectionUpperBound2nd( GetInfoCorrectionUpperBound2nd());
@@ -591,6 +809,18 @@ void ProfileSearching::DestroyScoreSystem()
 {
     if( scoreSystem )
         delete scoreSystem;
+    scoreSystem = NULL;
+}
+
+// DestroyScoreSystem: destroys score system of the worker
+//
+inline
+void ProfileSearching::DestroyScoreSystem( SearchingWorker& worker )
+{
+    if( worker.scoreSystem && worker.ownscores )
+        delete worker.scoreSystem;
+    worker.scoreSystem = NULL;
+    worker.ownscores = false;
 }
 
 // -------------------------------------------------------------------------
@@ -598,7 +828,7 @@ void ProfileSearching::DestroyScoreSystem()
 // -------------------------------------------------------------------------
 
 inline
-void ProfileSearching::ComputeScoreSystem()
+void ProfileSearching::ComputeScoreSystem( AbstractScoreMatrix* scoreSystem )
 {
 #ifdef __DEBUG__
     if( !scoreSystem )
@@ -608,10 +838,11 @@ void ProfileSearching::ComputeScoreSystem()
 }
 
 // -------------------------------------------------------------------------
-// ScanForHSPs: run algorithm of hsps
+// ScanForHSPs: run algorithm of hsps before the score system is computed
 //
 inline
 bool ProfileSearching::ScanForHSPs(
+    AbstractScoreMatrix* scoreSystem,
     double minhspscore, int hsplen, int nohsps, int mindist,
     int* possbjct, int* posquery )
 {
@@ -625,7 +856,7 @@ bool ProfileSearching::ScanForHSPs(
     switch( scoreSystem->GetType()) {
         case AbstractScoreMatrix::ProfileSpecific:
         case AbstractScoreMatrix::AdjustedProfileSpecific:
-            return scoreSystem->ScanForHSPs( minhspscore, hsplen, nohsps, mindist, possbjct, posquery );
+            return scoreSystem->PrescanForHSPs( minhspscore, hsplen, nohsps, mindist, possbjct, posquery );
 //             break;
 
         case AbstractScoreMatrix::Universal:
@@ -641,7 +872,7 @@ bool ProfileSearching::ScanForHSPs(
 // ScaleScoreSystem: scale score system
 //
 inline
-void ProfileSearching::ScaleScoreSystem()
+void ProfileSearching::ScaleScoreSystem( AbstractScoreMatrix* scoreSystem )
 {
 #ifdef __DEBUG__
     if( !scoreSystem )
@@ -672,40 +903,50 @@ void ProfileSearching::ScaleScoreSystem()
 //
 inline
 bool ProfileSearching::PreprocessSubject(
+    SearchingWorker&        worker,
     const FrequencyMatrix&  freq,
     const LogOddsMatrix&    pssm,
     GapScheme&              gaps,
-    bool                    firstpass )
+    bool                    firstpass,
+    double                  givenK )
 {
     if( firstpass ) {
-        if( scoreSystem == NULL ||
-            scoreSystem->GetType() == AbstractScoreMatrix::ProfileSpecific ||
-            scoreSystem->GetType() == AbstractScoreMatrix::AdjustedProfileSpecific )
+        if( worker.scoreSystem == NULL ||
+            worker.scoreSystem->GetType() == AbstractScoreMatrix::ProfileSpecific ||
+            worker.scoreSystem->GetType() == AbstractScoreMatrix::AdjustedProfileSpecific )
         {
-            DestroyScoreSystem();
-            CreateScoreSystem( freq, pssm );
-            ComputeScoreSystem();
-            if( !ScanForHSPs( GetHSPScore(), GetHSPLength(), GetHSPNoHSPs(), GetHSPDistance()))
+            //reuse the score system made for the previous subject
+            if( worker.scoreSystem && worker.ownscores && worker.scoreSystem->GetType() == GetMethod())
+                dynamic_cast<ScoringMatrix*>( worker.scoreSystem )->Rebind( freq, pssm );
+            else {
+                DestroyScoreSystem( worker );
+                CreateScoreSystem( worker, freq, pssm );
+            }
+            //pairs without the HSPs required are rejected before the scores are computed
+            if( !ScanForHSPs( worker.scoreSystem, GetHSPScore(), GetHSPLength(), GetHSPNoHSPs(), GetHSPDistance()))
                 return false;
-//             if( scoreSystem->GetSupportOptimFreq())
-//                 scoreSystem->OptimizeTargetFrequencies();
-            ScaleScoreSystem();
+            ComputeScoreSystem( worker.scoreSystem );
+//             if( worker.scoreSystem->GetSupportOptimFreq())
+//                 worker.scoreSystem->OptimizeTargetFrequencies();
+            //K computed for the pair while scanning is not computed again
+            worker.scoreSystem->SetGivenK( givenK );
+            ScaleScoreSystem( worker.scoreSystem );
         }
 #ifdef __DEBUG__
-        if( !scoreSystem )
+        if( !worker.scoreSystem )
             throw myruntime_error( mystring( "ProfileSearching: Unable to preprocess subject profile." ));
 #endif
 
-        if( scoreSystem->GetType() == AbstractScoreMatrix::Universal )
-            dynamic_cast<UniversalScoreMatrix*>( scoreSystem )->PreserveSubject( freq, pssm );
+        if( worker.scoreSystem->GetType() == AbstractScoreMatrix::Universal )
+            dynamic_cast<UniversalScoreMatrix*>( worker.scoreSystem )->PreserveSubject( freq, pssm );
     }
 
     gaps.SetUsePosACcorrections( GetAutocorrectionPositional());
-    query_gaps.SetUsePosACcorrections( GetAutocorrectionPositional());
+    worker.query_gaps->SetUsePosACcorrections( GetAutocorrectionPositional());
 
-    scoreSystem->PostScalingProc(
-        query_pssm, pssm,
-        query_gaps, gaps,
+    worker.scoreSystem->PostScalingProc(
+        *worker.query_pssm, pssm,
+        *worker.query_gaps, gaps,
         GetAutoGapCosts(),
         GetAutocorrWinsize(),
         firstpass
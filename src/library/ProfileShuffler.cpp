@@ -317,9 +317,9 @@ void ProfileShuffler::FillPositionProbabilities()
     if( profile_db.GetStore() == NULL )
         throw myruntime_error( mystring( "ProfileShuffler: Unable to compute position probability distribution function." ));
         
-    const SimpleVector* frequencies = profile_db.GetStore()->GetFrequencies();
+    const FrequencyStore*   frequencies = profile_db.GetStore();
 
-    if( frequencies == NULL )
+    if( frequencies->GetSize() == 0 )
         throw myruntime_error( mystring( "ProfileShuffler: No frequency vectors in the database." ));
 
     const size_t        size = frequencies->GetSize();
@@ -331,7 +331,7 @@ void ProfileShuffler::FillPositionProbabilities()
     positionProbs.Allocate( size );
 
     for( size_t n = 0; n < size; n++ ) {
-        FrequencyVector vector(( const char* )frequencies->GetValueAt( n ));
+        FrequencyVector vector( frequencies->GetVectorAt( n ));
         positionProbs.Push( vector.GetProbability());
     }
 
@@ -359,9 +359,9 @@ void ProfileShuffler::SimulateProfile( FrequencyMatrix& freq, LogOddsMatrix& pss
     if( profile_db.GetStore() == NULL )
         throw myruntime_error( mystring( "ProfileShuffler: Unable to simulate profile." ));
 
-    const SimpleVector* frequencies = profile_db.GetStore()->GetFrequencies();
+    const FrequencyStore*   frequencies = profile_db.GetStore();
 
-    if( frequencies == NULL )
+    if( frequencies->GetSize() == 0 )
         throw myruntime_error( mystring( "ProfileShuffler: No frequency vectors in the database." ));
 
 
@@ -386,7 +386,7 @@ void ProfileShuffler::SimulateProfile( FrequencyMatrix& freq, LogOddsMatrix& pss
     for( int n = 0; n < GetProfileLength(); n++ )
     {
         size_t  pos = positionProbs.GetIndex( prob = LecuyerRand( &rng_seed ) );
-        const FrequencyVector   vector(( const char* )frequencies->GetValueAt( pos ));
+        const FrequencyVector   vector( frequencies->GetVectorAt( pos ));
 
         for( int it = 0; it < FrequencyVector::GetNoElems(); it++ ) {
             posfreqvalues[it] = ( double )vector.GetValueAt( it ) / FREQUENCY_SUM;
@@ -0,0 +1,108 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Mindaugas Margelevicius                         *
+ *   Institute of Biotechnology, Vilnius                                   *
+ *   minmar@ibt.lt                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rc.h"
+#include "data.h"
+#include "QueryContext.h"
+
+
+// -------------------------------------------------------------------------
+// constructor: initialization
+// -------------------------------------------------------------------------
+
+QueryContext::QueryContext()
+:   frequencies( NULL ),
+    logodds( NULL ),
+    thicknessterms( NULL ),
+    thicknessmet( NULL ),
+    residuesx( NULL ),
+    length( 0 ),
+    thickness_number( 0 ),
+    thickness_percnt( 0.0 )
+{
+}
+
+// -------------------------------------------------------------------------
+// destructor: deallocation of resources
+// -------------------------------------------------------------------------
+
+QueryContext::~QueryContext()
+{
+    Destroy();
+}
+
+// -------------------------------------------------------------------------
+// Destroy: deallocates the data
+// -------------------------------------------------------------------------
+
+void QueryContext::Destroy()
+{
+    if( frequencies )
+        free( frequencies );
+    if( thicknessmet )
+        free( thicknessmet );
+
+    frequencies = logodds = thicknessterms = NULL;
+    thicknessmet = residuesx = NULL;
+    length = 0;
+}
+
+// -------------------------------------------------------------------------
+// Build: computes the data of the query given its frequency and log-odds
+//     matrices and the thickness constraints of the search
+// -------------------------------------------------------------------------
+
+void QueryContext::Build(
+    const FrequencyMatrix& freq, const LogOddsMatrix& logo,
+    int thick_number, double thick_percnt )
+{
+    int     qsize = logo.GetColumns();
+    int     n, a;
+
+    Destroy();
+
+    if( !logo.IsCompatible( freq ) || qsize < 1 )
+        throw myruntime_error( mystring( "QueryContext: Wrong query profile matrices." ));
+
+    frequencies = ( double* )malloc( sizeof( double ) * qsize * ( NUMAA + NUMAA + 1 ));
+    thicknessmet = ( char* )malloc( sizeof( char ) * qsize * 2 );
+
+    if( !frequencies || !thicknessmet ) {
+        Destroy();
+        throw myruntime_error( mystring( "QueryContext: Not enough memory." ));
+    }
+
+    logodds = frequencies + qsize * NUMAA;
+    thicknessterms = logodds + qsize * NUMAA;
+    residuesx = thicknessmet + qsize;
+
+    length = qsize;
+    thickness_number = thick_number;
+    thickness_percnt = thick_percnt;
+
+    for( n = 0; n < qsize; n++ ) {
+        const double  ( *freqs )[NUMALPH] = freq.GetVectorAt( n );
+        const double  ( *logos )[NUMALPH] = logo.GetVectorAt( n );
+
+        for( a = 0; a < NUMAA; a++ ) {
+            frequencies[a * qsize + n] = ( *freqs )[a];
+            logodds[a * qsize + n] = ( *logos )[a];
+        }
+
+        thicknessterms[n] = GetThicknessTerm( logo.GetThicknessAt( n ));
+
+        thicknessmet[n] = !(
+                      logo.GetThicknessAt( n ) < ( size_t )thick_number ||
+            ( double )logo.GetThicknessAt( n ) / logo.GetMtxEffectiveThickness() < thick_percnt );
+
+        residuesx[n] = freq.GetResidueAt( n ) == X;
+    }
+}
@@ -0,0 +1,150 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Mindaugas Margelevicius                         *
+ *   Institute of Biotechnology, Vilnius                                   *
+ *   minmar@ibt.lt                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef __QueryContext__
+#define __QueryContext__
+
+#include <math.h>
+#include <stddef.h>
+
+#include "debug.h"
+#include "types.h"
+#include "compdef.h"
+
+#include "mystring.h"
+#include "myexcept.h"
+
+#include "DistributionMatrix.h"
+
+
+// _________________________________________________________________________
+// Class QueryContext
+//
+// Data of the query profile which do not depend on the subject profile and
+// are used in computation of scores for each pair of profiles: frequencies
+// and log-odds values transposed so that the values of one amino acid are
+// contiguous over query positions, thickness terms and flags of thickness
+// constraints. Built once when the query is read and only read afterwards,
+// so that concurrent workers may refer to the same object
+//
+
+class QueryContext
+{
+public:
+    QueryContext();
+    ~QueryContext();
+
+    void            Build( const FrequencyMatrix&, const LogOddsMatrix&, int thick_number, double thick_percnt );
+    void            Destroy();
+
+    bool            IsBuilt() const                     { return frequencies != NULL; }
+    int             GetLength() const                   { return length; }
+    int             GetThicknessNumber() const          { return thickness_number; }
+    double          GetThicknessPercents() const        { return thickness_percnt; }
+
+    const double*   GetFrequenciesOf( int a ) const;    //frequencies of amino acid a at all positions
+    const double*   GetLogOddsOf( int a ) const;        //log-odds values of amino acid a at all positions
+
+    double          GetThicknessTermAt( int n ) const;
+    bool            GetThicknessMetAt( int n ) const;   //whether thickness constraints are met at the position
+    bool            GetResidueXAt( int n ) const;       //whether residue at the position is X
+
+    static double   GetThicknessTerm( size_t thickness );
+
+private:
+    double*         frequencies;        //transposed frequencies: NUMAA vectors of query length
+    double*         logodds;            //transposed log-odds values
+    double*         thicknessterms;     //thickness terms of positions used to weigh scores
+    char*           thicknessmet;       //flags of positions meeting thickness constraints
+    char*           residuesx;          //flags of positions of X
+    int             length;             //length of the query
+    int             thickness_number;   //thickness constraints the flags were computed with
+    double          thickness_percnt;
+};
+
+
+////////////////////////////////////////////////////////////////////////////
+// INLINES
+//
+// GetFrequenciesOf: returns frequencies of amino acid a at all query
+//     positions
+//
+inline
+const double* QueryContext::GetFrequenciesOf( int a ) const
+{
+#ifdef __DEBUG__
+    if( !frequencies || a < 0 || NUMAA <= a )
+        throw myruntime_error( mystring( "QueryContext: Memory access error." ));
+#endif
+    return frequencies + a * length;
+}
+
+// GetLogOddsOf: returns log-odds values of amino acid a at all query
+//     positions
+//
+inline
+const double* QueryContext::GetLogOddsOf( int a ) const
+{
+#ifdef __DEBUG__
+    if( !logodds || a < 0 || NUMAA <= a )
+        throw myruntime_error( mystring( "QueryContext: Memory access error." ));
+#endif
+    return logodds + a * length;
+}
+
+// GetThicknessTermAt: returns thickness term of the position
+//
+inline
+double QueryContext::GetThicknessTermAt( int n ) const
+{
+#ifdef __DEBUG__
+    if( !thicknessterms || n < 0 || length <= n )
+        throw myruntime_error( mystring( "QueryContext: Memory access error." ));
+#endif
+    return thicknessterms[n];
+}
+
+// GetThicknessMetAt: returns true if thickness constraints are met at
+//     the position
+//
+inline
+bool QueryContext::GetThicknessMetAt( int n ) const
+{
+#ifdef __DEBUG__
+    if( !thicknessmet || n < 0 || length <= n )
+        throw myruntime_error( mystring( "QueryContext: Memory access error." ));
+#endif
+    return thicknessmet[n];
+}
+
+// GetResidueXAt: returns true if residue at the position is X
+//
+inline
+bool QueryContext::GetResidueXAt( int n ) const
+{
+#ifdef __DEBUG__
+    if( !residuesx || n < 0 || length <= n )
+        throw myruntime_error( mystring( "QueryContext: Memory access error." ));
+#endif
+    return residuesx[n];
+}
+
+// -------------------------------------------------------------------------
+// GetThicknessTerm: returns the term of the position thickness used to
+//     weigh frequencies in the computation of scores
+// -------------------------------------------------------------------------
+
+inline
+double QueryContext::GetThicknessTerm( size_t thickness )
+{
+    if( thickness )
+        return 1.0 - ( 1.0 + log(( double )thickness )) / ( double )thickness;
+    return 0.0;
+}
+
+#endif//__QueryContext__
@@ -49,16 +49,24 @@ ScoringMatrix::ScoringMatrix(
     freq_fst_( freq_fst ),
     logo_fst_( logo_fst ),
 
-    freq_sec_( freq_sec ),
-    logo_sec_( logo_sec ),
+    freq_sec_( &freq_sec ),
+    logo_sec_( &logo_sec ),
 
+    infrm_threshold_( infrm_threshold ),
     thickness_number( thick_number ),
     thickness_percnt( thick_percnt ),
     maskscale_percnt( mask_percnt ),
 
-    scores_( freq_fst_.GetColumns() * freq_sec_.GetColumns()),
+    scores_( freq_fst_.GetColumns() * freq_sec.GetColumns()),
     rprobs_( freq_fst_.GetColumns()),
-    cprobs_( freq_sec_.GetColumns())
+    cprobs_( freq_sec.GetColumns()),
+
+    query_context( NULL ),
+
+    fstwghts_( NULL ),
+    secwghts_( NULL ),
+    rowscore_( NULL ),
+    qrymeets_( NULL )
 {
     PrivateInit();
     SetInformationThreshold( infrm_threshold );
@@ -87,16 +95,24 @@ ScoringMatrix::ScoringMatrix(
     freq_fst_( freq_fst ),
     logo_fst_( logo_fst ),
 
-    freq_sec_( freq_sec ),
-    logo_sec_( logo_sec ),
+    freq_sec_( &freq_sec ),
+    logo_sec_( &logo_sec ),
 
+    infrm_threshold_( infrm_threshold ),
     thickness_number( thick_number ),
     thickness_percnt( thick_percnt ),
     maskscale_percnt( mask_percnt ),
 
-    scores_( freq_fst_.GetColumns() * freq_sec_.GetColumns()),
+    scores_( freq_fst_.GetColumns() * freq_sec.GetColumns()),
     rprobs_( freq_fst_.GetColumns()),
-    cprobs_( freq_sec_.GetColumns())
+    cprobs_( freq_sec.GetColumns()),
+
+    query_context( NULL ),
+
+    fstwghts_( NULL ),
+    secwghts_( NULL ),
+    rowscore_( NULL ),
+    qrymeets_( NULL )
 {
     PrivateInit();
     SetInformationThreshold( infrm_threshold );
@@ -113,16 +129,24 @@ ScoringMatrix::ScoringMatrix()
     freq_fst_( smp_dummyfreq ),
     logo_fst_( smp_dummylogo ),
 
-    freq_sec_( smp_dummyfreq ),
-    logo_sec_( smp_dummylogo ),
+    freq_sec_( &smp_dummyfreq ),
+    logo_sec_( &smp_dummylogo ),
 
+    infrm_threshold_( 0.0 ),
     thickness_number( 0 ),
     thickness_percnt( 0.0 ),
     maskscale_percnt( 0.0 ),
 
     scores_( 1 ),
     rprobs_( 1 ),
-    cprobs_( 1 )
+    cprobs_( 1 ),
+
+    query_context( NULL ),
+
+    fstwghts_( NULL ),
+    secwghts_( NULL ),
+    rowscore_( NULL ),
+    qrymeets_( NULL )
 {
 }
 
@@ -132,6 +156,7 @@ ScoringMatrix::ScoringMatrix()
 
 ScoringMatrix::~ScoringMatrix()
 {
+    DestroyQueryData();
 }
 
 // -------------------------------------------------------------------------
@@ -140,21 +165,49 @@ ScoringMatrix::~ScoringMatrix()
 
 void ScoringMatrix::PrivateInit()
 {
-    if( !logo_fst_.IsCompatible( freq_fst_ ) || !logo_sec_.IsCompatible( freq_sec_ ))
+    if( !logo_fst_.IsCompatible( freq_fst_ ) || !GetSbjctLogo().IsCompatible( GetSbjctFreq()))
             throw myruntime_error( mystring( "ScoringMatrix: Profile matrices are incompatible." ));
 
     if(  freq_fst_.GetColumns() < 1 || freq_fst_.GetColumns() > MAXCOLUMNS ||
-         freq_sec_.GetColumns() < 1 || freq_sec_.GetColumns() > MAXCOLUMNS )
+         GetSbjctFreq().GetColumns() < 1 || GetSbjctFreq().GetColumns() > MAXCOLUMNS )
             throw myruntime_error( mystring( "ScoringMatrix: Wrong profile matrices." ));
 
     if( GetMaskscalePercents() < 0.0 )
             throw myruntime_error( mystring( "ScoringMatrix: Negative scaling factor of masked positions." ));
 
-    Init( freq_fst_.GetColumns(), freq_sec_.GetColumns());
+    Init( freq_fst_.GetColumns(), GetSbjctFreq().GetColumns());
 
 #ifdef USEPROFBACKPROBS
     LOSCORES.StoreProbabilities_1( logo_fst_.GetBackProbs());
-    LOSCORES.StoreProbabilities_2( logo_sec_.GetBackProbs());
+    LOSCORES.StoreProbabilities_2( GetSbjctLogo().GetBackProbs());
+#endif
+}
+
+// -------------------------------------------------------------------------
+// Rebind: binds the score system to another subject profile; memory
+//     allocated for the previous subjects is reused and values computed
+//     for the previous pair of profiles are reset, so that the score
+//     system is as if constructed anew
+// -------------------------------------------------------------------------
+
+void ScoringMatrix::Rebind( const FrequencyMatrix& freq_sec, const LogOddsMatrix& logo_sec )
+{
+    if( !logo_sec.IsCompatible( freq_sec ))
+            throw myruntime_error( mystring( "ScoringMatrix: Profile matrices are incompatible." ));
+
+    if(  freq_sec.GetColumns() < 1 || freq_sec.GetColumns() > MAXCOLUMNS )
+            throw myruntime_error( mystring( "ScoringMatrix: Wrong profile matrices." ));
+
+    freq_sec_ = &freq_sec;
+    logo_sec_ = &logo_sec;
+
+    cprobs_.Reserve( freq_sec.GetColumns());
+
+    Reinit( freq_sec.GetColumns());
+    SetInformationThreshold( infrm_threshold_ );
+
+#ifdef USEPROFBACKPROBS
+    LOSCORES.StoreProbabilities_2( GetSbjctLogo().GetBackProbs());
 #endif
 }
 
@@ -191,8 +244,8 @@ double ScoringMatrix::ComputeScore( int m, int n, bool final ) const
 //             if( fst_thckn ) log_fst_thckn = 1.0 - sqrt( fst_thckn ) / ( double ) fst_thckn; //log( fst_thckn );
 //             if( sec_thckn ) log_sec_thckn = 1.0 - sqrt( sec_thckn ) / ( double ) sec_thckn; //log( sec_thckn );
 
-            if( fst_thckn ) log_fst_thckn = 1.0 - ( 1.0 + log( fst_thckn )) / ( double ) fst_thckn; //log( fst_thckn );
-            if( sec_thckn ) log_sec_thckn = 1.0 - ( 1.0 + log( sec_thckn )) / ( double ) sec_thckn; //log( sec_thckn );
+            log_fst_thckn = QueryContext::GetThicknessTerm( fst_thckn );
+            log_sec_thckn = QueryContext::GetThicknessTerm( sec_thckn );
 //         }
 
         if( log_fst_thckn <= 0.0 && log_sec_thckn <= 0.0 ) {
@@ -217,9 +270,126 @@ double ScoringMatrix::ComputeScore( int m, int n, bool final ) const
     return score * GetMultiplier();
 }
 
+// -------------------------------------------------------------------------
+// PrepareQueryData: prepares the query data used to compute scores of all
+//     query positions at once; the data shared by the search are used if
+//     they have been made for the same query and constraints, otherwise
+//     they are made for this score system; information constraints are
+//     checked again on each call since the threshold may have been changed
+// -------------------------------------------------------------------------
+
+void ScoringMatrix::PrepareQueryData()
+{
+    int     qsize = GetQuerySize();
+    int     n;
+
+    if( !query_context || !query_context->IsBuilt() ||
+        query_context->GetLength() != qsize ||
+        query_context->GetThicknessNumber() != GetThicknessNumber() ||
+        query_context->GetThicknessPercents() != GetThicknessPercents())
+    {
+        own_context.Build( GetQueryFreq(), GetQueryLogo(), GetThicknessNumber(), GetThicknessPercents());
+        query_context = &own_context;
+    }
+
+    if( !fstwghts_ ) {
+        fstwghts_ = ( double* )malloc( sizeof( double ) * qsize * 3 );
+        qrymeets_ = ( char* )malloc( sizeof( char ) * qsize );
+
+        if( !fstwghts_ || !qrymeets_ ) {
+            DestroyQueryData();
+            throw myruntime_error( mystring( "ScoringMatrix: Not enough memory." ));
+        }
+        secwghts_ = fstwghts_ + qsize;
+        rowscore_ = secwghts_ + qsize;
+    }
+
+    for( n = 0; n < qsize; n++ )
+        qrymeets_[n] =
+            !( GetQueryLogo().GetInformationAt( n ) < GetInformationThreshold()) &&
+            query_context->GetThicknessMetAt( n );
+}
+
+// -------------------------------------------------------------------------
+// DestroyQueryData: deallocates the data of rows
+// -------------------------------------------------------------------------
+
+void ScoringMatrix::DestroyQueryData()
+{
+    if( fstwghts_ )
+        free( fstwghts_ );
+    if( qrymeets_ )
+        free( qrymeets_ );
+
+    fstwghts_ = secwghts_ = rowscore_ = NULL;
+    qrymeets_ = NULL;
+}
+
+// -------------------------------------------------------------------------
+// ComputeScoreRow: computes scores between the subject position and all
+//     query positions; terms are accumulated over amino acids for all
+//     query positions at a time in the same order as in ComputeScore, so
+//     that the scores are equal
+// -------------------------------------------------------------------------
+
+void ScoringMatrix::ComputeScoreRow( int m, bool final )
+{
+    int             qsize = GetQuerySize();
+    const double  ( *freqs )[NUMALPH] = GetSbjctFreq().GetVectorAt( m );
+    const double  ( *logos )[NUMALPH] = GetSbjctLogo().GetVectorAt( m );
+    const double*   qfreqs;
+    const double*   qlogos;
+    double          sfreq, slogo;
+    double          log_fst_thckn, log_sec_thckn, sum_thckn;
+    double          sec_thckn_term;
+    size_t          sec_thckn;
+    int             n, a;
+
+    if( final ) {
+        sec_thckn = GetSbjctLogo().GetThicknessAt( m );
+        sec_thckn_term = QueryContext::GetThicknessTerm( sec_thckn );
+
+        for( n = 0; n < qsize; n++ ) {
+            log_fst_thckn = query_context->GetThicknessTermAt( n );
+            log_sec_thckn = sec_thckn_term;
+
+            if( log_fst_thckn <= 0.0 && log_sec_thckn <= 0.0 ) {
+                log_fst_thckn = 1.0;
+                log_sec_thckn = 1.0;
+            }
+
+            sum_thckn = log_fst_thckn + log_sec_thckn;
+
+            if( sec_thckn == 0.0 )
+                sum_thckn = 1.0;
+
+            fstwghts_[n] = ( log_fst_thckn + log_fst_thckn ) / sum_thckn;
+            secwghts_[n] = ( log_sec_thckn + log_sec_thckn ) / sum_thckn;
+        }
+    }
+    else
+        for( n = 0; n < qsize; n++ )
+            fstwghts_[n] = secwghts_[n] = 1.0;
+
+    for( n = 0; n < qsize; n++ )
+        rowscore_[n] = 0.0;
+
+    for( a = 0; a < NUMAA; a++ ) {
+        qfreqs = query_context->GetFrequenciesOf( a );
+        qlogos = query_context->GetLogOddsOf( a );
+        sfreq = ( *freqs )[a];
+        slogo = ( *logos )[a];
+        // lambda is implicitly incorporated into the log-odds values of the profiles
+        for( n = 0; n < qsize; n++ )
+            rowscore_[n] += fstwghts_[n] * qfreqs[n] * slogo +
+                            secwghts_[n] * sfreq * qlogos[n];
+    }
+}
+
 // -------------------------------------------------------------------------
 // ComputeProfileScoringMatrix: computes scoring matrix that is to be used
-//     for aligning two profiles
+//     for aligning two profiles; scores are computed by rows of subject
+//     positions against the query data prepared once for the search
 // -------------------------------------------------------------------------
 
 void ScoringMatrix::ComputeProfileScoringMatrix( bool final )
@@ -234,46 +404,47 @@ void ScoringMatrix::ComputeProfileScoringMatrix( bool final )
     int     no_elems = 0;
     int     negatives = 0;
     TMask   currentmask = Unmasked;
+    bool    sbjctmeets = true;
     double  score = 0.0;
 
 
+    PrepareQueryData();
+
     //fill matrix with values
-    for( m = 0; m < GetSubjectSize(); m++ ) {
+    for( m = 0; m < GetSubjectSize(); m++ )
+    {
+        //give constant penalties at the positions of X
+        if( GetSbjctFreq().GetResidueAt( m ) == X ) {
+            for( n = 0; n < GetQuerySize(); n++ )
+                SetScore( g_scoreX, m, n );
+            continue;
+        }
+
+        sbjctmeets = SbjctConstraintsMet( m );
+
+        ComputeScoreRow( m, final );
+
         for( n = 0; n < GetQuerySize(); n++ )
         {
-            //give constant penalties at the positions of X
-            if( GetQueryFreq().GetResidueAt( n ) == X ||
-                GetSbjctFreq().GetResidueAt( m ) == X )
-            {
+            if( query_context->GetResidueXAt( n )) {
                 SetScore( g_scoreX, m, n );
                 continue;
             }
 
-            score = 0.0;
             currentmask = Unmasked;
 
-            if( logo_fst_.GetInformationAt( n ) < GetInformationThreshold() ||
-                logo_sec_.GetInformationAt( m ) < GetInformationThreshold() ||
-                ! ThicknessConstraintsMet( m, n ))
-            {
+            if( !sbjctmeets || !qrymeets_[n] )
                 //mask the score possibly excluding it from the ongoing computational statistics
                 SetMasked( currentmask = GetMaskingApproach(), m, n );
-            }
 
-            if( 1 || currentmask != MaskToIgnore )
-            {
-                score = ComputeScore( m, n, final );
+            score = rowscore_[n] * GetMultiplier();
 
-                if( currentmask != MaskToIgnore ) {
-                    no_elems++;
-                    if( score < 0.0 ) negatives++;    //increase counter for each negative score found
-                }
-                if( currentmask == MaskToConsider || currentmask == MaskToIgnore )
-                    score *= GetMaskscalePercents();
+            if( currentmask != MaskToIgnore ) {
+                no_elems++;
+                if( score < 0.0 ) negatives++;    //increase counter for each negative score found
             }
-            else
-                //give penalty to score at the positions;
-                score = g_scoreX;
+            if( currentmask == MaskToConsider || currentmask == MaskToIgnore )
+                score *= GetMaskscalePercents();
 
             SetScore( score, m, n );
         }
@@ -288,6 +459,65 @@ void ScoringMatrix::ComputeProfileScoringMatrix( bool final )
     PreliminaryVerification();
 }
 
+// -------------------------------------------------------------------------
+// ScanScoresForHSPs: computes scores row by row as
+//     ComputeProfileScoringMatrix does without saving them and passes each
+//     row to the search of HSPs until they are found
+// -------------------------------------------------------------------------
+
+bool ScoringMatrix::ScanScoresForHSPs( AttributableScores* PATTR_SCORES )
+{
+    if( PATTR_SCORES == NULL )
+        throw myruntime_error( mystring( "ScoringMatrix: Unable to scan scores: Wrong argument." ));
+
+    if( GetQuerySize() <= 0 || GetSubjectSize() <= 0 || !IsValid())
+        throw myruntime_error( mystring( "ScoringMatrix: Unable to scan scores." ));
+
+    int     m, n;
+    TMask   currentmask = Unmasked;
+    bool    sbjctmeets = true;
+    double  score = 0.0;
+
+    PrepareQueryData();
+
+    for( m = 0; m < GetSubjectSize(); m++ )
+    {
+        if( GetSbjctFreq().GetResidueAt( m ) == X ) {
+            for( n = 0; n < GetQuerySize(); n++ )
+                rowscore_[n] = g_scoreX;
+        }
+        else {
+            sbjctmeets = SbjctConstraintsMet( m );
+
+            ComputeScoreRow( m, false );
+
+            for( n = 0; n < GetQuerySize(); n++ )
+            {
+                if( query_context->GetResidueXAt( n )) {
+                    rowscore_[n] = g_scoreX;
+                    continue;
+                }
+
+                currentmask = Unmasked;
+
+                if( !sbjctmeets || !qrymeets_[n] )
+                    currentmask = GetMaskingApproach();
+
+                score = rowscore_[n] * GetMultiplier();
+
+                if( currentmask == MaskToConsider || currentmask == MaskToIgnore )
+                    score *= GetMaskscalePercents();
+
+                rowscore_[n] = score;
+            }
+        }
+
+        if( PATTR_SCORES->ScanHSPRow( m, rowscore_ ))
+            break;
+    }
+    return true;
+}
+
 // -------------------------------------------------------------------------
 // PreliminaryVerification: applies fast alignment algorithm given this
 //     score system before scaling takes place
@@ -365,7 +595,7 @@ void ScoringMatrix::ComputePositionalScoreProbs( AttributableScores* PATTR_SCORE
     }
     try{
         for( m = 0; m < GetSubjectSize(); m++ ) {
-            if( freq_sec_[m] == X )
+            if( GetSbjctFreq()[m] == X )
                 continue;
 
             normterm = 0.0;
@@ -389,7 +619,7 @@ void ScoringMatrix::ComputePositionalScoreProbs( AttributableScores* PATTR_SCORE
                         continue;
 //                     sum += ( freq_fst_( n, r ) + freq_sec_( m, r )) * LOSCORES.LogPROBABility( r );
                     sum +=  freq_fst_( n, r ) * LOSCORES.LogPROBABILITY_2( r ) +
-                            freq_sec_( m, r ) * LOSCORES.LogPROBABILITY_1( r );
+                            GetSbjctFreq()( m, r ) * LOSCORES.LogPROBABILITY_1( r );
                 }
 
                 exp2sum = exp( sum );
@@ -428,6 +658,78 @@ void ScoringMatrix::ComputePositionalScoreProbs( AttributableScores* PATTR_SCORE
     if( querynorm ) free( querynorm );
 }
 
+// -------------------------------------------------------------------------
+// ComputeBackgroundProbs: computes non-normalized background probabilities
+//     of query (rprobs) and subject (cprobs) positions, except positions
+//     of X
+// -------------------------------------------------------------------------
+
+void ScoringMatrix::ComputeBackgroundProbs( Pslvector& rprobs, Pslvector& cprobs ) const
+{
+    int     n, m, nn, mm, r;
+    double  sum;
+
+    rprobs.Clear();
+    cprobs.Clear();
+
+    for( n = 0, nn = 0; n < GetQuerySize(); n++ ) {
+        if( freq_fst_[n] == X )
+            continue;
+        sum = 0.0;
+        for( r = 0; r < NUMALPH; r++ ) {
+            if( LOSCORES.PROBABility( r ) <= 0.0 )
+                continue;
+            sum += freq_fst_( n, r ) * LOSCORES.LogPROBABILITY_1( r );
+        }
+        rprobs.AddValueAt( nn++, exp( sum ));
+    }
+
+    for( m = 0, mm = 0; m < GetSubjectSize(); m++ ) {
+        if( GetSbjctFreq()[m] == X )
+            continue;
+        sum = 0.0;
+        for( r = 0; r < NUMALPH; r++ ) {
+            if( LOSCORES.PROBABility( r ) <= 0.0 )
+                continue;
+            sum += GetSbjctFreq()( m, r ) * LOSCORES.LogPROBABILITY_2( r );
+        }
+        cprobs.AddValueAt( mm++, exp( sum ));
+    }
+}
+
+// -------------------------------------------------------------------------
+// TabulateScores: makes the table of scores with their weights in the
+//     order the scores contribute to probabilities in
+//     ComputeScoreProbabilities
+// -------------------------------------------------------------------------
+
+bool ScoringMatrix::TabulateScores( AttributableScores* PATTR_SCORES )
+{
+    if( PATTR_SCORES == NULL )
+        throw myruntime_error( mystring( "ScoringMatrix: Unable to tabulate scores: Wrong argument." ));
+
+    Pslvector   rprobs( GetQuerySize());
+    Pslvector   cprobs( GetSubjectSize());
+    double      proquery, prosbjct;
+    int         n, m, nn, mm;
+
+    ComputeBackgroundProbs( rprobs, cprobs );
+
+    for( n = 0, nn = 0; n < GetQuerySize(); n++ )
+    {
+        proquery = ( freq_fst_[n] == X )? -1.0: rprobs.GetValueAt( nn++ );
+
+        for( m = 0, mm = 0; m < GetSubjectSize(); m++ ) {
+            prosbjct = ( GetSbjctFreq()[m] == X )? -1.0: cprobs.GetValueAt( mm++ );
+
+            if( proquery < 0.0 || prosbjct < 0.0 )
+                    PATTR_SCORES->PushTableScore( m, n, -1.0 );
+            else    PATTR_SCORES->PushTableScore( m, n, proquery * prosbjct );
+        }
+    }
+    return true;
+}
+
 #if 1
 // -------------------------------------------------------------------------
 // ComputeScoreProbabilities: computes probabilities to observe scores at
@@ -455,9 +757,8 @@ void ScoringMatrix::ComputeScoreProbabilities( AttributableScores* PATTR_SCORES
 
     const double    accuracy = 1.0e-4;
 
-    int     n, m, nn, mm, r;
+    int     n, m, nn, mm;
     char    strbuf[KBYTE];
-    double  sum = 0.0;      //initial sum
     double  proquery = 0.0; //non-normalized probability of query position
     double  prosbjct = 0.0; //non-normalized probability of subject position
     double  exp2sum = 0.0;  //e to sum
@@ -468,33 +769,8 @@ void ScoringMatrix::ComputeScoreProbabilities( AttributableScores* PATTR_SCORES
     TScore  loc_score  = 0;
 
     scores_.Clear();
-    rprobs_.Clear();
-    cprobs_.Clear();
-
-
-    for( n = 0, nn = 0; n < GetQuerySize(); n++ ) {
-        if( freq_fst_[n] == X )
-            continue;
-        sum = 0.0;
-        for( r = 0; r < NUMALPH; r++ ) {
-            if( LOSCORES.PROBABility( r ) <= 0.0 )
-                continue;
-            sum += freq_fst_( n, r ) * LOSCORES.LogPROBABILITY_1( r );
-        }
-        rprobs_.AddValueAt( nn++, exp( sum ));
-    }
 
-    for( m = 0, mm = 0; m < GetSubjectSize(); m++ ) {
-        if( freq_sec_[m] == X )
-            continue;
-        sum = 0.0;
-        for( r = 0; r < NUMALPH; r++ ) {
-            if( LOSCORES.PROBABility( r ) <= 0.0 )
-                continue;
-            sum += freq_sec_( m, r ) * LOSCORES.LogPROBABILITY_2( r );
-        }
-        cprobs_.AddValueAt( mm++, exp( sum ));
-    }
+    ComputeBackgroundProbs( rprobs_, cprobs_ );
 
 
     for( n = 0, nn = 0; n < GetQuerySize(); n++ )
@@ -505,7 +781,7 @@ void ScoringMatrix::ComputeScoreProbabilities( AttributableScores* PATTR_SCORES
         proquery = rprobs_.GetValueAt( nn++ );
 
         for( m = 0, mm = 0; m < GetSubjectSize(); m++ ) {
-            if( freq_sec_[m] == X )
+            if( GetSbjctFreq()[m] == X )
                 continue;
 
             prosbjct = cprobs_.GetValueAt( mm++ );
@@ -597,7 +873,7 @@ void ScoringMatrix::ComputeScoreProbabilities( AttributableScores* PATTR_SCORES
 
         for( int m = 0; m < GetSubjectSize(); m++ )
         {
-            if( freq_sec_[m] == X )
+            if( GetSbjctFreq()[m] == X )
                 continue;
 
             sum = 0.0;
@@ -614,7 +890,7 @@ void ScoringMatrix::ComputeScoreProbabilities( AttributableScores* PATTR_SCORES
                 if( LOSCORES.PROBABility( r ) <= 0.0 )
                     continue;//consider only residues which have background probabilities
 
-                freq = ( unsigned )rint( 100.0 * freq_sec_( m, r ));
+                freq = ( unsigned )rint( 100.0 * GetSbjctFreq()( m, r ));
                 sum += freq * LOSCORES.LogPROBABility( r ) - LOG_FREQUENCIES.SumOf( freq );
             }
             sum += LOG_FREQUENCIES.Total();//log gamma(sum freq)
@@ -729,7 +1005,7 @@ void ScoringMatrix::IncorporateTargetFrequencies( const Pslvector& optfreqs )
         proquery = rprobs_.GetValueAt( nn++ );
 
         for( m = 0, mm = 0; m < GetSubjectSize(); m++ ) {
-            if( freq_sec_[m] == X )
+            if( GetSbjctFreq()[m] == X )
                 continue;
 
             prosbjct = cprobs_.GetValueAt( mm++ );
@@ -827,7 +1103,7 @@ void ScoringMatrix::PrintScoringMatrix( FILE* fp ) const
 
     fprintf( fp, "\n%9c", 32 );
     for( m = 0; m < GetSubjectSize(); m++ )
-        fprintf( fp, " %4c", DehashCode( logo_sec_[m] ));
+        fprintf( fp, " %4c", DehashCode( GetSbjctLogo()[m] ));
 
     for( n = 0; n < GetQuerySize(); n++ ) {
 
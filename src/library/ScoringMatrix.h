@@ -19,6 +19,7 @@
 
 #include "AbstractScoreMatrix.h"
 #include "DistributionMatrix.h"
+#include "QueryContext.h"
 
 
 class ScoringMatrix: public AbstractScoreMatrix
@@ -45,6 +46,8 @@ public:
     virtual const char* GetMethodName() const   { return "Profile-specific vector-based"; }
 
     virtual void        ComputeProfileScoringMatrix( bool final = false );
+                                                                    //bind the score system to another subject
+    virtual void        Rebind( const FrequencyMatrix& freq_sec, const LogOddsMatrix& logo_sec );
                                                                     //compute e-value
     virtual double      ComputeExpectation( double, double* = NULL, double* = NULL, double* = NULL, double* = NULL ) const;
 
@@ -52,12 +55,19 @@ public:
     double              GetThicknessPercents() const    { return thickness_percnt; }
     double              GetMaskscalePercents() const    { return maskscale_percnt; }
 
+    const QueryContext* GetQueryContext() const         { return query_context; }
+    void                SetQueryContext( const QueryContext* ctx ) { query_context = ctx; }
+
     virtual void        OptimizeTargetFrequencies();
 
                                                             //compute probabilities to observe scores at each position
     virtual void        ComputeScoreProbabilities( AttributableScores* );
                                                             //compute positional probabilities of scores
     virtual void        ComputePositionalScoreProbs( AttributableScores* );
+                                                            //tabulate scores with their weights in probabilities
+    virtual bool        TabulateScores( AttributableScores* );
+                                                            //compute rows of scores on the fly for the search of HSPs
+    virtual bool        ScanScoresForHSPs( AttributableScores* );
 
     virtual void        PrintParameterTable( TPrintFunction, void* vpn ) const;
     virtual void        PrintFinal( TPrintFunction, void* vpn ) const;
@@ -83,15 +93,22 @@ protected:
     void                    PrivateInit();                          //private initialization method
     double                  ComputeScore( int m, int n, bool final ) const;
 
+    void                    PrepareQueryData();                     //prepare query data used in computation of scores
+    void                    ComputeScoreRow( int m, bool final );   //compute scores of all query positions for a subject position
+    void                    DestroyQueryData();
+
     const FrequencyMatrix&  GetQueryFreq() const    { return freq_fst_; }
     const LogOddsMatrix&    GetQueryLogo() const    { return logo_fst_; }
 
-    const FrequencyMatrix&  GetSbjctFreq() const    { return freq_sec_; }
-    const LogOddsMatrix&    GetSbjctLogo() const    { return logo_sec_; }
+    const FrequencyMatrix&  GetSbjctFreq() const    { return *freq_sec_; }
+    const LogOddsMatrix&    GetSbjctLogo() const    { return *logo_sec_; }
 
     bool                    ThicknessConstraintsMet( int m, int n ) const;
+    bool                    SbjctConstraintsMet( int m ) const;
 
     void                    PreliminaryVerification();
+                                                            //compute background probabilities of profile positions
+    void                    ComputeBackgroundProbs( Pslvector& rprobs, Pslvector& cprobs ) const;
 
     //helper routines for optimization of target frequencies
     void                    IncorporateTargetFrequencies( const Pslvector& );
@@ -100,9 +117,10 @@ private:
     const FrequencyMatrix&  freq_fst_;  //reference to the first weighted frequency matrix
     const LogOddsMatrix&    logo_fst_;  //reference to the first log-odds matrix
 
-    const FrequencyMatrix&  freq_sec_;  //reference to the second weighted frequency matrix
-    const LogOddsMatrix&    logo_sec_;  //reference to the second log-odds matrix
+    const FrequencyMatrix*  freq_sec_;  //address of the second weighted frequency matrix
+    const LogOddsMatrix*    logo_sec_;  //address of the second log-odds matrix
 
+    const double            infrm_threshold_;   //information content threshold the score system is created with
     const int               thickness_number;   //thickness in number of sequences a position must have, otherwise it will be ignored
     const double            thickness_percnt;   //thickness in percentage
     const double            maskscale_percnt;   //scaling of masked positions in percentage
@@ -111,6 +129,13 @@ private:
     Pslvector               rprobs_;    //row background probabilities of the score system
     Pslvector               cprobs_;    //column background probabilities of the score system
 
+    const QueryContext*     query_context;  //data of the query shared by the score systems of the search
+    QueryContext            own_context;    //data of the query made if no shared data are given
+
+    double*                 fstwghts_;  //weights of query frequencies for one subject position
+    double*                 secwghts_;  //weights of subject frequencies for one subject position
+    double*                 rowscore_;  //scores of one subject position against all query positions
+    char*                   qrymeets_;  //flags of query positions meeting information and thickness constraints
 };
 
 
@@ -149,13 +174,13 @@ bool ScoringMatrix::ThicknessConstraintsMet( int m, int n ) const
     if( GetQuerySize() <= n || n < 0 )
         throw myruntime_error( mystring( "ScoringMatrix: Memory access error." ));
 
-    if( !logo_sec_.GetMtxEffectiveThickness() || !logo_fst_.GetMtxEffectiveThickness())
+    if( !GetSbjctLogo().GetMtxEffectiveThickness() || !logo_fst_.GetMtxEffectiveThickness())
         throw myruntime_error( mystring( "ScoringMatrix: Profile thickness found to be wrong." ));
 #endif
 
-    if(           logo_sec_.GetThicknessAt( m ) < ( size_t )GetThicknessNumber() ||
+    if(           GetSbjctLogo().GetThicknessAt( m ) < ( size_t )GetThicknessNumber() ||
                   logo_fst_.GetThicknessAt( n ) < ( size_t )GetThicknessNumber() ||
-        ( double )logo_sec_.GetThicknessAt( m ) / logo_sec_.GetMtxEffectiveThickness() < GetThicknessPercents() ||
+        ( double )GetSbjctLogo().GetThicknessAt( m ) / GetSbjctLogo().GetMtxEffectiveThickness() < GetThicknessPercents() ||
         ( double )logo_fst_.GetThicknessAt( n ) / logo_fst_.GetMtxEffectiveThickness() < GetThicknessPercents())
             //if number of residues within a column is less than a number specified or
             //residues ratio in a column is less than a percentage specified
@@ -164,5 +189,21 @@ bool ScoringMatrix::ThicknessConstraintsMet( int m, int n ) const
     return true;
 }
 
+// -------------------------------------------------------------------------
+// SbjctConstraintsMet: returns false if information content or thickness
+//     of the subject position is below the thresholds; the constraints
+//     are met for a pair of positions if they are met for each of them
+// -------------------------------------------------------------------------
+
+inline
+bool ScoringMatrix::SbjctConstraintsMet( int m ) const
+{
+    if(           GetSbjctLogo().GetInformationAt( m ) < GetInformationThreshold() ||
+                  GetSbjctLogo().GetThicknessAt( m ) < ( size_t )GetThicknessNumber() ||
+        ( double )GetSbjctLogo().GetThicknessAt( m ) / GetSbjctLogo().GetMtxEffectiveThickness() < GetThicknessPercents())
+            return false;
+
+    return true;
+}
 
 #endif//__ScoringMatrix__
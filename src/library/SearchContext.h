@@ -0,0 +1,71 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Mindaugas Margelevicius                         *
+ *   Institute of Biotechnology, Vilnius                                   *
+ *   minmar@ibt.lt                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef __SearchContext__
+#define __SearchContext__
+
+#include <stddef.h>
+
+#include "debug.h"
+#include "types.h"
+
+
+// _________________________________________________________________________
+// Class SearchContext
+//
+// Parameters of one search which are shared by all the score systems and
+// alignments made within it. Written once before the database is scanned
+// and only read afterwards, so that concurrent workers may refer to the
+// same object
+//
+
+class SearchContext
+{
+public:
+    SearchContext();
+
+    size_t      GetDeltaLength() const                  { return deltaLength; }     //length adjustment
+    void        SetDeltaLength( size_t value )          { deltaLength = value; }
+
+    Uint64      GetSearchSpace() const                  { return searchSpace; }     //effective search space
+    void        SetSearchSpace( Uint64 value )          { searchSpace = value; }
+
+    Uint64      GetRawSearchSpace() const               { return raw_search_space; }//raw search space
+    void        SetRawSearchSpace( Uint64 value )       { raw_search_space = value; }
+
+    double      GetInformationThreshold() const         { return information_thrsh; }
+    void        SetInformationThreshold( double value ) { information_thrsh = value; }
+
+    double      GetSEGdistanceThreshold() const         { return segdistance_thrsh; }
+    void        SetSEGdistanceThreshold( double value ) { segdistance_thrsh = value; }
+
+private:
+    size_t      deltaLength;                //length adjustment for edge-effect correction
+    Uint64      searchSpace;                //search space computed taking into account deltaLength
+    Uint64      raw_search_space;           //raw search space without any corrections
+    double      information_thrsh;          //information content threshold
+    double      segdistance_thrsh;          //SEG distance threshold
+};
+
+
+////////////////////////////////////////////////////////////////////////////
+// INLINES
+//
+// Constructor
+//
+inline
+SearchContext::SearchContext()
+:   deltaLength( 0 ),
+    searchSpace( 0 ),
+    raw_search_space( 0 ),
+    information_thrsh( 0.0 ),
+    segdistance_thrsh( 0.0 )
+{
+}
+
+#endif//__SearchContext__
@@ -14,6 +14,7 @@
 #include "GapScheme.h"
 
 #include "FrequencyStore.h"
+#include "AbstractUniversalScoreMatrix.h"
 
 #include "mystring.h"
 #include "myexcept.h"
@@ -429,6 +430,111 @@ void Serializer::DeserializeFrequencies( FrequencyVector& vect, FILE* ffp )
 }
 
 
+// =========================================================================
+// SerializeScoreSystem: serializes parameters of universal score system
+//     to file
+// -------------------------------------------------------------------------
+
+void Serializer::SerializeScoreSystem( const AbstractUniversalScoreMatrix& scores, const char* filename )
+{
+#ifdef SER_ANSI
+    if( fp != NULL )
+        throw myruntime_error( mystring( "Serializer: Unable to serialize score system." ));
+
+    fp = fopen( filename, "wb" );
+    if( fp == NULL )
+        throw myruntime_error(
+            mystring( "Serializer: Failed to open file for writing." ));
+#else
+    if( fd != -1 )
+        throw myruntime_error( mystring( "Serializer: Unable to serialize score system." ));
+
+    fd = open( filename, O_WRONLY | O_CREAT | O_TRUNC );
+    if( fd == -1 )
+        throw myruntime_error(
+            mystring( "Serializer: Failed to open file for writing." ));
+#endif
+
+    try {
+        scores.Serialize( *this );
+
+    } catch( myexception const& ex )
+    {
+#ifdef SER_ANSI
+        fclose( fp );
+        fp = NULL;
+#else
+        close( fd );
+        fd = -1;
+#endif
+        throw myruntime_error( ex.what(), ex.eclass());
+    }
+
+
+#ifdef SER_ANSI
+    if( fclose( fp ) != 0 ) {
+        fp = NULL;
+        throw myruntime_error(
+            mystring( "Serializer: Failed to write score system." ));
+    }
+    fp = NULL;
+#else
+    close( fd );
+    fd = -1;
+#endif
+}
+
+// -------------------------------------------------------------------------
+// DeserializeScoreSystem: deserializes parameters of universal score
+//     system from file
+// -------------------------------------------------------------------------
+
+void Serializer::DeserializeScoreSystem( AbstractUniversalScoreMatrix& scores, const char* filename )
+{
+#ifdef SER_ANSI
+    if( fp != NULL )
+        throw myruntime_error( mystring( "Serializer: Unable to deserialize score system." ));
+
+    fp = fopen( filename, "rb" );
+    if( fp == NULL )
+        throw myruntime_error(
+            mystring( "Serializer: Failed to open file for reading." ));
+#else
+    if( fd != -1 )
+        throw myruntime_error( mystring( "Serializer: Unable to deserialize score system." ));
+
+    fd = open( filename, O_RDONLY );
+    if( fd == -1 )
+        throw myruntime_error(
+            mystring( "Serializer: Failed to open file for reading." ));
+#endif
+
+    try {
+        scores.Deserialize( *this );
+
+    } catch( myexception const& ex )
+    {
+#ifdef SER_ANSI
+        fclose( fp );
+        fp = NULL;
+#else
+        close( fd );
+        fd = -1;
+#endif
+        throw myruntime_error( ex.what(), ex.eclass());
+    }
+
+
+#ifdef SER_ANSI
+    fclose( fp );
+    fp = NULL;
+#else
+    close( fd );
+    fd = -1;
+#endif
+}
+
+
 
 
 
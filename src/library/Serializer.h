@@ -17,6 +17,7 @@ typedef class ExtendedDistributionMatrix    LogOddsMatrix;
 class GapScheme;
 
 class FrequencyVector;
+class AbstractUniversalScoreMatrix;
 
 class Serializer
 {
@@ -42,6 +43,9 @@ public:
     void    DeserializeFrequencies( FrequencyVector& );
     void    DeserializeFrequencies( FrequencyVector&, FILE* );
 
+    void    SerializeScoreSystem( const AbstractUniversalScoreMatrix&, const char* fname );
+    void    DeserializeScoreSystem( AbstractUniversalScoreMatrix&, const char* fname );
+
     void    WriteVector( FILE*, const FrequencyVector& );
     void    ReadVector( FILE*, FrequencyVector& );
 
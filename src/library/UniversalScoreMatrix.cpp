@@ -12,6 +12,7 @@
 
 #include "rc.h"
 #include "data.h"
+#include "HashFunctions.h"
 #include "UniversalScoreMatrix.h"
 #include "FrequencyStore.h"
 
@@ -19,6 +20,8 @@
 static const FrequencyMatrix    usm_dummyfreq;
 static const LogOddsMatrix      usm_dummylogo;
 
+const size_t UniversalScoreMatrix::min_part_size = 4096;
+
 void UniversalScoreMatrix::ResetSbjctFreq() { sbjctfreq = &usm_dummyfreq; }
 void UniversalScoreMatrix::ResetSbjctLogo() { sbjctpssm = &usm_dummylogo; }
 
@@ -64,10 +67,13 @@ UniversalScoreMatrix::UniversalScoreMatrix(
 
     qspair_scores( NULL ),
     qspair_mask( NULL ),
+    sbjct_vectors( NULL ),
     sbjct_length( 0 ),
     sbjct_reserved( 0 ),
 
-    queryprob( NULL )
+    queryprob( NULL ),
+
+    no_threads( 1 )
 {
     if( !querypssm.IsCompatible( queryfreq ))
             USM_THROW( "Query profile corrupted." );
@@ -76,7 +82,7 @@ UniversalScoreMatrix::UniversalScoreMatrix(
             USM_THROW( "Query profile has wrong number of positions." );
 
 
-    size_t  no_freqs = GetStore()->GetFrequencies()->GetSize();
+    size_t  no_freqs = GetStore()->GetSize();
 
     if( PreferCPU()) {
         Init( 0, 0 );   //zeros to indicate that no large matrix in memory will be used
@@ -110,10 +116,13 @@ UniversalScoreMatrix::UniversalScoreMatrix()
 
     qspair_scores( NULL ),
     qspair_mask( NULL ),
+    sbjct_vectors( NULL ),
     sbjct_length( 0 ),
     sbjct_reserved( 0 ),
 
-    queryprob( NULL )
+    queryprob( NULL ),
+
+    no_threads( 1 )
 {
 }
 
@@ -144,39 +153,29 @@ void UniversalScoreMatrix::ReallocatePairScores( int s_size )
         return;
     }
 
-    if( qspair_scores == NULL ) {
-        qspair_scores = ( double** )malloc( sizeof( double* ) * queryfreq.GetColumns());
+    int q_size = queryfreq.GetColumns();
 
-        if( qspair_scores == NULL )
-            USM_THROW( "UniversalScoreMatrix: Not enough memory." );
+    DestroyPairScores();
+    sbjct_reserved = 0;
 
-        memset( qspair_scores, 0, sizeof( double* ) * queryfreq.GetColumns());
-    }
+    //rows of each matrix follow the table of row addresses in one block
+    qspair_scores = ( double** )malloc( sizeof( double* ) * q_size + sizeof( double ) * q_size * s_size );
+    qspair_mask = ( TMask** )malloc( sizeof( TMask* ) * q_size + sizeof( TMask ) * q_size * s_size );
+    sbjct_vectors = ( const char** )malloc( sizeof( const char* ) * s_size );
 
-    if( qspair_mask == NULL ) {
-        qspair_mask = ( TMask** )malloc( sizeof( TMask* ) * queryfreq.GetColumns());
+    if( qspair_scores == NULL || qspair_mask == NULL || sbjct_vectors == NULL )
+        USM_THROW( "UniversalScoreMatrix: Not enough memory." );
 
-        if( qspair_mask == NULL )
-            USM_THROW( "UniversalScoreMatrix: Not enough memory." );
+    qspair_scores[0] = ( double* )( qspair_scores + q_size );
+    qspair_mask[0] = ( TMask* )( qspair_mask + q_size );
 
-        memset( qspair_mask, 0, sizeof( TMask* ) * queryfreq.GetColumns());
+    for( int n = 1; n < q_size; n++ ) {
+        qspair_scores[n] = qspair_scores[n-1] + s_size;
+        qspair_mask[n] = qspair_mask[n-1] + s_size;
     }
 
-
-
-    for( int n = 0; n < queryfreq.GetColumns(); n++ ) {
-        if( qspair_scores[n] )  free( qspair_scores[n] );
-        if( qspair_mask[n] )    free( qspair_mask[n] );
-
-        qspair_scores[n] = ( double* )malloc( sizeof( double ) * s_size );
-        qspair_mask[n]   = ( TMask* )malloc( sizeof( TMask ) * s_size );
-
-        if( qspair_scores[n] == NULL || qspair_mask[n] == NULL )
-            USM_THROW( "UniversalScoreMatrix: Not enough memory." );
-
-        memset( qspair_scores[n], 0, sizeof( double ) * s_size );
-        memset( qspair_mask[n], 0, sizeof( TMask ) * s_size );
-    }
+    memset( qspair_scores[0], 0, sizeof( double ) * q_size * s_size );
+    memset( qspair_mask[0], 0, sizeof( TMask ) * q_size * s_size );
 
     sbjct_reserved = s_size;
     sbjct_length = s_size;
@@ -190,22 +189,19 @@ void UniversalScoreMatrix::ReallocatePairScores( int s_size )
 void UniversalScoreMatrix::DestroyPairScores()
 {
     if( qspair_scores ) {
-        for( int n = 0; n < queryfreq.GetColumns(); n++ )
-            if( qspair_scores[n] )
-                free( qspair_scores[n] );
-
         free( qspair_scores );
         qspair_scores = NULL;
     }
 
     if( qspair_mask ) {
-        for( int n = 0; n < queryfreq.GetColumns(); n++ )
-            if( qspair_mask[n] )
-                free( qspair_mask[n] );
-
         free( qspair_mask );
         qspair_mask = NULL;
     }
+
+    if( sbjct_vectors ) {
+        free( sbjct_vectors );
+        sbjct_vectors = NULL;
+    }
 }
 
 // -------------------------------------------------------------------------
@@ -342,7 +338,7 @@ void UniversalScoreMatrix::ComputeProfileScoringMatrix( bool final )
         return;
 
 
-    if( !IsValid() || !GetStore() || !GetStore()->GetFrequencies())
+    if( !IsValid() || !GetStore() || !GetStore()->GetSize())
         USM_THROW( "Failed to compute matrix of scores." );
 
     int                 no_elems = 0;
@@ -351,7 +347,7 @@ void UniversalScoreMatrix::ComputeProfileScoringMatrix( bool final )
     bool                all_negat = true;
     double              score = 0.0;
     const double        scoreX = -1.0;  //score of profile positions with representative Xs
-    const SimpleVector* frequencies = GetStore()->GetFrequencies();
+    const FrequencyStore* frequencies = GetStore();
 
     //fill matrix with values
     for( int n = 0; n < GetPrivateQuerySize(); n++ ) {
@@ -365,7 +361,7 @@ void UniversalScoreMatrix::ComputeProfileScoringMatrix( bool final )
                 continue;
             }
 
-            const FrequencyVector   vector(( const char* )frequencies->GetValueAt( m ));
+            const FrequencyVector   vector( frequencies->GetVectorAt( m ));
 
             currentmask = Unmasked;
 
@@ -394,6 +390,80 @@ void UniversalScoreMatrix::ComputeProfileScoringMatrix( bool final )
     SetAllNegatives( all_negat );
 }
 
+// -------------------------------------------------------------------------
+// ComputeFingerprints: computes the fingerprints identifying the score
+//     system: that of the query profile, that of the options which the
+//     scaling depends on, and that of the frequency vectors given;
+//     searchprint is the hash of the options of the search that do not
+//     pass through the score system
+// -------------------------------------------------------------------------
+
+void UniversalScoreMatrix::ComputeFingerprints( Uint64 storeprint, Uint64 searchprint )
+{
+    const int   columns = GetQuerySize();
+    Uint64      hash = FNVBASIS;
+    Uint64      thickness;
+    double      values[9];
+    int         n, ps;
+
+    //query profile
+    hash = fnvhashing( &columns, sizeof( columns ), hash );
+    hash = fnvhashing( GetQueryFreq().GetVector(), sizeof( double ) * NUMALPH * columns, hash );
+    hash = fnvhashing( GetQueryLogo().GetVector(), sizeof( double ) * NUMALPH * columns, hash );
+    hash = fnvhashing( GetQueryLogo().GetResidues(), sizeof( char ) * columns, hash );
+    for( n = 0; n < columns; n++ ) {
+        values[0] = GetQueryLogo().GetFrequencyWeightAt( n );
+        values[1] = GetQueryLogo().GetInformationAt( n );
+        thickness = ( Uint64 )GetQueryLogo().GetThicknessAt( n );
+        hash = fnvhashing( values, sizeof( double ) * 2, hash );
+        hash = fnvhashing( &thickness, sizeof( thickness ), hash );
+    }
+    thickness = ( Uint64 )GetQueryLogo().GetMtxEffectiveThickness();
+    hash = fnvhashing( &thickness, sizeof( thickness ), hash );
+    SetFingerprint( QueryPrint, hash );
+
+    //options
+    hash = FNVBASIS;
+    for( ps = 0; ps < NoSchemes; ps++ ) {
+        const Configuration&    config = GetConfiguration(( TProcomSchemes )ps );
+        values[0] = config.GetLambda();
+        values[1] = config.GetK();
+        values[2] = config.GetH();
+        values[3] = config.GetAlpha();
+        values[4] = config.GetBeta();
+        values[5] = config.GetScaleFactor();
+        values[6] = config.GetGapOpenCost();
+        values[7] = config.GetGapExtendCost();
+        values[8] = config.GetAutoGapOpenCost();
+        hash = fnvhashing( values, sizeof( double ) * 9, hash );
+    }
+    values[0] = GetInformationThreshold();
+    values[1] = GetThicknessNumber();
+    values[2] = GetThicknessPercents();
+    values[3] = GetDeletionCoefficient();
+    values[4] = GetInfoCorrectionUpperBound2nd();
+    values[5] = GetInfoCorrectionNumerator2nd();
+    values[6] = GetInfoCorrectionScale2nd();
+    values[7] = GetInfoCorrectionNumeratorAlt();
+    values[8] = GetInfoCorrectionScaleAlt();
+    hash = fnvhashing( values, sizeof( double ) * 9, hash );
+    values[0] = GetBehaviour();
+    values[1] = GetMaskingApproach();
+    values[2] = GetDistributionType();
+    values[3] = GetAutoScaling();
+    values[4] = GetFPScaling();
+    values[5] = GetAutoScalingFactor();
+    values[6] = GetAutocorrectionPositional();
+    values[7] = PreferCPU();
+    values[8] = GetSupportOptimFreq();
+    hash = fnvhashing( values, sizeof( double ) * 9, hash );
+    hash = fnvhashing( &searchprint, sizeof( searchprint ), hash );
+    SetFingerprint( OptionsPrint, hash );
+
+    //frequency vectors
+    SetFingerprint( StorePrint, storeprint );
+}
+
 // -------------------------------------------------------------------------
 // PreserveSubject: prepares scoring system for alignment of query and
 //     subject; subject profile is given by the arguments to this method;
@@ -425,10 +495,32 @@ void UniversalScoreMatrix::PreserveSubject( const FrequencyMatrix& sfreq, const
 //     if( GetCorresScores()) GetCorresScores()->Init( GetQuerySize(), GetSubjectSize());
 //     if( GetScaledScores()) GetScaledScores()->Init( GetQuerySize(), GetSubjectSize());
 
+    //find the vector of each subject position in the store once for
+    //all query positions
+    for( int m = 0; m < GetSubjectSize(); m++ )
+    {
+        sbjct_vectors[m] = NULL;
+
+        //do not try to find a vector where subject's corresponding residue is X
+        if( GetSbjctFreq().GetResidueAt( m ) == X )
+            continue;
+
+        //change the vector with values of other column
+        vector.SetVector(   *GetSbjctFreq().GetVectorAt( m ),
+                             GetSbjctLogo().GetFrequencyWeightAt( m ),
+                             GetSbjctLogo().GetThicknessAt( m ),
+                            *GetSbjctLogo().GetVectorAt( m ),
+                             GetSbjctLogo().GetInformationAt( m )
+        );
+
+        sbjct_vectors[m] = ( const char* )GetStore()->Find( vector );
+    }
+
+    vector.Destroy();
+
     for( int n = 0; n < GetQuerySize(); n++ ) {
         for( int m = 0; m < GetSubjectSize(); m++ )
         {
-            //do not try to find a vector where subject's corresponding residue is X
             if( GetQueryFreq().GetResidueAt( n ) == X ||
                 GetSbjctFreq().GetResidueAt( m ) == X )
             {
@@ -436,20 +528,10 @@ void UniversalScoreMatrix::PreserveSubject( const FrequencyMatrix& sfreq, const
                 continue;
             }
 
-            //change the vector with values of other column
-            vector.SetVector(   *GetSbjctFreq().GetVectorAt( m ),
-                                 GetSbjctLogo().GetFrequencyWeightAt( m ),
-                                 GetSbjctLogo().GetThicknessAt( m ),
-                                *GetSbjctLogo().GetVectorAt( m ),
-                                 GetSbjctLogo().GetInformationAt( m )
-            );
-
-            const char* found = ( const char* )GetStore()->Find( vector );
+            const char* found = sbjct_vectors[m];
 
-            if( found == NULL ) {
-                vector.Destroy();
+            if( found == NULL )
                 USM_THROW( "UniversalScoreMatrix: No frequency vector found in the database." );
-            }
 
             double                  score = 0.0;
             const FrequencyVector   quest_vector( found );
@@ -474,14 +556,11 @@ void UniversalScoreMatrix::PreserveSubject( const FrequencyMatrix& sfreq, const
                 PreservePairScore( score, n, m );
 
             } catch( myexception const& ex ) {
-                vector.Destroy();
                 USM_THROW( ex.what(), ex.eclass());
             }
         }
     }
 
-    vector.Destroy();
-
     ResetSbjctFreq();
     ResetSbjctLogo();
 
@@ -513,17 +592,11 @@ void UniversalScoreMatrix::PreserveSubject( const FrequencyMatrix& sfreq, const
 
 bool UniversalScoreMatrix::ComputeScoreProbabilitiesCPU( AttributableScores* PATTR_SCORES )
 {
-    size_t  length = 0;         //effective length of query
-    double  probsum = 0.0;      //sum of all score probabilities
-    bool    all_negat = true;   //all negative scores
-
-    int     loc_multiplier = PATTR_SCORES->GetAutoScalingFactor();
-
     //get storage for scores and probabilities...
-    BinarySearchStructure*  loc_probabilities = GetProbCalculator();
+    ScoreHistogram*         loc_probabilities = GetProbCalculator();
 
 #ifdef __DEBUG__
-    if( !GetStore() || !GetStore()->GetFrequencies() ||
+    if( !GetStore() || !GetStore()->GetSize() ||
         !loc_probabilities )
         USM_THROW( "UniversalScoreMatrix: Unable to compute probabilities." );
 #endif
@@ -531,13 +604,134 @@ bool UniversalScoreMatrix::ComputeScoreProbabilitiesCPU( AttributableScores* PAT
     if( loc_probabilities->GetSize())
         USM_THROW( "UniversalScoreMatrix: Error in computation of probabilities." );
 
-    const SimpleVector*     frequencies = GetStore()->GetFrequencies();
+    size_t                  no_freqs = GetStore()->GetSize();
+    size_t                  nthreads = ( GetNoThreads() < 1 )? 1: ( size_t )GetNoThreads();
+    TUSMProbabilitiesPart*  parts = NULL;
+    size_t                  nstarted = 0;
+    size_t                  p;
+    double                  probsum = 0.0;
+    bool                    all_negat = true;
+    mystring                errmsg;
+    int                     errcls = NOCLASS;
+
+    //each thread is to get a range of vectors worth a thread
+    if( no_freqs / min_part_size < nthreads )
+        nthreads = ( no_freqs / min_part_size )? no_freqs / min_part_size: 1;
+
+    parts = new TUSMProbabilitiesPart[nthreads];
+    if( !parts )
+        USM_THROW( "UniversalScoreMatrix: Not enough memory." );
+
+    for( p = 0; p < nthreads; p++ ) {
+        parts[p].owner = this;
+        parts[p].begin = no_freqs * p / nthreads;
+        parts[p].end = no_freqs * ( p + 1 ) / nthreads;
+        parts[p].multiplier = PATTR_SCORES->GetAutoScalingFactor();
+        parts[p].probabilities = NULL;
+        parts[p].probsum = 0.0;
+        parts[p].all_negat = true;
+        parts[p].errclass = NOCLASS;
+    }
+
+    if( nthreads == 1 ) {
+        //no need for a thread; probabilities go to the structure of the object
+        parts[0].probabilities = loc_probabilities;
+        ProbabilitiesThread( parts );
+    }
+    else {
+        for( p = 0; p < nthreads; p++ ) {
+            parts[p].probabilities = new ScoreHistogram;
+            if( !parts[p].probabilities ) {
+                parts[p].error = "UniversalScoreMatrix: Not enough memory.";
+                break;
+            }
+        }
+        if( p == nthreads )
+            for( p = 0; p < nthreads; p++ ) {
+                if( pthread_create( &parts[p].thread, NULL, &ProbabilitiesThread, parts + p ) != 0 ) {
+                    parts[p].error = "UniversalScoreMatrix: Failed to create thread.";
+                    break;
+                }
+                nstarted++;
+            }
+        for( p = 0; p < nstarted; p++ )
+            pthread_join( parts[p].thread, NULL );
+    }
+
+    for( p = 0; p < nthreads; p++ )
+        if( !parts[p].error.empty()) {
+            errmsg = parts[p].error;
+            errcls = parts[p].errclass;
+            break;
+        }
+
+    //reduce the parts in the order of the ranges
+    for( p = 0; p < nthreads; p++ ) {
+        probsum += parts[p].probsum;
+        all_negat = all_negat && parts[p].all_negat;
+
+        if( !parts[p].probabilities || parts[p].probabilities == loc_probabilities )
+            continue;
+
+        try {
+            if( errmsg.empty())
+                loc_probabilities->Add( *parts[p].probabilities );
+        } catch( myexception const& ex ) {
+            errmsg = ex.what();
+            errcls = ex.eclass();
+        }
+        delete parts[p].probabilities;
+    }
+
+    delete[] parts;
+
+    if( !errmsg.empty()) {
+        loc_probabilities->Clear();
+        USM_THROW( errmsg.c_str(), errcls );
+    }
+
+    SetAllNegatives( all_negat );
+    ProcessScoreProbabilities( PATTR_SCORES, probsum/*length*/ );
+
+    return true;
+}
+
+// -------------------------------------------------------------------------
+// ProbabilitiesThread: entry point of a thread computing probabilities
+//     over the range of vectors of its part
+// -------------------------------------------------------------------------
+
+void* UniversalScoreMatrix::ProbabilitiesThread( void* arg )
+{
+    TUSMProbabilitiesPart*  part = ( TUSMProbabilitiesPart* )arg;
+
+    if( !part || !part->owner )
+        return NULL;
+
+    try {
+        part->owner->ComputeProbabilitiesPart( *part );
+
+    } catch( myexception const& ex ) {
+        part->error = ex.what();
+        part->errclass = ex.eclass();
+    }
+    return NULL;
+}
+
+// -------------------------------------------------------------------------
+// ComputeProbabilitiesPart: computes probabilities of scores of all query
+//     positions against the range of vectors of the part; probabilities
+//     are accumulated in the structure of the part
+// -------------------------------------------------------------------------
+
+void UniversalScoreMatrix::ComputeProbabilitiesPart( TUSMProbabilitiesPart& part ) const
+{
+    const FrequencyStore*   frequencies = GetStore();
     size_t                  no_colms = GetQuerySize();
-    size_t                  no_freqs = frequencies->GetSize();
 
     double                  score = 0.0;
     double                  scoreprob = 0.0;
-    ScoreProbability*       scp = ScoreProbability::NewScoreProbability();
+    int                     intscore;
 
     for( size_t n = 0; n < no_colms; n++ ) {
         if( GetQueryFreq().GetResidueAt( n ) == X )
@@ -549,10 +743,9 @@ bool UniversalScoreMatrix::ComputeScoreProbabilitiesCPU( AttributableScores* PAT
             if( GetQueryLogo().GetInformationAt( n ) < GetInformationThreshold())
                 continue;
 
-        length++;
-        for( size_t m = 0; m < no_freqs; m++ )
+        for( size_t m = part.begin; m < part.end; m++ )
         {
-            const   FrequencyVector   vector(( const char* )frequencies->GetValueAt( m ));
+            const   FrequencyVector   vector( frequencies->GetVectorAt( m ));
 
             if( GetMaskingApproach() == MaskToIgnore )
                 //the same...
@@ -562,29 +755,18 @@ bool UniversalScoreMatrix::ComputeScoreProbabilitiesCPU( AttributableScores* PAT
             score = ComputeScore( n, vector );
             scoreprob = VectorScoreProbability( n, vector );
 
-            scp->SetScores( score * loc_multiplier );
-            scp->SetProbability( scoreprob );
-            probsum += scoreprob;
+            intscore = ( int )rint( score * part.multiplier );
+            part.probsum += scoreprob;
 
-            if( all_negat && 0 < scp->GetScore())
-                all_negat = false;
+            if( part.all_negat && 0 < intscore )
+                part.all_negat = false;
 
-            if( scp->GetScore() <= SCORE_MIN || scp->GetProbability() <= 0.0 )
+            if( intscore <= SCORE_MIN || scoreprob <= 0.0 )
                 continue;
 
-            if( Push( scp )) {
-                //score with probability has been inserted: construct new object
-                scp = ScoreProbability::NewScoreProbability();
-            }
+            part.probabilities->Add( intscore, scoreprob );
         }
     }
-
-    ScoreProbability::Destroy( scp );
-
-    SetAllNegatives( all_negat );
-    ProcessScoreProbabilities( PATTR_SCORES, probsum/*length*/ );
-
-    return true;
 }
 
 // -------------------------------------------------------------------------
@@ -655,7 +837,7 @@ void UniversalScoreMatrix::PrintFinal( TPrintFunction print_func, void* vpn ) co
 
 void UniversalScoreMatrix::PrintScoringMatrix( FILE* fp ) const
 {
-    if( !GetStore() || !GetStore()->GetFrequencies())
+    if( !GetStore() || !GetStore()->GetSize())
         return;
 
     if( fp == NULL )
@@ -665,7 +847,7 @@ void UniversalScoreMatrix::PrintScoringMatrix( FILE* fp ) const
 
     fprintf( fp, "%9c", 32 );
 
-    const SimpleVector*     frequencies = GetStore()->GetFrequencies();
+    const FrequencyStore*   frequencies = GetStore();
     size_t                  no_colms = GetQuerySize();
     size_t                  no_freqs = frequencies->GetSize();
     int                     l = 0;
@@ -679,7 +861,7 @@ void UniversalScoreMatrix::PrintScoringMatrix( FILE* fp ) const
 
         for( size_t m = 0; m < no_freqs; m++ )
         {
-            const FrequencyVector   vector(( const char* )frequencies->GetValueAt( m ));
+            const FrequencyVector   vector( frequencies->GetVectorAt( m ));
             fprintf( fp, "%3d ", ( int )rint( ComputeScore( n, vector )));
         }
     }
@@ -10,6 +10,7 @@
 #define __UniversalScoreMatrix__
 
 #include <math.h>
+#include <pthread.h>
 
 #include "debug.h"
 #include "types.h"
@@ -23,6 +24,22 @@
 // extern double rint( double x );
 
 class FrequencyVector;
+class UniversalScoreMatrix;
+
+//part of the computation of score probabilities made by one thread over
+//  a range of vectors of the store
+struct TUSMProbabilitiesPart {
+    UniversalScoreMatrix*   owner;          //score system the probabilities are computed for
+    pthread_t               thread;         //thread identifier
+    size_t                  begin;          //first vector of the range
+    size_t                  end;            //vector following the range
+    int                     multiplier;     //scaling factor of scores
+    ScoreHistogram*         probabilities;  //scores observed and their probabilities
+    double                  probsum;        //sum of probabilities
+    bool                    all_negat;      //whether all scores are negative
+    mystring                error;          //error message if the computation failed
+    int                     errclass;       //class of the error
+};
 
 
 // _________________________________________________________________________
@@ -54,11 +71,17 @@ public:
                                                                 //prepares scoring system for alignment of query and subject
     void                PreserveSubject( const FrequencyMatrix&, const LogOddsMatrix& );
 
+                                                                //compute fingerprints identifying the score system
+    void                ComputeFingerprints( Uint64 storeprint, Uint64 searchprint );
+
     virtual int         GetQuerySize() const                { return GetQueryFreq().GetColumns(); }
     virtual int         GetSubjectSize() const              { return sbjct_length; }
 
     virtual void        ComputeProfileScoringMatrix( bool final = false );
 
+    int                 GetNoThreads() const                { return no_threads; }
+    void                SetNoThreads( int value )           { no_threads = value; }
+
     int                 GetThicknessNumber() const          { return thickness_number; }
     double              GetThicknessPercents() const        { return thickness_percnt; }
 
@@ -78,6 +101,9 @@ protected:
 
     virtual bool        ComputeScoreProbabilitiesCPU( AttributableScores* );    //an implementation of ComputeScoreProbabilities
     virtual bool        ComputeScoreProbabilitiesMem( AttributableScores* );    //an implementation of ComputeScoreProbabilities
+                                                                //compute probabilities over a range of vectors
+    void                ComputeProbabilitiesPart( TUSMProbabilitiesPart& ) const;
+    static void*        ProbabilitiesThread( void* );           //entry point of a thread computing probabilities
 
     void                ReallocatePairScores( int sbjct_sz );   //allocate space for pair scores
     void                DestroyPairScores();                    //destroy pair scores
@@ -122,9 +148,14 @@ private:
 
     double**                qspair_scores;  //query-subject pair scores
     TMask**                 qspair_mask;    //masks of scores
+    const char**            sbjct_vectors;  //vectors of the store found for subject positions
     int                     sbjct_length;   //length of subject
     int                     sbjct_reserved; //currently reserved length of subject
     double*                 queryprob;      //vector of probabilities of all query positions
+
+    int                     no_threads;     //number of threads to compute score probabilities with
+
+    static const size_t     min_part_size;  //minimum number of vectors a thread is given
 };
 
 
@@ -182,6 +182,13 @@
 // infinite sum to; the probability is used to compute K
 #define PARAMETER_K_ACCURACY ( 1.e-4 )
 
+// number of profile columns a word of the column-word index
+// of the database consists of
+#define CWI_WORD_LENGTH 3
+
+// maximum length of words of the column-word index
+#define CWI_MAX_WORD_LENGTH 5
+
 // maximum number of times to iterate searching for fixed
 // value of length adjustment expression
 #define LENGTH_ADJUSTMENT_MAXIT 20
@@ -0,0 +1,211 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Mindaugas Margelevicius                         *
+ *   Institute of Biotechnology, Vilnius                                   *
+ *   minmar@ibt.lt                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+// Test of the position-specific gap coefficients ProfileAlignment computes
+// once before aligning; each of them has to be equal to the value the
+// GapScheme accessors, called for each cell of the dynamic programming
+// matrix before, return.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "rc.h"
+#include "Configuration.h"
+#include "GapScheme.h"
+#include "DistributionMatrix.h"
+#include "ScoringMatrix.h"
+#include "ProfileAlignment.h"
+
+#include "mystring.h"
+#include "myexcept.h"
+
+
+//number of times of deletion extension tested
+const int   noexttimes = 16;
+
+// -------------------------------------------------------------------------
+// CLASS GapCoefficientsTest
+// Access to the gap coefficients of profile alignment
+//
+class GapCoefficientsTest: public ProfileAlignment
+{
+public:
+    GapCoefficientsTest(
+            const FrequencyMatrix& freq_fst, const LogOddsMatrix& logo_fst, const GapScheme& gaps_fst,
+            const FrequencyMatrix& freq_sec, const LogOddsMatrix& logo_sec, const GapScheme& gaps_sec,
+            const AbstractScoreMatrix* scsystem )
+    :   ProfileAlignment( freq_fst, logo_fst, gaps_fst, freq_sec, logo_sec, gaps_sec, scsystem ),
+        gaps_fst_( gaps_fst ),
+        gaps_sec_( gaps_sec )
+    {}
+
+    int     Verify( bool probabilities );
+
+private:
+    int     Verify( const GapScheme&, const double* coefs, int size, bool probabilities, const char* );
+
+    const GapScheme&    gaps_fst_;
+    const GapScheme&    gaps_sec_;
+};
+
+// -------------------------------------------------------------------------
+// Verify: computes gap coefficients and verifies them against the values
+//     of the accessors of the gap schemes; returns the number of mismatches
+//
+int GapCoefficientsTest::Verify( bool probabilities )
+{
+    int     errors = 0;
+
+    ComputeGapCoefficients( probabilities );
+
+    errors += Verify( gaps_fst_, GetFstCoefficients( gcOpen ), GetQuerySize(), probabilities, "query" );
+    errors += Verify( gaps_sec_, GetSecCoefficients( gcOpen ), GetSubjectSize(), probabilities, "subject" );
+    return errors;
+}
+
+// Verify: verifies the coefficients of one of the gap schemes; coefs is
+//     the beginning of the coefficients of the gap scheme
+//
+int GapCoefficientsTest::Verify(
+    const GapScheme& gaps, const double* coefs, int size, bool probabilities, const char* name )
+{
+    double  gapadj = GetScoreMatrix()->GetDeletionCoefficient();
+    double  factor01 = gaps.GetProbabilityFactor();
+    int     errors = 0;
+    int     n, t;
+
+    for( n = 0; n < size; n++ ) {
+        if( coefs[gcOpen * size + n] != gaps.GetOpenAt( n )) {
+            fprintf( stderr, "Mismatch of %s gap opening cost at %d.\n", name, n );
+            errors++;
+        }
+        if( coefs[gcExtend * size + n] != gaps.GetExtendAt( n )) {
+            fprintf( stderr, "Mismatch of %s gap extension cost at %d.\n", name, n );
+            errors++;
+        }
+        if( !probabilities )
+            continue;
+        if( coefs[gcProb * size + n] != gaps.GetProbabilityAt( n )) {
+            fprintf( stderr, "Mismatch of %s gap probability at %d.\n", name, n );
+            errors++;
+        }
+        if( coefs[gcDelOpen * size + n] != gaps.GetDeleteOpenProbAt( n ) * gapadj ) {
+            fprintf( stderr, "Mismatch of %s deletion opening probability at %d.\n", name, n );
+            errors++;
+        }
+        for( t = 0; t < noexttimes; t++ )
+            if( gaps.GetDeleteExtensionProbAt( n, t, factor01 ) != gaps.GetDeleteExtensionProbAt( n, t )) {
+                fprintf( stderr, "Mismatch of %s deletion extension probability at %d, time %d.\n", name, n, t );
+                errors++;
+            }
+    }
+    return errors;
+}
+
+// -------------------------------------------------------------------------
+// MakeProfile: makes a profile of pseudo-random values of the given length
+//
+void MakeProfile( int length, FrequencyMatrix& freq, LogOddsMatrix& pssm, GapScheme& gaps, bool fixedcosts )
+{
+    double  values[NUMALPH];
+    double  sum, weight, delbeg, delend;
+    char    residue;
+    int     n, a;
+
+    freq.Reserve( length );
+    pssm.Reserve( length );
+    gaps.Reserve( length );
+
+    for( n = 0; n < length; n++ ) {
+        residue = ( char )( rand() % NUMAA );
+        sum = 0.0;
+        for( a = 0; a < NUMAA; a++ )
+            sum += values[a] = ( double )( rand() % 1000 + 1 );
+        for( a = 0; a < NUMAA; a++ )
+            values[a] /= sum;
+        for( ; a < NUMALPH; a++ )
+            values[a] = 0.0;
+        freq.Push( values, residue );
+
+        for( a = 0; a < NUMAA; a++ )
+            values[a] = ( double )( rand() % 2001 - 1000 ) / 200.0;
+        pssm.Push( values, residue, ( double )( rand() % 1000 ) / 100.0, ( double )( rand() % 1000 ) / 1000.0, rand() % 100 + 1 );
+
+        weight = ( double )( rand() % 1000 ) / 1000.0;
+        delbeg = ( double )( rand() % 1000 ) / 2000.0;
+        delend = ( double )( rand() % 1000 ) / 2000.0;
+        gaps.Push( weight, delbeg, delend, rand() % 10, residue );
+    }
+
+    //probability factor less than 1 for zero thickness
+    gaps.SetGapProbabFactorEvalue( 1.0e-5 );
+    gaps.SetGapProbabFactorWeight( 0.4 );
+    gaps.SetGapProbabFactorShift( 0.5 );
+    gaps.Initialize();
+    gaps.Prepare( -4.0, -1.0, fixedcosts );
+}
+
+// -------------------------------------------------------------------------
+// Test: tests gap coefficients of a pair of profiles of the given lengths
+//
+int Test( int qlength, int slength, bool fixedcosts, double delcoeff )
+{
+    FrequencyMatrix freq_fst, freq_sec;
+    LogOddsMatrix   logo_fst, logo_sec;
+    GapScheme       gaps_fst, gaps_sec;
+    Configuration   config[NoSchemes];
+
+    MakeProfile( qlength, freq_fst, logo_fst, gaps_fst, fixedcosts );
+    MakeProfile( slength, freq_sec, logo_sec, gaps_sec, fixedcosts );
+
+    ScoringMatrix   scsystem(
+            freq_fst, logo_fst, freq_sec, logo_sec,
+            0.0, 1, 0.0, 0.0, config,
+            AbstractScoreMatrix::ComputeStatistics,
+            AbstractScoreMatrix::NoScaling,
+            MaskToIgnore );
+
+    scsystem.SetDeletionCoefficient( delcoeff );
+
+    GapCoefficientsTest alignment( freq_fst, logo_fst, gaps_fst, freq_sec, logo_sec, gaps_sec, &scsystem );
+
+    return alignment.Verify( !fixedcosts );
+}
+
+// -------------------------------------------------------------------------
+// main: runs the tests; exit status is non-zero if any of them fails
+//
+int main()
+{
+    int     errors = 0;
+
+    SetGlobalProgName( "testgapcoefs", "" );
+    srand( 7 );
+
+    try {
+        errors += Test( 1, 1, false, 0.6 );
+        errors += Test( 37, 211, false, 0.6 );
+        errors += Test( 250, 19, false, 1.0 );
+        errors += Test( 64, 64, true, 0.6 );
+
+    } catch( myexception const& ex ) {
+        error( ex.what());
+        return EXIT_FAILURE;
+    }
+
+    if( errors ) {
+        fprintf( stderr, "Gap coefficients: %d mismatches.\n", errors );
+        return EXIT_FAILURE;
+    }
+
+    fprintf( stdout, "Gap coefficients: OK\n" );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Mindaugas Margelevicius                         *
+ *   Institute of Biotechnology, Vilnius                                   *
+ *   minmar@ibt.lt                                                         *
+ *                                                                         *
+ ***************************************************************************/
+
+// Test of reusing parameter K. The value of K recorded for a hit and given
+// to the score system made for the same pair of profiles again, when the
+// hit is rendered (SetGivenK), has to be taken and to equal K computed
+// anew within the tolerance, with the other statistical parameters
+// unchanged.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "rc.h"
+#include "Configuration.h"
+#include "DistributionMatrix.h"
+#include "ScoringMatrix.h"
+
+#include "mystring.h"
+#include "myexcept.h"
+
+
+//relative tolerance of the values of K compared
+const double    tolerance = 1.0e-12;
+
+// -------------------------------------------------------------------------
+// MakeProfile: makes a profile of pseudo-random values of the given length;
+//     each position prefers its residue
+//
+void MakeProfile( int length, FrequencyMatrix& freq, LogOddsMatrix& pssm )
+{
+    double  values[NUMALPH];
+    double  sum, peak;
+    char    residue;
+    int     n, a;
+
+    freq.Reserve( length );
+    pssm.Reserve( length );
+
+    for( n = 0; n < length; n++ ) {
+        residue = ( char )( rand() % NUMAA );
+        peak = ( double )( rand() % 500 ) / 1000.0;
+        sum = 0.0;
+        for( a = 0; a < NUMAA; a++ )
+            sum += values[a] = ( double )( rand() % 1000 + 1000 );
+        for( a = 0; a < NUMAA; a++ )
+            values[a] = ( 1.0 - peak ) * values[a] / sum + (( a == residue )? peak: 0.0 );
+        for( ; a < NUMALPH; a++ )
+            values[a] = 0.0;
+        freq.Push( values, residue );
+
+        //log-odds with respect to uniform background probabilities
+        for( a = 0; a < NUMAA; a++ )
+            values[a] = log( values[a] * ( double )NUMAA );
+        pssm.Push( values, residue, ( double )( rand() % 1000 ) / 100.0, ( double )( rand() % 1000 ) / 1000.0, rand() % 100 + 1 );
+    }
+}
+
+// -------------------------------------------------------------------------
+// Differ: returns true if the values differ by more than the tolerance
+//
+bool Differ( double one, double another )
+{
+    return fabs( one - another ) > tolerance * fabs( one );
+}
+
+// -------------------------------------------------------------------------
+// Test: tests parameter K of a pair of profiles of the given lengths;
+//     returns the number of mismatches
+//
+int Test( int qlength, int slength, AbstractScoreMatrix::TScaling scaling )
+{
+    FrequencyMatrix freq_fst, freq_sec;
+    LogOddsMatrix   logo_fst, logo_sec;
+    Configuration   config[NoSchemes];
+    int             errors = 0;
+
+    SetUngappedParams( config[ProcomUngapped] );
+    SetUngappedParams( config[ProcomGapped] );
+
+    MakeProfile( qlength, freq_fst, logo_fst );
+    MakeProfile( slength, freq_sec, logo_sec );
+
+    //K computed anew
+    ScoringMatrix   computed(
+            freq_fst, logo_fst, freq_sec, logo_sec,
+            0.0, 1, 0.0, 0.0, config,
+            AbstractScoreMatrix::ComputeStatistics, scaling, MaskToIgnore );
+
+    computed.ComputeProfileScoringMatrix();
+    computed.ScaleScoringMatrix();
+
+    if( computed.GetK() <= 0.0 ) {
+        fprintf( stderr, "K not computed for profiles of lengths %d and %d.\n", qlength, slength );
+        return 1;
+    }
+
+    //K given as recorded for a hit
+    ScoringMatrix   given(
+            freq_fst, logo_fst, freq_sec, logo_sec,
+            0.0, 1, 0.0, 0.0, config,
+            AbstractScoreMatrix::ComputeStatistics, scaling, MaskToIgnore );
+
+    given.ComputeProfileScoringMatrix();
+    given.SetGivenK( computed.GetK());
+    given.ScaleScoringMatrix();
+
+    if( Differ( computed.GetK(), given.GetK()) ||
+        Differ( computed.GetLambda(), given.GetLambda()) ||
+        Differ( computed.GetEntropy(), given.GetEntropy()))
+    {
+        fprintf( stderr, "K of profiles of lengths %d and %d: %.17g, given %.17g.\n",
+                qlength, slength, computed.GetK(), given.GetK());
+        errors++;
+    }
+
+    //K given has to be taken instead of being computed
+    ScoringMatrix   taken(
+            freq_fst, logo_fst, freq_sec, logo_sec,
+            0.0, 1, 0.0, 0.0, config,
+            AbstractScoreMatrix::ComputeStatistics, scaling, MaskToIgnore );
+
+    taken.ComputeProfileScoringMatrix();
+    taken.SetGivenK( 2.0 * computed.GetK());
+    taken.ScaleScoringMatrix();
+
+    if( Differ( 2.0 * computed.GetK(), taken.GetK())) {
+        fprintf( stderr, "K given for profiles of lengths %d and %d not taken.\n", qlength, slength );
+        errors++;
+    }
+    return errors;
+}
+
+// -------------------------------------------------------------------------
+// main: runs the tests; exit status is non-zero if any of them fails
+//
+int main()
+{
+    int     errors = 0;
+
+    SetGlobalProgName( "testkarlinsk", "" );
+    srand( 11 );
+
+    try {
+        errors += Test( 12, 17, AbstractScoreMatrix::NoScaling );
+        errors += Test( 41, 133, AbstractScoreMatrix::NoScaling );
+        errors += Test( 90, 60, AbstractScoreMatrix::AutoScalling );
+        errors += Test( 200, 150, AbstractScoreMatrix::AutoScalling );
+
+    } catch( myexception const& ex ) {
+        error( ex.what());
+        return EXIT_FAILURE;
+    }
+
+    if( errors ) {
+        fprintf( stderr, "Parameter K: %d mismatches.\n", errors );
+        return EXIT_FAILURE;
+    }
+
+    fprintf( stdout, "Parameter K: OK (relative tolerance %g)\n", tolerance );
+    return EXIT_SUCCESS;
+}
@@ -27,10 +27,14 @@
 //
 // 1.0  . Text format introduced
 // 1.1  . Background probabilities added
+//
+// bindbversion:
+// 1.0  . Binary format of the main database file introduced
 
 
 static const char*  dataversion = "1.1";
 static const char*  dbversion = "1.1";
+extern const char*  bindbversion;     //defined in Database.cpp
 
 
 #endif//__version_h__
@@ -31,8 +31,13 @@ int main( int argc, char *argv[] )
     mystring        seglowent;
     mystring        seghighent;
     mystring        segdistance;
+    mystring        nthreads;
     bool            suppress = true;    //suppress output
     bool            usingseg = false;   //whether using seg
+    bool            makeindex = false;  //whether to make index
+    bool            binary = false;     //whether to write database in binary format
+    bool            append = false;     //whether to append profiles to the existing database
+    int             valTHREADS = 1;     //number of threads to make the database with
     int             c;
 
     SetGlobalProgName( argv[0], version );
@@ -50,6 +55,10 @@ int main( int argc, char *argv[] )
             {"t",       required_argument, 0, 't'},
             {"d",       required_argument, 0, 'd'},
             {"v",       no_argument,       0, 'v'},
+            {"I",       no_argument,       0, 'I'},
+            {"b",       no_argument,       0, 'b'},
+            {"T",       required_argument, 0, 'T'},
+            {"append",  no_argument,       0, 'a'},
 
             {"U",       no_argument,       0, 'U'},
             {"w",       required_argument, 0, 'w'},
@@ -58,10 +67,10 @@ int main( int argc, char *argv[] )
             {"D",       required_argument, 0, 'D'},
             { 0, 0, 0, 0 }
         };
-        if(( c = getopt_long_only( argc, argv, "hvo:t:d:Uw:f:F:D:", long_options, &option_index )) == -1 )
+        if(( c = getopt_long_only( argc, argv, "hvo:t:d:IbT:aUw:f:F:D:", long_options, &option_index )) == -1 )
             break;
 #else
-        if(( c = getopt( argc, argv, "hvo:t:d:Uw:f:F:D:" )) == -1 )
+        if(( c = getopt( argc, argv, "hvo:t:d:IbT:aUw:f:F:D:" )) == -1 )
             break;
 #endif
 
@@ -74,6 +83,10 @@ int main( int argc, char *argv[] )
             case 'o':   output       = optarg;      break;
             case 't':   distribution = optarg;      break;
             case 'd':   directory    = optarg;      break;
+            case 'I':   makeindex    = true;        break;
+            case 'b':   binary       = true;        break;
+            case 'T':   nthreads     = optarg;      break;
+            case 'a':   append       = true;        break;
 
             case 'U':   usingseg    = true;                     break;
             case 'w':   segwindow   = optarg; usingseg = true;  break;
@@ -150,6 +163,14 @@ int main( int argc, char *argv[] )
             return EXIT_FAILURE;
     }
 
+    if( !nthreads.empty()) {
+        valTHREADS = strtol( nthreads.c_str(), &p, 10 );
+        if( errno || *p || valTHREADS <= 0 ) {
+            error( "Number of threads is invalid." );
+            return EXIT_FAILURE;
+        }
+    }
+
     // SEG options --
     if( !segwindow.empty()) {
         intvalue = strtol( segwindow.c_str(), &p, 10 );
@@ -238,7 +259,13 @@ int main( int argc, char *argv[] )
             );
 
         database->SetDistributionType( distribtype );
-        database->Make();
+        database->SetMakeIndex( makeindex );
+        database->SetBinary( binary );
+        database->SetNoThreads( valTHREADS );
+        if( append )
+            database->Append();
+        else
+            database->Make();
         delete database;
 
     } catch( myexception const& ex )
@@ -39,9 +39,15 @@
 // 1.02 . new format: text format
 // 1.03 . weights for observed frequencies changed: negative values disallowed;
 //          does not affect the overall performance
+// 1.04 . column-word index of profiles
+// 1.05 . binary format of database
+// 1.06 . offset index of profiles
+// 1.07 . profiles processed by multiple threads and written in one pass
+// 1.08 . profiles appended to the existing database
+// 1.09 . image of the store of frequency vectors written for mapping by searches
 
 
-static const char*  version = "1.03";
+static const char*  version = "1.09";
 static const char*  verdate = "";
 
 static const char*  makeinst = "\n\
@@ -65,6 +71,20 @@ Database construction options:\n\
                  profile)    simple,  simple discrete distribution,\n\
                              multin,  multinomial distribution,\n\
                              profile, distribution of profile vectors.\n\
+-I                          Make column-word index of profiles to\n\
+                            preselect profiles to search; searches use\n\
+                            it if option IDXNOSEEDS is set.\n\
+-b                          Write profiles in binary format, which is\n\
+                            read faster in searching.\n\
+-T <threads>    [Integer]   Number of threads to process profiles with.     (  1)\n\
+-a                          Append profiles to the existing database;\n\
+                            the distribution type and format (-b) are\n\
+                            to be the same.\n\
+                            Offset index missing in databases made\n\
+                            before version 1.06 is made again by\n\
+                            reading the database; otherwise, indices\n\
+                            not corresponding to the database require\n\
+                            making the database again.\n\
 \n\
 SEG options:\n\
 -U                          Invoke low-complexity filtering of profiles.\n\
@@ -82,6 +102,7 @@ Examples:\n\
 <> -o my_db -t uniform -d ./my_profiles\n\
 <> -o my_db -t profile d_70_1_2.pro b_119_1_1.pro c_17_1_1.pro c_69_1_5.pro\n\
 <> -o my_db *.pro\n\
+<> -o my_db -a new_*.pro\n\
 \n\
 ";
 
@@ -331,13 +331,13 @@ void ParallelUniversalScoreMatrix::MasterComputations( AttributableScores* PATTR
     bool    loc_all_negat = true;   //local variable to check for negativity
 
     //get storage for scores and probabilities...
-    BinarySearchStructure*  loc_probabilities = GetProbCalculator();
+    ScoreHistogram*         loc_probabilities = GetProbCalculator();
 
 #ifdef __DEBUG__
     if( GetMyMPIRank() < 0 || GetMPIRingSize() < 1 )
         USM_THROW( "ParallelUniversalScoreMatrix: Wrong MPI rank or ring size." );
 
-//     if( !GetStore() || !GetStore()->GetFrequencies() ||
+//     if( !GetStore() || !GetStore()->GetSize() ||
 //         !loc_probabilities )
 //         USM_THROW( "ParallelUniversalScoreMatrix: Unable to compute probabilities." );
 #endif
@@ -346,7 +346,7 @@ void ParallelUniversalScoreMatrix::MasterComputations( AttributableScores* PATTR
         USM_THROW( "ParallelUniversalScoreMatrix: Error in computation of probabilities." );
 
 
-//     const SimpleVector*     frequencies = GetStore()->GetFrequencies();
+//     const FrequencyStore*   frequencies = GetStore();
 //     size_t                  no_freqs = 0;
     double                  probsum = 0.0;      //sum of probabilities of all scores received
     double                  partialsum = 0.0;   //partial sum of probabilities of scores received
@@ -369,7 +369,7 @@ void ParallelUniversalScoreMatrix::MasterComputations( AttributableScores* PATTR
             continue;
         }
 
-        BinarySearchStructure*  probs_obtained = NULL;
+        ScoreHistogram*         probs_obtained = NULL;
 
         try {
             probs_obtained = DeformatProbCalculator( GetSRMBuffer());
@@ -387,8 +387,7 @@ void ParallelUniversalScoreMatrix::MasterComputations( AttributableScores* PATTR
         }
 
         if( probs_obtained )
-            //members of probs_obtained are redirected to ProbCalculator of this class,
-            //destroy only vector used to contain them
+            //probabilities have been added to ProbCalculator of this class
             delete probs_obtained;
     }
 
@@ -423,13 +422,13 @@ void ParallelUniversalScoreMatrix::SlaveComputations()
 
 
     //get storage for scores and probabilities...
-    BinarySearchStructure*  loc_probabilities = GetProbCalculator();
+    ScoreHistogram*         loc_probabilities = GetProbCalculator();
 
 #ifdef __DEBUG__
     if( GetMyMPIRank() < 0 || GetMPIRingSize() < 1 )
         USM_THROW( "ParallelUniversalScoreMatrix: Wrong MPI rank or ring size." );
 
-    if( !GetStore() || !GetStore()->GetFrequencies() ||
+    if( !GetStore() || !GetStore()->GetSize() ||
         !loc_probabilities )
         USM_THROW( "ParallelUniversalScoreMatrix: Unable to compute probabilities." );
 #endif
@@ -438,13 +437,13 @@ void ParallelUniversalScoreMatrix::SlaveComputations()
         USM_THROW( "ParallelUniversalScoreMatrix: Error in computation of probabilities." );
 
 
-    const SimpleVector*     frequencies = GetStore()->GetFrequencies();
+    const FrequencyStore*   frequencies = GetStore();
     size_t                  no_freqs = 0;
 
     bool                    error = false;
     double                  score = 0.0;
     double                  scoreprob = 0.0;
-    ScoreProbability*       scp = ScoreProbability::NewScoreProbability();
+    int                     intscore;
 
     if( frequencies )
         no_freqs = frequencies->GetSize();
@@ -454,7 +453,7 @@ void ParallelUniversalScoreMatrix::SlaveComputations()
 //     for( size_t N = 0 + GetMyMPIRank() - 1; N < no_freqs && !error; N += GetMPIRingSize() - 1 )
     for( size_t N = 0; N < no_freqs && !error; N ++ )
     {
-        const FrequencyVector   rowvector(( const char* )frequencies->GetValueAt( N ));
+        const FrequencyVector   rowvector( frequencies->GetVectorAt( N ));
 
         //omit rows for which positional vectors have less information than the threshold
         if(( double ) rowvector.GetInfContent() / INFO_SCALE_CONSTANT < GetInformationThreshold())
@@ -465,7 +464,7 @@ void ParallelUniversalScoreMatrix::SlaveComputations()
 //         for( size_t M = N; M < no_freqs && !error; M ++ )
         for( size_t M = N + GetMyMPIRank() - 1; M < no_freqs && !error; M += GetMPIRingSize() - 1 )
         {
-            const FrequencyVector   colvector(( const char* )frequencies->GetValueAt( M ));
+            const FrequencyVector   colvector( frequencies->GetVectorAt( M ));
 
             //omit columns for which positional vectors have less information than the threshold
             if(( double ) colvector.GetInfContent() / INFO_SCALE_CONSTANT < GetInformationThreshold())
@@ -474,31 +473,25 @@ void ParallelUniversalScoreMatrix::SlaveComputations()
             score = ComputeScore( rowvector, colvector );
             scoreprob = VectorScoreProbability( rowvector, colvector );
 
-            scp->SetScores( score * loc_multiplier );
-            scp->SetProbability( scoreprob );
+            intscore = ( int )rint( score * loc_multiplier );
 
             if( M != N ) {
                 //change order of the vectors...
-                scoreprob = VectorScoreProbability( colvector, rowvector );
                 //if this isn't a score obtained via the diagonal elements,
                 //increase the score probability since it occurs twice: in the upper and lower triangles
-                scp->IncProbability( scoreprob );
+                scoreprob += VectorScoreProbability( colvector, rowvector );
             }
 
-            if( all_negat && 0 < scp->GetScore())
+            if( all_negat && 0 < intscore )
                 all_negat = false;
 
-            if( scp->GetScore() <= SCORE_MIN || scp->GetProbability() <= 0.0 )
+            if( intscore <= SCORE_MIN || scoreprob <= 0.0 )
                 continue;
 
-            if( Push( scp )) {
-                //score with probability has been inserted: construct new object
-                scp = ScoreProbability::NewScoreProbability();
-            }
+            loc_probabilities->Add( intscore, scoreprob );
         }
     }
 // PrintProbCalculator( stderr );
-    ScoreProbability::Destroy( scp );
 
     //format data and send them to the master
     size_t  written = FormatProbCalculator( GetSRMBuffer());
@@ -506,8 +499,8 @@ void ParallelUniversalScoreMatrix::SlaveComputations()
     //the function below will throw an exception if an error occurs
     ( *send_function  )( GetSRMBuffer(), written, true );
 
-    //destroy members of loc_probabilities and re-initialize it
-    ClearProbCalculator( loc_probabilities );
+    //clear loc_probabilities for the next computation
+    loc_probabilities->Clear();
 }
 
 // -------------------------------------------------------------------------
@@ -572,7 +565,7 @@ void ParallelUniversalScoreMatrix::PrintFinal( TPrintFunction print_func, void*
 
 void ParallelUniversalScoreMatrix::PrintScoringMatrix( FILE* fp ) const
 {
-    if( !GetStore() || !GetStore()->GetFrequencies())
+    if( !GetStore() || !GetStore()->GetSize())
         return;
 
     if( fp == NULL )
@@ -582,7 +575,7 @@ void ParallelUniversalScoreMatrix::PrintScoringMatrix( FILE* fp ) const
 
     fprintf( fp, "%9c", 32 );
 
-    const SimpleVector*     frequencies = GetStore()->GetFrequencies();
+    const FrequencyStore*   frequencies = GetStore();
     size_t                  no_freqs = frequencies->GetSize();
     int                     l = 0;
 
@@ -591,12 +584,12 @@ void ParallelUniversalScoreMatrix::PrintScoringMatrix( FILE* fp ) const
 
 
     for( size_t N = 0; N < no_freqs; N++ ) {
-        const FrequencyVector   rowvector(( const char* )frequencies->GetValueAt( N ));
+        const FrequencyVector   rowvector( frequencies->GetVectorAt( N ));
         fprintf( fp, "\n%5d %c   ", ++l, 32 );
 
         for( size_t M = 0; M < no_freqs; M++ )
         {
-            const FrequencyVector   colvector(( const char* )frequencies->GetValueAt( M ));
+            const FrequencyVector   colvector( frequencies->GetVectorAt( M ));
             fprintf( fp, "%3d ", ( int )rint( ComputeScore( rowvector, colvector )));
         }
     }